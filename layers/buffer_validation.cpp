@@ -33,255 +33,104 @@
 
 #include "buffer_validation.h"
 
-void SetLayout(layer_data *device_data, GLOBAL_CB_NODE *pCB, ImageSubresourcePair imgpair, const VkImageLayout &layout) {
-    auto it = pCB->imageLayoutMap.find(imgpair);
-    if (it != pCB->imageLayoutMap.end()) {
-        it->second.layout = layout;
-    } else {
-        assert(imgpair.hasSubresource);
-        IMAGE_CMD_BUF_LAYOUT_NODE node;
-        if (!FindCmdBufLayout(device_data, pCB, imgpair.image, imgpair.subresource, node)) {
-            node.initialLayout = layout;
-        }
-        SetLayout(device_data, pCB, imgpair, {node.initialLayout, layout});
-    }
-}
-template <class OBJECT, class LAYOUT>
-void SetLayout(layer_data *device_data, OBJECT *pObject, VkImage image, VkImageSubresource range, const LAYOUT &layout) {
-    ImageSubresourcePair imgpair = {image, true, range};
-    SetLayout(device_data, pObject, imgpair, layout, VK_IMAGE_ASPECT_COLOR_BIT);
-    SetLayout(device_data, pObject, imgpair, layout, VK_IMAGE_ASPECT_DEPTH_BIT);
-    SetLayout(device_data, pObject, imgpair, layout, VK_IMAGE_ASPECT_STENCIL_BIT);
-    SetLayout(device_data, pObject, imgpair, layout, VK_IMAGE_ASPECT_METADATA_BIT);
-    if (GetDeviceExtensions(device_data)->vk_khr_sampler_ycbcr_conversion) {
-        SetLayout(device_data, pObject, imgpair, layout, VK_IMAGE_ASPECT_PLANE_0_BIT_KHR);
-        SetLayout(device_data, pObject, imgpair, layout, VK_IMAGE_ASPECT_PLANE_1_BIT_KHR);
-        SetLayout(device_data, pObject, imgpair, layout, VK_IMAGE_ASPECT_PLANE_2_BIT_KHR);
-    }
-}
-
-template <class OBJECT, class LAYOUT>
-void SetLayout(layer_data *device_data, OBJECT *pObject, ImageSubresourcePair imgpair, const LAYOUT &layout,
-               VkImageAspectFlags aspectMask) {
-    if (imgpair.subresource.aspectMask & aspectMask) {
-        imgpair.subresource.aspectMask = aspectMask;
-        SetLayout(device_data, pObject, imgpair, layout);
-    }
-}
-
-// Set the layout in supplied map
-void SetLayout(std::unordered_map<ImageSubresourcePair, IMAGE_LAYOUT_NODE> &imageLayoutMap, ImageSubresourcePair imgpair,
-               VkImageLayout layout) {
-    auto it = imageLayoutMap.find(imgpair);
-    if (it != imageLayoutMap.end()) {
-        it->second.layout = layout;  // Update
-    } else {
-        imageLayoutMap[imgpair].layout = layout;  // Insert
-    }
-}
-
-bool FindLayoutVerifyNode(layer_data const *device_data, GLOBAL_CB_NODE const *pCB, ImageSubresourcePair imgpair,
-                          IMAGE_CMD_BUF_LAYOUT_NODE &node, const VkImageAspectFlags aspectMask) {
-    const debug_report_data *report_data = core_validation::GetReportData(device_data);
-
-    if (!(imgpair.subresource.aspectMask & aspectMask)) {
-        return false;
-    }
-    VkImageAspectFlags oldAspectMask = imgpair.subresource.aspectMask;
-    imgpair.subresource.aspectMask = aspectMask;
-    auto imgsubIt = pCB->imageLayoutMap.find(imgpair);
-    if (imgsubIt == pCB->imageLayoutMap.end()) {
-        return false;
-    }
-    if (node.layout != VK_IMAGE_LAYOUT_MAX_ENUM && node.layout != imgsubIt->second.layout) {
-        log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, HandleToUint64(imgpair.image),
-                __LINE__, DRAWSTATE_INVALID_LAYOUT, "DS",
-                "Cannot query for VkImage 0x%" PRIx64 " layout when combined aspect mask %d has multiple layout types: %s and %s",
-                HandleToUint64(imgpair.image), oldAspectMask, string_VkImageLayout(node.layout),
-                string_VkImageLayout(imgsubIt->second.layout));
-    }
-    if (node.initialLayout != VK_IMAGE_LAYOUT_MAX_ENUM && node.initialLayout != imgsubIt->second.initialLayout) {
-        log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, HandleToUint64(imgpair.image),
-                __LINE__, DRAWSTATE_INVALID_LAYOUT, "DS",
-                "Cannot query for VkImage 0x%" PRIx64
-                " layout when combined aspect mask %d has multiple initial layout types: %s and %s",
-                HandleToUint64(imgpair.image), oldAspectMask, string_VkImageLayout(node.initialLayout),
-                string_VkImageLayout(imgsubIt->second.initialLayout));
-    }
-    node = imgsubIt->second;
-    return true;
-}
-
-bool FindLayoutVerifyLayout(layer_data const *device_data, ImageSubresourcePair imgpair, VkImageLayout &layout,
-                            const VkImageAspectFlags aspectMask) {
-    if (!(imgpair.subresource.aspectMask & aspectMask)) {
-        return false;
-    }
-    const debug_report_data *report_data = core_validation::GetReportData(device_data);
-    VkImageAspectFlags oldAspectMask = imgpair.subresource.aspectMask;
-    imgpair.subresource.aspectMask = aspectMask;
-    auto imgsubIt = (*core_validation::GetImageLayoutMap(device_data)).find(imgpair);
-    if (imgsubIt == (*core_validation::GetImageLayoutMap(device_data)).end()) {
-        return false;
-    }
-    if (layout != VK_IMAGE_LAYOUT_MAX_ENUM && layout != imgsubIt->second.layout) {
-        log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_IMAGE_EXT, HandleToUint64(imgpair.image),
-                __LINE__, DRAWSTATE_INVALID_LAYOUT, "DS",
-                "Cannot query for VkImage 0x%" PRIx64 " layout when combined aspect mask %d has multiple layout types: %s and %s",
-                HandleToUint64(imgpair.image), oldAspectMask, string_VkImageLayout(layout),
-                string_VkImageLayout(imgsubIt->second.layout));
-    }
-    layout = imgsubIt->second.layout;
-    return true;
-}
-
-// Find layout(s) on the command buffer level
-bool FindCmdBufLayout(layer_data const *device_data, GLOBAL_CB_NODE const *pCB, VkImage image, VkImageSubresource range,
-                      IMAGE_CMD_BUF_LAYOUT_NODE &node) {
-    ImageSubresourcePair imgpair = {image, true, range};
-    node = IMAGE_CMD_BUF_LAYOUT_NODE(VK_IMAGE_LAYOUT_MAX_ENUM, VK_IMAGE_LAYOUT_MAX_ENUM);
-    FindLayoutVerifyNode(device_data, pCB, imgpair, node, VK_IMAGE_ASPECT_COLOR_BIT);
-    FindLayoutVerifyNode(device_data, pCB, imgpair, node, VK_IMAGE_ASPECT_DEPTH_BIT);
-    FindLayoutVerifyNode(device_data, pCB, imgpair, node, VK_IMAGE_ASPECT_STENCIL_BIT);
-    FindLayoutVerifyNode(device_data, pCB, imgpair, node, VK_IMAGE_ASPECT_METADATA_BIT);
-    if (GetDeviceExtensions(device_data)->vk_khr_sampler_ycbcr_conversion) {
-        FindLayoutVerifyNode(device_data, pCB, imgpair, node, VK_IMAGE_ASPECT_PLANE_0_BIT_KHR);
-        FindLayoutVerifyNode(device_data, pCB, imgpair, node, VK_IMAGE_ASPECT_PLANE_1_BIT_KHR);
-        FindLayoutVerifyNode(device_data, pCB, imgpair, node, VK_IMAGE_ASPECT_PLANE_2_BIT_KHR);
-    }
-    if (node.layout == VK_IMAGE_LAYOUT_MAX_ENUM) {
-        imgpair = {image, false, VkImageSubresource()};
-        auto imgsubIt = pCB->imageLayoutMap.find(imgpair);
-        if (imgsubIt == pCB->imageLayoutMap.end()) return false;
-        // TODO: This is ostensibly a find function but it changes state here
-        node = imgsubIt->second;
-    }
-    return true;
-}
-
-// Find layout(s) on the global level
-bool FindGlobalLayout(layer_data *device_data, ImageSubresourcePair imgpair, VkImageLayout &layout) {
-    layout = VK_IMAGE_LAYOUT_MAX_ENUM;
-    FindLayoutVerifyLayout(device_data, imgpair, layout, VK_IMAGE_ASPECT_COLOR_BIT);
-    FindLayoutVerifyLayout(device_data, imgpair, layout, VK_IMAGE_ASPECT_DEPTH_BIT);
-    FindLayoutVerifyLayout(device_data, imgpair, layout, VK_IMAGE_ASPECT_STENCIL_BIT);
-    FindLayoutVerifyLayout(device_data, imgpair, layout, VK_IMAGE_ASPECT_METADATA_BIT);
-    if (GetDeviceExtensions(device_data)->vk_khr_sampler_ycbcr_conversion) {
-        FindLayoutVerifyLayout(device_data, imgpair, layout, VK_IMAGE_ASPECT_PLANE_0_BIT_KHR);
-        FindLayoutVerifyLayout(device_data, imgpair, layout, VK_IMAGE_ASPECT_PLANE_1_BIT_KHR);
-        FindLayoutVerifyLayout(device_data, imgpair, layout, VK_IMAGE_ASPECT_PLANE_2_BIT_KHR);
-    }
-    if (layout == VK_IMAGE_LAYOUT_MAX_ENUM) {
-        imgpair = {imgpair.image, false, VkImageSubresource()};
-        auto imgsubIt = (*core_validation::GetImageLayoutMap(device_data)).find(imgpair);
-        if (imgsubIt == (*core_validation::GetImageLayoutMap(device_data)).end()) return false;
-        layout = imgsubIt->second.layout;
-    }
-    return true;
+// Layouts are tracked per aspect bit, and the plane aspects only exist with VK_KHR_sampler_ycbcr_conversion
+static VkImageAspectFlags GetTrackedLayoutAspects(layer_data const *device_data, VkImageAspectFlags aspect_mask) {
+    if (!GetDeviceExtensions(device_data)->vk_khr_sampler_ycbcr_conversion) {
+        aspect_mask &= ~(VK_IMAGE_ASPECT_PLANE_0_BIT_KHR | VK_IMAGE_ASPECT_PLANE_1_BIT_KHR | VK_IMAGE_ASPECT_PLANE_2_BIT_KHR);
+    }
+    return aspect_mask;
+}
+
+// Call func(begin, end) for each run of subresource indices covered by range
+template <typename F>
+static void ForEachSubresourceRange(layer_data const *device_data, const ImageSubresourceIndex &subresource_index,
+                                    const VkImageSubresourceRange &range, F func) {
+    subresource_index.ForEachRange(GetTrackedLayoutAspects(device_data, range.aspectMask), range.baseMipLevel, range.levelCount,
+                                   range.baseArrayLayer, range.layerCount, func);
+}
+
+// Return the layouts pCB tracks for the subresources of an image, starting an empty set if it has none yet
+static ImageLayoutRanges<IMAGE_CMD_BUF_LAYOUT_NODE> &GetCmdBufImageLayouts(GLOBAL_CB_NODE *pCB, const IMAGE_STATE *image_state) {
+    auto image_layouts = pCB->imageLayoutMap.find(image_state->image);
+    if (image_layouts != pCB->imageLayoutMap.end()) return image_layouts->second;
+    auto &new_image_layouts = pCB->imageLayoutMap[image_state->image];
+    new_image_layouts.subresource_index = ImageSubresourceIndex(image_state->createInfo);
+    return new_image_layouts;
+}
+
+// Call func(subresource, node) for each run of subresources in range whose layout pCB tracks, where subresource is the first
+// subresource of the run
+template <typename F>
+static void ForEachCmdBufLayout(layer_data const *device_data, GLOBAL_CB_NODE const *pCB, VkImage image,
+                                const VkImageSubresourceRange &range, F func) {
+    auto image_layouts = pCB->imageLayoutMap.find(image);
+    if (image_layouts == pCB->imageLayoutMap.end()) return;
+    const ImageSubresourceIndex &subresource_index = image_layouts->second.subresource_index;
+    const auto &ranges = image_layouts->second.ranges;
+    ForEachSubresourceRange(device_data, subresource_index, range, [&](uint64_t begin, uint64_t end) {
+        ranges.for_each(begin, end, [&](uint64_t run_begin, uint64_t, const IMAGE_CMD_BUF_LAYOUT_NODE &node) {
+            func(subresource_index.Decode(run_begin), node);
+        });
+    });
+}
+
+// Set the layouts pCB tracks for the subresources in range to update(current), where current is the layout already tracked
+// for a run of them, or nullptr if there is none
+template <typename F>
+static void UpdateCmdBufLayouts(layer_data const *device_data, GLOBAL_CB_NODE *pCB, const IMAGE_STATE *image_state,
+                                const VkImageSubresourceRange &range, F update) {
+    auto &image_layouts = GetCmdBufImageLayouts(pCB, image_state);
+    ForEachSubresourceRange(device_data, image_layouts.subresource_index, range,
+                            [&](uint64_t begin, uint64_t end) { image_layouts.ranges.update(begin, end, update); });
+}
+
+// Call func(begin, end, layout) for each run of [begin, end) with a known layout in image_layout
+template <typename F>
+static void ForEachImageLayout(const IMAGE_LAYOUT_NODE &image_layout, uint64_t begin, uint64_t end, F func) {
+    uint64_t cursor = begin;
+    image_layout.subresource_layouts.ranges.for_each(begin, end, [&](uint64_t run_begin, uint64_t run_end, VkImageLayout layout) {
+        if (cursor < run_begin && image_layout.layout != VK_IMAGE_LAYOUT_MAX_ENUM) func(cursor, run_begin, image_layout.layout);
+        func(run_begin, run_end, layout);
+        cursor = run_end;
+    });
+    if (cursor < end && image_layout.layout != VK_IMAGE_LAYOUT_MAX_ENUM) func(cursor, end, image_layout.layout);
 }
 
 bool FindLayouts(layer_data *device_data, VkImage image, std::vector<VkImageLayout> &layouts) {
-    auto sub_data = (*core_validation::GetImageSubresourceMap(device_data)).find(image);
-    if (sub_data == (*core_validation::GetImageSubresourceMap(device_data)).end()) return false;
+    auto image_layout = core_validation::GetImageLayoutMap(device_data)->find(image);
+    if (image_layout == core_validation::GetImageLayoutMap(device_data)->end()) return false;
     auto image_state = GetImageState(device_data, image);
     if (!image_state) return false;
-    bool ignoreGlobal = false;
+    const auto &subresource_ranges = image_layout->second.subresource_layouts.ranges;
+    uint64_t subresource_count = 0;
+    for (const auto &range : subresource_ranges) subresource_count += range.end - range.begin;
     // TODO: Make this robust for >1 aspect mask. Now it will just say ignore potential errors in this case.
-    if (sub_data->second.size() >= (image_state->createInfo.arrayLayers * image_state->createInfo.mipLevels + 1)) {
-        ignoreGlobal = true;
+    if (subresource_count < uint64_t(image_state->createInfo.arrayLayers) * image_state->createInfo.mipLevels &&
+        image_layout->second.layout != VK_IMAGE_LAYOUT_MAX_ENUM) {
+        layouts.push_back(image_layout->second.layout);
     }
-    for (auto imgsubpair : sub_data->second) {
-        if (ignoreGlobal && !imgsubpair.hasSubresource) continue;
-        auto img_data = (*core_validation::GetImageLayoutMap(device_data)).find(imgsubpair);
-        if (img_data != (*core_validation::GetImageLayoutMap(device_data)).end()) {
-            layouts.push_back(img_data->second.layout);
-        }
+    for (const auto &range : subresource_ranges) {
+        layouts.push_back(range.value);
     }
     return true;
 }
-bool FindLayout(const std::unordered_map<ImageSubresourcePair, IMAGE_LAYOUT_NODE> &imageLayoutMap, ImageSubresourcePair imgpair,
-                VkImageLayout &layout, const VkImageAspectFlags aspectMask) {
-    if (!(imgpair.subresource.aspectMask & aspectMask)) {
-        return false;
-    }
-    imgpair.subresource.aspectMask = aspectMask;
-    auto imgsubIt = imageLayoutMap.find(imgpair);
-    if (imgsubIt == imageLayoutMap.end()) {
-        return false;
-    }
-    layout = imgsubIt->second.layout;
-    return true;
-}
-
-// find layout in supplied map
-bool FindLayout(layer_data *device_data, const std::unordered_map<ImageSubresourcePair, IMAGE_LAYOUT_NODE> &imageLayoutMap,
-                ImageSubresourcePair imgpair, VkImageLayout &layout) {
-    layout = VK_IMAGE_LAYOUT_MAX_ENUM;
-    FindLayout(imageLayoutMap, imgpair, layout, VK_IMAGE_ASPECT_COLOR_BIT);
-    FindLayout(imageLayoutMap, imgpair, layout, VK_IMAGE_ASPECT_DEPTH_BIT);
-    FindLayout(imageLayoutMap, imgpair, layout, VK_IMAGE_ASPECT_STENCIL_BIT);
-    FindLayout(imageLayoutMap, imgpair, layout, VK_IMAGE_ASPECT_METADATA_BIT);
-    if (GetDeviceExtensions(device_data)->vk_khr_sampler_ycbcr_conversion) {
-        FindLayout(imageLayoutMap, imgpair, layout, VK_IMAGE_ASPECT_PLANE_0_BIT_KHR);
-        FindLayout(imageLayoutMap, imgpair, layout, VK_IMAGE_ASPECT_PLANE_1_BIT_KHR);
-        FindLayout(imageLayoutMap, imgpair, layout, VK_IMAGE_ASPECT_PLANE_2_BIT_KHR);
-    }
-    // Image+subresource not found, look for image handle w/o subresource
-    if (layout == VK_IMAGE_LAYOUT_MAX_ENUM) {
-        imgpair = {imgpair.image, false, VkImageSubresource()};
-        auto imgsubIt = imageLayoutMap.find(imgpair);
-        if (imgsubIt == imageLayoutMap.end()) return false;
-        layout = imgsubIt->second.layout;
-    }
-    return true;
-}
-
-// Set the layout on the global level
-void SetGlobalLayout(layer_data *device_data, ImageSubresourcePair imgpair, const VkImageLayout &layout) {
-    VkImage &image = imgpair.image;
-    auto &lmap = (*core_validation::GetImageLayoutMap(device_data));
-    auto data = lmap.find(imgpair);
-    if (data != lmap.end()) {
-        data->second.layout = layout;  // Update
-    } else {
-        lmap[imgpair].layout = layout;  // Insert
-    }
-    auto &image_subresources = (*core_validation::GetImageSubresourceMap(device_data))[image];
-    auto subresource = std::find(image_subresources.begin(), image_subresources.end(), imgpair);
-    if (subresource == image_subresources.end()) {
-        image_subresources.push_back(imgpair);
-    }
-}
 
-// Set the layout on the cmdbuf level
-void SetLayout(layer_data *device_data, GLOBAL_CB_NODE *pCB, ImageSubresourcePair imgpair, const IMAGE_CMD_BUF_LAYOUT_NODE &node) {
-    auto it = pCB->imageLayoutMap.find(imgpair);
-    if (it != pCB->imageLayoutMap.end()) {
-        it->second = node;  // Update
-    } else {
-        pCB->imageLayoutMap[imgpair] = node;  // Insert
-    }
-}
 // Set image layout for given VkImageSubresourceRange struct
 void SetImageLayout(layer_data *device_data, GLOBAL_CB_NODE *cb_node, const IMAGE_STATE *image_state,
                     VkImageSubresourceRange image_subresource_range, const VkImageLayout &layout) {
     assert(image_state);
     cb_node->image_layout_change_count++;  // Change the version of this data to force revalidation
-    for (uint32_t level_index = 0; level_index < image_subresource_range.levelCount; ++level_index) {
-        uint32_t level = image_subresource_range.baseMipLevel + level_index;
-        for (uint32_t layer_index = 0; layer_index < image_subresource_range.layerCount; layer_index++) {
-            uint32_t layer = image_subresource_range.baseArrayLayer + layer_index;
-            VkImageSubresource sub = {image_subresource_range.aspectMask, level, layer};
-            // TODO: If ImageView was created with depth or stencil, transition both layouts as the aspectMask is ignored and both
-            // are used. Verify that the extra implicit layout is OK for descriptor set layout validation
-            if (image_subresource_range.aspectMask & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)) {
-                if (FormatIsDepthAndStencil(image_state->createInfo.format)) {
-                    sub.aspectMask |= (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT);
-                }
-            }
-            SetLayout(device_data, cb_node, image_state->image, sub, layout);
+    // TODO: If ImageView was created with depth or stencil, transition both layouts as the aspectMask is ignored and both
+    // are used. Verify that the extra implicit layout is OK for descriptor set layout validation
+    if (image_subresource_range.aspectMask & (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT)) {
+        if (FormatIsDepthAndStencil(image_state->createInfo.format)) {
+            image_subresource_range.aspectMask |= (VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT);
         }
     }
+    UpdateCmdBufLayouts(device_data, cb_node, image_state, image_subresource_range, [layout](const IMAGE_CMD_BUF_LAYOUT_NODE *current) {
+        // Subresources the command buffer has not used before start out in the layout they are set to
+        return IMAGE_CMD_BUF_LAYOUT_NODE(current ? current->initialLayout : layout, layout);
+    });
 }
 // Set image layout for given VkImageSubresourceLayers struct
 void SetImageLayout(layer_data *device_data, GLOBAL_CB_NODE *cb_node, const IMAGE_STATE *image_state,
@@ -323,27 +172,17 @@ bool VerifyFramebufferAndRenderPassLayouts(layer_data *device_data, GLOBAL_CB_NO
         const VkImage &image = view_state->create_info.image;
         const VkImageSubresourceRange &subRange = view_state->create_info.subresourceRange;
         auto initial_layout = pRenderPassInfo->pAttachments[i].initialLayout;
-        // TODO: Do not iterate over every possibility - consolidate where possible
-        for (uint32_t j = 0; j < subRange.levelCount; j++) {
-            uint32_t level = subRange.baseMipLevel + j;
-            for (uint32_t k = 0; k < subRange.layerCount; k++) {
-                uint32_t layer = subRange.baseArrayLayer + k;
-                VkImageSubresource sub = {subRange.aspectMask, level, layer};
-                IMAGE_CMD_BUF_LAYOUT_NODE node;
-                if (!FindCmdBufLayout(device_data, pCB, image, sub, node)) {
-                    // Missing layouts will be added during state update
-                    continue;
-                }
-                if (initial_layout != VK_IMAGE_LAYOUT_UNDEFINED && initial_layout != node.layout) {
-                    skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0,
-                                    __LINE__, DRAWSTATE_INVALID_RENDERPASS, "DS",
-                                    "You cannot start a render pass using attachment %u where the render pass initial layout is %s "
-                                    "and the previous known layout of the attachment is %s. The layouts must match, or the render "
-                                    "pass initial layout for the attachment must be VK_IMAGE_LAYOUT_UNDEFINED",
-                                    i, string_VkImageLayout(initial_layout), string_VkImageLayout(node.layout));
-                }
+        // Missing layouts will be added during state update
+        ForEachCmdBufLayout(device_data, pCB, image, subRange, [&](const VkImageSubresource &, const IMAGE_CMD_BUF_LAYOUT_NODE &node) {
+            if (initial_layout != VK_IMAGE_LAYOUT_UNDEFINED && initial_layout != node.layout) {
+                skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0, __LINE__,
+                                DRAWSTATE_INVALID_RENDERPASS, "DS",
+                                "You cannot start a render pass using attachment %u where the render pass initial layout is %s "
+                                "and the previous known layout of the attachment is %s. The layouts must match, or the render "
+                                "pass initial layout for the attachment must be VK_IMAGE_LAYOUT_UNDEFINED",
+                                i, string_VkImageLayout(initial_layout), string_VkImageLayout(node.layout));
             }
-        }
+        });
     }
     return skip;
 }
@@ -374,30 +213,6 @@ void TransitionSubpassLayouts(layer_data *device_data, GLOBAL_CB_NODE *pCB, cons
     }
 }
 
-bool ValidateImageAspectLayout(layer_data *device_data, GLOBAL_CB_NODE const *pCB, const VkImageMemoryBarrier *mem_barrier,
-                               uint32_t level, uint32_t layer, VkImageAspectFlags aspect) {
-    if (!(mem_barrier->subresourceRange.aspectMask & aspect)) {
-        return false;
-    }
-    VkImageSubresource sub = {aspect, level, layer};
-    IMAGE_CMD_BUF_LAYOUT_NODE node;
-    if (!FindCmdBufLayout(device_data, pCB, mem_barrier->image, sub, node)) {
-        return false;
-    }
-    bool skip = false;
-    if (mem_barrier->oldLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
-        // TODO: Set memory invalid which is in mem_tracker currently
-    } else if (node.layout != mem_barrier->oldLayout) {
-        skip |= log_msg(core_validation::GetReportData(device_data), VK_DEBUG_REPORT_ERROR_BIT_EXT,
-                        VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT, HandleToUint64(pCB->commandBuffer), __LINE__,
-                        DRAWSTATE_INVALID_IMAGE_LAYOUT, "DS",
-                        "For image 0x%" PRIx64 " you cannot transition the layout of aspect %d from %s when current layout is %s.",
-                        HandleToUint64(mem_barrier->image), aspect, string_VkImageLayout(mem_barrier->oldLayout),
-                        string_VkImageLayout(node.layout));
-    }
-    return skip;
-}
-
 // Transition the layout state for renderpass attachments based on the BeginRenderPass() call. This includes:
 // 1. Transition into initialLayout state
 // 2. Transition from initialLayout to layout used in subpass 0
@@ -413,25 +228,6 @@ void TransitionBeginRenderPassLayouts(layer_data *device_data, GLOBAL_CB_NODE *c
     TransitionSubpassLayouts(device_data, cb_state, render_pass_state, 0, framebuffer_state);
 }
 
-void TransitionImageAspectLayout(layer_data *device_data, GLOBAL_CB_NODE *pCB, const VkImageMemoryBarrier *mem_barrier,
-                                 uint32_t level, uint32_t layer, VkImageAspectFlags aspect) {
-    if (!(mem_barrier->subresourceRange.aspectMask & aspect)) {
-        return;
-    }
-    VkImageSubresource sub = {aspect, level, layer};
-    IMAGE_CMD_BUF_LAYOUT_NODE node;
-    if (!FindCmdBufLayout(device_data, pCB, mem_barrier->image, sub, node)) {
-        pCB->image_layout_change_count++;  // Change the version of this data to force revalidation
-        SetLayout(device_data, pCB, mem_barrier->image, sub,
-                  IMAGE_CMD_BUF_LAYOUT_NODE(mem_barrier->oldLayout, mem_barrier->newLayout));
-        return;
-    }
-    if (mem_barrier->oldLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
-        // TODO: Set memory invalid
-    }
-    SetLayout(device_data, pCB, mem_barrier->image, sub, mem_barrier->newLayout);
-}
-
 bool VerifyAspectsPresent(VkImageAspectFlags aspect_mask, VkFormat format) {
     if ((aspect_mask & VK_IMAGE_ASPECT_COLOR_BIT) != 0) {
         if (!FormatIsColor(format)) return false;
@@ -548,27 +344,26 @@ bool ValidateBarriersToImages(layer_data *device_data, GLOBAL_CB_NODE const *cb_
                     string_VkFormat(image_create_info->format), aspect_mask, validation_error_map[VALIDATION_ERROR_0a00096e]);
             }
         }
-        uint32_t level_count = ResolveRemainingLevels(&img_barrier->subresourceRange, image_create_info->mipLevels);
-        uint32_t layer_count = ResolveRemainingLayers(&img_barrier->subresourceRange, image_create_info->arrayLayers);
-
-        for (uint32_t j = 0; j < level_count; j++) {
-            uint32_t level = img_barrier->subresourceRange.baseMipLevel + j;
-            for (uint32_t k = 0; k < layer_count; k++) {
-                uint32_t layer = img_barrier->subresourceRange.baseArrayLayer + k;
-                skip |= ValidateImageAspectLayout(device_data, cb_state, img_barrier, level, layer, VK_IMAGE_ASPECT_COLOR_BIT);
-                skip |= ValidateImageAspectLayout(device_data, cb_state, img_barrier, level, layer, VK_IMAGE_ASPECT_DEPTH_BIT);
-                skip |= ValidateImageAspectLayout(device_data, cb_state, img_barrier, level, layer, VK_IMAGE_ASPECT_STENCIL_BIT);
-                skip |= ValidateImageAspectLayout(device_data, cb_state, img_barrier, level, layer, VK_IMAGE_ASPECT_METADATA_BIT);
-                if (GetDeviceExtensions(device_data)->vk_khr_sampler_ycbcr_conversion) {
-                    skip |= ValidateImageAspectLayout(device_data, cb_state, img_barrier, level, layer,
-                                                      VK_IMAGE_ASPECT_PLANE_0_BIT_KHR);
-                    skip |= ValidateImageAspectLayout(device_data, cb_state, img_barrier, level, layer,
-                                                      VK_IMAGE_ASPECT_PLANE_1_BIT_KHR);
-                    skip |= ValidateImageAspectLayout(device_data, cb_state, img_barrier, level, layer,
-                                                      VK_IMAGE_ASPECT_PLANE_2_BIT_KHR);
+        VkImageSubresourceRange range = img_barrier->subresourceRange;
+        range.levelCount = ResolveRemainingLevels(&img_barrier->subresourceRange, image_create_info->mipLevels);
+        range.layerCount = ResolveRemainingLayers(&img_barrier->subresourceRange, image_create_info->arrayLayers);
+
+        // Check the old layout against each run of subresources the command buffer has already used
+        ForEachCmdBufLayout(
+            device_data, cb_state, img_barrier->image, range,
+            [&](const VkImageSubresource &subresource, const IMAGE_CMD_BUF_LAYOUT_NODE &node) {
+                if (img_barrier->oldLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
+                    // TODO: Set memory invalid which is in mem_tracker currently
+                } else if (node.layout != img_barrier->oldLayout) {
+                    skip |= log_msg(core_validation::GetReportData(device_data), VK_DEBUG_REPORT_ERROR_BIT_EXT,
+                                    VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT, HandleToUint64(cb_state->commandBuffer),
+                                    __LINE__, DRAWSTATE_INVALID_IMAGE_LAYOUT, "DS",
+                                    "For image 0x%" PRIx64
+                                    " you cannot transition the layout of aspect %d from %s when current layout is %s.",
+                                    HandleToUint64(img_barrier->image), subresource.aspectMask,
+                                    string_VkImageLayout(img_barrier->oldLayout), string_VkImageLayout(node.layout));
                 }
-            }
-        }
+            });
     }
     return skip;
 }
@@ -581,32 +376,30 @@ void TransitionImageLayouts(layer_data *device_data, VkCommandBuffer cmdBuffer,
         auto mem_barrier = &pImgMemBarriers[i];
         if (!mem_barrier) continue;
 
-        VkImageCreateInfo *image_create_info = &(GetImageState(device_data, mem_barrier->image)->createInfo);
-        uint32_t level_count = ResolveRemainingLevels(&mem_barrier->subresourceRange, image_create_info->mipLevels);
-        uint32_t layer_count = ResolveRemainingLayers(&mem_barrier->subresourceRange, image_create_info->arrayLayers);
+        auto image_state = GetImageState(device_data, mem_barrier->image);
+        if (!image_state) continue;
+        VkImageCreateInfo *image_create_info = &image_state->createInfo;
+        VkImageSubresourceRange range = mem_barrier->subresourceRange;
+        range.levelCount = ResolveRemainingLevels(&mem_barrier->subresourceRange, image_create_info->mipLevels);
+        range.layerCount = ResolveRemainingLayers(&mem_barrier->subresourceRange, image_create_info->arrayLayers);
 
         // Special case for 3D images with VK_IMAGE_CREATE_2D_ARRAY_COMPATIBLE_BIT_KHR flag bit, where <extent.depth> and
         // <arrayLayers> can potentially alias. When recording layout for the entire image, pre-emptively record layouts
         // for all (potential) layer sub_resources.
         if ((0 != (image_create_info->flags & VK_IMAGE_CREATE_2D_ARRAY_COMPATIBLE_BIT_KHR)) &&
-            (mem_barrier->subresourceRange.baseArrayLayer == 0) && (layer_count == 1)) {
-            layer_count = image_create_info->extent.depth;  // Treat each depth slice as a layer subresource
+            (mem_barrier->subresourceRange.baseArrayLayer == 0) && (range.layerCount == 1)) {
+            range.layerCount = image_create_info->extent.depth;  // Treat each depth slice as a layer subresource
         }
 
-        for (uint32_t j = 0; j < level_count; j++) {
-            uint32_t level = mem_barrier->subresourceRange.baseMipLevel + j;
-            for (uint32_t k = 0; k < layer_count; k++) {
-                uint32_t layer = mem_barrier->subresourceRange.baseArrayLayer + k;
-                TransitionImageAspectLayout(device_data, pCB, mem_barrier, level, layer, VK_IMAGE_ASPECT_COLOR_BIT);
-                TransitionImageAspectLayout(device_data, pCB, mem_barrier, level, layer, VK_IMAGE_ASPECT_DEPTH_BIT);
-                TransitionImageAspectLayout(device_data, pCB, mem_barrier, level, layer, VK_IMAGE_ASPECT_STENCIL_BIT);
-                TransitionImageAspectLayout(device_data, pCB, mem_barrier, level, layer, VK_IMAGE_ASPECT_METADATA_BIT);
-                if (GetDeviceExtensions(device_data)->vk_khr_sampler_ycbcr_conversion) {
-                    TransitionImageAspectLayout(device_data, pCB, mem_barrier, level, layer, VK_IMAGE_ASPECT_PLANE_0_BIT_KHR);
-                    TransitionImageAspectLayout(device_data, pCB, mem_barrier, level, layer, VK_IMAGE_ASPECT_PLANE_1_BIT_KHR);
-                    TransitionImageAspectLayout(device_data, pCB, mem_barrier, level, layer, VK_IMAGE_ASPECT_PLANE_2_BIT_KHR);
-                }
-            }
+        bool first_use = false;
+        UpdateCmdBufLayouts(device_data, pCB, image_state, range,
+                            [mem_barrier, &first_use](const IMAGE_CMD_BUF_LAYOUT_NODE *current) -> IMAGE_CMD_BUF_LAYOUT_NODE {
+                                if (current) return IMAGE_CMD_BUF_LAYOUT_NODE(current->initialLayout, mem_barrier->newLayout);
+                                first_use = true;
+                                return IMAGE_CMD_BUF_LAYOUT_NODE(mem_barrier->oldLayout, mem_barrier->newLayout);
+                            });
+        if (first_use) {
+            pCB->image_layout_change_count++;  // Change the version of this data to force revalidation
         }
     }
 }
@@ -618,22 +411,19 @@ bool VerifyImageLayout(layer_data const *device_data, GLOBAL_CB_NODE const *cb_n
     const auto image = image_state->image;
     bool skip = false;
 
-    for (uint32_t i = 0; i < subLayers.layerCount; ++i) {
-        uint32_t layer = i + subLayers.baseArrayLayer;
-        VkImageSubresource sub = {subLayers.aspectMask, subLayers.mipLevel, layer};
-        IMAGE_CMD_BUF_LAYOUT_NODE node;
-        if (FindCmdBufLayout(device_data, cb_node, image, sub, node)) {
-            if (node.layout != explicit_layout) {
-                *error = true;
-                // TODO: Improve log message in the next pass
-                skip |= log_msg(
-                    report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT,
-                    HandleToUint64(cb_node->commandBuffer), __LINE__, DRAWSTATE_INVALID_IMAGE_LAYOUT, "DS",
-                    "%s: Cannot use image 0x%" PRIx64 " with specific layout %s that doesn't match the actual current layout %s.",
-                    caller, HandleToUint64(image), string_VkImageLayout(explicit_layout), string_VkImageLayout(node.layout));
-            }
+    const VkImageSubresourceRange range = {subLayers.aspectMask, subLayers.mipLevel, 1, subLayers.baseArrayLayer,
+                                           subLayers.layerCount};
+    ForEachCmdBufLayout(device_data, cb_node, image, range, [&](const VkImageSubresource &, const IMAGE_CMD_BUF_LAYOUT_NODE &node) {
+        if (node.layout != explicit_layout) {
+            *error = true;
+            // TODO: Improve log message in the next pass
+            skip |= log_msg(
+                report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT,
+                HandleToUint64(cb_node->commandBuffer), __LINE__, DRAWSTATE_INVALID_IMAGE_LAYOUT, "DS",
+                "%s: Cannot use image 0x%" PRIx64 " with specific layout %s that doesn't match the actual current layout %s.",
+                caller, HandleToUint64(image), string_VkImageLayout(explicit_layout), string_VkImageLayout(node.layout));
         }
-    }
+    });
     // If optimal_layout is not UNDEFINED, check that layout matches optimal for this case
     if ((VK_IMAGE_LAYOUT_UNDEFINED != optimal_layout) && (explicit_layout != optimal_layout)) {
         if (VK_IMAGE_LAYOUT_GENERAL == explicit_layout) {
@@ -930,10 +720,9 @@ void PostCallRecordCreateImage(layer_data *device_data, const VkImageCreateInfo
     IMAGE_LAYOUT_NODE image_state;
     image_state.layout = pCreateInfo->initialLayout;
     image_state.format = pCreateInfo->format;
-    GetImageMap(device_data)->insert(std::make_pair(*pImage, std::unique_ptr<IMAGE_STATE>(new IMAGE_STATE(*pImage, pCreateInfo))));
-    ImageSubresourcePair subpair{*pImage, false, VkImageSubresource()};
-    (*core_validation::GetImageSubresourceMap(device_data))[*pImage].push_back(subpair);
-    (*core_validation::GetImageLayoutMap(device_data))[subpair] = image_state;
+    image_state.subresource_layouts.subresource_index = ImageSubresourceIndex(*pCreateInfo);
+    GetImageMap(device_data)->insert(*pImage, std::unique_ptr<IMAGE_STATE>(new IMAGE_STATE(*pImage, pCreateInfo)));
+    (*core_validation::GetImageLayoutMap(device_data))[*pImage] = std::move(image_state);
 }
 
 bool PreCallValidateDestroyImage(layer_data *device_data, VkImage image, IMAGE_STATE **image_state, VK_OBJECT *obj_struct) {
@@ -961,16 +750,7 @@ void PostCallRecordDestroyImage(layer_data *device_data, VkImage image, IMAGE_ST
     core_validation::ClearMemoryObjectBindings(device_data, obj_struct.handle, kVulkanObjectTypeImage);
     // Remove image from imageMap
     core_validation::GetImageMap(device_data)->erase(image);
-    std::unordered_map<VkImage, std::vector<ImageSubresourcePair>> *imageSubresourceMap =
-        core_validation::GetImageSubresourceMap(device_data);
-
-    const auto &sub_entry = imageSubresourceMap->find(image);
-    if (sub_entry != imageSubresourceMap->end()) {
-        for (const auto &pair : sub_entry->second) {
-            core_validation::GetImageLayoutMap(device_data)->erase(pair);
-        }
-        imageSubresourceMap->erase(sub_entry);
-    }
+    core_validation::GetImageLayoutMap(device_data)->erase(image);
 }
 
 bool ValidateImageAttributes(layer_data *device_data, IMAGE_STATE *image_state, VkImageSubresourceRange range) {
@@ -1027,8 +807,8 @@ bool VerifyClearImageLayout(layer_data *device_data, GLOBAL_CB_NODE *cb_node, IM
     bool skip = false;
     const debug_report_data *report_data = core_validation::GetReportData(device_data);
 
-    uint32_t level_count = ResolveRemainingLevels(&range, image_state->createInfo.mipLevels);
-    uint32_t layer_count = ResolveRemainingLayers(&range, image_state->createInfo.arrayLayers);
+    range.levelCount = ResolveRemainingLevels(&range, image_state->createInfo.mipLevels);
+    range.layerCount = ResolveRemainingLayers(&range, image_state->createInfo.arrayLayers);
 
     if (dest_image_layout != VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL) {
         if (dest_image_layout == VK_IMAGE_LAYOUT_GENERAL) {
@@ -1069,50 +849,39 @@ bool VerifyClearImageLayout(layer_data *device_data, GLOBAL_CB_NODE *cb_node, IM
         }
     }
 
-    for (uint32_t level_index = 0; level_index < level_count; ++level_index) {
-        uint32_t level = level_index + range.baseMipLevel;
-        for (uint32_t layer_index = 0; layer_index < layer_count; ++layer_index) {
-            uint32_t layer = layer_index + range.baseArrayLayer;
-            VkImageSubresource sub = {range.aspectMask, level, layer};
-            IMAGE_CMD_BUF_LAYOUT_NODE node;
-            if (FindCmdBufLayout(device_data, cb_node, image_state->image, sub, node)) {
-                if (node.layout != dest_image_layout) {
-                    UNIQUE_VALIDATION_ERROR_CODE error_code = VALIDATION_ERROR_18800008;
-                    if (strcmp(func_name, "vkCmdClearDepthStencilImage()") == 0) {
-                        error_code = VALIDATION_ERROR_18a00016;
-                    } else {
-                        assert(strcmp(func_name, "vkCmdClearColorImage()") == 0);
-                    }
-                    skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT, 0,
+    ForEachCmdBufLayout(device_data, cb_node, image_state->image, range,
+                        [&](const VkImageSubresource &, const IMAGE_CMD_BUF_LAYOUT_NODE &node) {
+                            if (node.layout != dest_image_layout) {
+                                UNIQUE_VALIDATION_ERROR_CODE error_code = VALIDATION_ERROR_18800008;
+                                if (strcmp(func_name, "vkCmdClearDepthStencilImage()") == 0) {
+                                    error_code = VALIDATION_ERROR_18a00016;
+                                } else {
+                                    assert(strcmp(func_name, "vkCmdClearColorImage()") == 0);
+                                }
+                                skip |= log_msg(
+                                    report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT, 0,
                                     __LINE__, error_code, "DS",
                                     "%s: Cannot clear an image whose layout is %s and doesn't match the current layout %s. %s",
                                     func_name, string_VkImageLayout(dest_image_layout), string_VkImageLayout(node.layout),
                                     validation_error_map[error_code]);
-                }
-            }
-        }
-    }
+                            }
+                        });
 
     return skip;
 }
 
 void RecordClearImageLayout(layer_data *device_data, GLOBAL_CB_NODE *cb_node, VkImage image, VkImageSubresourceRange range,
                             VkImageLayout dest_image_layout) {
-    VkImageCreateInfo *image_create_info = &(GetImageState(device_data, image)->createInfo);
-    uint32_t level_count = ResolveRemainingLevels(&range, image_create_info->mipLevels);
-    uint32_t layer_count = ResolveRemainingLayers(&range, image_create_info->arrayLayers);
-
-    for (uint32_t level_index = 0; level_index < level_count; ++level_index) {
-        uint32_t level = level_index + range.baseMipLevel;
-        for (uint32_t layer_index = 0; layer_index < layer_count; ++layer_index) {
-            uint32_t layer = layer_index + range.baseArrayLayer;
-            VkImageSubresource sub = {range.aspectMask, level, layer};
-            IMAGE_CMD_BUF_LAYOUT_NODE node;
-            if (!FindCmdBufLayout(device_data, cb_node, image, sub, node)) {
-                SetLayout(device_data, cb_node, image, sub, IMAGE_CMD_BUF_LAYOUT_NODE(dest_image_layout, dest_image_layout));
-            }
-        }
-    }
+    auto image_state = GetImageState(device_data, image);
+    range.levelCount = ResolveRemainingLevels(&range, image_state->createInfo.mipLevels);
+    range.layerCount = ResolveRemainingLayers(&range, image_state->createInfo.arrayLayers);
+
+    // Only subresources the command buffer has not used yet get a layout from the clear
+    UpdateCmdBufLayouts(device_data, cb_node, image_state, range,
+                        [dest_image_layout](const IMAGE_CMD_BUF_LAYOUT_NODE *current) -> IMAGE_CMD_BUF_LAYOUT_NODE {
+                            if (current) return *current;
+                            return IMAGE_CMD_BUF_LAYOUT_NODE(dest_image_layout, dest_image_layout);
+                        });
 }
 
 bool PreCallValidateCmdClearColorImage(layer_data *dev_data, VkCommandBuffer commandBuffer, VkImage image,
@@ -1144,11 +913,10 @@ void PreCallRecordCmdClearImage(layer_data *dev_data, VkCommandBuffer commandBuf
     auto image_state = GetImageState(dev_data, image);
     if (cb_node && image_state) {
         AddCommandBufferBindingImage(dev_data, cb_node, image_state);
-        std::function<bool()> function = [=]() {
+        cb_node->queue_submit_functions.emplace_back([=]() {
             SetImageMemoryValid(dev_data, image_state, true);
             return false;
-        };
-        cb_node->queue_submit_functions.push_back(function);
+        });
         for (uint32_t i = 0; i < rangeCount; ++i) {
             RecordClearImageLayout(dev_data, cb_node, image, pRanges[i], imageLayout);
         }
@@ -2081,13 +1849,12 @@ void PreCallRecordCmdCopyImage(layer_data *device_data, GLOBAL_CB_NODE *cb_node,
     // Update bindings between images and cmd buffer
     AddCommandBufferBindingImage(device_data, cb_node, src_image_state);
     AddCommandBufferBindingImage(device_data, cb_node, dst_image_state);
-    std::function<bool()> function = [=]() { return ValidateImageMemoryIsValid(device_data, src_image_state, "vkCmdCopyImage()"); };
-    cb_node->queue_submit_functions.push_back(function);
-    function = [=]() {
+    cb_node->queue_submit_functions.emplace_back(
+        [=]() { return ValidateImageMemoryIsValid(device_data, src_image_state, "vkCmdCopyImage()"); });
+    cb_node->queue_submit_functions.emplace_back([=]() {
         SetImageMemoryValid(device_data, dst_image_state, true);
         return false;
-    };
-    cb_node->queue_submit_functions.push_back(function);
+    });
 }
 
 // Returns true if sub_rect is entirely contained within rect
@@ -2294,15 +2061,13 @@ void PreCallRecordCmdResolveImage(layer_data *device_data, GLOBAL_CB_NODE *cb_no
     AddCommandBufferBindingImage(device_data, cb_node, src_image_state);
     AddCommandBufferBindingImage(device_data, cb_node, dst_image_state);
 
-    std::function<bool()> function = [=]() {
+    cb_node->queue_submit_functions.emplace_back([=]() {
         return ValidateImageMemoryIsValid(device_data, src_image_state, "vkCmdResolveImage()");
-    };
-    cb_node->queue_submit_functions.push_back(function);
-    function = [=]() {
+    });
+    cb_node->queue_submit_functions.emplace_back([=]() {
         SetImageMemoryValid(device_data, dst_image_state, true);
         return false;
-    };
-    cb_node->queue_submit_functions.push_back(function);
+    });
 }
 
 bool PreCallValidateCmdBlitImage(layer_data *device_data, GLOBAL_CB_NODE *cb_node, IMAGE_STATE *src_image_state,
@@ -2695,59 +2460,68 @@ void PreCallRecordCmdBlitImage(layer_data *device_data, GLOBAL_CB_NODE *cb_node,
     AddCommandBufferBindingImage(device_data, cb_node, src_image_state);
     AddCommandBufferBindingImage(device_data, cb_node, dst_image_state);
 
-    std::function<bool()> function = [=]() { return ValidateImageMemoryIsValid(device_data, src_image_state, "vkCmdBlitImage()"); };
-    cb_node->queue_submit_functions.push_back(function);
-    function = [=]() {
+    cb_node->queue_submit_functions.emplace_back(
+        [=]() { return ValidateImageMemoryIsValid(device_data, src_image_state, "vkCmdBlitImage()"); });
+    cb_node->queue_submit_functions.emplace_back([=]() {
         SetImageMemoryValid(device_data, dst_image_state, true);
         return false;
-    };
-    cb_node->queue_submit_functions.push_back(function);
+    });
 }
 
 // This validates that the initial layout specified in the command buffer for
 // the IMAGE is the same
 // as the global IMAGE layout
 bool ValidateCmdBufImageLayouts(layer_data *device_data, GLOBAL_CB_NODE *pCB,
-                                std::unordered_map<ImageSubresourcePair, IMAGE_LAYOUT_NODE> const &globalImageLayoutMap,
-                                std::unordered_map<ImageSubresourcePair, IMAGE_LAYOUT_NODE> &overlayLayoutMap) {
+                                std::unordered_map<VkImage, IMAGE_LAYOUT_NODE> const &globalImageLayoutMap,
+                                std::unordered_map<VkImage, IMAGE_LAYOUT_NODE> &overlayLayoutMap) {
     bool skip = false;
     const debug_report_data *report_data = core_validation::GetReportData(device_data);
-    for (auto cb_image_data : pCB->imageLayoutMap) {
-        VkImageLayout imageLayout;
-
-        if (FindLayout(device_data, overlayLayoutMap, cb_image_data.first, imageLayout) ||
-            FindLayout(device_data, globalImageLayoutMap, cb_image_data.first, imageLayout)) {
-            if (cb_image_data.second.initialLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
-                // TODO: Set memory invalid which is in mem_tracker currently
-            } else if (imageLayout != cb_image_data.second.initialLayout) {
-                if (cb_image_data.first.hasSubresource) {
+    for (const auto &cb_image_layouts : pCB->imageLayoutMap) {
+        const VkImage image = cb_image_layouts.first;
+        auto global_layout = globalImageLayoutMap.find(image);
+        if (global_layout == globalImageLayoutMap.end()) continue;
+        // The overlay holds the layouts left by the command buffers ahead of this one in the same submission
+        auto &overlay_ranges = overlayLayoutMap[image].subresource_layouts.ranges;
+        const ImageSubresourceIndex &subresource_index = cb_image_layouts.second.subresource_index;
+        for (const auto &cb_range : cb_image_layouts.second.ranges) {
+            const IMAGE_CMD_BUF_LAYOUT_NODE &cb_layout = cb_range.value;
+            auto check_layout = [&](uint64_t begin, uint64_t, VkImageLayout imageLayout) {
+                if (cb_layout.initialLayout == VK_IMAGE_LAYOUT_UNDEFINED) {
+                    // TODO: Set memory invalid which is in mem_tracker currently
+                } else if (imageLayout != cb_layout.initialLayout) {
+                    const VkImageSubresource subresource = subresource_index.Decode(begin);
                     skip |= log_msg(
                         report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT,
                         HandleToUint64(pCB->commandBuffer), __LINE__, DRAWSTATE_INVALID_IMAGE_LAYOUT, "DS",
                         "Cannot submit cmd buffer using image (0x%" PRIx64
                         ") [sub-resource: aspectMask 0x%X array layer %u, mip level %u], with layout %s when first use is %s.",
-                        HandleToUint64(cb_image_data.first.image), cb_image_data.first.subresource.aspectMask,
-                        cb_image_data.first.subresource.arrayLayer, cb_image_data.first.subresource.mipLevel,
-                        string_VkImageLayout(imageLayout), string_VkImageLayout(cb_image_data.second.initialLayout));
-                } else {
-                    skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT,
-                                    HandleToUint64(pCB->commandBuffer), __LINE__, DRAWSTATE_INVALID_IMAGE_LAYOUT, "DS",
-                                    "Cannot submit cmd buffer using image (0x%" PRIx64 ") with layout %s when first use is %s.",
-                                    HandleToUint64(cb_image_data.first.image), string_VkImageLayout(imageLayout),
-                                    string_VkImageLayout(cb_image_data.second.initialLayout));
+                        HandleToUint64(image), subresource.aspectMask, subresource.arrayLayer, subresource.mipLevel,
+                        string_VkImageLayout(imageLayout), string_VkImageLayout(cb_layout.initialLayout));
                 }
-            }
-            SetLayout(overlayLayoutMap, cb_image_data.first, cb_image_data.second.layout);
+            };
+            // Prefer the overlay's layouts, falling back to the global ones where it has none
+            uint64_t cursor = cb_range.begin;
+            overlay_ranges.for_each(cb_range.begin, cb_range.end, [&](uint64_t begin, uint64_t end, VkImageLayout imageLayout) {
+                if (cursor < begin) ForEachImageLayout(global_layout->second, cursor, begin, check_layout);
+                check_layout(begin, end, imageLayout);
+                cursor = end;
+            });
+            if (cursor < cb_range.end) ForEachImageLayout(global_layout->second, cursor, cb_range.end, check_layout);
+            overlay_ranges.insert_or_assign(cb_range.begin, cb_range.end, cb_layout.layout);
         }
     }
     return skip;
 }
 
 void UpdateCmdBufImageLayouts(layer_data *device_data, GLOBAL_CB_NODE *pCB) {
-    for (auto cb_image_data : pCB->imageLayoutMap) {
-        VkImageLayout imageLayout;
-        FindGlobalLayout(device_data, cb_image_data.first, imageLayout);
-        SetGlobalLayout(device_data, cb_image_data.first, cb_image_data.second.layout);
+    auto image_layout_map = core_validation::GetImageLayoutMap(device_data);
+    for (const auto &cb_image_layouts : pCB->imageLayoutMap) {
+        auto global_layout = image_layout_map->find(cb_image_layouts.first);
+        if (global_layout == image_layout_map->end()) continue;
+        auto &global_ranges = global_layout->second.subresource_layouts.ranges;
+        for (const auto &cb_range : cb_image_layouts.second.ranges) {
+            global_ranges.insert_or_assign(cb_range.begin, cb_range.end, cb_range.value.layout);
+        }
     }
 }
 
@@ -3119,8 +2893,7 @@ bool PreCallValidateCreateBuffer(layer_data *device_data, const VkBufferCreateIn
 
 void PostCallRecordCreateBuffer(layer_data *device_data, const VkBufferCreateInfo *pCreateInfo, VkBuffer *pBuffer) {
     // TODO : This doesn't create deep copy of pQueueFamilyIndices so need to fix that if/when we want that data to be valid
-    GetBufferMap(device_data)
-        ->insert(std::make_pair(*pBuffer, std::unique_ptr<BUFFER_STATE>(new BUFFER_STATE(*pBuffer, pCreateInfo))));
+    GetBufferMap(device_data)->insert(*pBuffer, std::unique_ptr<BUFFER_STATE>(new BUFFER_STATE(*pBuffer, pCreateInfo)));
 }
 
 bool PreCallValidateCreateBufferView(layer_data *device_data, const VkBufferViewCreateInfo *pCreateInfo) {
@@ -3539,11 +3312,11 @@ bool PreCallValidateCreateImageView(layer_data *device_data, const VkImageViewCr
 }
 
 void PostCallRecordCreateImageView(layer_data *device_data, const VkImageViewCreateInfo *create_info, VkImageView view) {
-    auto image_view_map = GetImageViewMap(device_data);
-    (*image_view_map)[view] = std::unique_ptr<IMAGE_VIEW_STATE>(new IMAGE_VIEW_STATE(view, create_info));
+    auto image_view_state = new IMAGE_VIEW_STATE(view, create_info);
+    GetImageViewMap(device_data)->insert_or_assign(view, std::unique_ptr<IMAGE_VIEW_STATE>(image_view_state));
 
     auto image_state = GetImageState(device_data, create_info->image);
-    auto &sub_res_range = (*image_view_map)[view].get()->create_info.subresourceRange;
+    auto &sub_res_range = image_view_state->create_info.subresourceRange;
     sub_res_range.levelCount = ResolveRemainingLevels(&sub_res_range, image_state->createInfo.mipLevels);
     sub_res_range.layerCount = ResolveRemainingLayers(&sub_res_range, image_state->createInfo.arrayLayers);
 }
@@ -3571,15 +3344,13 @@ void PreCallRecordCmdCopyBuffer(layer_data *device_data, GLOBAL_CB_NODE *cb_node
     AddCommandBufferBindingBuffer(device_data, cb_node, src_buffer_state);
     AddCommandBufferBindingBuffer(device_data, cb_node, dst_buffer_state);
 
-    std::function<bool()> function = [=]() {
+    cb_node->queue_submit_functions.emplace_back([=]() {
         return ValidateBufferMemoryIsValid(device_data, src_buffer_state, "vkCmdCopyBuffer()");
-    };
-    cb_node->queue_submit_functions.push_back(function);
-    function = [=]() {
+    });
+    cb_node->queue_submit_functions.emplace_back([=]() {
         SetBufferMemoryValid(device_data, dst_buffer_state, true);
         return false;
-    };
-    cb_node->queue_submit_functions.push_back(function);
+    });
 }
 
 static bool validateIdleBuffer(layer_data *device_data, VkBuffer buffer) {
@@ -3678,11 +3449,10 @@ bool PreCallValidateCmdFillBuffer(layer_data *device_data, GLOBAL_CB_NODE *cb_no
 }
 
 void PreCallRecordCmdFillBuffer(layer_data *device_data, GLOBAL_CB_NODE *cb_node, BUFFER_STATE *buffer_state) {
-    std::function<bool()> function = [=]() {
+    cb_node->queue_submit_functions.emplace_back([=]() {
         SetBufferMemoryValid(device_data, buffer_state, true);
         return false;
-    };
-    cb_node->queue_submit_functions.push_back(function);
+    });
     // Update bindings between buffer and cmd buffer
     AddCommandBufferBindingBuffer(device_data, cb_node, buffer_state);
 }
@@ -4040,15 +3810,13 @@ void PreCallRecordCmdCopyImageToBuffer(layer_data *device_data, GLOBAL_CB_NODE *
     AddCommandBufferBindingImage(device_data, cb_node, src_image_state);
     AddCommandBufferBindingBuffer(device_data, cb_node, dst_buffer_state);
 
-    std::function<bool()> function = [=]() {
+    cb_node->queue_submit_functions.emplace_back([=]() {
         return ValidateImageMemoryIsValid(device_data, src_image_state, "vkCmdCopyImageToBuffer()");
-    };
-    cb_node->queue_submit_functions.push_back(function);
-    function = [=]() {
+    });
+    cb_node->queue_submit_functions.emplace_back([=]() {
         SetBufferMemoryValid(device_data, dst_buffer_state, true);
         return false;
-    };
-    cb_node->queue_submit_functions.push_back(function);
+    });
 }
 
 bool PreCallValidateCmdCopyBufferToImage(layer_data *device_data, VkImageLayout dstImageLayout, GLOBAL_CB_NODE *cb_node,
@@ -4103,13 +3871,12 @@ void PreCallRecordCmdCopyBufferToImage(layer_data *device_data, GLOBAL_CB_NODE *
     }
     AddCommandBufferBindingBuffer(device_data, cb_node, src_buffer_state);
     AddCommandBufferBindingImage(device_data, cb_node, dst_image_state);
-    std::function<bool()> function = [=]() {
+    cb_node->queue_submit_functions.emplace_back([=]() {
         SetImageMemoryValid(device_data, dst_image_state, true);
         return false;
-    };
-    cb_node->queue_submit_functions.push_back(function);
-    function = [=]() { return ValidateBufferMemoryIsValid(device_data, src_buffer_state, "vkCmdCopyBufferToImage()"); };
-    cb_node->queue_submit_functions.push_back(function);
+    });
+    cb_node->queue_submit_functions.emplace_back(
+        [=]() { return ValidateBufferMemoryIsValid(device_data, src_buffer_state, "vkCmdCopyBufferToImage()"); });
 }
 
 bool PreCallValidateGetImageSubresourceLayout(layer_data *device_data, VkImage image, const VkImageSubresource *pSubresource) {
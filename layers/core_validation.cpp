@@ -39,6 +39,8 @@
 #include <algorithm>
 #include <array>
 #include <assert.h>
+#include <condition_variable>
+#include <deque>
 #include <iostream>
 #include <list>
 #include <map>
@@ -50,6 +52,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <string>
+#include <thread>
 #include <valarray>
 #include <inttypes.h>
 
@@ -69,6 +72,9 @@
 #include "vk_layer_data.h"
 #include "vk_layer_extension_utils.h"
 #include "vk_layer_utils.h"
+#include "vk_layer_concurrent_map.h"
+#include "vk_layer_shared_mutex.h"
+#include "vk_layer_thread_pool.h"
 #include "vk_typemap_helper.h"
 
 #if defined __ANDROID__
@@ -85,10 +91,6 @@
 // This intentionally includes a cpp file
 #include "vk_safe_struct.cpp"
 
-using mutex_t = std::mutex;
-using lock_guard_t = std::lock_guard<mutex_t>;
-using unique_lock_t = std::unique_lock<mutex_t>;
-
 namespace core_validation {
 
 using std::max;
@@ -116,6 +118,7 @@ struct instance_layer_data {
     CALL_STATE vkEnumeratePhysicalDeviceGroupsState = UNCALLED;
     uint32_t physical_device_groups_count = 0;
     CHECK_DISABLED disabled = {};
+    CORE_VALIDATION_SETTINGS settings;
 
     unordered_map<VkPhysicalDevice, PHYSICAL_DEVICE_STATE> physical_device_map;
     unordered_map<VkSurfaceKHR, SURFACE_STATE> surface_map;
@@ -130,32 +133,34 @@ struct layer_data {
     DeviceExtensions extensions = {};
     unordered_set<VkQueue> queues;  // All queues under given device
     // Layer specific data
-    unordered_map<VkSampler, unique_ptr<SAMPLER_STATE>> samplerMap;
-    unordered_map<VkImageView, unique_ptr<IMAGE_VIEW_STATE>> imageViewMap;
-    unordered_map<VkImage, unique_ptr<IMAGE_STATE>> imageMap;
-    unordered_map<VkBufferView, unique_ptr<BUFFER_VIEW_STATE>> bufferViewMap;
-    unordered_map<VkBuffer, unique_ptr<BUFFER_STATE>> bufferMap;
-    unordered_map<VkPipeline, unique_ptr<PIPELINE_STATE>> pipelineMap;
-    unordered_map<VkCommandPool, COMMAND_POOL_NODE> commandPoolMap;
-    unordered_map<VkDescriptorPool, DESCRIPTOR_POOL_STATE *> descriptorPoolMap;
-    unordered_map<VkDescriptorSet, cvdescriptorset::DescriptorSet *> setMap;
-    unordered_map<VkDescriptorSetLayout, std::shared_ptr<cvdescriptorset::DescriptorSetLayout>> descriptorSetLayoutMap;
-    unordered_map<VkPipelineLayout, PIPELINE_LAYOUT_NODE> pipelineLayoutMap;
-    unordered_map<VkDeviceMemory, unique_ptr<DEVICE_MEM_INFO>> memObjMap;
-    unordered_map<VkFence, FENCE_NODE> fenceMap;
-    unordered_map<VkQueue, QUEUE_STATE> queueMap;
-    unordered_map<VkEvent, EVENT_STATE> eventMap;
+    // Handle -> state maps are read on nearly every call and written only at create/destroy time, so they can be
+    // searched without global_lock (see vk_layer_concurrent_map.h)
+    vl_concurrent_unordered_map<VkSampler, unique_ptr<SAMPLER_STATE>> samplerMap;
+    vl_concurrent_unordered_map<VkImageView, unique_ptr<IMAGE_VIEW_STATE>> imageViewMap;
+    vl_concurrent_unordered_map<VkImage, unique_ptr<IMAGE_STATE>> imageMap;
+    vl_concurrent_unordered_map<VkBufferView, unique_ptr<BUFFER_VIEW_STATE>> bufferViewMap;
+    vl_concurrent_unordered_map<VkBuffer, unique_ptr<BUFFER_STATE>> bufferMap;
+    vl_concurrent_unordered_map<VkPipeline, unique_ptr<PIPELINE_STATE>> pipelineMap;
+    vl_concurrent_unordered_map<VkCommandPool, COMMAND_POOL_NODE> commandPoolMap;
+    vl_concurrent_unordered_map<VkDescriptorPool, DESCRIPTOR_POOL_STATE *> descriptorPoolMap;
+    vl_concurrent_unordered_map<VkDescriptorSet, cvdescriptorset::DescriptorSet *> setMap;
+    vl_concurrent_unordered_map<VkDescriptorSetLayout, std::shared_ptr<cvdescriptorset::DescriptorSetLayout>>
+        descriptorSetLayoutMap;
+    vl_concurrent_unordered_map<VkPipelineLayout, PIPELINE_LAYOUT_NODE> pipelineLayoutMap;
+    vl_concurrent_unordered_map<VkDeviceMemory, unique_ptr<DEVICE_MEM_INFO>> memObjMap;
+    vl_concurrent_unordered_map<VkFence, FENCE_NODE> fenceMap;
+    vl_concurrent_unordered_map<VkQueue, QUEUE_STATE> queueMap;
+    vl_concurrent_unordered_map<VkEvent, EVENT_STATE> eventMap;
     unordered_map<QueryObject, bool> queryToStateMap;
-    unordered_map<VkQueryPool, QUERY_POOL_NODE> queryPoolMap;
-    unordered_map<VkSemaphore, SEMAPHORE_NODE> semaphoreMap;
-    unordered_map<VkCommandBuffer, GLOBAL_CB_NODE *> commandBufferMap;
-    unordered_map<VkFramebuffer, unique_ptr<FRAMEBUFFER_STATE>> frameBufferMap;
-    unordered_map<VkImage, vector<ImageSubresourcePair>> imageSubresourceMap;
-    unordered_map<ImageSubresourcePair, IMAGE_LAYOUT_NODE> imageLayoutMap;
-    unordered_map<VkRenderPass, std::shared_ptr<RENDER_PASS_STATE>> renderPassMap;
-    unordered_map<VkShaderModule, unique_ptr<shader_module>> shaderModuleMap;
-    unordered_map<VkDescriptorUpdateTemplateKHR, unique_ptr<TEMPLATE_STATE>> desc_template_map;
-    unordered_map<VkSwapchainKHR, std::unique_ptr<SWAPCHAIN_NODE>> swapchainMap;
+    vl_concurrent_unordered_map<VkQueryPool, QUERY_POOL_NODE> queryPoolMap;
+    vl_concurrent_unordered_map<VkSemaphore, SEMAPHORE_NODE> semaphoreMap;
+    vl_concurrent_unordered_map<VkCommandBuffer, GLOBAL_CB_NODE *> commandBufferMap;
+    vl_concurrent_unordered_map<VkFramebuffer, unique_ptr<FRAMEBUFFER_STATE>> frameBufferMap;
+    unordered_map<VkImage, IMAGE_LAYOUT_NODE> imageLayoutMap;
+    vl_concurrent_unordered_map<VkRenderPass, std::shared_ptr<RENDER_PASS_STATE>> renderPassMap;
+    vl_concurrent_unordered_map<VkShaderModule, unique_ptr<shader_module>> shaderModuleMap;
+    vl_concurrent_unordered_map<VkDescriptorUpdateTemplateKHR, unique_ptr<TEMPLATE_STATE>> desc_template_map;
+    vl_concurrent_unordered_map<VkSwapchainKHR, std::unique_ptr<SWAPCHAIN_NODE>> swapchainMap;
 
     VkDevice device = VK_NULL_HANDLE;
     VkPhysicalDevice physical_device = VK_NULL_HANDLE;
@@ -173,11 +178,25 @@ struct layer_data {
     };
     DeviceExtensionProperties phys_dev_ext_props = {};
     bool external_sync_warning = false;
+    // Draw and dispatch calls validated, and how many of them skipped ValidateDrawState because nothing it checks had
+    // changed since the previous clean draw; the hit rate is reported when the device is destroyed
+    std::atomic<uint64_t> draw_validation_count{0};
+    std::atomic<uint64_t> draw_validation_skips{0};
+    // Validates the pipelines of a vkCreate*Pipelines batch concurrently; null unless pipeline_validation_threads asks for
+    // more than one thread
+    std::unique_ptr<vl_thread_pool> pipeline_validation_pool;
+    // Shader modules known to pass spirv-val, loaded from validation_cache_file and written back to it at DestroyDevice;
+    // null unless the setting names a file
+    std::unique_ptr<ValidationCache> implicit_validation_cache;
+    size_t implicit_validation_cache_loaded_size = 0;
+    // spirv-val context, and background workers if async_shader_module_validation is on; null with shader validation
+    // disabled
+    std::unique_ptr<spirv_validator> spirv_validation;
 };
 
-// TODO : Do we need to guard access to layer_data_map w/ lock?
-static unordered_map<void *, layer_data *> layer_data_map;
-static unordered_map<void *, instance_layer_data *> instance_layer_data_map;
+// Looked up lock-free on every call, from any thread; see vl_layer_data_map
+static vl_layer_data_map<layer_data> layer_data_map;
+static vl_layer_data_map<instance_layer_data> instance_layer_data_map;
 
 static uint32_t loader_layer_if_version = CURRENT_LOADER_LAYER_INTERFACE_VERSION;
 
@@ -206,104 +225,285 @@ void ValidateLayerOrdering(const TCreateInfo &createInfo) {
     }
 }
 
+static void RunQueuedSubmitValidation();
+
+// Device-wide lock.  Taking it exclusively first finishes validating any vkQueueSubmit calls still queued for the async
+// submit worker (see AsyncSubmitQueue), so that every call that could observe or change the state those submissions touch
+// sees them fully validated and recorded.  Shared ownership, used only for command buffer recording, skips this.
+class global_mutex_t : public SharedMutex {
+   public:
+    void lock() {
+        SharedMutex::lock();
+        RunQueuedSubmitValidation();
+    }
+};
+
+using mutex_t = global_mutex_t;
+using lock_guard_t = std::lock_guard<mutex_t>;
+using unique_lock_t = std::unique_lock<mutex_t>;
+
 // TODO : This can be much smarter, using separate locks for separate global data
 static mutex_t global_lock;
 
+// With lunarg_core_validation.async_submit_validation enabled, vkQueueSubmit snapshots its arguments, passes the call down
+// the chain straight away and queues the snapshot here.  A worker thread then runs PreCallValidateQueueSubmit and
+// PostCallRecordQueueSubmit for each queued submission in order, under global_lock just like the synchronous path, and any
+// errors go out through the usual debug report callbacks.  As the call has already been made by then, errors can no
+// longer keep it from reaching the driver.
+//
+// Every exclusive acquisition of global_lock runs whatever is still queued first, which makes fence waits,
+// vkQueueWaitIdle, vkDeviceWaitIdle, command buffer resets and object destruction all flush points.  At most
+// kMaxQueuedSubmits submissions are queued; beyond that vkQueueSubmit waits for the worker to catch up.
+class AsyncSubmitQueue {
+   public:
+    struct Submission {
+        layer_data *dev_data;
+        VkQueue queue;
+        VkFence fence;
+        std::vector<safe_VkSubmitInfo> submits;
+    };
+
+    AsyncSubmitQueue() : queued_(0), device_count_(0), stop_(false) {}
+    ~AsyncSubmitQueue() {
+        // Only reached with a device still alive at exit; the worker may be blocked, so leave it be rather than join it
+        if (worker_.joinable()) worker_.detach();
+    }
+
+    // Start the worker along with the first device that uses it
+    void AddDevice() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (device_count_++ == 0) {
+            stop_ = false;
+            worker_ = std::thread(&AsyncSubmitQueue::WorkerMain, this);
+        }
+    }
+
+    // Stop the worker along with the last device that uses it.  Must not be called holding global_lock.
+    void RemoveDevice() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (--device_count_ == 0) {
+            stop_ = true;
+            work_cv_.notify_one();
+            lock.unlock();
+            worker_.join();
+        }
+    }
+
+    // Must not be called holding global_lock, as it may have to wait for the worker
+    void Enqueue(Submission &&submission) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_cv_.wait(lock, [this]() { return submissions_.size() < kMaxQueuedSubmits; });
+        submissions_.push_back(std::move(submission));
+        queued_.store(submissions_.size(), std::memory_order_release);
+        work_cv_.notify_one();
+    }
+
+    // Validate and record everything queued so far.  Caller holds global_lock exclusively.
+    void RunQueued() {
+        if (queued_.load(std::memory_order_acquire) == 0) return;
+        std::deque<Submission> batch;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            batch.swap(submissions_);
+            queued_.store(0, std::memory_order_release);
+        }
+        space_cv_.notify_all();
+        for (auto &submission : batch) {
+            Validate(submission);
+        }
+    }
+
+   private:
+    static const size_t kMaxQueuedSubmits = 64;
+
+    static void Validate(const Submission &submission);
+
+    void WorkerMain() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop_) {
+            if (submissions_.empty()) {
+                work_cv_.wait(lock);
+                continue;
+            }
+            lock.unlock();
+            {
+                // Take the plain SharedMutex lock; the queue is run explicitly
+                std::lock_guard<SharedMutex> global(global_lock);
+                RunQueued();
+            }
+            lock.lock();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable space_cv_;
+    std::deque<Submission> submissions_;
+    std::atomic<size_t> queued_;  // submissions_.size(), readable without mutex_
+    std::thread worker_;
+    uint32_t device_count_;
+    bool stop_;
+};
+
+static AsyncSubmitQueue async_submit_queue;
+
+static void RunQueuedSubmitValidation() { async_submit_queue.RunQueued(); }
+
+// Lock held by the vkCmd* entry points while validating and recording into a command buffer.  By default this is just
+// exclusive ownership of global_lock.  With lunarg_core_validation.command_buffer_locking enabled, recording threads hold
+// global_lock shared and serialize only on the command buffer's own record_mutex, so that distinct command buffers can be
+// recorded in parallel.  Device-level state changed while recording (object cb_bindings, descriptor set caches) then needs
+// its own guard; everything else a Cmd* call writes belongs to the command buffer.
+class record_lock_t {
+   public:
+    record_lock_t(layer_data *dev_data, VkCommandBuffer command_buffer)
+        : per_cb_(dev_data->instance_data->settings.command_buffer_locking), cb_state_(nullptr), owns_(false) {
+        if (per_cb_) {
+            global_lock.lock_shared();
+            cb_state_ = GetCBNode(dev_data, command_buffer);
+            if (cb_state_) cb_state_->record_mutex.lock();
+            owns_ = true;
+        } else {
+            lock();
+        }
+    }
+    record_lock_t(const record_lock_t &) = delete;
+    record_lock_t &operator=(const record_lock_t &) = delete;
+    ~record_lock_t() {
+        if (owns_) unlock();
+    }
+
+    void lock() {
+        if (per_cb_) {
+            global_lock.lock_shared();
+            if (cb_state_) cb_state_->record_mutex.lock();
+        } else {
+            global_lock.lock();
+        }
+        owns_ = true;
+    }
+    void unlock() {
+        if (per_cb_) {
+            if (cb_state_) cb_state_->record_mutex.unlock();
+            global_lock.unlock_shared();
+        } else {
+            global_lock.unlock();
+        }
+        owns_ = false;
+    }
+
+   private:
+    const bool per_cb_;
+    GLOBAL_CB_NODE *cb_state_;
+    bool owns_;
+};
+
+// Striped locks guarding the cb_bindings sets of objects that several command buffers may be recording against at once
+static const size_t kCommandBufferBindingLockCount = 64;
+static std::mutex cb_binding_locks[kCommandBufferBindingLockCount];
+
+// Add cb_node to an object's cb_bindings set.  Removal only happens with global_lock held exclusively and needs no stripe.
+void InsertCommandBufferBinding(std::unordered_set<GLOBAL_CB_NODE *> *cb_bindings, GLOBAL_CB_NODE *cb_node) {
+    auto &stripe = cb_binding_locks[(reinterpret_cast<uintptr_t>(cb_bindings) >> 4) % kCommandBufferBindingLockCount];
+    std::lock_guard<std::mutex> lock(stripe);
+    cb_bindings->insert(cb_node);
+}
+
 // Return IMAGE_VIEW_STATE ptr for specified imageView or else NULL
 IMAGE_VIEW_STATE *GetImageViewState(const layer_data *dev_data, VkImageView image_view) {
     auto iv_it = dev_data->imageViewMap.find(image_view);
-    if (iv_it == dev_data->imageViewMap.end()) {
+    if (!iv_it) {
         return nullptr;
     }
-    return iv_it->second.get();
+    return iv_it->get();
 }
 // Return sampler node ptr for specified sampler or else NULL
 SAMPLER_STATE *GetSamplerState(const layer_data *dev_data, VkSampler sampler) {
     auto sampler_it = dev_data->samplerMap.find(sampler);
-    if (sampler_it == dev_data->samplerMap.end()) {
+    if (!sampler_it) {
         return nullptr;
     }
-    return sampler_it->second.get();
+    return sampler_it->get();
 }
 // Return image state ptr for specified image or else NULL
 IMAGE_STATE *GetImageState(const layer_data *dev_data, VkImage image) {
     auto img_it = dev_data->imageMap.find(image);
-    if (img_it == dev_data->imageMap.end()) {
+    if (!img_it) {
         return nullptr;
     }
-    return img_it->second.get();
+    return img_it->get();
 }
 // Return buffer state ptr for specified buffer or else NULL
 BUFFER_STATE *GetBufferState(const layer_data *dev_data, VkBuffer buffer) {
     auto buff_it = dev_data->bufferMap.find(buffer);
-    if (buff_it == dev_data->bufferMap.end()) {
+    if (!buff_it) {
         return nullptr;
     }
-    return buff_it->second.get();
+    return buff_it->get();
 }
 // Return swapchain node for specified swapchain or else NULL
 SWAPCHAIN_NODE *GetSwapchainNode(const layer_data *dev_data, VkSwapchainKHR swapchain) {
     auto swp_it = dev_data->swapchainMap.find(swapchain);
-    if (swp_it == dev_data->swapchainMap.end()) {
+    if (!swp_it) {
         return nullptr;
     }
-    return swp_it->second.get();
+    return swp_it->get();
 }
 // Return buffer node ptr for specified buffer or else NULL
 BUFFER_VIEW_STATE *GetBufferViewState(const layer_data *dev_data, VkBufferView buffer_view) {
     auto bv_it = dev_data->bufferViewMap.find(buffer_view);
-    if (bv_it == dev_data->bufferViewMap.end()) {
+    if (!bv_it) {
         return nullptr;
     }
-    return bv_it->second.get();
+    return bv_it->get();
 }
 
 FENCE_NODE *GetFenceNode(layer_data *dev_data, VkFence fence) {
     auto it = dev_data->fenceMap.find(fence);
-    if (it == dev_data->fenceMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return &it->second;
+    return it;
 }
 
 EVENT_STATE *GetEventNode(layer_data *dev_data, VkEvent event) {
     auto it = dev_data->eventMap.find(event);
-    if (it == dev_data->eventMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return &it->second;
+    return it;
 }
 
 QUERY_POOL_NODE *GetQueryPoolNode(layer_data *dev_data, VkQueryPool query_pool) {
     auto it = dev_data->queryPoolMap.find(query_pool);
-    if (it == dev_data->queryPoolMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return &it->second;
+    return it;
 }
 
 QUEUE_STATE *GetQueueState(layer_data *dev_data, VkQueue queue) {
     auto it = dev_data->queueMap.find(queue);
-    if (it == dev_data->queueMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return &it->second;
+    return it;
 }
 
 SEMAPHORE_NODE *GetSemaphoreNode(layer_data *dev_data, VkSemaphore semaphore) {
     auto it = dev_data->semaphoreMap.find(semaphore);
-    if (it == dev_data->semaphoreMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return &it->second;
+    return it;
 }
 
 COMMAND_POOL_NODE *GetCommandPoolNode(layer_data *dev_data, VkCommandPool pool) {
     auto it = dev_data->commandPoolMap.find(pool);
-    if (it == dev_data->commandPoolMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return &it->second;
+    return it;
 }
 
 PHYSICAL_DEVICE_STATE *GetPhysicalDeviceState(instance_layer_data *instance_data, VkPhysicalDevice phys) {
@@ -343,10 +543,10 @@ GLOBAL_CB_NODE *GetCBNode(layer_data const *, const VkCommandBuffer);
 //  Calls to this function should be wrapped in mutex
 DEVICE_MEM_INFO *GetMemObjInfo(const layer_data *dev_data, const VkDeviceMemory mem) {
     auto mem_it = dev_data->memObjMap.find(mem);
-    if (mem_it == dev_data->memObjMap.end()) {
+    if (!mem_it) {
         return NULL;
     }
-    return mem_it->second.get();
+    return mem_it->get();
 }
 
 static void add_mem_obj_info(layer_data *dev_data, void *object, const VkDeviceMemory mem,
@@ -429,7 +629,7 @@ void SetBufferMemoryValid(layer_data *dev_data, BUFFER_STATE *buffer_state, bool
 
 // Create binding link between given sampler and command buffer node
 void AddCommandBufferBindingSampler(GLOBAL_CB_NODE *cb_node, SAMPLER_STATE *sampler_state) {
-    sampler_state->cb_bindings.insert(cb_node);
+    InsertCommandBufferBinding(&sampler_state->cb_bindings, cb_node);
     cb_node->object_bindings.insert({HandleToUint64(sampler_state->sampler), kVulkanObjectTypeSampler});
 }
 
@@ -441,21 +641,21 @@ void AddCommandBufferBindingImage(const layer_data *dev_data, GLOBAL_CB_NODE *cb
         for (auto mem_binding : image_state->GetBoundMemory()) {
             DEVICE_MEM_INFO *pMemInfo = GetMemObjInfo(dev_data, mem_binding);
             if (pMemInfo) {
-                pMemInfo->cb_bindings.insert(cb_node);
+                InsertCommandBufferBinding(&pMemInfo->cb_bindings, cb_node);
                 // Now update CBInfo's Mem reference list
                 cb_node->memObjs.insert(mem_binding);
             }
         }
         // Now update cb binding for image
         cb_node->object_bindings.insert({HandleToUint64(image_state->image), kVulkanObjectTypeImage});
-        image_state->cb_bindings.insert(cb_node);
+        InsertCommandBufferBinding(&image_state->cb_bindings, cb_node);
     }
 }
 
 // Create binding link between given image view node and its image with command buffer node
 void AddCommandBufferBindingImageView(const layer_data *dev_data, GLOBAL_CB_NODE *cb_node, IMAGE_VIEW_STATE *view_state) {
     // First add bindings for imageView
-    view_state->cb_bindings.insert(cb_node);
+    InsertCommandBufferBinding(&view_state->cb_bindings, cb_node);
     cb_node->object_bindings.insert({HandleToUint64(view_state->image_view), kVulkanObjectTypeImageView});
     auto image_state = GetImageState(dev_data, view_state->create_info.image);
     // Add bindings for image within imageView
@@ -470,20 +670,20 @@ void AddCommandBufferBindingBuffer(const layer_data *dev_data, GLOBAL_CB_NODE *c
     for (auto mem_binding : buffer_state->GetBoundMemory()) {
         DEVICE_MEM_INFO *pMemInfo = GetMemObjInfo(dev_data, mem_binding);
         if (pMemInfo) {
-            pMemInfo->cb_bindings.insert(cb_node);
+            InsertCommandBufferBinding(&pMemInfo->cb_bindings, cb_node);
             // Now update CBInfo's Mem reference list
             cb_node->memObjs.insert(mem_binding);
         }
     }
     // Now update cb binding for buffer
     cb_node->object_bindings.insert({HandleToUint64(buffer_state->buffer), kVulkanObjectTypeBuffer});
-    buffer_state->cb_bindings.insert(cb_node);
+    InsertCommandBufferBinding(&buffer_state->cb_bindings, cb_node);
 }
 
 // Create binding link between given buffer view node and its buffer with command buffer node
 void AddCommandBufferBindingBufferView(const layer_data *dev_data, GLOBAL_CB_NODE *cb_node, BUFFER_VIEW_STATE *view_state) {
     // First add bindings for bufferView
-    view_state->cb_bindings.insert(cb_node);
+    InsertCommandBufferBinding(&view_state->cb_bindings, cb_node);
     cb_node->object_bindings.insert({HandleToUint64(view_state->buffer_view), kVulkanObjectTypeBufferView});
     auto buffer_state = GetBufferState(dev_data, view_state->create_info.buffer);
     // Add bindings for buffer within bufferView
@@ -706,59 +906,59 @@ static bool validate_status(layer_data *dev_data, GLOBAL_CB_NODE *pNode, CBStatu
 // Retrieve pipeline node ptr for given pipeline object
 static PIPELINE_STATE *getPipelineState(layer_data const *dev_data, VkPipeline pipeline) {
     auto it = dev_data->pipelineMap.find(pipeline);
-    if (it == dev_data->pipelineMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return it->second.get();
+    return it->get();
 }
 
 RENDER_PASS_STATE *GetRenderPassState(layer_data const *dev_data, VkRenderPass renderpass) {
     auto it = dev_data->renderPassMap.find(renderpass);
-    if (it == dev_data->renderPassMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return it->second.get();
+    return it->get();
 }
 
 std::shared_ptr<RENDER_PASS_STATE> GetRenderPassStateSharedPtr(layer_data const *dev_data, VkRenderPass renderpass) {
     auto it = dev_data->renderPassMap.find(renderpass);
-    if (it == dev_data->renderPassMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return it->second;
+    return *it;
 }
 
 FRAMEBUFFER_STATE *GetFramebufferState(const layer_data *dev_data, VkFramebuffer framebuffer) {
     auto it = dev_data->frameBufferMap.find(framebuffer);
-    if (it == dev_data->frameBufferMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return it->second.get();
+    return it->get();
 }
 
 std::shared_ptr<cvdescriptorset::DescriptorSetLayout const> const GetDescriptorSetLayout(layer_data const *dev_data,
                                                                                          VkDescriptorSetLayout dsLayout) {
     auto it = dev_data->descriptorSetLayoutMap.find(dsLayout);
-    if (it == dev_data->descriptorSetLayoutMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return it->second;
+    return *it;
 }
 
 static PIPELINE_LAYOUT_NODE const *getPipelineLayout(layer_data const *dev_data, VkPipelineLayout pipeLayout) {
     auto it = dev_data->pipelineLayoutMap.find(pipeLayout);
-    if (it == dev_data->pipelineLayoutMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return &it->second;
+    return it;
 }
 
 shader_module const *GetShaderModuleState(layer_data const *dev_data, VkShaderModule module) {
     auto it = dev_data->shaderModuleMap.find(module);
-    if (it == dev_data->shaderModuleMap.end()) {
+    if (!it) {
         return nullptr;
     }
-    return it->second.get();
+    return it->get();
 }
 
 // Return true if for a given PSO, the given state enum is dynamic, else return false
@@ -945,10 +1145,10 @@ static bool validateRenderPassCompatibility(layer_data const *dev_data, const ch
 // Return Set node ptr for specified set or else NULL
 cvdescriptorset::DescriptorSet *GetSetNode(const layer_data *dev_data, VkDescriptorSet set) {
     auto set_it = dev_data->setMap.find(set);
-    if (set_it == dev_data->setMap.end()) {
+    if (!set_it) {
         return NULL;
     }
-    return set_it->second;
+    return *set_it;
 }
 
 // For given pipeline, return number of MSAA samples, or one if MSAA disabled
@@ -1145,9 +1345,9 @@ static bool verify_set_layout_compatibility(const cvdescriptorset::DescriptorSet
 }
 
 // Validate overall state at the time of a draw call
-static bool ValidateDrawState(layer_data *dev_data, GLOBAL_CB_NODE *cb_node, CMD_TYPE cmd_type, const bool indexed,
-                              const VkPipelineBindPoint bind_point, const char *function,
-                              UNIQUE_VALIDATION_ERROR_CODE const msg_code) {
+static bool ValidateBoundDrawState(layer_data *dev_data, GLOBAL_CB_NODE *cb_node, CMD_TYPE cmd_type, const bool indexed,
+                                   const VkPipelineBindPoint bind_point, const char *function,
+                                   UNIQUE_VALIDATION_ERROR_CODE const msg_code) {
     bool result = false;
     auto const &state = cb_node->lastBound[bind_point];
     PIPELINE_STATE *pPipe = state.pipeline_state;
@@ -1221,9 +1421,52 @@ static bool ValidateDrawState(layer_data *dev_data, GLOBAL_CB_NODE *cb_node, CMD
     return result;
 }
 
+static DRAW_VALIDATION_KEY GetDrawValidationKey(GLOBAL_CB_NODE const *cb_node, LAST_BOUND_STATE const &state, CMD_TYPE cmd_type,
+                                                bool indexed) {
+    DRAW_VALIDATION_KEY key = {};
+    key.bind_generation = state.generation;
+    key.image_layout_change_count = cb_node->image_layout_change_count;
+    key.status = cb_node->status;
+    key.viewport_mask = cb_node->viewportMask;
+    key.scissor_mask = cb_node->scissorMask;
+    key.render_pass = cb_node->activeRenderPass;
+    key.subpass = cb_node->activeSubpass;
+    key.cmd_type = cmd_type;
+    key.indexed = indexed;
+    key.vertex_buffer_used = cb_node->vertex_buffer_used;
+    return key;
+}
+
+// Validate draw-time state unless none of it has changed since the last draw on this bind point that validated cleanly
+static bool ValidateDrawState(layer_data *dev_data, GLOBAL_CB_NODE *cb_node, CMD_TYPE cmd_type, const bool indexed,
+                              const VkPipelineBindPoint bind_point, const char *function,
+                              UNIQUE_VALIDATION_ERROR_CODE const msg_code) {
+    auto &state = cb_node->lastBound[bind_point];
+    const DRAW_VALIDATION_KEY key = GetDrawValidationKey(cb_node, state, cmd_type, indexed);
+    dev_data->draw_validation_count.fetch_add(1, std::memory_order_relaxed);
+    // Updating a bound set or destroying anything it refers to takes the command buffer out of the recording state
+    if (cb_node->state == CB_RECORDING && state.validated_draw == key) {
+        dev_data->draw_validation_skips.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    const uint64_t message_count = dev_data->report_data->message_count.load(std::memory_order_relaxed);
+    bool result = ValidateBoundDrawState(dev_data, cb_node, cmd_type, indexed, bind_point, function, msg_code);
+    // Only remember draws that reported nothing at all, so that repeating a bad draw repeats its messages
+    if (!result && message_count == dev_data->report_data->message_count.load(std::memory_order_relaxed)) {
+        state.validated_draw = key;
+    }
+    return result;
+}
+
 static void UpdateDrawState(layer_data *dev_data, GLOBAL_CB_NODE *cb_state, const VkPipelineBindPoint bind_point) {
-    auto const &state = cb_state->lastBound[bind_point];
+    auto &state = cb_state->lastBound[bind_point];
     PIPELINE_STATE *pPipe = state.pipeline_state;
+    // The sets bound here have already been bound to the command buffer and their resources recorded
+    if (state.recorded_generation == state.generation && cb_state->state == CB_RECORDING) {
+        return;
+    }
+    state.recorded_generation = state.generation;
     if (VK_NULL_HANDLE != state.pipeline_layout.layout) {
         for (const auto &set_binding_pair : pPipe->active_slots) {
             uint32_t setIndex = set_binding_pair.first;
@@ -1288,8 +1531,9 @@ static bool ValidatePipelineLocked(layer_data *dev_data, std::vector<std::unique
 }
 
 // UNLOCKED pipeline validation. DO NOT lookup objects in the layer_data->* maps in this function.
-static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::unique_ptr<PIPELINE_STATE>> const &pPipelines,
-                                     int pipelineIndex) {
+// Messages go to report_data, which need not be dev_data's own: see ValidatePipelinesUnlocked
+static bool ValidatePipelineUnlocked(layer_data *dev_data, debug_report_data const *report_data,
+                                     std::vector<std::unique_ptr<PIPELINE_STATE>> const &pPipelines, int pipelineIndex) {
     bool skip = false;
 
     PIPELINE_STATE *pPipeline = pPipelines[pipelineIndex].get();
@@ -1299,7 +1543,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
     // emit errors for renderpass being invalid.
     auto subpass_desc = &pPipeline->rp_state->createInfo.pSubpasses[pPipeline->graphicsPipelineCI.subpass];
     if (pPipeline->graphicsPipelineCI.subpass >= pPipeline->rp_state->createInfo.subpassCount) {
-        skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+        skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                         HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_096005ee, "DS",
                         "Invalid Pipeline CreateInfo State: Subpass index %u is out of range for this renderpass (0..%u). %s",
                         pPipeline->graphicsPipelineCI.subpass, pPipeline->rp_state->createInfo.subpassCount - 1,
@@ -1311,7 +1555,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
         const safe_VkPipelineColorBlendStateCreateInfo *color_blend_state = pPipeline->graphicsPipelineCI.pColorBlendState;
         if (color_blend_state->attachmentCount != subpass_desc->colorAttachmentCount) {
             skip |= log_msg(
-                dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+                report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                 HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_096005d4, "DS",
                 "vkCreateGraphicsPipelines(): Render pass (0x%" PRIx64
                 ") subpass %u has colorAttachmentCount of %u which doesn't match the pColorBlendState->attachmentCount of %u. %s",
@@ -1329,7 +1573,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
                     if (memcmp(static_cast<const void *>(pAttachments), static_cast<const void *>(&pAttachments[i]),
                                sizeof(pAttachments[0]))) {
                         skip |=
-                            log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+                            log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                                     HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_0f4004ba, "DS",
                                     "Invalid Pipeline CreateInfo: If independent blend feature not enabled, all elements of "
                                     "pAttachments must be identical. %s",
@@ -1341,21 +1585,21 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
         }
         if (!dev_data->enabled_features.logicOp && (pPipeline->graphicsPipelineCI.pColorBlendState->logicOpEnable != VK_FALSE)) {
             skip |=
-                log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+                log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                         HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_0f4004bc, "DS",
                         "Invalid Pipeline CreateInfo: If logic operations feature not enabled, logicOpEnable must be VK_FALSE. %s",
                         validation_error_map[VALIDATION_ERROR_0f4004bc]);
         }
     }
 
-    if (validate_and_capture_pipeline_shader_state(dev_data, pPipeline)) {
+    if (validate_and_capture_pipeline_shader_state(dev_data, report_data, pPipeline)) {
         skip = true;
     }
     // Each shader's stage must be unique
     if (pPipeline->duplicate_shaders) {
         for (uint32_t stage = VK_SHADER_STAGE_VERTEX_BIT; stage & VK_SHADER_STAGE_ALL_GRAPHICS; stage <<= 1) {
             if (pPipeline->duplicate_shaders & stage) {
-                skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+                skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                                 HandleToUint64(pPipeline->pipeline), __LINE__, DRAWSTATE_INVALID_PIPELINE_CREATE_STATE, "DS",
                                 "Invalid Pipeline CreateInfo State: Multiple shaders provided for stage %s",
                                 string_VkShaderStageFlagBits(VkShaderStageFlagBits(stage)));
@@ -1364,7 +1608,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
     }
     // VS is required
     if (!(pPipeline->active_shaders & VK_SHADER_STAGE_VERTEX_BIT)) {
-        skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+        skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                         HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_096005ae, "DS",
                         "Invalid Pipeline CreateInfo State: Vertex Shader required. %s",
                         validation_error_map[VALIDATION_ERROR_096005ae]);
@@ -1373,20 +1617,20 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
     bool has_control = (pPipeline->active_shaders & VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT) != 0;
     bool has_eval = (pPipeline->active_shaders & VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT) != 0;
     if (has_control && !has_eval) {
-        skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+        skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                         HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_096005b2, "DS",
                         "Invalid Pipeline CreateInfo State: TE and TC shaders must be included or excluded as a pair. %s",
                         validation_error_map[VALIDATION_ERROR_096005b2]);
     }
     if (!has_control && has_eval) {
-        skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+        skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                         HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_096005b4, "DS",
                         "Invalid Pipeline CreateInfo State: TE and TC shaders must be included or excluded as a pair. %s",
                         validation_error_map[VALIDATION_ERROR_096005b4]);
     }
     // Compute shaders should be specified independent of Gfx shaders
     if (pPipeline->active_shaders & VK_SHADER_STAGE_COMPUTE_BIT) {
-        skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+        skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                         HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_096005b0, "DS",
                         "Invalid Pipeline CreateInfo State: Do not specify Compute Shader for Gfx Pipeline. %s",
                         validation_error_map[VALIDATION_ERROR_096005b0]);
@@ -1396,7 +1640,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
     if (has_control && has_eval &&
         (!pPipeline->graphicsPipelineCI.pInputAssemblyState ||
          pPipeline->graphicsPipelineCI.pInputAssemblyState->topology != VK_PRIMITIVE_TOPOLOGY_PATCH_LIST)) {
-        skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+        skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                         HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_096005c0, "DS",
                         "Invalid Pipeline CreateInfo State: VK_PRIMITIVE_TOPOLOGY_PATCH_LIST must be set as IA topology for "
                         "tessellation pipelines. %s",
@@ -1405,7 +1649,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
     if (pPipeline->graphicsPipelineCI.pInputAssemblyState &&
         pPipeline->graphicsPipelineCI.pInputAssemblyState->topology == VK_PRIMITIVE_TOPOLOGY_PATCH_LIST) {
         if (!has_control || !has_eval) {
-            skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+            skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                             HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_096005c2, "DS",
                             "Invalid Pipeline CreateInfo State: VK_PRIMITIVE_TOPOLOGY_PATCH_LIST primitive topology is only valid "
                             "for tessellation pipelines. %s",
@@ -1417,7 +1661,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
     if (pPipeline->graphicsPipelineCI.pRasterizationState) {
         if ((pPipeline->graphicsPipelineCI.pRasterizationState->depthClampEnable == VK_TRUE) &&
             (!dev_data->enabled_features.depthClamp)) {
-            skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+            skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                             HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_1020061c, "DS",
                             "vkCreateGraphicsPipelines(): the depthClamp device feature is disabled: the depthClampEnable member "
                             "of the VkPipelineRasterizationStateCreateInfo structure must be set to VK_FALSE. %s",
@@ -1427,7 +1671,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
         if (!isDynamic(pPipeline, VK_DYNAMIC_STATE_DEPTH_BIAS) &&
             (pPipeline->graphicsPipelineCI.pRasterizationState->depthBiasClamp != 0.0) &&
             (!dev_data->enabled_features.depthBiasClamp)) {
-            skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+            skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                             HandleToUint64(pPipeline->pipeline), __LINE__, DRAWSTATE_INVALID_FEATURE, "DS",
                             "vkCreateGraphicsPipelines(): the depthBiasClamp device feature is disabled: the depthBiasClamp member "
                             "of the VkPipelineRasterizationStateCreateInfo structure must be set to 0.0 unless the "
@@ -1438,7 +1682,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
         if (pPipeline->graphicsPipelineCI.pRasterizationState->rasterizerDiscardEnable == VK_FALSE) {
             if ((pPipeline->graphicsPipelineCI.pMultisampleState->alphaToOneEnable == VK_TRUE) &&
                 (!dev_data->enabled_features.alphaToOne)) {
-                skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+                skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                                 HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_10000622, "DS",
                                 "vkCreateGraphicsPipelines(): the alphaToOne device feature is disabled: the alphaToOneEnable "
                                 "member of the VkPipelineMultisampleStateCreateInfo structure must be set to VK_FALSE. %s",
@@ -1449,7 +1693,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
             if (subpass_desc && subpass_desc->pDepthStencilAttachment &&
                 subpass_desc->pDepthStencilAttachment->attachment != VK_ATTACHMENT_UNUSED) {
                 if (!pPipeline->graphicsPipelineCI.pDepthStencilState) {
-                    skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+                    skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                                     HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_096005e0, "DS",
                                     "Invalid Pipeline CreateInfo State: pDepthStencilState is NULL when rasterization is enabled "
                                     "and subpass uses a depth/stencil attachment. %s",
@@ -1457,7 +1701,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
 
                 } else if ((pPipeline->graphicsPipelineCI.pDepthStencilState->depthBoundsTestEnable == VK_TRUE) &&
                            (!dev_data->enabled_features.depthBounds)) {
-                    skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+                    skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                                     HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_0f6004ac, "DS",
                                     "vkCreateGraphicsPipelines(): the depthBounds device feature is disabled: the "
                                     "depthBoundsTestEnable member of the VkPipelineDepthStencilStateCreateInfo structure must be "
@@ -1475,7 +1719,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
                     }
                 }
                 if (color_attachment_count > 0 && pPipeline->graphicsPipelineCI.pColorBlendState == nullptr) {
-                    skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+                    skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                                     HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_096005e2, "DS",
                                     "Invalid Pipeline CreateInfo State: pColorBlendState is NULL when rasterization is enabled and "
                                     "subpass uses color attachments. %s",
@@ -1495,7 +1739,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
                                                                                       &properties);
             if ((properties.bufferFeatures & VK_FORMAT_FEATURE_VERTEX_BUFFER_BIT) == 0) {
                 skip |=
-                    log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0,
+                    log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0,
                             __LINE__, VALIDATION_ERROR_14a004de, "IMAGE",
                             "vkCreateGraphicsPipelines: pCreateInfo[%d].pVertexInputState->vertexAttributeDescriptions[%d].format "
                             "(%s) is not a supported vertex buffer format. %s",
@@ -1519,7 +1763,7 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
                          pPipeline->rp_state->createInfo.pAttachments[subpass_desc->pDepthStencilAttachment->attachment].samples);
         }
         if (pPipeline->graphicsPipelineCI.pMultisampleState->rasterizationSamples != max_sample_count) {
-            skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
+            skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_PIPELINE_EXT,
                             HandleToUint64(pPipeline->pipeline), __LINE__, VALIDATION_ERROR_09600bc2, "DS",
                             "vkCreateGraphicsPipelines: pCreateInfo[%d].pMultisampleState->rasterizationSamples (%s) != max "
                             "attachment samples (%s) used in subpass %u. %s",
@@ -1533,15 +1777,42 @@ static bool ValidatePipelineUnlocked(layer_data *dev_data, std::vector<std::uniq
     return skip;
 }
 
+// Run validate(report_data, i) for each of the count pipelines of a vkCreate*Pipelines batch.  With a pipeline validation
+// pool the pipelines are validated concurrently, each logging into its own debug_report_capture, and the captured messages
+// are replayed here afterwards in pipeline order, so callbacks see the same messages in the same order, and on the same
+// thread, as when the batch is validated serially.
+static bool ValidatePipelineBatch(layer_data *dev_data, uint32_t count,
+                                  const std::function<bool(debug_report_data const *, uint32_t)> &validate) {
+    bool skip = false;
+    if (!dev_data->pipeline_validation_pool || count < 2) {
+        for (uint32_t i = 0; i < count; i++) {
+            skip |= validate(dev_data->report_data, i);
+        }
+        return skip;
+    }
+
+    std::vector<std::unique_ptr<debug_report_capture>> captures(count);
+    std::vector<uint8_t> results(count, 0);
+    dev_data->pipeline_validation_pool->parallel_for(count, [&](uint32_t i) {
+        captures[i].reset(new debug_report_capture(dev_data->report_data));
+        results[i] = validate(captures[i]->report_data(), i);
+    });
+    for (uint32_t i = 0; i < count; i++) {
+        skip |= captures[i]->replay();
+        skip |= results[i] != 0;
+    }
+    return skip;
+}
+
 // Block of code at start here specifically for managing/tracking DSs
 
 // Return Pool node ptr for specified pool or else NULL
 DESCRIPTOR_POOL_STATE *GetDescriptorPoolState(const layer_data *dev_data, const VkDescriptorPool pool) {
     auto pool_it = dev_data->descriptorPoolMap.find(pool);
-    if (pool_it == dev_data->descriptorPoolMap.end()) {
+    if (!pool_it) {
         return NULL;
     }
-    return pool_it->second;
+    return *pool_it;
 }
 
 // Validate that given set is valid and that it's not being used by an in-flight CmdBuffer
@@ -1552,14 +1823,14 @@ static bool validateIdleDescriptorSet(const layer_data *dev_data, VkDescriptorSe
     if (dev_data->instance_data->disabled.idle_descriptor_set) return false;
     bool skip = false;
     auto set_node = dev_data->setMap.find(set);
-    if (set_node == dev_data->setMap.end()) {
+    if (!set_node) {
         skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_SET_EXT,
                         HandleToUint64(set), __LINE__, DRAWSTATE_DOUBLE_DESTROY, "DS",
                         "Cannot call %s() on descriptor set 0x%" PRIx64 " that has not been allocated.", func_str.c_str(),
                         HandleToUint64(set));
     } else {
         // TODO : This covers various error cases so should pass error enum into this function and use passed in enum here
-        if (set_node->second->in_use.load()) {
+        if ((*set_node)->in_use.load()) {
             skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_SET_EXT,
                             HandleToUint64(set), __LINE__, VALIDATION_ERROR_2860026a, "DS",
                             "Cannot call %s() on descriptor set 0x%" PRIx64 " that is in use by a command buffer. %s",
@@ -1572,20 +1843,25 @@ static bool validateIdleDescriptorSet(const layer_data *dev_data, VkDescriptorSe
 // Remove set from setMap and delete the set
 static void freeDescriptorSet(layer_data *dev_data, cvdescriptorset::DescriptorSet *descriptor_set) {
     dev_data->setMap.erase(descriptor_set->GetSet());
-    delete descriptor_set;
+    cvdescriptorset::DestroyDescriptorSet(descriptor_set);
+}
+// Free every set in the pool. Sets that live in the pool's arena give their memory back in one go.
+static void freePoolDescriptorSets(layer_data *dev_data, DESCRIPTOR_POOL_STATE *pool_state) {
+    for (auto ds : pool_state->sets) {
+        freeDescriptorSet(dev_data, ds);
+    }
+    pool_state->sets.clear();
+    pool_state->set_arena.reset();
 }
 // Free all DS Pools including their Sets & related sub-structs
 // NOTE : Calls to this function should be wrapped in mutex
 static void deletePools(layer_data *dev_data) {
-    for (auto ii = dev_data->descriptorPoolMap.begin(); ii != dev_data->descriptorPoolMap.end();) {
+    for (auto ii : dev_data->descriptorPoolMap.snapshot()) {
         // Remove this pools' sets from setMap and delete them
-        for (auto ds : ii->second->sets) {
-            freeDescriptorSet(dev_data, ds);
-        }
-        ii->second->sets.clear();
-        delete ii->second;
-        ii = dev_data->descriptorPoolMap.erase(ii);
+        freePoolDescriptorSets(dev_data, *ii.second);
+        delete *ii.second;
     }
+    dev_data->descriptorPoolMap.clear();
 }
 
 static void clearDescriptorPool(layer_data *dev_data, const VkDevice device, const VkDescriptorPool pool,
@@ -1593,10 +1869,7 @@ static void clearDescriptorPool(layer_data *dev_data, const VkDevice device, con
     DESCRIPTOR_POOL_STATE *pPool = GetDescriptorPoolState(dev_data, pool);
     // TODO: validate flags
     // For every set off of this pool, clear it, remove from setMap, and free cvdescriptorset::DescriptorSet
-    for (auto ds : pPool->sets) {
-        freeDescriptorSet(dev_data, ds);
-    }
-    pPool->sets.clear();
+    freePoolDescriptorSets(dev_data, pPool);
     // Reset available count for each type and available sets for this pool
     for (uint32_t i = 0; i < pPool->availableDescriptorTypeCount.size(); ++i) {
         pPool->availableDescriptorTypeCount[i] = pPool->maxDescriptorTypeCount[i];
@@ -1607,10 +1880,10 @@ static void clearDescriptorPool(layer_data *dev_data, const VkDevice device, con
 // For given CB object, fetch associated CB Node from map
 GLOBAL_CB_NODE *GetCBNode(layer_data const *dev_data, const VkCommandBuffer cb) {
     auto it = dev_data->commandBufferMap.find(cb);
-    if (it == dev_data->commandBufferMap.end()) {
+    if (!it) {
         return NULL;
     }
-    return it->second;
+    return *it;
 }
 
 // If a renderpass is active, verify that the given command type is appropriate for current subpass state
@@ -1834,11 +2107,33 @@ BASE_NODE *GetStateStructPtrFromObject(layer_data *dev_data, VK_OBJECT object_st
     return base_ptr;
 }
 
+// For given cb_nodes, invalidate them and track object causing invalidation
+template <typename CB_NODE_SET>
+static void InvalidateCommandBufferSet(const layer_data *dev_data, CB_NODE_SET const &cb_nodes, VK_OBJECT obj) {
+    for (auto cb_node : cb_nodes) {
+        if (cb_node->state == CB_RECORDING) {
+            log_msg(dev_data->report_data, VK_DEBUG_REPORT_WARNING_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT,
+                    HandleToUint64(cb_node->commandBuffer), __LINE__, DRAWSTATE_INVALID_COMMAND_BUFFER, "DS",
+                    "Invalidating a command buffer that's currently being recorded: 0x%" PRIx64 ".",
+                    HandleToUint64(cb_node->commandBuffer));
+            cb_node->state = CB_INVALID_INCOMPLETE;
+        } else if (cb_node->state == CB_RECORDED) {
+            cb_node->state = CB_INVALID_COMPLETE;
+        }
+        cb_node->broken_bindings.push_back(obj);
+
+        // if secondary, then propagate the invalidation to the primaries that will call us.
+        if (cb_node->createInfo.level == VK_COMMAND_BUFFER_LEVEL_SECONDARY) {
+            InvalidateCommandBufferSet(dev_data, cb_node->linkedCommandBuffers, obj);
+        }
+    }
+}
+
 // Tie the VK_OBJECT to the cmd buffer which includes:
 //  Add object_binding to cmd buffer
 //  Add cb_binding to object
 static void addCommandBufferBinding(std::unordered_set<GLOBAL_CB_NODE *> *cb_bindings, VK_OBJECT obj, GLOBAL_CB_NODE *cb_node) {
-    cb_bindings->insert(cb_node);
+    InsertCommandBufferBinding(cb_bindings, cb_node);
     cb_node->object_bindings.insert(obj);
 }
 // For a given object, if cb_node is in that objects cb_bindings, remove cb_node
@@ -1889,7 +2184,7 @@ static void ResetCommandBufferState(layer_data *dev_data, const VkCommandBuffer
         pCB->primaryCommandBuffer = VK_NULL_HANDLE;
         // If secondary, invalidate any primary command buffer that may call us.
         if (pCB->createInfo.level == VK_COMMAND_BUFFER_LEVEL_SECONDARY) {
-            invalidateCommandBuffers(dev_data, pCB->linkedCommandBuffers, {HandleToUint64(cb), kVulkanObjectTypeCommandBuffer});
+            InvalidateCommandBufferSet(dev_data, pCB->linkedCommandBuffers, {HandleToUint64(cb), kVulkanObjectTypeCommandBuffer});
         }
 
         // Remove reverse command buffer links.
@@ -1904,6 +2199,8 @@ static void ResetCommandBufferState(layer_data *dev_data, const VkCommandBuffer
         pCB->cmd_execute_commands_functions.clear();
         pCB->eventUpdates.clear();
         pCB->queryUpdates.clear();
+        // The deferred calls above were the only users of the arena
+        pCB->validation_arena.reset();
 
         // Remove object bindings
         for (auto obj : pCB->object_bindings) {
@@ -1993,6 +2290,21 @@ bool outsideRenderPass(const layer_data *dev_data, GLOBAL_CB_NODE *pCB, const ch
 
 static void init_core_validation(instance_layer_data *instance_data, const VkAllocationCallbacks *pAllocator) {
     layer_debug_actions(instance_data->report_data, instance_data->logging_callback, pAllocator, "lunarg_core_validation");
+
+    instance_data->settings.command_buffer_locking =
+        !strcmp(getLayerOption("lunarg_core_validation.command_buffer_locking"), "true");
+    instance_data->settings.async_submit_validation =
+        !strcmp(getLayerOption("lunarg_core_validation.async_submit_validation"), "true");
+    const char *pipeline_validation_threads = getLayerOption("lunarg_core_validation.pipeline_validation_threads");
+    if (*pipeline_validation_threads) {
+        // 0 asks for one thread per hardware thread
+        uint32_t threads = static_cast<uint32_t>(strtoul(pipeline_validation_threads, NULL, 10));
+        if (!threads) threads = std::max(1u, std::thread::hardware_concurrency());
+        instance_data->settings.pipeline_validation_threads = threads;
+    }
+    instance_data->settings.validation_cache_file = getLayerOption("lunarg_core_validation.validation_cache_file");
+    instance_data->settings.async_shader_module_validation =
+        !strcmp(getLayerOption("lunarg_core_validation.async_shader_module_validation"), "true");
 }
 
 // For the given ValidationCheck enum, set all relevant instance disabled flags to true
@@ -2264,6 +2576,21 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateDevice(VkPhysicalDevice gpu, const VkDevice
 
     lock.unlock();
 
+    if (instance_data->settings.async_submit_validation) {
+        async_submit_queue.AddDevice();
+    }
+    if (instance_data->settings.pipeline_validation_threads > 1) {
+        device_data->pipeline_validation_pool.reset(new vl_thread_pool(instance_data->settings.pipeline_validation_threads));
+    }
+    if (!instance_data->disabled.shader_validation) {
+        device_data->spirv_validation.reset(new spirv_validator(instance_data->settings.async_shader_module_validation));
+    }
+    if (!instance_data->settings.validation_cache_file.empty() && !instance_data->disabled.shader_validation) {
+        device_data->implicit_validation_cache.reset(
+            ValidationCache::LoadFile(instance_data->settings.validation_cache_file.c_str()));
+        device_data->implicit_validation_cache_loaded_size = device_data->implicit_validation_cache->Size();
+    }
+
     ValidateLayerOrdering(*pCreateInfo);
 
     return result;
@@ -2274,12 +2601,36 @@ VKAPI_ATTR void VKAPI_CALL DestroyDevice(VkDevice device, const VkAllocationCall
     // TODOSC : Shouldn't need any customization here
     dispatch_key key = get_dispatch_key(device);
     layer_data *dev_data = GetLayerDataPtr(key, layer_data_map);
+    const uint64_t draw_count = dev_data->draw_validation_count.load();
+    if (draw_count) {
+        log_msg(dev_data->report_data, VK_DEBUG_REPORT_INFORMATION_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_EXT,
+                HandleToUint64(device), __LINE__, DRAWSTATE_NONE, "DS",
+                "Draw-time validation was skipped for %" PRIu64 " of %" PRIu64
+                " draws and dispatches, whose bound state was unchanged since the previous one.",
+                dev_data->draw_validation_skips.load(), draw_count);
+    }
+    // Finish any shader module validation still running in the background, which may yet add to the implicit cache, and
+    // report on modules the application never used or destroyed
+    dev_data->spirv_validation.reset();
+    for (auto &entry : dev_data->shaderModuleMap.snapshot()) {
+        (*entry.second)->wait_for_validation(dev_data->report_data);
+    }
+    // Only shader modules that weren't in the file already give it anything to merge
+    auto implicit_cache = dev_data->implicit_validation_cache.get();
+    if (implicit_cache && implicit_cache->Size() > dev_data->implicit_validation_cache_loaded_size) {
+        const char *path = dev_data->instance_data->settings.validation_cache_file.c_str();
+        if (!implicit_cache->StoreFile(path)) {
+            log_msg(dev_data->report_data, VK_DEBUG_REPORT_WARNING_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_EXT,
+                    HandleToUint64(device), __LINE__, DRAWSTATE_NONE, "DS", "Could not write the validation cache file %s.",
+                    path);
+        }
+    }
     // Free all the memory
     unique_lock_t lock(global_lock);
     dev_data->pipelineMap.clear();
     dev_data->renderPassMap.clear();
-    for (auto ii = dev_data->commandBufferMap.begin(); ii != dev_data->commandBufferMap.end(); ++ii) {
-        delete (*ii).second;
+    for (auto ii : dev_data->commandBufferMap.snapshot()) {
+        delete *ii.second;
     }
     dev_data->commandBufferMap.clear();
     // This will also delete all sets in the pool & remove them from setMap
@@ -2289,20 +2640,23 @@ VKAPI_ATTR void VKAPI_CALL DestroyDevice(VkDevice device, const VkAllocationCall
     dev_data->descriptorSetLayoutMap.clear();
     dev_data->imageViewMap.clear();
     dev_data->imageMap.clear();
-    dev_data->imageSubresourceMap.clear();
     dev_data->imageLayoutMap.clear();
     dev_data->bufferViewMap.clear();
     dev_data->bufferMap.clear();
     // Queues persist until device is destroyed
     dev_data->queueMap.clear();
-    // Report any memory leaks
-    layer_debug_report_destroy_device(device);
     lock.unlock();
 
+    // Taking global_lock above already ran any submissions this device had queued
+    if (dev_data->instance_data->settings.async_submit_validation) {
+        async_submit_queue.RemoveDevice();
+    }
+
 #if DISPATCH_MAP_DEBUG
     fprintf(stderr, "Device: 0x%p, key: 0x%p\n", device, key);
 #endif
 
+    layer_debug_report_destroy_device(dev_data->report_data, device);
     dev_data->dispatch_table.DestroyDevice(device, pAllocator);
     FreeLayerDataPtr(key, layer_data_map);
 }
@@ -2498,8 +2852,8 @@ static void RetireWorkOnQueue(layer_data *dev_data, QUEUE_STATE *pQueue, uint64_
             }
             for (auto event : cb_node->writeEventsBeforeWait) {
                 auto eventNode = dev_data->eventMap.find(event);
-                if (eventNode != dev_data->eventMap.end()) {
-                    eventNode->second.write_in_use--;
+                if (eventNode) {
+                    eventNode->write_in_use--;
                 }
             }
             for (auto queryStatePair : cb_node->queryToStateMap) {
@@ -2843,7 +3197,7 @@ static bool PreCallValidateQueueSubmit(layer_data *dev_data, VkQueue queue, uint
     unordered_set<VkSemaphore> unsignaled_semaphores;
     unordered_set<VkSemaphore> internal_semaphores;
     vector<VkCommandBuffer> current_cmds;
-    unordered_map<ImageSubresourcePair, IMAGE_LAYOUT_NODE> localImageLayoutMap;
+    unordered_map<VkImage, IMAGE_LAYOUT_NODE> localImageLayoutMap;
     // Now verify each individual submit
     for (uint32_t submit_idx = 0; submit_idx < submitCount; submit_idx++) {
         const VkSubmitInfo *submit = &pSubmits[submit_idx];
@@ -2914,8 +3268,35 @@ static bool PreCallValidateQueueSubmit(layer_data *dev_data, VkQueue queue, uint
     return skip;
 }
 
+void AsyncSubmitQueue::Validate(const Submission &submission) {
+    const uint32_t submit_count = static_cast<uint32_t>(submission.submits.size());
+    const VkSubmitInfo *submits = submit_count ? submission.submits[0].ptr() : nullptr;
+    // The call already went down the chain, so there is nothing left for skip to prevent
+    PreCallValidateQueueSubmit(submission.dev_data, submission.queue, submit_count, submits, submission.fence);
+    PostCallRecordQueueSubmit(submission.dev_data, submission.queue, submit_count, submits, submission.fence);
+}
+
+static VkResult QueueSubmitAsyncValidation(layer_data *dev_data, VkQueue queue, uint32_t submitCount,
+                                           const VkSubmitInfo *pSubmits, VkFence fence) {
+    AsyncSubmitQueue::Submission submission = {dev_data, queue, fence, {}};
+    submission.submits.reserve(submitCount);
+    for (uint32_t i = 0; i < submitCount; ++i) {
+        submission.submits.emplace_back(&pSubmits[i]);
+        // Extension structs are not copied, and submit validation does not look at them
+        submission.submits.back().pNext = nullptr;
+    }
+
+    VkResult result = dev_data->dispatch_table.QueueSubmit(queue, submitCount, pSubmits, fence);
+
+    async_submit_queue.Enqueue(std::move(submission));
+    return result;
+}
+
 VKAPI_ATTR VkResult VKAPI_CALL QueueSubmit(VkQueue queue, uint32_t submitCount, const VkSubmitInfo *pSubmits, VkFence fence) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(queue), layer_data_map);
+    if (dev_data->instance_data->settings.async_submit_validation) {
+        return QueueSubmitAsyncValidation(dev_data, queue, submitCount, pSubmits, fence);
+    }
     unique_lock_t lock(global_lock);
 
     bool skip = PreCallValidateQueueSubmit(dev_data, queue, submitCount, pSubmits, fence);
@@ -3048,8 +3429,8 @@ static bool ValidateMapMemRange(layer_data *dev_data, VkDeviceMemory mem, VkDevi
     }
 
     auto mem_element = dev_data->memObjMap.find(mem);
-    if (mem_element != dev_data->memObjMap.end()) {
-        auto mem_info = mem_element->second.get();
+    if (mem_element) {
+        auto mem_info = mem_element->get();
         // It is an application error to call VkMapMemory on an object that is already mapped
         if (mem_info->mem_range.size != 0) {
             skip = log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_MEMORY_EXT,
@@ -3293,15 +3674,15 @@ VKAPI_ATTR VkResult VKAPI_CALL QueueWaitIdle(VkQueue queue) {
 static bool PreCallValidateDeviceWaitIdle(layer_data *dev_data) {
     if (dev_data->instance_data->disabled.device_wait_idle) return false;
     bool skip = false;
-    for (auto &queue : dev_data->queueMap) {
-        skip |= VerifyQueueStateToSeq(dev_data, &queue.second, queue.second.seq + queue.second.submissions.size());
+    for (auto &queue : dev_data->queueMap.snapshot()) {
+        skip |= VerifyQueueStateToSeq(dev_data, queue.second, queue.second->seq + queue.second->submissions.size());
     }
     return skip;
 }
 
 static void PostCallRecordDeviceWaitIdle(layer_data *dev_data) {
-    for (auto &queue : dev_data->queueMap) {
-        RetireWorkOnQueue(dev_data, &queue.second, queue.second.seq + queue.second.submissions.size());
+    for (auto &queue : dev_data->queueMap.snapshot()) {
+        RetireWorkOnQueue(dev_data, queue.second, queue.second->seq + queue.second->submissions.size());
     }
 }
 
@@ -3451,8 +3832,8 @@ static bool PreCallValidateGetQueryPoolResults(layer_data *dev_data, VkQueryPool
                                                unordered_map<QueryObject, vector<VkCommandBuffer>> *queries_in_flight) {
     bool skip = false;
     auto query_pool_state = dev_data->queryPoolMap.find(query_pool);
-    if (query_pool_state != dev_data->queryPoolMap.end()) {
-        if ((query_pool_state->second.createInfo.queryType == VK_QUERY_TYPE_TIMESTAMP) && (flags & VK_QUERY_RESULT_PARTIAL_BIT)) {
+    if (query_pool_state) {
+        if ((query_pool_state->createInfo.queryType == VK_QUERY_TYPE_TIMESTAMP) && (flags & VK_QUERY_RESULT_PARTIAL_BIT)) {
             skip |= log_msg(
                 dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_QUERY_POOL_EXT, 0, __LINE__,
                 VALIDATION_ERROR_2fa00664, "DS",
@@ -3463,9 +3844,9 @@ static bool PreCallValidateGetQueryPoolResults(layer_data *dev_data, VkQueryPool
     }
 
     // TODO: clean this up, it's insanely wasteful.
-    for (auto cmd_buffer : dev_data->commandBufferMap) {
-        if (cmd_buffer.second->in_use.load()) {
-            for (auto query_state_pair : cmd_buffer.second->queryToStateMap) {
+    for (auto cmd_buffer : dev_data->commandBufferMap.snapshot()) {
+        if ((*cmd_buffer.second)->in_use.load()) {
+            for (auto query_state_pair : (*cmd_buffer.second)->queryToStateMap) {
                 (*queries_in_flight)[query_state_pair.first].push_back(cmd_buffer.first);
             }
         }
@@ -3599,6 +3980,16 @@ bool rangesIntersect(layer_data const *dev_data, MEMORY_RANGE const *range1, VkD
     bool tmp_bool;
     return rangesIntersect(dev_data, range1, &range_wrap, &tmp_bool, true);
 }
+// Call func(bound_range) for each range bound to mem_info that could intersect [start-end] under rangesIntersect. Candidates
+// are looked up in bound_range_index over [start-end] widened to bufferImageGranularity, which covers the padding that
+// rangesIntersect applies, so callers still make the final decision with rangesIntersect.
+template <typename F>
+static void ForEachCandidateRange(layer_data const *dev_data, DEVICE_MEM_INFO *mem_info, VkDeviceSize start, VkDeviceSize end,
+                                  F func) {
+    const VkDeviceSize pad_align = dev_data->phys_dev_properties.properties.limits.bufferImageGranularity;
+    mem_info->bound_range_index.for_each_overlapping(start & ~(pad_align - 1), end | (pad_align - 1),
+                                                     [&func](VkDeviceSize, VkDeviceSize, MEMORY_RANGE *range) { func(range); });
+}
 // For given mem_info, set all ranges valid that intersect [offset-end] range
 // TODO : For ranges where there is no alias, we may want to create new buffer ranges that are valid
 static void SetMemRangesValid(layer_data const *dev_data, DEVICE_MEM_INFO *mem_info, VkDeviceSize offset, VkDeviceSize end) {
@@ -3607,12 +3998,12 @@ static void SetMemRangesValid(layer_data const *dev_data, DEVICE_MEM_INFO *mem_i
     map_range.linear = true;
     map_range.start = offset;
     map_range.end = end;
-    for (auto &handle_range_pair : mem_info->bound_ranges) {
-        if (rangesIntersect(dev_data, &handle_range_pair.second, &map_range, &tmp_bool, false)) {
+    ForEachCandidateRange(dev_data, mem_info, offset, end, [&](MEMORY_RANGE *bound_range) {
+        if (rangesIntersect(dev_data, bound_range, &map_range, &tmp_bool, false)) {
             // TODO : WARN here if tmp_bool true?
-            handle_range_pair.second.valid = true;
+            bound_range->valid = true;
         }
-    }
+    });
 }
 
 static bool ValidateInsertMemoryRange(layer_data const *dev_data, uint64_t handle, DEVICE_MEM_INFO *mem_info,
@@ -3632,14 +4023,13 @@ static bool ValidateInsertMemoryRange(layer_data const *dev_data, uint64_t handl
     range.aliases.clear();
 
     // Check for aliasing problems.
-    for (auto &obj_range_pair : mem_info->bound_ranges) {
-        auto check_range = &obj_range_pair.second;
+    ForEachCandidateRange(dev_data, mem_info, range.start, range.end, [&](MEMORY_RANGE *check_range) {
         bool intersection_error = false;
         if (rangesIntersect(dev_data, &range, check_range, &intersection_error, false)) {
             skip |= intersection_error;
             range.aliases.insert(check_range);
         }
-    }
+    });
 
     if (memoryOffset >= mem_info->alloc_info.allocationSize) {
         UNIQUE_VALIDATION_ERROR_CODE error_code = is_image ? VALIDATION_ERROR_1740082c : VALIDATION_ERROR_1700080e;
@@ -3678,17 +4068,23 @@ static void InsertMemoryRange(layer_data const *dev_data, uint64_t handle, DEVIC
     // Save aliased ranges so we can copy into final map entry below. Can't do it in loop b/c we don't yet have final ptr. If we
     // inserted into map before loop to get the final ptr, then we may enter loop when not needed & we check range against itself
     std::unordered_set<MEMORY_RANGE *> tmp_alias_ranges;
-    for (auto &obj_range_pair : mem_info->bound_ranges) {
-        auto check_range = &obj_range_pair.second;
+    auto old_range = mem_info->bound_ranges.find(handle);
+    if (old_range != mem_info->bound_ranges.end()) {
+        // Rebinding replaces the old range in place, so drop it from the index before it is overwritten
+        mem_info->bound_range_index.erase(old_range->second.start, &old_range->second);
+    }
+    ForEachCandidateRange(dev_data, mem_info, range.start, range.end, [&](MEMORY_RANGE *check_range) {
         bool intersection_error = false;
         if (rangesIntersect(dev_data, &range, check_range, &intersection_error, true)) {
             range.aliases.insert(check_range);
             tmp_alias_ranges.insert(check_range);
         }
-    }
-    mem_info->bound_ranges[handle] = std::move(range);
+    });
+    auto bound_range = &mem_info->bound_ranges[handle];
+    *bound_range = std::move(range);
+    mem_info->bound_range_index.insert(bound_range->start, bound_range->end, bound_range);
     for (auto tmp_range : tmp_alias_ranges) {
-        tmp_range->aliases.insert(&mem_info->bound_ranges[handle]);
+        tmp_range->aliases.insert(bound_range);
     }
     if (is_image)
         mem_info->bound_images.insert(handle);
@@ -3725,6 +4121,7 @@ static void RemoveMemoryRange(uint64_t handle, DEVICE_MEM_INFO *mem_info, bool i
         alias_range->aliases.erase(erase_range);
     }
     erase_range->aliases.clear();
+    mem_info->bound_range_index.erase(erase_range->start, erase_range);
     mem_info->bound_ranges.erase(handle);
     if (is_image) {
         mem_info->bound_images.erase(handle);
@@ -4110,6 +4507,10 @@ VKAPI_ATTR void VKAPI_CALL DestroyShaderModule(VkDevice device, VkShaderModule s
                                                const VkAllocationCallbacks *pAllocator) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(device), layer_data_map);
 
+    // A module no pipeline used still gets what background validation found about it reported
+    auto module = GetShaderModuleState(dev_data, shaderModule);
+    if (module) module->wait_for_validation(dev_data->report_data);
+
     unique_lock_t lock(global_lock);
     dev_data->shaderModuleMap.erase(shaderModule);
     lock.unlock();
@@ -4199,9 +4600,9 @@ VKAPI_ATTR void VKAPI_CALL DestroySampler(VkDevice device, VkSampler sampler, co
 
 static void PostCallRecordDestroyDescriptorSetLayout(layer_data *dev_data, VkDescriptorSetLayout ds_layout) {
     auto layout_it = dev_data->descriptorSetLayoutMap.find(ds_layout);
-    if (layout_it != dev_data->descriptorSetLayoutMap.end()) {
-        layout_it->second.get()->MarkDestroyed();
-        dev_data->descriptorSetLayoutMap.erase(layout_it);
+    if (layout_it) {
+        layout_it->get()->MarkDestroyed();
+        dev_data->descriptorSetLayoutMap.erase(ds_layout);
     }
 }
 
@@ -4231,9 +4632,7 @@ static void PostCallRecordDestroyDescriptorPool(layer_data *dev_data, VkDescript
     // Any bound cmd buffers are now invalid
     invalidateCommandBuffers(dev_data, desc_pool_state->cb_bindings, obj_struct);
     // Free sets that were in this pool
-    for (auto ds : desc_pool_state->sets) {
-        freeDescriptorSet(dev_data, ds);
-    }
+    freePoolDescriptorSets(dev_data, desc_pool_state);
     dev_data->descriptorPoolMap.erase(descriptorPool);
     delete desc_pool_state;
 }
@@ -4418,6 +4817,9 @@ VKAPI_ATTR VkResult VKAPI_CALL ResetCommandPool(VkDevice device, VkCommandPool c
         for (auto cmdBuffer : pPool->commandBuffers) {
             ResetCommandBufferState(dev_data, cmdBuffer);
         }
+        if (flags & VK_COMMAND_POOL_RESET_RELEASE_RESOURCES_BIT) {
+            pPool->arena_blocks.trim();
+        }
         lock.unlock();
     }
     return result;
@@ -4460,25 +4862,8 @@ VKAPI_ATTR VkResult VKAPI_CALL ResetFences(VkDevice device, uint32_t fenceCount,
     return result;
 }
 
-// For given cb_nodes, invalidate them and track object causing invalidation
 void invalidateCommandBuffers(const layer_data *dev_data, std::unordered_set<GLOBAL_CB_NODE *> const &cb_nodes, VK_OBJECT obj) {
-    for (auto cb_node : cb_nodes) {
-        if (cb_node->state == CB_RECORDING) {
-            log_msg(dev_data->report_data, VK_DEBUG_REPORT_WARNING_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT,
-                    HandleToUint64(cb_node->commandBuffer), __LINE__, DRAWSTATE_INVALID_COMMAND_BUFFER, "DS",
-                    "Invalidating a command buffer that's currently being recorded: 0x%" PRIx64 ".",
-                    HandleToUint64(cb_node->commandBuffer));
-            cb_node->state = CB_INVALID_INCOMPLETE;
-        } else if (cb_node->state == CB_RECORDED) {
-            cb_node->state = CB_INVALID_COMPLETE;
-        }
-        cb_node->broken_bindings.push_back(obj);
-
-        // if secondary, then propagate the invalidation to the primaries that will call us.
-        if (cb_node->createInfo.level == VK_COMMAND_BUFFER_LEVEL_SECONDARY) {
-            invalidateCommandBuffers(dev_data, cb_node->linkedCommandBuffers, obj);
-        }
-    }
+    InvalidateCommandBufferSet(dev_data, cb_nodes, obj);
 }
 
 static bool PreCallValidateDestroyFramebuffer(layer_data *dev_data, VkFramebuffer framebuffer,
@@ -4610,31 +4995,37 @@ const VkPhysicalDeviceProperties *GetPhysicalDeviceProperties(core_validation::l
 
 const CHECK_DISABLED *GetDisables(core_validation::layer_data *device_data) { return &device_data->instance_data->disabled; }
 
-std::unordered_map<VkImage, std::unique_ptr<IMAGE_STATE>> *GetImageMap(core_validation::layer_data *device_data) {
-    return &device_data->imageMap;
+const CORE_VALIDATION_SETTINGS *GetSettings(core_validation::layer_data *device_data) {
+    return &device_data->instance_data->settings;
 }
 
-std::unordered_map<VkImage, std::vector<ImageSubresourcePair>> *GetImageSubresourceMap(core_validation::layer_data *device_data) {
-    return &device_data->imageSubresourceMap;
+ValidationCache *GetImplicitValidationCache(core_validation::layer_data *device_data) {
+    return device_data->implicit_validation_cache.get();
+}
+
+spirv_validator *GetSpirvValidator(core_validation::layer_data *device_data) { return device_data->spirv_validation.get(); }
+
+vl_concurrent_unordered_map<VkImage, std::unique_ptr<IMAGE_STATE>> *GetImageMap(core_validation::layer_data *device_data) {
+    return &device_data->imageMap;
 }
 
-std::unordered_map<ImageSubresourcePair, IMAGE_LAYOUT_NODE> *GetImageLayoutMap(layer_data *device_data) {
+std::unordered_map<VkImage, IMAGE_LAYOUT_NODE> *GetImageLayoutMap(layer_data *device_data) {
     return &device_data->imageLayoutMap;
 }
 
-std::unordered_map<ImageSubresourcePair, IMAGE_LAYOUT_NODE> const *GetImageLayoutMap(layer_data const *device_data) {
+std::unordered_map<VkImage, IMAGE_LAYOUT_NODE> const *GetImageLayoutMap(layer_data const *device_data) {
     return &device_data->imageLayoutMap;
 }
 
-std::unordered_map<VkBuffer, std::unique_ptr<BUFFER_STATE>> *GetBufferMap(layer_data *device_data) {
+vl_concurrent_unordered_map<VkBuffer, std::unique_ptr<BUFFER_STATE>> *GetBufferMap(layer_data *device_data) {
     return &device_data->bufferMap;
 }
 
-std::unordered_map<VkBufferView, std::unique_ptr<BUFFER_VIEW_STATE>> *GetBufferViewMap(layer_data *device_data) {
+vl_concurrent_unordered_map<VkBufferView, std::unique_ptr<BUFFER_VIEW_STATE>> *GetBufferViewMap(layer_data *device_data) {
     return &device_data->bufferViewMap;
 }
 
-std::unordered_map<VkImageView, std::unique_ptr<IMAGE_VIEW_STATE>> *GetImageViewMap(layer_data *device_data) {
+vl_concurrent_unordered_map<VkImageView, std::unique_ptr<IMAGE_VIEW_STATE>> *GetImageViewMap(layer_data *device_data) {
     return &device_data->imageViewMap;
 }
 
@@ -4828,6 +5219,7 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateGraphicsPipelines(VkDevice device, VkPipeli
         pipe_state.push_back(std::unique_ptr<PIPELINE_STATE>(new PIPELINE_STATE));
         pipe_state[i]->initGraphicsPipeline(&pCreateInfos[i], GetRenderPassStateSharedPtr(dev_data, pCreateInfos[i].renderPass));
         pipe_state[i]->pipeline_layout = *getPipelineLayout(dev_data, pCreateInfos[i].layout);
+        set_pipeline_state(pipe_state[i].get());
     }
 
     for (i = 0; i < count; i++) {
@@ -4836,9 +5228,9 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateGraphicsPipelines(VkDevice device, VkPipeli
 
     lock.unlock();
 
-    for (i = 0; i < count; i++) {
-        skip |= ValidatePipelineUnlocked(dev_data, pipe_state, i);
-    }
+    skip |= ValidatePipelineBatch(dev_data, count, [&](debug_report_data const *report_data, uint32_t index) {
+        return ValidatePipelineUnlocked(dev_data, report_data, pipe_state, index);
+    });
 
     if (skip) {
         for (i = 0; i < count; i++) {
@@ -4876,10 +5268,13 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateComputePipelines(VkDevice device, VkPipelin
         pPipeState.push_back(unique_ptr<PIPELINE_STATE>(new PIPELINE_STATE));
         pPipeState[i]->initComputePipeline(&pCreateInfos[i]);
         pPipeState[i]->pipeline_layout = *getPipelineLayout(dev_data, pCreateInfos[i].layout);
-
-        // TODO: Add Compute Pipeline Verification
-        skip |= validate_compute_pipeline(dev_data, pPipeState[i].get());
     }
+    lock.unlock();
+
+    // TODO: Add Compute Pipeline Verification
+    skip |= ValidatePipelineBatch(dev_data, count, [&](debug_report_data const *report_data, uint32_t index) {
+        return validate_compute_pipeline(dev_data, report_data, pPipeState[index].get());
+    });
 
     if (skip) {
         for (i = 0; i < count; i++) {
@@ -4888,7 +5283,6 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateComputePipelines(VkDevice device, VkPipelin
         return VK_ERROR_VALIDATION_FAILED_EXT;
     }
 
-    lock.unlock();
     auto result =
         dev_data->dispatch_table.CreateComputePipelines(device, pipelineCache, count, pCreateInfos, pAllocator, pPipelines);
     lock.lock();
@@ -5397,6 +5791,9 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateDescriptorPool(VkDevice device, const VkDes
     VkResult result = dev_data->dispatch_table.CreateDescriptorPool(device, pCreateInfo, pAllocator, pDescriptorPool);
     if (VK_SUCCESS == result) {
         DESCRIPTOR_POOL_STATE *pNewNode = new DESCRIPTOR_POOL_STATE(*pDescriptorPool, pCreateInfo);
+        if (pNewNode && pNewNode->sets_in_arena) {
+            pNewNode->set_arena.reserve(cvdescriptorset::GetDescriptorPoolArenaSize(pCreateInfo));
+        }
         if (NULL == pNewNode) {
             if (log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_POOL_EXT,
                         HandleToUint64(*pDescriptorPool), __LINE__, DRAWSTATE_OUT_OF_MEMORY, "DS",
@@ -5503,8 +5900,12 @@ static void PostCallRecordFreeDescriptorSets(layer_data *dev_data, VkDescriptorP
                 descriptor_count = descriptor_set->GetDescriptorCountFromIndex(j);
                 pool_state->availableDescriptorTypeCount[type_index] += descriptor_count;
             }
+            // Unlink the set from the pool by moving the pool's last set into its slot
+            const size_t slot = descriptor_set->GetPoolSlot();
+            pool_state->sets[slot] = pool_state->sets.back();
+            pool_state->sets[slot]->SetPoolSlot(slot);
+            pool_state->sets.pop_back();
             freeDescriptorSet(dev_data, descriptor_set);
-            pool_state->sets.erase(descriptor_set);
         }
     }
 }
@@ -5583,6 +5984,7 @@ VKAPI_ATTR VkResult VKAPI_CALL AllocateCommandBuffers(VkDevice device, const VkC
                 // Add command buffer to its commandPool map
                 pPool->commandBuffers.insert(pCommandBuffer[i]);
                 GLOBAL_CB_NODE *pCB = new GLOBAL_CB_NODE;
+                pCB->validation_arena.set_block_pool(&pPool->arena_blocks);
                 // Add command buffer to map
                 dev_data->commandBufferMap[pCommandBuffer[i]] = pCB;
                 ResetCommandBufferState(dev_data, pCommandBuffer[i]);
@@ -5730,7 +6132,7 @@ static void PostCallRecordEndCommandBuffer(layer_data *dev_data, GLOBAL_CB_NODE
 VKAPI_ATTR VkResult VKAPI_CALL EndCommandBuffer(VkCommandBuffer commandBuffer) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         if ((VK_COMMAND_BUFFER_LEVEL_PRIMARY == pCB->createInfo.level) ||
@@ -5791,7 +6193,7 @@ VKAPI_ATTR void VKAPI_CALL CmdBindPipeline(VkCommandBuffer commandBuffer, VkPipe
                                            VkPipeline pipeline) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *cb_state = GetCBNode(dev_data, commandBuffer);
     if (cb_state) {
         skip |= ValidateCmdQueueFlags(dev_data, cb_state, "vkCmdBindPipeline()", VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT,
@@ -5806,7 +6208,7 @@ VKAPI_ATTR void VKAPI_CALL CmdBindPipeline(VkCommandBuffer commandBuffer, VkPipe
             cb_state->status |= cb_state->static_status;
         }
         cb_state->lastBound[pipelineBindPoint].pipeline_state = pipe_state;
-        set_pipeline_state(pipe_state);
+        ++cb_state->lastBound[pipelineBindPoint].generation;
         skip |= validate_dual_src_blend_feature(dev_data, pipe_state);
         addCommandBufferBinding(&pipe_state->cb_bindings, {HandleToUint64(pipeline), kVulkanObjectTypePipeline}, cb_state);
     }
@@ -5818,7 +6220,7 @@ VKAPI_ATTR void VKAPI_CALL CmdSetViewport(VkCommandBuffer commandBuffer, uint32_
                                           const VkViewport *pViewports) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |= ValidateCmdQueueFlags(dev_data, pCB, "vkCmdSetViewport()", VK_QUEUE_GRAPHICS_BIT, VALIDATION_ERROR_1e002415);
@@ -5842,7 +6244,7 @@ VKAPI_ATTR void VKAPI_CALL CmdSetScissor(VkCommandBuffer commandBuffer, uint32_t
                                          const VkRect2D *pScissors) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |= ValidateCmdQueueFlags(dev_data, pCB, "vkCmdSetScissor()", VK_QUEUE_GRAPHICS_BIT, VALIDATION_ERROR_1d802415);
@@ -5865,7 +6267,7 @@ VKAPI_ATTR void VKAPI_CALL CmdSetScissor(VkCommandBuffer commandBuffer, uint32_t
 VKAPI_ATTR void VKAPI_CALL CmdSetLineWidth(VkCommandBuffer commandBuffer, float lineWidth) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |= ValidateCmdQueueFlags(dev_data, pCB, "vkCmdSetLineWidth()", VK_QUEUE_GRAPHICS_BIT, VALIDATION_ERROR_1d602415);
@@ -5889,7 +6291,7 @@ VKAPI_ATTR void VKAPI_CALL CmdSetDepthBias(VkCommandBuffer commandBuffer, float
                                            float depthBiasSlopeFactor) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |= ValidateCmdQueueFlags(dev_data, pCB, "vkCmdSetDepthBias()", VK_QUEUE_GRAPHICS_BIT, VALIDATION_ERROR_1cc02415);
@@ -5919,7 +6321,7 @@ VKAPI_ATTR void VKAPI_CALL CmdSetDepthBias(VkCommandBuffer commandBuffer, float
 VKAPI_ATTR void VKAPI_CALL CmdSetBlendConstants(VkCommandBuffer commandBuffer, const float blendConstants[4]) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |= ValidateCmdQueueFlags(dev_data, pCB, "vkCmdSetBlendConstants()", VK_QUEUE_GRAPHICS_BIT, VALIDATION_ERROR_1ca02415);
@@ -5941,7 +6343,7 @@ VKAPI_ATTR void VKAPI_CALL CmdSetBlendConstants(VkCommandBuffer commandBuffer, c
 VKAPI_ATTR void VKAPI_CALL CmdSetDepthBounds(VkCommandBuffer commandBuffer, float minDepthBounds, float maxDepthBounds) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |= ValidateCmdQueueFlags(dev_data, pCB, "vkCmdSetDepthBounds()", VK_QUEUE_GRAPHICS_BIT, VALIDATION_ERROR_1ce02415);
@@ -5964,7 +6366,7 @@ VKAPI_ATTR void VKAPI_CALL CmdSetStencilCompareMask(VkCommandBuffer commandBuffe
                                                     uint32_t compareMask) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |=
@@ -5988,7 +6390,7 @@ VKAPI_ATTR void VKAPI_CALL CmdSetStencilCompareMask(VkCommandBuffer commandBuffe
 VKAPI_ATTR void VKAPI_CALL CmdSetStencilWriteMask(VkCommandBuffer commandBuffer, VkStencilFaceFlags faceMask, uint32_t writeMask) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |=
@@ -6012,7 +6414,7 @@ VKAPI_ATTR void VKAPI_CALL CmdSetStencilWriteMask(VkCommandBuffer commandBuffer,
 VKAPI_ATTR void VKAPI_CALL CmdSetStencilReference(VkCommandBuffer commandBuffer, VkStencilFaceFlags faceMask, uint32_t reference) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |=
@@ -6040,6 +6442,7 @@ static void PreCallRecordCmdBindDescriptorSets(layer_data *device_data, GLOBAL_C
     string error_string = "";
     uint32_t last_set_index = firstSet + setCount - 1;
     auto last_bound = &cb_state->lastBound[pipelineBindPoint];
+    ++last_bound->generation;
 
     if (last_set_index >= last_bound->boundDescriptorSets.size()) {
         last_bound->boundDescriptorSets.resize(last_set_index + 1);
@@ -6202,7 +6605,7 @@ VKAPI_ATTR void VKAPI_CALL CmdBindDescriptorSets(VkCommandBuffer commandBuffer,
                                                  const uint32_t *pDynamicOffsets) {
     bool skip = false;
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(device_data, commandBuffer);
     GLOBAL_CB_NODE *cb_state = GetCBNode(device_data, commandBuffer);
     assert(cb_state);
     skip = PreCallValidateCmdBindDescriptorSets(device_data, cb_state, pipelineBindPoint, layout, firstSet, setCount,
@@ -6294,13 +6697,14 @@ static void PreCallRecordCmdPushDescriptorSetKHR(layer_data *device_data, GLOBAL
         new cvdescriptorset::DescriptorSet(0, 0, layout_state->set_layouts[set], device_data)};
     cb_state->lastBound[pipelineBindPoint].boundDescriptorSets[set] = new_desc.get();
     cb_state->lastBound[pipelineBindPoint].push_descriptor_set = std::move(new_desc);
+    ++cb_state->lastBound[pipelineBindPoint].generation;
 }
 
 VKAPI_ATTR void VKAPI_CALL CmdPushDescriptorSetKHR(VkCommandBuffer commandBuffer, VkPipelineBindPoint pipelineBindPoint,
                                                    VkPipelineLayout layout, uint32_t set, uint32_t descriptorWriteCount,
                                                    const VkWriteDescriptorSet *pDescriptorWrites) {
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(device_data, commandBuffer);
     auto cb_state = GetCBNode(device_data, commandBuffer);
     bool skip = PreCallValidateCmdPushDescriptorSetKHR(device_data, cb_state, pipelineBindPoint, layout, set, descriptorWriteCount,
                                                        pDescriptorWrites, "vkCmdPushDescriptorSetKHR()");
@@ -6330,7 +6734,7 @@ VKAPI_ATTR void VKAPI_CALL CmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkB
                                               VkIndexType indexType) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
 
     auto buffer_state = GetBufferState(dev_data, buffer);
     auto cb_node = GetCBNode(dev_data, commandBuffer);
@@ -6352,10 +6756,9 @@ VKAPI_ATTR void VKAPI_CALL CmdBindIndexBuffer(VkCommandBuffer commandBuffer, VkB
 
     if (skip) return;
 
-    std::function<bool()> function = [=]() {
+    cb_node->queue_submit_functions.emplace_back([=]() {
         return ValidateBufferMemoryIsValid(dev_data, buffer_state, "vkCmdBindIndexBuffer()");
-    };
-    cb_node->queue_submit_functions.push_back(function);
+    });
     cb_node->status |= CBSTATUS_INDEX_BUFFER_BOUND;
 
     lock.unlock();
@@ -6370,6 +6773,7 @@ void updateResourceTracking(GLOBAL_CB_NODE *pCB, uint32_t firstBinding, uint32_t
     for (uint32_t i = 0; i < bindingCount; ++i) {
         pCB->currentDrawData.buffers[i + firstBinding] = pBuffers[i];
     }
+    ++pCB->lastBound[VK_PIPELINE_BIND_POINT_GRAPHICS].generation;
 }
 
 static inline void updateResourceTrackingOnDraw(GLOBAL_CB_NODE *pCB) { pCB->drawData.push_back(pCB->currentDrawData); }
@@ -6378,7 +6782,7 @@ VKAPI_ATTR void VKAPI_CALL CmdBindVertexBuffers(VkCommandBuffer commandBuffer, u
                                                 const VkBuffer *pBuffers, const VkDeviceSize *pOffsets) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
 
     auto cb_node = GetCBNode(dev_data, commandBuffer);
     assert(cb_node);
@@ -6404,10 +6808,9 @@ VKAPI_ATTR void VKAPI_CALL CmdBindVertexBuffers(VkCommandBuffer commandBuffer, u
     for (uint32_t i = 0; i < bindingCount; ++i) {
         auto buffer_state = GetBufferState(dev_data, pBuffers[i]);
         assert(buffer_state);
-        std::function<bool()> function = [=]() {
+        cb_node->queue_submit_functions.emplace_back([=]() {
             return ValidateBufferMemoryIsValid(dev_data, buffer_state, "vkCmdBindVertexBuffers()");
-        };
-        cb_node->queue_submit_functions.push_back(function);
+        });
     }
 
     updateResourceTracking(cb_node, firstBinding, bindingCount, pBuffers);
@@ -6424,20 +6827,18 @@ static void MarkStoreImagesAndBuffersAsWritten(layer_data *dev_data, GLOBAL_CB_N
 
         auto image_state = GetImageState(dev_data, view_state->create_info.image);
         assert(image_state);
-        std::function<bool()> function = [=]() {
+        pCB->queue_submit_functions.emplace_back([=]() {
             SetImageMemoryValid(dev_data, image_state, true);
             return false;
-        };
-        pCB->queue_submit_functions.push_back(function);
+        });
     }
     for (auto buffer : pCB->updateBuffers) {
         auto buffer_state = GetBufferState(dev_data, buffer);
         assert(buffer_state);
-        std::function<bool()> function = [=]() {
+        pCB->queue_submit_functions.emplace_back([=]() {
             SetBufferMemoryValid(dev_data, buffer_state, true);
             return false;
-        };
-        pCB->queue_submit_functions.push_back(function);
+        });
     }
 }
 
@@ -6485,7 +6886,7 @@ VKAPI_ATTR void VKAPI_CALL CmdDraw(VkCommandBuffer commandBuffer, uint32_t verte
                                    uint32_t firstVertex, uint32_t firstInstance) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
     GLOBAL_CB_NODE *cb_state = nullptr;
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     bool skip = PreCallValidateCmdDraw(dev_data, commandBuffer, false, VK_PIPELINE_BIND_POINT_GRAPHICS, &cb_state, "vkCmdDraw()");
     lock.unlock();
     if (!skip) {
@@ -6510,7 +6911,7 @@ VKAPI_ATTR void VKAPI_CALL CmdDrawIndexed(VkCommandBuffer commandBuffer, uint32_
                                           uint32_t firstIndex, int32_t vertexOffset, uint32_t firstInstance) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
     GLOBAL_CB_NODE *cb_state = nullptr;
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     bool skip = PreCallValidateCmdDrawIndexed(dev_data, commandBuffer, true, VK_PIPELINE_BIND_POINT_GRAPHICS, &cb_state,
                                               "vkCmdDrawIndexed()");
     lock.unlock();
@@ -6546,7 +6947,7 @@ VKAPI_ATTR void VKAPI_CALL CmdDrawIndirect(VkCommandBuffer commandBuffer, VkBuff
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
     GLOBAL_CB_NODE *cb_state = nullptr;
     BUFFER_STATE *buffer_state = nullptr;
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     bool skip = PreCallValidateCmdDrawIndirect(dev_data, commandBuffer, buffer, false, VK_PIPELINE_BIND_POINT_GRAPHICS, &cb_state,
                                                &buffer_state, "vkCmdDrawIndirect()");
     lock.unlock();
@@ -6583,7 +6984,7 @@ VKAPI_ATTR void VKAPI_CALL CmdDrawIndexedIndirect(VkCommandBuffer commandBuffer,
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
     GLOBAL_CB_NODE *cb_state = nullptr;
     BUFFER_STATE *buffer_state = nullptr;
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     bool skip = PreCallValidateCmdDrawIndexedIndirect(dev_data, commandBuffer, buffer, true, VK_PIPELINE_BIND_POINT_GRAPHICS,
                                                       &cb_state, &buffer_state, "vkCmdDrawIndexedIndirect()");
     lock.unlock();
@@ -6608,7 +7009,7 @@ static void PostCallRecordCmdDispatch(layer_data *dev_data, GLOBAL_CB_NODE *cb_s
 VKAPI_ATTR void VKAPI_CALL CmdDispatch(VkCommandBuffer commandBuffer, uint32_t x, uint32_t y, uint32_t z) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
     GLOBAL_CB_NODE *cb_state = nullptr;
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     bool skip =
         PreCallValidateCmdDispatch(dev_data, commandBuffer, false, VK_PIPELINE_BIND_POINT_COMPUTE, &cb_state, "vkCmdDispatch()");
     lock.unlock();
@@ -6641,7 +7042,7 @@ VKAPI_ATTR void VKAPI_CALL CmdDispatchIndirect(VkCommandBuffer commandBuffer, Vk
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
     GLOBAL_CB_NODE *cb_state = nullptr;
     BUFFER_STATE *buffer_state = nullptr;
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     bool skip = PreCallValidateCmdDispatchIndirect(dev_data, commandBuffer, buffer, false, VK_PIPELINE_BIND_POINT_COMPUTE,
                                                    &cb_state, &buffer_state, "vkCmdDispatchIndirect()");
     lock.unlock();
@@ -6656,7 +7057,7 @@ VKAPI_ATTR void VKAPI_CALL CmdDispatchIndirect(VkCommandBuffer commandBuffer, Vk
 VKAPI_ATTR void VKAPI_CALL CmdCopyBuffer(VkCommandBuffer commandBuffer, VkBuffer srcBuffer, VkBuffer dstBuffer,
                                          uint32_t regionCount, const VkBufferCopy *pRegions) {
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(device_data, commandBuffer);
 
     auto cb_node = GetCBNode(device_data, commandBuffer);
     auto src_buffer_state = GetBufferState(device_data, srcBuffer);
@@ -6680,7 +7081,7 @@ VKAPI_ATTR void VKAPI_CALL CmdCopyImage(VkCommandBuffer commandBuffer, VkImage s
                                         const VkImageCopy *pRegions) {
     bool skip = false;
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(device_data, commandBuffer);
 
     auto cb_node = GetCBNode(device_data, commandBuffer);
     auto src_image_state = GetImageState(device_data, srcImage);
@@ -6719,7 +7120,7 @@ VKAPI_ATTR void VKAPI_CALL CmdBlitImage(VkCommandBuffer commandBuffer, VkImage s
                                         VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount,
                                         const VkImageBlit *pRegions, VkFilter filter) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
 
     auto cb_node = GetCBNode(dev_data, commandBuffer);
     auto src_image_state = GetImageState(dev_data, srcImage);
@@ -6741,7 +7142,7 @@ VKAPI_ATTR void VKAPI_CALL CmdCopyBufferToImage(VkCommandBuffer commandBuffer, V
                                                 VkImageLayout dstImageLayout, uint32_t regionCount,
                                                 const VkBufferImageCopy *pRegions) {
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(device_data, commandBuffer);
     bool skip = false;
     auto cb_node = GetCBNode(device_data, commandBuffer);
     auto src_buffer_state = GetBufferState(device_data, srcBuffer);
@@ -6766,7 +7167,7 @@ VKAPI_ATTR void VKAPI_CALL CmdCopyImageToBuffer(VkCommandBuffer commandBuffer, V
                                                 VkBuffer dstBuffer, uint32_t regionCount, const VkBufferImageCopy *pRegions) {
     bool skip = false;
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(device_data, commandBuffer);
 
     auto cb_node = GetCBNode(device_data, commandBuffer);
     auto src_image_state = GetImageState(device_data, srcImage);
@@ -6803,18 +7204,17 @@ static bool PreCallCmdUpdateBuffer(layer_data *device_data, const GLOBAL_CB_NODE
 static void PostCallRecordCmdUpdateBuffer(layer_data *device_data, GLOBAL_CB_NODE *cb_state, BUFFER_STATE *dst_buffer_state) {
     // Update bindings between buffer and cmd buffer
     AddCommandBufferBindingBuffer(device_data, cb_state, dst_buffer_state);
-    std::function<bool()> function = [=]() {
+    cb_state->queue_submit_functions.emplace_back([=]() {
         SetBufferMemoryValid(device_data, dst_buffer_state, true);
         return false;
-    };
-    cb_state->queue_submit_functions.push_back(function);
+    });
 }
 
 VKAPI_ATTR void VKAPI_CALL CmdUpdateBuffer(VkCommandBuffer commandBuffer, VkBuffer dstBuffer, VkDeviceSize dstOffset,
                                            VkDeviceSize dataSize, const uint32_t *pData) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
 
     auto cb_state = GetCBNode(dev_data, commandBuffer);
     assert(cb_state);
@@ -6833,7 +7233,7 @@ VKAPI_ATTR void VKAPI_CALL CmdUpdateBuffer(VkCommandBuffer commandBuffer, VkBuff
 VKAPI_ATTR void VKAPI_CALL CmdFillBuffer(VkCommandBuffer commandBuffer, VkBuffer dstBuffer, VkDeviceSize dstOffset,
                                          VkDeviceSize size, uint32_t data) {
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(device_data, commandBuffer);
     auto cb_node = GetCBNode(device_data, commandBuffer);
     auto buffer_state = GetBufferState(device_data, dstBuffer);
 
@@ -6856,7 +7256,7 @@ VKAPI_ATTR void VKAPI_CALL CmdClearAttachments(VkCommandBuffer commandBuffer, ui
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
     {
-        lock_guard_t lock(global_lock);
+        record_lock_t lock(dev_data, commandBuffer);
         skip = PreCallValidateCmdClearAttachments(dev_data, commandBuffer, attachmentCount, pAttachments, rectCount, pRects);
     }
     if (!skip) dev_data->dispatch_table.CmdClearAttachments(commandBuffer, attachmentCount, pAttachments, rectCount, pRects);
@@ -6866,7 +7266,7 @@ VKAPI_ATTR void VKAPI_CALL CmdClearColorImage(VkCommandBuffer commandBuffer, VkI
                                               const VkClearColorValue *pColor, uint32_t rangeCount,
                                               const VkImageSubresourceRange *pRanges) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
 
     bool skip = PreCallValidateCmdClearColorImage(dev_data, commandBuffer, image, imageLayout, rangeCount, pRanges);
     if (!skip) {
@@ -6880,7 +7280,7 @@ VKAPI_ATTR void VKAPI_CALL CmdClearDepthStencilImage(VkCommandBuffer commandBuff
                                                      const VkClearDepthStencilValue *pDepthStencil, uint32_t rangeCount,
                                                      const VkImageSubresourceRange *pRanges) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
 
     bool skip = PreCallValidateCmdClearDepthStencilImage(dev_data, commandBuffer, image, imageLayout, rangeCount, pRanges);
     if (!skip) {
@@ -6894,7 +7294,7 @@ VKAPI_ATTR void VKAPI_CALL CmdResolveImage(VkCommandBuffer commandBuffer, VkImag
                                            VkImage dstImage, VkImageLayout dstImageLayout, uint32_t regionCount,
                                            const VkImageResolve *pRegions) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
 
     auto cb_node = GetCBNode(dev_data, commandBuffer);
     auto src_image_state = GetImageState(dev_data, srcImage);
@@ -6929,8 +7329,8 @@ bool setEventStageMask(VkQueue queue, VkCommandBuffer commandBuffer, VkEvent eve
         pCB->eventToStageMap[event] = stageMask;
     }
     auto queue_data = dev_data->queueMap.find(queue);
-    if (queue_data != dev_data->queueMap.end()) {
-        queue_data->second.eventToStageMap[event] = stageMask;
+    if (queue_data) {
+        queue_data->eventToStageMap[event] = stageMask;
     }
     return false;
 }
@@ -6938,7 +7338,7 @@ bool setEventStageMask(VkQueue queue, VkCommandBuffer commandBuffer, VkEvent eve
 VKAPI_ATTR void VKAPI_CALL CmdSetEvent(VkCommandBuffer commandBuffer, VkEvent event, VkPipelineStageFlags stageMask) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |= ValidateCmdQueueFlags(dev_data, pCB, "vkCmdSetEvent()", VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT,
@@ -6950,7 +7350,6 @@ VKAPI_ATTR void VKAPI_CALL CmdSetEvent(VkCommandBuffer commandBuffer, VkEvent ev
         auto event_state = GetEventNode(dev_data, event);
         if (event_state) {
             addCommandBufferBinding(&event_state->cb_bindings, {HandleToUint64(event), kVulkanObjectTypeEvent}, pCB);
-            event_state->cb_bindings.insert(pCB);
         }
         pCB->events.push_back(event);
         if (!pCB->waitedEvents.count(event)) {
@@ -6965,7 +7364,7 @@ VKAPI_ATTR void VKAPI_CALL CmdSetEvent(VkCommandBuffer commandBuffer, VkEvent ev
 VKAPI_ATTR void VKAPI_CALL CmdResetEvent(VkCommandBuffer commandBuffer, VkEvent event, VkPipelineStageFlags stageMask) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |= ValidateCmdQueueFlags(dev_data, pCB, "vkCmdResetEvent()", VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT,
@@ -6977,7 +7376,6 @@ VKAPI_ATTR void VKAPI_CALL CmdResetEvent(VkCommandBuffer commandBuffer, VkEvent
         auto event_state = GetEventNode(dev_data, event);
         if (event_state) {
             addCommandBufferBinding(&event_state->cb_bindings, {HandleToUint64(event), kVulkanObjectTypeEvent}, pCB);
-            event_state->cb_bindings.insert(pCB);
         }
         pCB->events.push_back(event);
         if (!pCB->waitedEvents.count(event)) {
@@ -7386,9 +7784,9 @@ class ValidatorState {
     static bool ValidateAtQueueSubmit(const VkQueue queue, const layer_data *device_data, uint32_t src_family, uint32_t dst_family,
                                       const ValidatorState &val) {
         auto queue_data_it = device_data->queueMap.find(queue);
-        if (queue_data_it == device_data->queueMap.end()) return false;
+        if (!queue_data_it) return false;
 
-        uint32_t queue_family = queue_data_it->second.queueFamilyIndex;
+        uint32_t queue_family = queue_data_it->queueFamilyIndex;
         if ((src_family != queue_family) && (dst_family != queue_family)) {
             const UNIQUE_VALIDATION_ERROR_CODE val_code = val.val_codes_[kSubmitQueueMustMatchSrcOrDst];
             const char *src_annotation = val.GetFamilyAnnotation(src_family);
@@ -7657,9 +8055,9 @@ bool validateEventStageMask(VkQueue queue, GLOBAL_CB_NODE *pCB, uint32_t eventCo
     for (uint32_t i = 0; i < eventCount; ++i) {
         auto event = pCB->events[firstEventIndex + i];
         auto queue_data = dev_data->queueMap.find(queue);
-        if (queue_data == dev_data->queueMap.end()) return false;
-        auto event_data = queue_data->second.eventToStageMap.find(event);
-        if (event_data != queue_data->second.eventToStageMap.end()) {
+        if (!queue_data) return false;
+        auto event_data = queue_data->eventToStageMap.find(event);
+        if (event_data != queue_data->eventToStageMap.end()) {
             stageMask |= event_data->second;
         } else {
             auto global_event_data = GetEventNode(dev_data, event);
@@ -7771,7 +8169,7 @@ VKAPI_ATTR void VKAPI_CALL CmdWaitEvents(VkCommandBuffer commandBuffer, uint32_t
                                          uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *cb_state = GetCBNode(dev_data, commandBuffer);
     if (cb_state) {
         skip |= ValidateStageMasksAgainstQueueCapabilities(dev_data, cb_state, sourceStageMask, dstStageMask, "vkCmdWaitEvents",
@@ -7794,7 +8192,6 @@ VKAPI_ATTR void VKAPI_CALL CmdWaitEvents(VkCommandBuffer commandBuffer, uint32_t
                 if (event_state) {
                     addCommandBufferBinding(&event_state->cb_bindings, {HandleToUint64(pEvents[i]), kVulkanObjectTypeEvent},
                                             cb_state);
-                    event_state->cb_bindings.insert(cb_state);
                 }
                 cb_state->waitedEvents.insert(pEvents[i]);
                 cb_state->events.push_back(pEvents[i]);
@@ -7852,7 +8249,7 @@ VKAPI_ATTR void VKAPI_CALL CmdPipelineBarrier(VkCommandBuffer commandBuffer, VkP
                                               uint32_t imageMemoryBarrierCount, const VkImageMemoryBarrier *pImageMemoryBarriers) {
     bool skip = false;
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(device_data, commandBuffer);
     GLOBAL_CB_NODE *cb_state = GetCBNode(device_data, commandBuffer);
     if (cb_state) {
         skip |= PreCallValidateCmdPipelineBarrier(device_data, cb_state, srcStageMask, dstStageMask, dependencyFlags,
@@ -7879,8 +8276,8 @@ static bool setQueryState(VkQueue queue, VkCommandBuffer commandBuffer, QueryObj
         pCB->queryToStateMap[object] = value;
     }
     auto queue_data = dev_data->queueMap.find(queue);
-    if (queue_data != dev_data->queueMap.end()) {
-        queue_data->second.queryToStateMap[object] = value;
+    if (queue_data) {
+        queue_data->queryToStateMap[object] = value;
     }
     return false;
 }
@@ -7888,7 +8285,7 @@ static bool setQueryState(VkQueue queue, VkCommandBuffer commandBuffer, QueryObj
 VKAPI_ATTR void VKAPI_CALL CmdBeginQuery(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t slot, VkFlags flags) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |= ValidateCmdQueueFlags(dev_data, pCB, "vkCmdBeginQuery()", VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT,
@@ -7914,7 +8311,7 @@ VKAPI_ATTR void VKAPI_CALL CmdBeginQuery(VkCommandBuffer commandBuffer, VkQueryP
 VKAPI_ATTR void VKAPI_CALL CmdEndQuery(VkCommandBuffer commandBuffer, VkQueryPool queryPool, uint32_t slot) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     QueryObject query = {queryPool, slot};
     GLOBAL_CB_NODE *cb_state = GetCBNode(dev_data, commandBuffer);
     if (cb_state) {
@@ -7947,7 +8344,7 @@ VKAPI_ATTR void VKAPI_CALL CmdResetQueryPool(VkCommandBuffer commandBuffer, VkQu
                                              uint32_t queryCount) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *cb_state = GetCBNode(dev_data, commandBuffer);
     skip |= insideRenderPass(dev_data, cb_state, "vkCmdResetQueryPool()", VALIDATION_ERROR_1c600017);
     skip |= ValidateCmd(dev_data, cb_state, CMD_RESETQUERYPOOL, "VkCmdResetQueryPool()");
@@ -8003,7 +8400,7 @@ VKAPI_ATTR void VKAPI_CALL CmdCopyQueryPoolResults(VkCommandBuffer commandBuffer
                                                    VkDeviceSize stride, VkQueryResultFlags flags) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
 
     auto cb_node = GetCBNode(dev_data, commandBuffer);
     auto dst_buff_state = GetBufferState(dev_data, dstBuffer);
@@ -8042,7 +8439,7 @@ VKAPI_ATTR void VKAPI_CALL CmdPushConstants(VkCommandBuffer commandBuffer, VkPip
                                             uint32_t offset, uint32_t size, const void *pValues) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *cb_state = GetCBNode(dev_data, commandBuffer);
     if (cb_state) {
         skip |= ValidateCmdQueueFlags(dev_data, cb_state, "vkCmdPushConstants()", VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT,
@@ -8087,7 +8484,7 @@ VKAPI_ATTR void VKAPI_CALL CmdWriteTimestamp(VkCommandBuffer commandBuffer, VkPi
                                              VkQueryPool queryPool, uint32_t slot) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *cb_state = GetCBNode(dev_data, commandBuffer);
     if (cb_state) {
         skip |= ValidateCmdQueueFlags(dev_data, cb_state, "vkCmdWriteTimestamp()", VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT,
@@ -8601,15 +8998,19 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateShaderModule(VkDevice device, const VkShade
                                                   const VkAllocationCallbacks *pAllocator, VkShaderModule *pShaderModule) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(device), layer_data_map);
     bool spirv_valid;
+    bool spirv_deferred;
 
-    if (PreCallValidateCreateShaderModule(dev_data, pCreateInfo, &spirv_valid)) return VK_ERROR_VALIDATION_FAILED_EXT;
+    // Nothing here touches state that global_lock guards: the validator context is shared read-only, the validation
+    // caches lock themselves and shaderModuleMap is safe for concurrent use
+    if (PreCallValidateCreateShaderModule(dev_data, pCreateInfo, &spirv_valid, &spirv_deferred)) {
+        return VK_ERROR_VALIDATION_FAILED_EXT;
+    }
 
     VkResult res = dev_data->dispatch_table.CreateShaderModule(device, pCreateInfo, pAllocator, pShaderModule);
 
     if (res == VK_SUCCESS) {
-        lock_guard_t lock(global_lock);
-        unique_ptr<shader_module> new_shader_module(spirv_valid ? new shader_module(pCreateInfo) : new shader_module());
-        dev_data->shaderModuleMap[*pShaderModule] = std::move(new_shader_module);
+        dev_data->shaderModuleMap.insert_or_assign(
+            *pShaderModule, PostCallRecordCreateShaderModule(dev_data, pCreateInfo, spirv_valid, spirv_deferred));
     }
     return res;
 }
@@ -8883,7 +9284,7 @@ VKAPI_ATTR void VKAPI_CALL CmdBeginRenderPass(VkCommandBuffer commandBuffer, con
                                               VkSubpassContents contents) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *cb_node = GetCBNode(dev_data, commandBuffer);
     auto render_pass_state = pRenderPassBegin ? GetRenderPassState(dev_data, pRenderPassBegin->renderPass) : nullptr;
     auto framebuffer = pRenderPassBegin ? GetFramebufferState(dev_data, pRenderPassBegin->framebuffer) : nullptr;
@@ -8897,32 +9298,28 @@ VKAPI_ATTR void VKAPI_CALL CmdBeginRenderPass(VkCommandBuffer commandBuffer, con
                 if (FormatSpecificLoadAndStoreOpSettings(pAttachment->format, pAttachment->loadOp, pAttachment->stencilLoadOp,
                                                          VK_ATTACHMENT_LOAD_OP_CLEAR)) {
                     clear_op_size = static_cast<uint32_t>(i) + 1;
-                    std::function<bool()> function = [=]() {
+                    cb_node->queue_submit_functions.emplace_back([=]() {
                         SetImageMemoryValid(dev_data, GetImageState(dev_data, fb_info.image), true);
                         return false;
-                    };
-                    cb_node->queue_submit_functions.push_back(function);
+                    });
                 } else if (FormatSpecificLoadAndStoreOpSettings(pAttachment->format, pAttachment->loadOp,
                                                                 pAttachment->stencilLoadOp, VK_ATTACHMENT_LOAD_OP_DONT_CARE)) {
-                    std::function<bool()> function = [=]() {
+                    cb_node->queue_submit_functions.emplace_back([=]() {
                         SetImageMemoryValid(dev_data, GetImageState(dev_data, fb_info.image), false);
                         return false;
-                    };
-                    cb_node->queue_submit_functions.push_back(function);
+                    });
                 } else if (FormatSpecificLoadAndStoreOpSettings(pAttachment->format, pAttachment->loadOp,
                                                                 pAttachment->stencilLoadOp, VK_ATTACHMENT_LOAD_OP_LOAD)) {
-                    std::function<bool()> function = [=]() {
+                    cb_node->queue_submit_functions.emplace_back([=]() {
                         return ValidateImageMemoryIsValid(dev_data, GetImageState(dev_data, fb_info.image),
                                                           "vkCmdBeginRenderPass()");
-                    };
-                    cb_node->queue_submit_functions.push_back(function);
+                    });
                 }
                 if (render_pass_state->attachment_first_read[i]) {
-                    std::function<bool()> function = [=]() {
+                    cb_node->queue_submit_functions.emplace_back([=]() {
                         return ValidateImageMemoryIsValid(dev_data, GetImageState(dev_data, fb_info.image),
                                                           "vkCmdBeginRenderPass()");
-                    };
-                    cb_node->queue_submit_functions.push_back(function);
+                    });
                 }
             }
             if (clear_op_size > pRenderPassBegin->clearValueCount) {
@@ -8975,7 +9372,7 @@ VKAPI_ATTR void VKAPI_CALL CmdBeginRenderPass(VkCommandBuffer commandBuffer, con
 VKAPI_ATTR void VKAPI_CALL CmdNextSubpass(VkCommandBuffer commandBuffer, VkSubpassContents contents) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     GLOBAL_CB_NODE *pCB = GetCBNode(dev_data, commandBuffer);
     if (pCB) {
         skip |= validatePrimaryCommandBuffer(dev_data, pCB, "vkCmdNextSubpass()", VALIDATION_ERROR_1b600019);
@@ -9009,7 +9406,7 @@ VKAPI_ATTR void VKAPI_CALL CmdNextSubpass(VkCommandBuffer commandBuffer, VkSubpa
 VKAPI_ATTR void VKAPI_CALL CmdEndRenderPass(VkCommandBuffer commandBuffer) {
     bool skip = false;
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     auto pCB = GetCBNode(dev_data, commandBuffer);
     FRAMEBUFFER_STATE *framebuffer = NULL;
     if (pCB) {
@@ -9028,18 +9425,16 @@ VKAPI_ATTR void VKAPI_CALL CmdEndRenderPass(VkCommandBuffer commandBuffer) {
                 auto pAttachment = &rp_state->createInfo.pAttachments[i];
                 if (FormatSpecificLoadAndStoreOpSettings(pAttachment->format, pAttachment->storeOp, pAttachment->stencilStoreOp,
                                                          VK_ATTACHMENT_STORE_OP_STORE)) {
-                    std::function<bool()> function = [=]() {
+                    pCB->queue_submit_functions.emplace_back([=]() {
                         SetImageMemoryValid(dev_data, GetImageState(dev_data, fb_info.image), true);
                         return false;
-                    };
-                    pCB->queue_submit_functions.push_back(function);
+                    });
                 } else if (FormatSpecificLoadAndStoreOpSettings(pAttachment->format, pAttachment->storeOp,
                                                                 pAttachment->stencilStoreOp, VK_ATTACHMENT_STORE_OP_DONT_CARE)) {
-                    std::function<bool()> function = [=]() {
+                    pCB->queue_submit_functions.emplace_back([=]() {
                         SetImageMemoryValid(dev_data, GetImageState(dev_data, fb_info.image), false);
                         return false;
-                    };
-                    pCB->queue_submit_functions.push_back(function);
+                    });
                 }
             }
         }
@@ -9099,34 +9494,34 @@ static bool validateSecondaryCommandBufferState(layer_data *dev_data, GLOBAL_CB_
     unordered_set<int> activeTypes;
     for (auto queryObject : pCB->activeQueries) {
         auto queryPoolData = dev_data->queryPoolMap.find(queryObject.pool);
-        if (queryPoolData != dev_data->queryPoolMap.end()) {
-            if (queryPoolData->second.createInfo.queryType == VK_QUERY_TYPE_PIPELINE_STATISTICS &&
+        if (queryPoolData) {
+            if (queryPoolData->createInfo.queryType == VK_QUERY_TYPE_PIPELINE_STATISTICS &&
                 pSubCB->beginInfo.pInheritanceInfo) {
                 VkQueryPipelineStatisticFlags cmdBufStatistics = pSubCB->beginInfo.pInheritanceInfo->pipelineStatistics;
-                if ((cmdBufStatistics & queryPoolData->second.createInfo.pipelineStatistics) != cmdBufStatistics) {
+                if ((cmdBufStatistics & queryPoolData->createInfo.pipelineStatistics) != cmdBufStatistics) {
                     skip |= log_msg(
                         dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT,
                         HandleToUint64(pCB->commandBuffer), __LINE__, VALIDATION_ERROR_1b2000d0, "DS",
                         "vkCmdExecuteCommands() called w/ invalid Cmd Buffer 0x%" PRIx64
                         " which has invalid active query pool 0x%" PRIx64
                         ". Pipeline statistics is being queried so the command buffer must have all bits set on the queryPool. %s",
-                        HandleToUint64(pCB->commandBuffer), HandleToUint64(queryPoolData->first),
+                        HandleToUint64(pCB->commandBuffer), HandleToUint64(queryObject.pool),
                         validation_error_map[VALIDATION_ERROR_1b2000d0]);
                 }
             }
-            activeTypes.insert(queryPoolData->second.createInfo.queryType);
+            activeTypes.insert(queryPoolData->createInfo.queryType);
         }
     }
     for (auto queryObject : pSubCB->startedQueries) {
         auto queryPoolData = dev_data->queryPoolMap.find(queryObject.pool);
-        if (queryPoolData != dev_data->queryPoolMap.end() && activeTypes.count(queryPoolData->second.createInfo.queryType)) {
+        if (queryPoolData && activeTypes.count(queryPoolData->createInfo.queryType)) {
             skip |= log_msg(dev_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_COMMAND_BUFFER_EXT,
                             HandleToUint64(pCB->commandBuffer), __LINE__, DRAWSTATE_INVALID_SECONDARY_COMMAND_BUFFER, "DS",
                             "vkCmdExecuteCommands() called w/ invalid Cmd Buffer 0x%" PRIx64
                             " which has invalid active query pool 0x%" PRIx64
                             " of type %d but a query of that type has been started on secondary Cmd Buffer 0x%" PRIx64 ".",
-                            HandleToUint64(pCB->commandBuffer), HandleToUint64(queryPoolData->first),
-                            queryPoolData->second.createInfo.queryType, HandleToUint64(pSubCB->commandBuffer));
+                            HandleToUint64(pCB->commandBuffer), HandleToUint64(queryObject.pool),
+                            queryPoolData->createInfo.queryType, HandleToUint64(pSubCB->commandBuffer));
         }
     }
 
@@ -9230,28 +9625,21 @@ VKAPI_ATTR void VKAPI_CALL CmdExecuteCommands(VkCommandBuffer commandBuffer, uin
             }
             // TODO: separate validate from update! This is very tangled.
             // Propagate layout transitions to the primary cmd buffer
-            for (auto ilm_entry : pSubCB->imageLayoutMap) {
-                if (pCB->imageLayoutMap.find(ilm_entry.first) != pCB->imageLayoutMap.end()) {
-                    pCB->imageLayoutMap[ilm_entry.first].layout = ilm_entry.second.layout;
-                } else {
-                    assert(ilm_entry.first.hasSubresource);
-                    IMAGE_CMD_BUF_LAYOUT_NODE node;
-                    if (!FindCmdBufLayout(dev_data, pCB, ilm_entry.first.image, ilm_entry.first.subresource, node)) {
-                        node.initialLayout = ilm_entry.second.initialLayout;
-                    }
-                    node.layout = ilm_entry.second.layout;
-                    SetLayout(dev_data, pCB, ilm_entry.first, node);
+            for (const auto &sub_image_layouts : pSubCB->imageLayoutMap) {
+                auto &image_layouts = pCB->imageLayoutMap[sub_image_layouts.first];
+                image_layouts.subresource_index = sub_image_layouts.second.subresource_index;
+                for (const auto &sub_range : sub_image_layouts.second.ranges) {
+                    image_layouts.ranges.update(sub_range.begin, sub_range.end, [&sub_range](const IMAGE_CMD_BUF_LAYOUT_NODE *node) {
+                        return IMAGE_CMD_BUF_LAYOUT_NODE(node ? node->initialLayout : sub_range.value.initialLayout,
+                                                         sub_range.value.layout);
+                    });
                 }
             }
             pSubCB->primaryCommandBuffer = pCB->commandBuffer;
             pCB->linkedCommandBuffers.insert(pSubCB);
             pSubCB->linkedCommandBuffers.insert(pCB);
-            for (auto &function : pSubCB->queryUpdates) {
-                pCB->queryUpdates.push_back(function);
-            }
-            for (auto &function : pSubCB->queue_submit_functions) {
-                pCB->queue_submit_functions.push_back(function);
-            }
+            pCB->queryUpdates.append(pSubCB->queryUpdates);
+            pCB->queue_submit_functions.append(pSubCB->queue_submit_functions);
         }
         skip |= validatePrimaryCommandBuffer(dev_data, pCB, "vkCmdExecuteCommands()", VALIDATION_ERROR_1b200019);
         skip |=
@@ -9624,9 +10012,9 @@ VKAPI_ATTR VkResult VKAPI_CALL SetEvent(VkDevice device, VkEvent event) {
     // Host setting event is visible to all queues immediately so update stageMask for any queue that's seen this event
     // TODO : For correctness this needs separate fix to verify that app doesn't make incorrect assumptions about the
     // ordering of this command in relation to vkCmd[Set|Reset]Events (see GH297)
-    for (auto queue_data : dev_data->queueMap) {
-        auto event_entry = queue_data.second.eventToStageMap.find(event);
-        if (event_entry != queue_data.second.eventToStageMap.end()) {
+    for (auto queue_data : dev_data->queueMap.snapshot()) {
+        auto event_entry = queue_data.second->eventToStageMap.find(event);
+        if (event_entry != queue_data.second->eventToStageMap.end()) {
             event_entry->second |= VK_PIPELINE_STAGE_HOST_BIT;
         }
     }
@@ -10382,16 +10770,7 @@ VKAPI_ATTR void VKAPI_CALL DestroySwapchainKHR(VkDevice device, VkSwapchainKHR s
     if (swapchain_data) {
         if (swapchain_data->images.size() > 0) {
             for (auto swapchain_image : swapchain_data->images) {
-                auto image_sub = dev_data->imageSubresourceMap.find(swapchain_image);
-                if (image_sub != dev_data->imageSubresourceMap.end()) {
-                    for (auto imgsubpair : image_sub->second) {
-                        auto image_item = dev_data->imageLayoutMap.find(imgsubpair);
-                        if (image_item != dev_data->imageLayoutMap.end()) {
-                            dev_data->imageLayoutMap.erase(image_item);
-                        }
-                    }
-                    dev_data->imageSubresourceMap.erase(image_sub);
-                }
+                dev_data->imageLayoutMap.erase(swapchain_image);
                 skip = ClearMemoryObjectBindings(dev_data, HandleToUint64(swapchain_image), kVulkanObjectTypeSwapchainKHR);
                 dev_data->imageMap.erase(swapchain_image);
             }
@@ -10445,9 +10824,6 @@ static void PostCallRecordGetSwapchainImagesKHR(layer_data *device_data, SWAPCHA
         for (uint32_t i = 0; i < *pSwapchainImageCount; ++i) {
             if (swapchain_state->images[i] != VK_NULL_HANDLE) continue;  // Already retrieved this.
 
-            IMAGE_LAYOUT_NODE image_layout_node;
-            image_layout_node.layout = VK_IMAGE_LAYOUT_UNDEFINED;
-            image_layout_node.format = swapchain_state->createInfo.imageFormat;
             // Add imageMap entries for each swapchain image
             VkImageCreateInfo image_ci = {};
             image_ci.flags = 0;
@@ -10467,9 +10843,10 @@ static void PostCallRecordGetSwapchainImagesKHR(layer_data *device_data, SWAPCHA
             image_state->valid = false;
             image_state->binding.mem = MEMTRACKER_SWAP_CHAIN_IMAGE_KEY;
             swapchain_state->images[i] = pSwapchainImages[i];
-            ImageSubresourcePair subpair = {pSwapchainImages[i], false, VkImageSubresource()};
-            device_data->imageSubresourceMap[pSwapchainImages[i]].push_back(subpair);
-            device_data->imageLayoutMap[subpair] = image_layout_node;
+            IMAGE_LAYOUT_NODE &image_layout_node = device_data->imageLayoutMap[pSwapchainImages[i]];
+            image_layout_node.layout = VK_IMAGE_LAYOUT_UNDEFINED;
+            image_layout_node.format = swapchain_state->createInfo.imageFormat;
+            image_layout_node.subresource_layouts.subresource_index = ImageSubresourceIndex(image_ci);
         }
     }
 
@@ -11619,6 +11996,13 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateDescriptorUpdateTemplateKHR(VkDevice device
         safe_VkDescriptorUpdateTemplateCreateInfoKHR *local_create_info =
             new safe_VkDescriptorUpdateTemplateCreateInfoKHR(pCreateInfo);
         std::unique_ptr<TEMPLATE_STATE> template_state(new TEMPLATE_STATE(*pDescriptorUpdateTemplate, local_create_info));
+        if (pCreateInfo->templateType == VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR) {
+            template_state->layout = GetDescriptorSetLayout(dev_data, pCreateInfo->descriptorSetLayout);
+            if (template_state->layout) {
+                cvdescriptorset::CompileUpdateTemplate(template_state->layout.get(), template_state->create_info,
+                                                       &template_state->ops);
+            }
+        }
         dev_data->desc_template_map[*pDescriptorUpdateTemplate] = std::move(template_state);
     }
     return result;
@@ -11634,32 +12018,47 @@ VKAPI_ATTR void VKAPI_CALL DestroyDescriptorUpdateTemplateKHR(VkDevice device,
     dev_data->dispatch_table.DestroyDescriptorUpdateTemplateKHR(device, descriptorUpdateTemplate, pAllocator);
 }
 
+static bool PreCallValidateUpdateDescriptorSetWithTemplateKHR(layer_data *device_data, VkDescriptorSet descriptorSet,
+                                                              VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate,
+                                                              const void *pData) {
+    if (device_data->instance_data->disabled.update_descriptor_sets) return false;
+    auto const template_map_entry = device_data->desc_template_map.find(descriptorUpdateTemplate);
+    if (!template_map_entry) return false;
+    return cvdescriptorset::ValidateUpdateDescriptorSetsWithTemplateKHR(device_data->report_data, device_data, descriptorSet,
+                                                                        *template_map_entry, pData);
+}
+
 // PostCallRecord* handles recording state updates following call down chain to UpdateDescriptorSetsWithTemplate()
 static void PostCallRecordUpdateDescriptorSetWithTemplateKHR(layer_data *device_data, VkDescriptorSet descriptorSet,
                                                              VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate,
                                                              const void *pData) {
     auto const template_map_entry = device_data->desc_template_map.find(descriptorUpdateTemplate);
-    if (template_map_entry == device_data->desc_template_map.end()) {
+    if (!template_map_entry) {
         assert(0);
     }
 
-    cvdescriptorset::PerformUpdateDescriptorSetsWithTemplateKHR(device_data, descriptorSet, template_map_entry->second, pData);
+    cvdescriptorset::PerformUpdateDescriptorSetsWithTemplateKHR(device_data, descriptorSet, *template_map_entry, pData);
 }
 
 VKAPI_ATTR void VKAPI_CALL UpdateDescriptorSetWithTemplateKHR(VkDevice device, VkDescriptorSet descriptorSet,
                                                               VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate,
                                                               const void *pData) {
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(device), layer_data_map);
-    device_data->dispatch_table.UpdateDescriptorSetWithTemplateKHR(device, descriptorSet, descriptorUpdateTemplate, pData);
-
-    PostCallRecordUpdateDescriptorSetWithTemplateKHR(device_data, descriptorSet, descriptorUpdateTemplate, pData);
+    unique_lock_t lock(global_lock);
+    bool skip = PreCallValidateUpdateDescriptorSetWithTemplateKHR(device_data, descriptorSet, descriptorUpdateTemplate, pData);
+    lock.unlock();
+    if (!skip) {
+        device_data->dispatch_table.UpdateDescriptorSetWithTemplateKHR(device, descriptorSet, descriptorUpdateTemplate, pData);
+        lock.lock();
+        PostCallRecordUpdateDescriptorSetWithTemplateKHR(device_data, descriptorSet, descriptorUpdateTemplate, pData);
+    }
 }
 
 VKAPI_ATTR void VKAPI_CALL CmdPushDescriptorSetWithTemplateKHR(VkCommandBuffer commandBuffer,
                                                                VkDescriptorUpdateTemplateKHR descriptorUpdateTemplate,
                                                                VkPipelineLayout layout, uint32_t set, const void *pData) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     bool skip = false;
     GLOBAL_CB_NODE *cb_state = GetCBNode(dev_data, commandBuffer);
     // Minimal validation for command buffer state
@@ -11794,7 +12193,7 @@ VKAPI_ATTR VkResult VKAPI_CALL DebugMarkerSetObjectTagEXT(VkDevice device, VkDeb
 
 VKAPI_ATTR void VKAPI_CALL CmdDebugMarkerBeginEXT(VkCommandBuffer commandBuffer, VkDebugMarkerMarkerInfoEXT *pMarkerInfo) {
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(device_data, commandBuffer);
     bool skip = false;
     GLOBAL_CB_NODE *cb_state = GetCBNode(device_data, commandBuffer);
     // Minimal validation for command buffer state
@@ -11809,7 +12208,7 @@ VKAPI_ATTR void VKAPI_CALL CmdDebugMarkerBeginEXT(VkCommandBuffer commandBuffer,
 
 VKAPI_ATTR void VKAPI_CALL CmdDebugMarkerEndEXT(VkCommandBuffer commandBuffer) {
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(device_data, commandBuffer);
     bool skip = false;
     GLOBAL_CB_NODE *cb_state = GetCBNode(device_data, commandBuffer);
     // Minimal validation for command buffer state
@@ -11830,7 +12229,7 @@ VKAPI_ATTR void VKAPI_CALL CmdDebugMarkerInsertEXT(VkCommandBuffer commandBuffer
 VKAPI_ATTR void VKAPI_CALL CmdSetDiscardRectangleEXT(VkCommandBuffer commandBuffer, uint32_t firstDiscardRectangle,
                                                      uint32_t discardRectangleCount, const VkRect2D *pDiscardRectangles) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     bool skip = false;
     GLOBAL_CB_NODE *cb_state = GetCBNode(dev_data, commandBuffer);
     // Minimal validation for command buffer state
@@ -11848,7 +12247,7 @@ VKAPI_ATTR void VKAPI_CALL CmdSetDiscardRectangleEXT(VkCommandBuffer commandBuff
 VKAPI_ATTR void VKAPI_CALL CmdSetSampleLocationsEXT(VkCommandBuffer commandBuffer,
                                                     const VkSampleLocationsInfoEXT *pSampleLocationsInfo) {
     layer_data *dev_data = GetLayerDataPtr(get_dispatch_key(commandBuffer), layer_data_map);
-    unique_lock_t lock(global_lock);
+    record_lock_t lock(dev_data, commandBuffer);
     bool skip = false;
     GLOBAL_CB_NODE *cb_state = GetCBNode(dev_data, commandBuffer);
     // Minimal validation for command buffer state
@@ -29,14 +29,22 @@
 #include "vk_layer_logging.h"
 #include "vk_object_types.h"
 #include "vk_extension_helper.h"
+#include "vk_layer_arena.h"
+#include "vk_layer_concurrent_map.h"
+#include "vk_layer_dense_map.h"
+#include "vk_layer_interval_tree.h"
+#include "vk_layer_range_map.h"
+#include <algorithm>
 #include <atomic>
 #include <functional>
 #include <map>
 #include <string.h>
+#include <string>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include <list>
 
 // Fwd declarations
@@ -46,6 +54,8 @@ class DescriptorSet;
 }  // namespace cvdescriptorset
 
 struct GLOBAL_CB_NODE;
+class ValidationCache;
+struct spirv_validator;
 
 enum CALL_STATE {
     UNCALLED,       // Function has not been called
@@ -72,6 +82,8 @@ struct COMMAND_POOL_NODE : public BASE_NODE {
     uint32_t queueFamilyIndex;
     // Cmd buffers allocated from this pool
     std::unordered_set<VkCommandBuffer> commandBuffers;
+    // Backing blocks for the validation_arena of each of those cmd buffers
+    vl_arena_block_pool arena_blocks;
 };
 
 // Generic wrapper for vulkan objects
@@ -119,9 +131,14 @@ struct DESCRIPTOR_POOL_STATE : BASE_NODE {
     uint32_t availableSets;  // Available descriptor sets in this pool
 
     safe_VkDescriptorPoolCreateInfo createInfo;
-    std::unordered_set<cvdescriptorset::DescriptorSet *> sets;  // Collection of all sets in this pool
-    std::vector<uint32_t> maxDescriptorTypeCount;               // Max # of descriptors of each type in this pool
-    std::vector<uint32_t> availableDescriptorTypeCount;         // Available # of descriptors of each type in this pool
+    std::vector<cvdescriptorset::DescriptorSet *> sets;  // Collection of all sets in this pool, see DescriptorSet::GetPoolSlot()
+    std::vector<uint32_t> maxDescriptorTypeCount;        // Max # of descriptors of each type in this pool
+    std::vector<uint32_t> availableDescriptorTypeCount;  // Available # of descriptors of each type in this pool
+    // A pool without FREE_DESCRIPTOR_SET_BIT only gives sets back all at once, so its sets and their descriptors are
+    // bump allocated from set_arena and vkResetDescriptorPool releases them in bulk.  Pools that can free individual sets
+    // keep them on the heap.
+    const bool sets_in_arena;
+    vl_arena set_arena;
 
     DESCRIPTOR_POOL_STATE(const VkDescriptorPool pool, const VkDescriptorPoolCreateInfo *pCreateInfo)
         : pool(pool),
@@ -129,7 +146,8 @@ struct DESCRIPTOR_POOL_STATE : BASE_NODE {
           availableSets(pCreateInfo->maxSets),
           createInfo(pCreateInfo),
           maxDescriptorTypeCount(VK_DESCRIPTOR_TYPE_RANGE_SIZE, 0),
-          availableDescriptorTypeCount(VK_DESCRIPTOR_TYPE_RANGE_SIZE, 0) {
+          availableDescriptorTypeCount(VK_DESCRIPTOR_TYPE_RANGE_SIZE, 0),
+          sets_in_arena(!(pCreateInfo->flags & VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT)) {
         // Collect maximums per descriptor type.
         for (uint32_t i = 0; i < createInfo.poolSizeCount; ++i) {
             uint32_t typeIndex = static_cast<uint32_t>(createInfo.pPoolSizes[i].type);
@@ -320,6 +338,8 @@ struct DEVICE_MEM_INFO : public BASE_NODE {
     VkMemoryAllocateInfo alloc_info;
     std::unordered_set<VK_OBJECT> obj_bindings;               // objects bound to this memory
     std::unordered_map<uint64_t, MEMORY_RANGE> bound_ranges;  // Map of object to its binding range
+    // The ranges of bound_ranges indexed by offset, for finding the bindings a range overlaps without visiting all of them
+    vl_interval_tree<VkDeviceSize, MEMORY_RANGE *> bound_range_index;
     // Convenience vectors image/buff handles to speed up iterating over images or buffers independently
     std::unordered_set<uint64_t> bound_images;
     std::unordered_set<uint64_t> bound_buffers;
@@ -366,6 +386,69 @@ class IMAGE_CMD_BUF_LAYOUT_NODE {
     VkImageLayout layout;
 };
 
+inline bool operator==(const IMAGE_CMD_BUF_LAYOUT_NODE &a, const IMAGE_CMD_BUF_LAYOUT_NODE &b) {
+    return a.initialLayout == b.initialLayout && a.layout == b.layout;
+}
+
+// Numbers the subresources of an image by aspect, then mip level, then array layer, so that per-subresource state can be
+// stored as ranges of a single index.  All layers of a mip level, and all levels of an aspect, are contiguous, so a
+// transition of a whole level or a whole image is one range per aspect.
+struct ImageSubresourceIndex {
+    static const uint32_t kAspectCount = 7;  // VK_IMAGE_ASPECT_COLOR_BIT through VK_IMAGE_ASPECT_PLANE_2_BIT_KHR
+
+    uint32_t mip_levels;
+    uint32_t array_layers;
+
+    ImageSubresourceIndex() : mip_levels(0), array_layers(0) {}
+    explicit ImageSubresourceIndex(const VkImageCreateInfo &create_info)
+        : mip_levels(create_info.mipLevels), array_layers(create_info.arrayLayers) {
+        // The depth slices of a 2D array compatible 3D image can have their layouts tracked as array layers
+        if (create_info.flags & VK_IMAGE_CREATE_2D_ARRAY_COMPATIBLE_BIT_KHR) {
+            array_layers = std::max(array_layers, create_info.extent.depth);
+        }
+    }
+
+    uint64_t Encode(uint32_t aspect_index, uint32_t mip_level, uint32_t array_layer) const {
+        return (uint64_t(aspect_index) * mip_levels + mip_level) * array_layers + array_layer;
+    }
+
+    VkImageSubresource Decode(uint64_t index) const {
+        VkImageSubresource subresource;
+        subresource.arrayLayer = static_cast<uint32_t>(index % array_layers);
+        index /= array_layers;
+        subresource.mipLevel = static_cast<uint32_t>(index % mip_levels);
+        subresource.aspectMask = VkImageAspectFlags(1) << (index / mip_levels);
+        return subresource;
+    }
+
+    // Call func(begin, end) for each run of indices making up the given subresources.  Levels and layers beyond the end of
+    // the image are ignored.
+    template <typename F>
+    void ForEachRange(VkImageAspectFlags aspect_mask, uint32_t base_mip_level, uint32_t level_count, uint32_t base_array_layer,
+                      uint32_t layer_count, F func) const {
+        if (base_mip_level >= mip_levels || base_array_layer >= array_layers) return;
+        level_count = std::min(level_count, mip_levels - base_mip_level);
+        layer_count = std::min(layer_count, array_layers - base_array_layer);
+        for (uint32_t aspect_index = 0; aspect_index < kAspectCount; ++aspect_index) {
+            if (!(aspect_mask & (1u << aspect_index))) continue;
+            if (layer_count == array_layers) {
+                func(Encode(aspect_index, base_mip_level, 0), Encode(aspect_index, base_mip_level + level_count, 0));
+            } else {
+                for (uint32_t level = base_mip_level; level < base_mip_level + level_count; ++level) {
+                    func(Encode(aspect_index, level, base_array_layer), Encode(aspect_index, level, base_array_layer + layer_count));
+                }
+            }
+        }
+    }
+};
+
+// Layouts of the subresources of one image, as ranges of ImageSubresourceIndex
+template <typename LAYOUT>
+struct ImageLayoutRanges {
+    ImageSubresourceIndex subresource_index;
+    vl_range_map<uint64_t, LAYOUT> ranges;
+};
+
 // Store the DAG.
 struct DAGNode {
     uint32_t pass;
@@ -478,9 +561,23 @@ enum CBStatusFlagBits {
     // clang-format on
 };
 
+// A run of descriptors within one binding that a descriptor update template writes, resolved against a set layout so that
+//  updates can be applied straight from the application's data
+struct DESCRIPTOR_TEMPLATE_OP {
+    uint32_t global_index;  // First descriptor written, as a global index into the layout
+    uint32_t class_index;   // The same descriptor's position among the layout's descriptors of its class
+    uint32_t count;
+    VkDescriptorType type;  // Type of the binding written
+    size_t offset;          // Offset of the first descriptor's info in the update data
+    size_t stride;
+};
+
 struct TEMPLATE_STATE {
     VkDescriptorUpdateTemplateKHR desc_update_template;
     safe_VkDescriptorUpdateTemplateCreateInfoKHR create_info;
+    // Entries resolved against create_info.descriptorSetLayout when the template was created, for templates that update sets
+    std::shared_ptr<cvdescriptorset::DescriptorSetLayout const> layout;
+    std::vector<DESCRIPTOR_TEMPLATE_OP> ops;
 
     TEMPLATE_STATE(VkDescriptorUpdateTemplateKHR update_template, safe_VkDescriptorUpdateTemplateCreateInfoKHR *pCreateInfo)
         : desc_update_template(update_template), create_info(*pCreateInfo) {}
@@ -507,34 +604,6 @@ struct DRAW_DATA {
     std::vector<VkBuffer> buffers;
 };
 
-struct ImageSubresourcePair {
-    VkImage image;
-    bool hasSubresource;
-    VkImageSubresource subresource;
-};
-
-inline bool operator==(const ImageSubresourcePair &img1, const ImageSubresourcePair &img2) {
-    if (img1.image != img2.image || img1.hasSubresource != img2.hasSubresource) return false;
-    return !img1.hasSubresource ||
-           (img1.subresource.aspectMask == img2.subresource.aspectMask && img1.subresource.mipLevel == img2.subresource.mipLevel &&
-            img1.subresource.arrayLayer == img2.subresource.arrayLayer);
-}
-
-namespace std {
-template <>
-struct hash<ImageSubresourcePair> {
-    size_t operator()(ImageSubresourcePair img) const throw() {
-        size_t hashVal = hash<uint64_t>()(reinterpret_cast<uint64_t &>(img.image));
-        hashVal ^= hash<bool>()(img.hasSubresource);
-        if (img.hasSubresource) {
-            hashVal ^= hash<uint32_t>()(reinterpret_cast<uint32_t &>(img.subresource.aspectMask));
-            hashVal ^= hash<uint32_t>()(img.subresource.mipLevel);
-            hashVal ^= hash<uint32_t>()(img.subresource.arrayLayer);
-        }
-        return hashVal;
-    }
-};
-}  // namespace std
 
 // Store layouts and pushconstants for PipelineLayout
 struct PIPELINE_LAYOUT_NODE {
@@ -642,6 +711,29 @@ class PIPELINE_STATE : public BASE_NODE {
     }
 };
 
+// Everything that the draw-time validation of one bind point depends on, apart from the contents of the bound descriptor
+// sets and the resources they refer to (changing either invalidates the command buffer).  Draws that find the same key as
+// the last draw that validated cleanly have nothing new to check.
+struct DRAW_VALIDATION_KEY {
+    uint64_t bind_generation;            // LAST_BOUND_STATE::generation
+    uint64_t image_layout_change_count;  // GLOBAL_CB_NODE::image_layout_change_count
+    CBStatusFlags status;
+    uint32_t viewport_mask;
+    uint32_t scissor_mask;
+    RENDER_PASS_STATE const *render_pass;
+    uint32_t subpass;
+    CMD_TYPE cmd_type;
+    bool indexed;
+    bool vertex_buffer_used;
+
+    bool operator==(const DRAW_VALIDATION_KEY &rhs) const {
+        return bind_generation == rhs.bind_generation && image_layout_change_count == rhs.image_layout_change_count &&
+               status == rhs.status && viewport_mask == rhs.viewport_mask && scissor_mask == rhs.scissor_mask &&
+               render_pass == rhs.render_pass && subpass == rhs.subpass && cmd_type == rhs.cmd_type && indexed == rhs.indexed &&
+               vertex_buffer_used == rhs.vertex_buffer_used;
+    }
+};
+
 // Track last states that are bound per pipeline bind point (Gfx & Compute)
 struct LAST_BOUND_STATE {
     PIPELINE_STATE *pipeline_state;
@@ -652,6 +744,11 @@ struct LAST_BOUND_STATE {
     std::unique_ptr<cvdescriptorset::DescriptorSet> push_descriptor_set;
     // one dynamic offset per dynamic descriptor bound to this CB
     std::vector<std::vector<uint32_t>> dynamicOffsets;
+    // Bumped by every change to the pipeline, descriptor sets, dynamic offsets or (for graphics) vertex buffers bound here
+    uint64_t generation = 1;
+    // Key of the last draw whose validation reported nothing, and the generation last recorded into the command buffer
+    DRAW_VALIDATION_KEY validated_draw = {};
+    uint64_t recorded_generation = 0;
 
     void reset() {
         pipeline_state = nullptr;
@@ -659,6 +756,7 @@ struct LAST_BOUND_STATE {
         boundDescriptorSets.clear();
         push_descriptor_set = nullptr;
         dynamicOffsets.clear();
+        ++generation;
     }
 };
 // Cmd Buffer Wrapper Struct - TODO : This desperately needs its own class
@@ -689,39 +787,43 @@ struct GLOBAL_CB_NODE : public BASE_NODE {
     VkSubpassContents activeSubpassContents;
     uint32_t activeSubpass;
     VkFramebuffer activeFramebuffer;
-    std::unordered_set<VkFramebuffer> framebuffers;
+    vl_dense_set<VkFramebuffer> framebuffers;
     // Unified data structs to track objects bound to this command buffer as well as object
     //  dependencies that have been broken : either destroyed objects, or updated descriptor sets
-    std::unordered_set<VK_OBJECT> object_bindings;
+    vl_dense_set<VK_OBJECT> object_bindings;
     std::vector<VK_OBJECT> broken_bindings;
 
-    std::unordered_set<VkEvent> waitedEvents;
+    vl_dense_set<VkEvent> waitedEvents;
     std::vector<VkEvent> writeEventsBeforeWait;
     std::vector<VkEvent> events;
-    std::unordered_map<QueryObject, std::unordered_set<VkEvent>> waitedEventsBeforeQueryReset;
-    std::unordered_map<QueryObject, bool> queryToStateMap;  // 0 is unavailable, 1 is available
-    std::unordered_set<QueryObject> activeQueries;
-    std::unordered_set<QueryObject> startedQueries;
-    std::unordered_map<ImageSubresourcePair, IMAGE_CMD_BUF_LAYOUT_NODE> imageLayoutMap;
-    std::unordered_map<VkEvent, VkPipelineStageFlags> eventToStageMap;
+    vl_dense_map<QueryObject, vl_dense_set<VkEvent>> waitedEventsBeforeQueryReset;
+    vl_dense_map<QueryObject, bool> queryToStateMap;  // 0 is unavailable, 1 is available
+    vl_dense_set<QueryObject> activeQueries;
+    vl_dense_set<QueryObject> startedQueries;
+    vl_dense_map<VkImage, ImageLayoutRanges<IMAGE_CMD_BUF_LAYOUT_NODE>> imageLayoutMap;
+    vl_dense_map<VkEvent, VkPipelineStageFlags> eventToStageMap;
     std::vector<DRAW_DATA> drawData;
     DRAW_DATA currentDrawData;
     bool vertex_buffer_used;  // Track for perf warning to make sure any bound vtx buffer used
     VkCommandBuffer primaryCommandBuffer;
     // Track images and buffers that are updated by this CB at the point of a draw
-    std::unordered_set<VkImageView> updateImages;
-    std::unordered_set<VkBuffer> updateBuffers;
+    vl_dense_set<VkImageView> updateImages;
+    vl_dense_set<VkBuffer> updateBuffers;
     // If primary, the secondary command buffers we will call.
     // If secondary, the primary command buffers we will be called by.
-    std::unordered_set<GLOBAL_CB_NODE *> linkedCommandBuffers;
+    vl_dense_set<GLOBAL_CB_NODE *> linkedCommandBuffers;
+    // Storage for the deferred validation calls below, drawn from the command pool's arena_blocks and reset with the CB
+    vl_arena validation_arena;
     // Validation functions run at primary CB queue submit time
-    std::vector<std::function<bool()>> queue_submit_functions;
+    vl_deferred_calls<bool()> queue_submit_functions{&validation_arena};
     // Validation functions run when secondary CB is executed in primary
-    std::vector<std::function<bool(VkFramebuffer)>> cmd_execute_commands_functions;
-    std::unordered_set<VkDeviceMemory> memObjs;
-    std::vector<std::function<bool(VkQueue)>> eventUpdates;
-    std::vector<std::function<bool(VkQueue)>> queryUpdates;
-    std::unordered_set<cvdescriptorset::DescriptorSet *> validated_descriptor_sets;
+    vl_deferred_calls<bool(VkFramebuffer)> cmd_execute_commands_functions{&validation_arena};
+    vl_dense_set<VkDeviceMemory> memObjs;
+    vl_deferred_calls<bool(VkQueue)> eventUpdates{&validation_arena};
+    vl_deferred_calls<bool(VkQueue)> queryUpdates{&validation_arena};
+    vl_dense_set<cvdescriptorset::DescriptorSet *> validated_descriptor_sets;
+    // Serializes recording into this CB when command_buffer_locking is enabled (see record_lock_t)
+    std::mutex record_mutex;
 };
 
 struct SEMAPHORE_WAIT {
@@ -747,9 +849,11 @@ struct CB_SUBMISSION {
     VkFence fence;
 };
 
+// Layout of an image as of the work submitted so far: layout applies to every subresource not in subresource_layouts
 struct IMAGE_LAYOUT_NODE {
-    VkImageLayout layout;
-    VkFormat format;
+    VkImageLayout layout = VK_IMAGE_LAYOUT_MAX_ENUM;
+    VkFormat format = VK_FORMAT_UNDEFINED;
+    ImageLayoutRanges<VkImageLayout> subresource_layouts;
 };
 
 // CHECK_DISABLED struct is a container for bools that can block validation checks from being performed.
@@ -790,6 +894,21 @@ struct CHECK_DISABLED {
     void SetAll(bool value) { std::fill(&command_buffer_state, &shader_validation + 1, value); }
 };
 
+// CORE_VALIDATION_SETTINGS holds the lunarg_core_validation.* options read from vk_layer_settings.txt at CreateInstance
+// time.  Unlike CHECK_DISABLED these do not change which checks run, only how the layer goes about running them.
+struct CORE_VALIDATION_SETTINGS {
+    // Record commands under a per-command-buffer lock instead of exclusively holding the device-wide lock
+    bool command_buffer_locking = false;
+    // Validate vkQueueSubmit on a worker thread after passing the call down the chain
+    bool async_submit_validation = false;
+    // Threads, counting the calling thread, over which the pipelines of a vkCreate*Pipelines batch are validated
+    uint32_t pipeline_validation_threads = 1;
+    // File in which the layer keeps the hashes of shader modules that passed spirv-val, across runs; empty for none
+    std::string validation_cache_file;
+    // Run spirv-val on new shader modules in the background, joining it before the first pipeline that uses the module
+    bool async_shader_module_validation = false;
+};
+
 struct MT_FB_ATTACHMENT_INFO {
     IMAGE_VIEW_STATE *view_state;
     VkImage image;
@@ -852,8 +971,6 @@ bool insideRenderPass(const layer_data *my_data, const GLOBAL_CB_NODE *pCB, cons
                       UNIQUE_VALIDATION_ERROR_CODE msgCode);
 void SetImageMemoryValid(layer_data *dev_data, IMAGE_STATE *image_state, bool valid);
 bool outsideRenderPass(const layer_data *my_data, GLOBAL_CB_NODE *pCB, const char *apiName, UNIQUE_VALIDATION_ERROR_CODE msgCode);
-void SetLayout(GLOBAL_CB_NODE *pCB, ImageSubresourcePair imgpair, const IMAGE_CMD_BUF_LAYOUT_NODE &node);
-void SetLayout(GLOBAL_CB_NODE *pCB, ImageSubresourcePair imgpair, const VkImageLayout &layout);
 bool ValidateImageMemoryIsValid(layer_data *dev_data, IMAGE_STATE *image_state, const char *functionName);
 bool ValidateImageSampleCount(layer_data *dev_data, IMAGE_STATE *image_state, VkSampleCountFlagBits sample_count,
                               const char *location, UNIQUE_VALIDATION_ERROR_CODE msgCode);
@@ -862,6 +979,7 @@ bool ValidateBufferMemoryIsValid(layer_data *dev_data, BUFFER_STATE *buffer_stat
 void SetBufferMemoryValid(layer_data *dev_data, BUFFER_STATE *buffer_state, bool valid);
 bool ValidateCmdSubpassState(const layer_data *dev_data, const GLOBAL_CB_NODE *pCB, const CMD_TYPE cmd_type);
 bool ValidateCmd(layer_data *dev_data, const GLOBAL_CB_NODE *cb_state, const CMD_TYPE cmd, const char *caller_name);
+void InsertCommandBufferBinding(std::unordered_set<GLOBAL_CB_NODE *> *cb_bindings, GLOBAL_CB_NODE *cb_node);
 
 // Prototypes for layer_data accessor functions.  These should be in their own header file at some point
 VkFormatProperties GetFormatProperties(core_validation::layer_data *device_data, VkFormat format);
@@ -870,13 +988,15 @@ VkResult GetImageFormatProperties(core_validation::layer_data *device_data, cons
 const debug_report_data *GetReportData(const layer_data *);
 const VkPhysicalDeviceProperties *GetPhysicalDeviceProperties(layer_data *);
 const CHECK_DISABLED *GetDisables(layer_data *);
-std::unordered_map<VkImage, std::unique_ptr<IMAGE_STATE>> *GetImageMap(core_validation::layer_data *);
-std::unordered_map<VkImage, std::vector<ImageSubresourcePair>> *GetImageSubresourceMap(layer_data *);
-std::unordered_map<ImageSubresourcePair, IMAGE_LAYOUT_NODE> *GetImageLayoutMap(layer_data *);
-std::unordered_map<ImageSubresourcePair, IMAGE_LAYOUT_NODE> const *GetImageLayoutMap(layer_data const *);
-std::unordered_map<VkBuffer, std::unique_ptr<BUFFER_STATE>> *GetBufferMap(layer_data *device_data);
-std::unordered_map<VkBufferView, std::unique_ptr<BUFFER_VIEW_STATE>> *GetBufferViewMap(layer_data *device_data);
-std::unordered_map<VkImageView, std::unique_ptr<IMAGE_VIEW_STATE>> *GetImageViewMap(layer_data *device_data);
+const CORE_VALIDATION_SETTINGS *GetSettings(layer_data *);
+ValidationCache *GetImplicitValidationCache(layer_data *);
+spirv_validator *GetSpirvValidator(layer_data *);
+vl_concurrent_unordered_map<VkImage, std::unique_ptr<IMAGE_STATE>> *GetImageMap(core_validation::layer_data *);
+std::unordered_map<VkImage, IMAGE_LAYOUT_NODE> *GetImageLayoutMap(layer_data *);
+std::unordered_map<VkImage, IMAGE_LAYOUT_NODE> const *GetImageLayoutMap(layer_data const *);
+vl_concurrent_unordered_map<VkBuffer, std::unique_ptr<BUFFER_STATE>> *GetBufferMap(layer_data *device_data);
+vl_concurrent_unordered_map<VkBufferView, std::unique_ptr<BUFFER_VIEW_STATE>> *GetBufferViewMap(layer_data *device_data);
+vl_concurrent_unordered_map<VkImageView, std::unique_ptr<IMAGE_VIEW_STATE>> *GetImageViewMap(layer_data *device_data);
 const DeviceExtensions *GetDeviceExtensions(const layer_data *);
 }  // namespace core_validation
 
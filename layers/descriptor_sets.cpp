@@ -35,16 +35,38 @@ struct BindingNumCmp {
     }
 };
 
-// Construct DescriptorSetLayout instance from given create info
+cvdescriptorset::DescriptorClass cvdescriptorset::GetDescriptorClassFromType(VkDescriptorType type) {
+    switch (type) {
+        case VK_DESCRIPTOR_TYPE_SAMPLER:
+            return PlainSampler;
+        case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+            return ImageSampler;
+        case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+        case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+        case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+            return Image;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
+            return TexelBuffer;
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+        case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+        case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+            return GeneralBuffer;
+        default:
+            assert(0);  // Bad descriptor type specified
+            return GeneralBuffer;
+    }
+}
+
+// Construct DescriptorSetLayoutDef instance from given create info
 // Proactively reserve and resize as possible, as the reallocation was visible in profiling
-cvdescriptorset::DescriptorSetLayout::DescriptorSetLayout(const VkDescriptorSetLayoutCreateInfo *p_create_info,
-                                                          const VkDescriptorSetLayout layout)
-    : layout_(layout),
-      layout_destroyed_(false),
-      flags_(p_create_info->flags),
+cvdescriptorset::DescriptorSetLayoutDef::DescriptorSetLayoutDef(const VkDescriptorSetLayoutCreateInfo *p_create_info)
+    : flags_(p_create_info->flags),
       binding_count_(0),
       descriptor_count_(0),
-      dynamic_descriptor_count_(0) {
+      dynamic_descriptor_count_(0),
+      class_descriptor_counts_{} {
     binding_type_stats_ = {0, 0, 0};
     std::set<const VkDescriptorSetLayoutBinding *, BindingNumCmp> sorted_bindings;
     const uint32_t input_bindings_count = p_create_info->bindingCount;
@@ -86,9 +108,14 @@ cvdescriptorset::DescriptorSetLayout::DescriptorSetLayout(const VkDescriptorSetL
     assert(bindings_.size() == binding_count_);
     uint32_t global_index = 0;
     binding_to_global_index_range_map_.reserve(binding_count_);
+    binding_storage_.reserve(binding_count_);
     // Vector order is finalized so create maps of bindings to descriptors and descriptors to indices
     for (uint32_t i = 0; i < binding_count_; ++i) {
         auto binding_num = bindings_[i].binding;
+        // Place this binding's descriptors after those of the earlier bindings of the same class
+        const auto descriptor_class = GetDescriptorClassFromType(bindings_[i].descriptorType);
+        binding_storage_.push_back({descriptor_class, class_descriptor_counts_[descriptor_class]});
+        class_descriptor_counts_[descriptor_class] += bindings_[i].descriptorCount;
         auto final_index = global_index + bindings_[i].descriptorCount;
         binding_to_global_index_range_map_[binding_num] = IndexRange(global_index, final_index);
         if (final_index != global_index) {
@@ -106,6 +133,91 @@ cvdescriptorset::DescriptorSetLayout::DescriptorSetLayout(const VkDescriptorSetL
     }
 }
 
+bool cvdescriptorset::DescriptorSetLayoutDef::operator==(const DescriptorSetLayoutDef &rhs) const {
+    if (flags_ != rhs.flags_ || binding_count_ != rhs.binding_count_) return false;
+    for (uint32_t i = 0; i < binding_count_; ++i) {
+        const auto &lh_binding = bindings_[i];
+        const auto &rh_binding = rhs.bindings_[i];
+        if (lh_binding.binding != rh_binding.binding || lh_binding.descriptorType != rh_binding.descriptorType ||
+            lh_binding.descriptorCount != rh_binding.descriptorCount || lh_binding.stageFlags != rh_binding.stageFlags ||
+            !lh_binding.pImmutableSamplers != !rh_binding.pImmutableSamplers) {
+            return false;
+        }
+        if (lh_binding.pImmutableSamplers &&
+            !std::equal(lh_binding.pImmutableSamplers, lh_binding.pImmutableSamplers + lh_binding.descriptorCount,
+                        rh_binding.pImmutableSamplers)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// FNV-1a over the values that operator== compares, a word at a time
+size_t cvdescriptorset::DescriptorSetLayoutDef::hash() const {
+    uint64_t hash = 14695981039346656037ULL;
+    auto mix = [&hash](uint64_t value) { hash = (hash ^ value) * 1099511628211ULL; };
+    mix(flags_);
+    mix(binding_count_);
+    for (const auto &binding : bindings_) {
+        mix(binding.binding);
+        mix(binding.descriptorType);
+        mix(binding.descriptorCount);
+        mix(binding.stageFlags);
+        if (binding.pImmutableSamplers) {
+            for (uint32_t i = 0; i < binding.descriptorCount; ++i) mix(HandleToUint64(binding.pImmutableSamplers[i]));
+        }
+    }
+    return static_cast<size_t>(hash);
+}
+
+namespace {
+// The live layout definitions, by hash.  Each definition removes its own entry when the last layout using it goes away.
+struct DescriptorSetLayoutDefTable {
+    std::mutex lock;
+    std::unordered_multimap<size_t, std::weak_ptr<cvdescriptorset::DescriptorSetLayoutDef const>> defs;
+};
+// Never destroyed, so that layouts released during process teardown can still remove their entries
+DescriptorSetLayoutDefTable *const descriptor_set_layout_defs = new DescriptorSetLayoutDefTable;
+}  // namespace
+
+std::shared_ptr<cvdescriptorset::DescriptorSetLayoutDef const> cvdescriptorset::GetCanonicalDescriptorSetLayoutDef(
+    const VkDescriptorSetLayoutCreateInfo *p_create_info) {
+    std::unique_ptr<DescriptorSetLayoutDef> def(new DescriptorSetLayoutDef(p_create_info));
+    const size_t hash = def->hash();
+    auto &table = *descriptor_set_layout_defs;
+    // Any definition looked at here may lose its last other owner meanwhile, and releasing it takes the table lock, so the
+    //  references are only dropped once the lock has been released
+    std::vector<std::shared_ptr<DescriptorSetLayoutDef const>> candidates;
+    std::lock_guard<std::mutex> lock(table.lock);
+    auto range = table.defs.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        candidates.push_back(it->second.lock());
+        if (candidates.back() && *candidates.back() == *def) return candidates.back();
+    }
+    std::shared_ptr<DescriptorSetLayoutDef const> canonical(def.release(), [hash](DescriptorSetLayoutDef const *released) {
+        {
+            auto &table = *descriptor_set_layout_defs;
+            std::lock_guard<std::mutex> lock(table.lock);
+            auto range = table.defs.equal_range(hash);
+            for (auto it = range.first; it != range.second;) {
+                if (it->second.expired()) {
+                    it = table.defs.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+        }
+        delete released;
+    });
+    table.defs.emplace(hash, canonical);
+    return canonical;
+}
+
+// Construct DescriptorSetLayout instance from given create info, sharing the definition of any equal layout
+cvdescriptorset::DescriptorSetLayout::DescriptorSetLayout(const VkDescriptorSetLayoutCreateInfo *p_create_info,
+                                                          const VkDescriptorSetLayout layout)
+    : layout_(layout), layout_destroyed_(false), layout_def_(GetCanonicalDescriptorSetLayoutDef(p_create_info)) {}
+
 // Validate descriptor set layout create info
 bool cvdescriptorset::DescriptorSetLayout::ValidateCreateInfo(const debug_report_data *report_data,
                                                               const VkDescriptorSetLayoutCreateInfo *create_info,
@@ -161,36 +273,36 @@ bool cvdescriptorset::DescriptorSetLayout::ValidateCreateInfo(const debug_report
 // Return valid index or "end" i.e. binding_count_;
 // The asserts in "Get" are reduced to the set where no valid answer(like null or 0) could be given
 // Common code for all binding lookups.
-uint32_t cvdescriptorset::DescriptorSetLayout::GetIndexFromBinding(uint32_t binding) const {
+uint32_t cvdescriptorset::DescriptorSetLayoutDef::GetIndexFromBinding(uint32_t binding) const {
     const auto &bi_itr = binding_to_index_map_.find(binding);
     if (bi_itr != binding_to_index_map_.cend()) return bi_itr->second;
     return GetBindingCount();
 }
-VkDescriptorSetLayoutBinding const *cvdescriptorset::DescriptorSetLayout::GetDescriptorSetLayoutBindingPtrFromIndex(
+VkDescriptorSetLayoutBinding const *cvdescriptorset::DescriptorSetLayoutDef::GetDescriptorSetLayoutBindingPtrFromIndex(
     const uint32_t index) const {
     if (index >= bindings_.size()) return nullptr;
     return bindings_[index].ptr();
 }
 // Return descriptorCount for given index, 0 if index is unavailable
-uint32_t cvdescriptorset::DescriptorSetLayout::GetDescriptorCountFromIndex(const uint32_t index) const {
+uint32_t cvdescriptorset::DescriptorSetLayoutDef::GetDescriptorCountFromIndex(const uint32_t index) const {
     if (index >= bindings_.size()) return 0;
     return bindings_[index].descriptorCount;
 }
 // For the given index, return descriptorType
-VkDescriptorType cvdescriptorset::DescriptorSetLayout::GetTypeFromIndex(const uint32_t index) const {
+VkDescriptorType cvdescriptorset::DescriptorSetLayoutDef::GetTypeFromIndex(const uint32_t index) const {
     assert(index < bindings_.size());
     if (index < bindings_.size()) return bindings_[index].descriptorType;
     return VK_DESCRIPTOR_TYPE_MAX_ENUM;
 }
 // For the given index, return stageFlags
-VkShaderStageFlags cvdescriptorset::DescriptorSetLayout::GetStageFlagsFromIndex(const uint32_t index) const {
+VkShaderStageFlags cvdescriptorset::DescriptorSetLayoutDef::GetStageFlagsFromIndex(const uint32_t index) const {
     assert(index < bindings_.size());
     if (index < bindings_.size()) return bindings_[index].stageFlags;
     return VkShaderStageFlags(0);
 }
 
 // For the given global index, return index
-uint32_t cvdescriptorset::DescriptorSetLayout::GetIndexFromGlobalIndex(const uint32_t global_index) const {
+uint32_t cvdescriptorset::DescriptorSetLayoutDef::GetIndexFromGlobalIndex(const uint32_t global_index) const {
     auto start_it = global_start_to_index_map_.upper_bound(global_index);
     uint32_t index = binding_count_;
     assert(start_it != global_start_to_index_map_.cbegin());
@@ -207,7 +319,7 @@ uint32_t cvdescriptorset::DescriptorSetLayout::GetIndexFromGlobalIndex(const uin
 
 // For the given binding, return the global index range
 // As start and end are often needed in pairs, get both with a single hash lookup.
-const cvdescriptorset::IndexRange &cvdescriptorset::DescriptorSetLayout::GetGlobalIndexRangeFromBinding(
+const cvdescriptorset::IndexRange &cvdescriptorset::DescriptorSetLayoutDef::GetGlobalIndexRangeFromBinding(
     const uint32_t binding) const {
     assert(binding_to_global_index_range_map_.count(binding));
     // In error case max uint32_t so index is out of bounds to break ASAP
@@ -220,7 +332,7 @@ const cvdescriptorset::IndexRange &cvdescriptorset::DescriptorSetLayout::GetGlob
 }
 
 // For given binding, return ptr to ImmutableSampler array
-VkSampler const *cvdescriptorset::DescriptorSetLayout::GetImmutableSamplerPtrFromBinding(const uint32_t binding) const {
+VkSampler const *cvdescriptorset::DescriptorSetLayoutDef::GetImmutableSamplerPtrFromBinding(const uint32_t binding) const {
     const auto &bi_itr = binding_to_index_map_.find(binding);
     if (bi_itr != binding_to_index_map_.end()) {
         return bindings_[bi_itr->second].pImmutableSamplers;
@@ -228,14 +340,14 @@ VkSampler const *cvdescriptorset::DescriptorSetLayout::GetImmutableSamplerPtrFro
     return nullptr;
 }
 // Move to next valid binding having a non-zero binding count
-uint32_t cvdescriptorset::DescriptorSetLayout::GetNextValidBinding(const uint32_t binding) const {
+uint32_t cvdescriptorset::DescriptorSetLayoutDef::GetNextValidBinding(const uint32_t binding) const {
     auto it = non_empty_bindings_.upper_bound(binding);
     assert(it != non_empty_bindings_.cend());
     if (it != non_empty_bindings_.cend()) return *it;
     return GetMaxBinding() + 1;
 }
 // For given index, return ptr to ImmutableSampler array
-VkSampler const *cvdescriptorset::DescriptorSetLayout::GetImmutableSamplerPtrFromIndex(const uint32_t index) const {
+VkSampler const *cvdescriptorset::DescriptorSetLayoutDef::GetImmutableSamplerPtrFromIndex(const uint32_t index) const {
     if (index < bindings_.size()) {
         return bindings_[index].pImmutableSamplers;
     }
@@ -247,17 +359,21 @@ bool cvdescriptorset::DescriptorSetLayout::IsCompatible(DescriptorSetLayout cons
                                                         std::string *error_msg) const {
     // Trivial case
     if (layout_ == rh_ds_layout->GetDescriptorSetLayout()) return true;
-    if (descriptor_count_ != rh_ds_layout->descriptor_count_) {
+    // Layouts created from equal create infos share their definition
+    if (layout_def_ == rh_ds_layout->layout_def_) return true;
+    const auto descriptor_count = GetTotalDescriptorCount();
+    if (descriptor_count != rh_ds_layout->GetTotalDescriptorCount()) {
         std::stringstream error_str;
-        error_str << "DescriptorSetLayout " << layout_ << " has " << descriptor_count_ << " descriptors, but DescriptorSetLayout "
+        error_str << "DescriptorSetLayout " << layout_ << " has " << descriptor_count << " descriptors, but DescriptorSetLayout "
                   << rh_ds_layout->GetDescriptorSetLayout() << ", which comes from pipelineLayout, has "
-                  << rh_ds_layout->descriptor_count_ << " descriptors.";
+                  << rh_ds_layout->GetTotalDescriptorCount() << " descriptors.";
         *error_msg = error_str.str();
         return false;  // trivial fail case
     }
     // Descriptor counts match so need to go through bindings one-by-one
     //  and verify that type and stageFlags match
-    for (auto binding : bindings_) {
+    for (uint32_t i = 0; i < GetBindingCount(); ++i) {
+        const auto &binding = *GetDescriptorSetLayoutBindingPtrFromIndex(i);
         // TODO : Do we also need to check immutable samplers?
         // VkDescriptorSetLayoutBinding *rh_binding;
         if (binding.descriptorCount != rh_ds_layout->GetDescriptorCountFromBinding(binding.binding)) {
@@ -290,7 +406,7 @@ bool cvdescriptorset::DescriptorSetLayout::IsCompatible(DescriptorSetLayout cons
     return true;
 }
 
-bool cvdescriptorset::DescriptorSetLayout::IsNextBindingConsistent(const uint32_t binding) const {
+bool cvdescriptorset::DescriptorSetLayoutDef::IsNextBindingConsistent(const uint32_t binding) const {
     if (!binding_to_index_map_.count(binding + 1)) return false;
     auto const &bi_itr = binding_to_index_map_.find(binding);
     if (bi_itr != binding_to_index_map_.end()) {
@@ -313,7 +429,7 @@ bool cvdescriptorset::DescriptorSetLayout::IsNextBindingConsistent(const uint32_
 //  descriptor updates and verify that for any binding boundaries that are crossed, the next binding(s) are all consistent
 //  Consistency means that their type, stage flags, and whether or not they use immutable samplers matches
 //  If so, return true. If not, fill in error_msg and return false
-bool cvdescriptorset::DescriptorSetLayout::VerifyUpdateConsistency(uint32_t current_binding, uint32_t offset, uint32_t update_count,
+bool cvdescriptorset::DescriptorSetLayoutDef::VerifyUpdateConsistency(uint32_t current_binding, uint32_t offset, uint32_t update_count,
                                                                    const char *type, const VkDescriptorSet set,
                                                                    std::string *error_msg) const {
     // Verify consecutive bindings match (if needed)
@@ -350,63 +466,71 @@ cvdescriptorset::AllocateDescriptorSetsData::AllocateDescriptorSetsData(uint32_t
     : required_descriptors_by_type{}, layout_nodes(count, nullptr) {}
 
 cvdescriptorset::DescriptorSet::DescriptorSet(const VkDescriptorSet set, const VkDescriptorPool pool,
-                                              const std::shared_ptr<DescriptorSetLayout const> &layout, layer_data *dev_data)
+                                              const std::shared_ptr<DescriptorSetLayout const> &layout, layer_data *dev_data,
+                                              vl_arena *arena)
     : some_update_(false),
       set_(set),
       pool_state_(nullptr),
+      pool_slot_(0),
+      arena_allocated_(arena != nullptr),
       p_layout_(layout),
       device_data_(dev_data),
       limits_(GetPhysDevProperties(dev_data)->properties.limits) {
     pool_state_ = GetDescriptorPoolState(dev_data, pool);
-    // Foreach binding, create default descriptors of given type
-    descriptors_.reserve(p_layout_->GetTotalDescriptorCount());
-    for (uint32_t i = 0; i < p_layout_->GetBindingCount(); ++i) {
-        auto type = p_layout_->GetTypeFromIndex(i);
-        switch (type) {
-            case VK_DESCRIPTOR_TYPE_SAMPLER: {
-                auto immut_sampler = p_layout_->GetImmutableSamplerPtrFromIndex(i);
-                for (uint32_t di = 0; di < p_layout_->GetDescriptorCountFromIndex(i); ++di) {
-                    if (immut_sampler) {
-                        descriptors_.emplace_back(new SamplerDescriptor(immut_sampler + di));
-                        some_update_ = true;  // Immutable samplers are updated at creation
-                    } else
-                        descriptors_.emplace_back(new SamplerDescriptor(nullptr));
-                }
-                break;
-            }
-            case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER: {
-                auto immut = p_layout_->GetImmutableSamplerPtrFromIndex(i);
-                for (uint32_t di = 0; di < p_layout_->GetDescriptorCountFromIndex(i); ++di) {
-                    if (immut) {
-                        descriptors_.emplace_back(new ImageSamplerDescriptor(immut + di));
-                        some_update_ = true;  // Immutable samplers are updated at creation
-                    } else
-                        descriptors_.emplace_back(new ImageSamplerDescriptor(nullptr));
-                }
-                break;
+    // Size the updated bitset and each class's records in 64-bit words, so that every array in the block stays aligned
+    auto words = [](size_t bytes) { return (bytes + sizeof(uint64_t) - 1) / sizeof(uint64_t); };
+    const size_t updated_words = (p_layout_->GetTotalDescriptorCount() + 63) / 64;
+    const size_t sampler_words = words(p_layout_->GetClassDescriptorCount(PlainSampler) * sizeof(SamplerDescriptor));
+    const size_t image_sampler_words = words(p_layout_->GetClassDescriptorCount(ImageSampler) * sizeof(ImageSamplerDescriptor));
+    const size_t image_words = words(p_layout_->GetClassDescriptorCount(Image) * sizeof(ImageDescriptor));
+    const size_t texel_buffer_words = words(p_layout_->GetClassDescriptorCount(TexelBuffer) * sizeof(TexelDescriptor));
+    const size_t buffer_words = words(p_layout_->GetClassDescriptorCount(GeneralBuffer) * sizeof(BufferDescriptor));
+    const size_t total_words = updated_words + sampler_words + image_sampler_words + image_words + texel_buffer_words + buffer_words;
+    uint64_t *cursor = nullptr;
+    if (arena) {
+        cursor = static_cast<uint64_t *>(arena->allocate(total_words * sizeof(uint64_t), std::alignment_of<uint64_t>::value));
+    } else {
+        storage_.reset(new uint64_t[total_words]);
+        cursor = storage_.get();
+    }
+    updated_ = cursor;
+    std::fill_n(updated_, updated_words, uint64_t(0));
+    cursor += updated_words;
+    samplers_ = reinterpret_cast<SamplerDescriptor *>(cursor);
+    cursor += sampler_words;
+    image_samplers_ = reinterpret_cast<ImageSamplerDescriptor *>(cursor);
+    cursor += image_sampler_words;
+    images_ = reinterpret_cast<ImageDescriptor *>(cursor);
+    cursor += image_words;
+    texel_buffers_ = reinterpret_cast<TexelDescriptor *>(cursor);
+    cursor += texel_buffer_words;
+    buffers_ = reinterpret_cast<BufferDescriptor *>(cursor);
+
+    // Records start out null; only immutable samplers need filling in
+    std::uninitialized_fill_n(samplers_, p_layout_->GetClassDescriptorCount(PlainSampler), SamplerDescriptor{VK_NULL_HANDLE});
+    std::uninitialized_fill_n(image_samplers_, p_layout_->GetClassDescriptorCount(ImageSampler),
+                              ImageSamplerDescriptor{VK_NULL_HANDLE, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED});
+    std::uninitialized_fill_n(images_, p_layout_->GetClassDescriptorCount(Image),
+                              ImageDescriptor{VK_NULL_HANDLE, VK_IMAGE_LAYOUT_UNDEFINED});
+    std::uninitialized_fill_n(texel_buffers_, p_layout_->GetClassDescriptorCount(TexelBuffer), TexelDescriptor{VK_NULL_HANDLE});
+    std::uninitialized_fill_n(buffers_, p_layout_->GetClassDescriptorCount(GeneralBuffer), BufferDescriptor{VK_NULL_HANDLE, 0, 0});
+    uint32_t global_start = 0;
+    for (uint32_t i = 0; i < p_layout_->GetBindingCount(); global_start += p_layout_->GetDescriptorCountFromIndex(i++)) {
+        auto immut = p_layout_->GetImmutableSamplerPtrFromIndex(i);
+        const auto count = p_layout_->GetDescriptorCountFromIndex(i);
+        if (!immut || !count) continue;
+        const auto class_start = p_layout_->GetClassStartFromIndex(i);
+        if (p_layout_->GetClassFromIndex(i) == PlainSampler) {
+            // Immutable samplers are updated at creation
+            for (uint32_t di = 0; di < count; ++di) {
+                samplers_[class_start + di].sampler = immut[di];
+                SetDescriptorUpdated(global_start + di, true);
             }
-            // ImageDescriptors
-            case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-            case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-            case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-                for (uint32_t di = 0; di < p_layout_->GetDescriptorCountFromIndex(i); ++di)
-                    descriptors_.emplace_back(new ImageDescriptor(type));
-                break;
-            case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-            case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-                for (uint32_t di = 0; di < p_layout_->GetDescriptorCountFromIndex(i); ++di)
-                    descriptors_.emplace_back(new TexelDescriptor(type));
-                break;
-            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-            case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-            case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
-                for (uint32_t di = 0; di < p_layout_->GetDescriptorCountFromIndex(i); ++di)
-                    descriptors_.emplace_back(new BufferDescriptor(type));
-                break;
-            default:
-                assert(0);  // Bad descriptor type specified
-                break;
+            some_update_ = true;
+        } else if (p_layout_->GetClassFromIndex(i) == ImageSampler) {
+            // The image still has to be written, but the set counts as updated
+            for (uint32_t di = 0; di < count; ++di) image_samplers_[class_start + di].sampler = immut[di];
+            some_update_ = true;
         }
     }
 }
@@ -449,19 +573,25 @@ bool cvdescriptorset::DescriptorSet::ValidateDrawState(const std::map<uint32_t,
             return false;
         }
         IndexRange index_range = p_layout_->GetGlobalIndexRangeFromBinding(binding);
+        const auto binding_index = p_layout_->GetIndexFromBinding(binding);
+        const auto descriptor_class = p_layout_->GetClassFromIndex(binding_index);
+        const auto class_start = p_layout_->GetClassStartFromIndex(binding_index);
+        const auto type = p_layout_->GetTypeFromIndex(binding_index);
+        const bool dynamic =
+            (type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC) || (type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC);
         auto array_idx = 0;  // Track array idx if we're dealing with array descriptors
         for (uint32_t i = index_range.start; i < index_range.end; ++i, ++array_idx) {
-            if (!descriptors_[i]->updated) {
+            if (!IsDescriptorUpdated(i)) {
                 std::stringstream error_str;
                 error_str << "Descriptor in binding #" << binding << " at global descriptor index " << i
                           << " is being used in draw but has not been updated.";
                 *error = error_str.str();
                 return false;
             } else {
-                auto descriptor_class = descriptors_[i]->GetClass();
                 if (descriptor_class == GeneralBuffer) {
+                    const auto &buffer_desc = buffers_[class_start + array_idx];
                     // Verify that buffers are valid
-                    auto buffer = static_cast<BufferDescriptor *>(descriptors_[i].get())->GetBuffer();
+                    auto buffer = buffer_desc.buffer;
                     auto buffer_node = GetBufferState(device_data_, buffer);
                     if (!buffer_node) {
                         std::stringstream error_str;
@@ -482,16 +612,15 @@ bool cvdescriptorset::DescriptorSet::ValidateDrawState(const std::map<uint32_t,
                     } else {
                         // Enqueue sparse resource validation, as these can only be validated at submit time
                         auto device_data_copy = device_data_;  // Cannot capture members by value, so make capturable copy.
-                        std::function<bool(void)> function = [device_data_copy, caller, buffer_node]() {
+                        cb_node->queue_submit_functions.emplace_back([device_data_copy, caller, buffer_node]() {
                             return core_validation::ValidateBufferMemoryIsValid(device_data_copy, buffer_node, caller);
-                        };
-                        cb_node->queue_submit_functions.push_back(function);
+                        });
                     }
-                    if (descriptors_[i]->IsDynamic()) {
+                    if (dynamic) {
                         // Validate that dynamic offsets are within the buffer
                         auto buffer_size = buffer_node->createInfo.size;
-                        auto range = static_cast<BufferDescriptor *>(descriptors_[i].get())->GetRange();
-                        auto desc_offset = static_cast<BufferDescriptor *>(descriptors_[i].get())->GetOffset();
+                        auto range = buffer_desc.range;
+                        auto desc_offset = buffer_desc.offset;
                         auto dyn_offset = dynamic_offsets[GetDynamicOffsetIndexFromBinding(binding) + array_idx];
                         if (VK_WHOLE_SIZE == range) {
                             if ((dyn_offset + desc_offset) > buffer_size) {
@@ -519,11 +648,11 @@ bool cvdescriptorset::DescriptorSet::ValidateDrawState(const std::map<uint32_t,
                     VkImageView image_view;
                     VkImageLayout image_layout;
                     if (descriptor_class == ImageSampler) {
-                        image_view = static_cast<ImageSamplerDescriptor *>(descriptors_[i].get())->GetImageView();
-                        image_layout = static_cast<ImageSamplerDescriptor *>(descriptors_[i].get())->GetImageLayout();
+                        image_view = image_samplers_[class_start + array_idx].image_view;
+                        image_layout = image_samplers_[class_start + array_idx].image_layout;
                     } else {
-                        image_view = static_cast<ImageDescriptor *>(descriptors_[i].get())->GetImageView();
-                        image_layout = static_cast<ImageDescriptor *>(descriptors_[i].get())->GetImageLayout();
+                        image_view = images_[class_start + array_idx].image_view;
+                        image_layout = images_[class_start + array_idx].image_layout;
                     }
                     auto reqs = binding_pair.second;
 
@@ -595,8 +724,8 @@ bool cvdescriptorset::DescriptorSet::ValidateDrawState(const std::map<uint32_t,
 
 // For given bindings, place any update buffers or images into the passed-in unordered_sets
 uint32_t cvdescriptorset::DescriptorSet::GetStorageUpdates(const std::map<uint32_t, descriptor_req> &bindings,
-                                                           std::unordered_set<VkBuffer> *buffer_set,
-                                                           std::unordered_set<VkImageView> *image_set) const {
+                                                           vl_dense_set<VkBuffer> *buffer_set,
+                                                           vl_dense_set<VkImageView> *image_set) const {
     auto num_updates = 0;
     for (auto binding_pair : bindings) {
         auto binding = binding_pair.first;
@@ -604,34 +733,36 @@ uint32_t cvdescriptorset::DescriptorSet::GetStorageUpdates(const std::map<uint32
         if (!p_layout_->HasBinding(binding)) {
             continue;
         }
+        const auto binding_index = p_layout_->GetIndexFromBinding(binding);
+        const auto type = p_layout_->GetTypeFromIndex(binding_index);
+        const auto class_start = p_layout_->GetClassStartFromIndex(binding_index);
+        const auto count = p_layout_->GetDescriptorCountFromIndex(binding_index);
         uint32_t start_idx = p_layout_->GetGlobalIndexRangeFromBinding(binding).start;
-        if (descriptors_[start_idx]->IsStorage()) {
-            if (Image == descriptors_[start_idx]->descriptor_class) {
-                for (uint32_t i = 0; i < p_layout_->GetDescriptorCountFromBinding(binding); ++i) {
-                    if (descriptors_[start_idx + i]->updated) {
-                        image_set->insert(static_cast<ImageDescriptor *>(descriptors_[start_idx + i].get())->GetImageView());
-                        num_updates++;
-                    }
+        if (VK_DESCRIPTOR_TYPE_STORAGE_IMAGE == type) {
+            for (uint32_t i = 0; i < count; ++i) {
+                if (IsDescriptorUpdated(start_idx + i)) {
+                    image_set->insert(images_[class_start + i].image_view);
+                    num_updates++;
                 }
-            } else if (TexelBuffer == descriptors_[start_idx]->descriptor_class) {
-                for (uint32_t i = 0; i < p_layout_->GetDescriptorCountFromBinding(binding); ++i) {
-                    if (descriptors_[start_idx + i]->updated) {
-                        auto bufferview = static_cast<TexelDescriptor *>(descriptors_[start_idx + i].get())->GetBufferView();
-                        auto bv_state = GetBufferViewState(device_data_, bufferview);
-                        if (bv_state) {
-                            buffer_set->insert(bv_state->create_info.buffer);
-                            num_updates++;
-                        }
-                    }
-                }
-            } else if (GeneralBuffer == descriptors_[start_idx]->descriptor_class) {
-                for (uint32_t i = 0; i < p_layout_->GetDescriptorCountFromBinding(binding); ++i) {
-                    if (descriptors_[start_idx + i]->updated) {
-                        buffer_set->insert(static_cast<BufferDescriptor *>(descriptors_[start_idx + i].get())->GetBuffer());
+            }
+        } else if (VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER == type) {
+            for (uint32_t i = 0; i < count; ++i) {
+                if (IsDescriptorUpdated(start_idx + i)) {
+                    auto bufferview = texel_buffers_[class_start + i].buffer_view;
+                    auto bv_state = GetBufferViewState(device_data_, bufferview);
+                    if (bv_state) {
+                        buffer_set->insert(bv_state->create_info.buffer);
                         num_updates++;
                     }
                 }
             }
+        } else if ((VK_DESCRIPTOR_TYPE_STORAGE_BUFFER == type) || (VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC == type)) {
+            for (uint32_t i = 0; i < count; ++i) {
+                if (IsDescriptorUpdated(start_idx + i)) {
+                    buffer_set->insert(buffers_[class_start + i].buffer);
+                    num_updates++;
+                }
+            }
         }
     }
     return num_updates;
@@ -650,10 +781,42 @@ void cvdescriptorset::DescriptorSet::PerformWriteUpdate(const VkWriteDescriptorS
     while (descriptors_remaining) {
         uint32_t update_count = std::min(descriptors_remaining, GetDescriptorCountFromBinding(binding_being_updated));
         auto global_idx = p_layout_->GetGlobalIndexRangeFromBinding(binding_being_updated).start + offset;
+        DescriptorClass descriptor_class;
+        uint32_t class_idx;
+        LocateDescriptor(global_idx, &descriptor_class, &class_idx);
         // Loop over the updates for a single binding at a time
-        for (uint32_t di = 0; di < update_count; ++di, ++update_index) {
-            descriptors_[global_idx + di]->WriteUpdate(update, update_index);
+        for (uint32_t di = 0; di < update_count; ++di) SetDescriptorUpdated(global_idx + di, true);
+        switch (descriptor_class) {
+            case PlainSampler:
+                for (uint32_t di = 0; di < update_count; ++di) {
+                    samplers_[class_idx + di].sampler = update->pImageInfo[update_index + di].sampler;
+                }
+                break;
+            case ImageSampler:
+                for (uint32_t di = 0; di < update_count; ++di) {
+                    const auto &image_info = update->pImageInfo[update_index + di];
+                    image_samplers_[class_idx + di] = {image_info.sampler, image_info.imageView, image_info.imageLayout};
+                }
+                break;
+            case Image:
+                for (uint32_t di = 0; di < update_count; ++di) {
+                    const auto &image_info = update->pImageInfo[update_index + di];
+                    images_[class_idx + di] = {image_info.imageView, image_info.imageLayout};
+                }
+                break;
+            case TexelBuffer:
+                for (uint32_t di = 0; di < update_count; ++di) {
+                    texel_buffers_[class_idx + di].buffer_view = update->pTexelBufferView[update_index + di];
+                }
+                break;
+            case GeneralBuffer:
+                for (uint32_t di = 0; di < update_count; ++di) {
+                    const auto &buffer_info = update->pBufferInfo[update_index + di];
+                    buffers_[class_idx + di] = {buffer_info.buffer, buffer_info.offset, buffer_info.range};
+                }
+                break;
         }
+        update_index += update_count;
         // Roll over to next binding in case of consecutive update
         descriptors_remaining -= update_count;
         offset = 0;
@@ -769,42 +932,191 @@ bool cvdescriptorset::DescriptorSet::ValidateCopyUpdate(const debug_report_data
 void cvdescriptorset::DescriptorSet::PerformCopyUpdate(const VkCopyDescriptorSet *update, const DescriptorSet *src_set) {
     auto src_start_idx = src_set->GetGlobalIndexRangeFromBinding(update->srcBinding).start + update->srcArrayElement;
     auto dst_start_idx = p_layout_->GetGlobalIndexRangeFromBinding(update->dstBinding).start + update->dstArrayElement;
+    if (!update->descriptorCount) {
+        InvalidateBoundCmdBuffers();
+        return;
+    }
+    // The bindings crossed by the copy all match the first (see VerifyUpdateConsistency), so on both sides the copied
+    //  descriptors are consecutive records of one class
+    DescriptorClass descriptor_class;
+    uint32_t src_class_idx, dst_class_idx;
+    src_set->LocateDescriptor(src_start_idx, &descriptor_class, &src_class_idx);
+    LocateDescriptor(dst_start_idx, &descriptor_class, &dst_class_idx);
+    const bool dst_immutable = p_layout_->GetImmutableSamplerPtrFromIndex(p_layout_->GetIndexFromGlobalIndex(dst_start_idx));
     // Update parameters all look good so perform update
     for (uint32_t di = 0; di < update->descriptorCount; ++di) {
-        auto src = src_set->descriptors_[src_start_idx + di].get();
-        auto dst = descriptors_[dst_start_idx + di].get();
-        if (src->updated) {
-            dst->CopyUpdate(src);
-            some_update_ = true;
-        } else {
-            dst->updated = false;
+        if (!src_set->IsDescriptorUpdated(src_start_idx + di)) {
+            SetDescriptorUpdated(dst_start_idx + di, false);
+            continue;
         }
+        const auto src_idx = src_class_idx + di;
+        const auto dst_idx = dst_class_idx + di;
+        switch (descriptor_class) {
+            case PlainSampler:
+                if (!dst_immutable) samplers_[dst_idx] = src_set->samplers_[src_idx];
+                break;
+            case ImageSampler:
+                if (!dst_immutable) image_samplers_[dst_idx].sampler = src_set->image_samplers_[src_idx].sampler;
+                image_samplers_[dst_idx].image_view = src_set->image_samplers_[src_idx].image_view;
+                image_samplers_[dst_idx].image_layout = src_set->image_samplers_[src_idx].image_layout;
+                break;
+            case Image:
+                images_[dst_idx] = src_set->images_[src_idx];
+                break;
+            case TexelBuffer:
+                texel_buffers_[dst_idx] = src_set->texel_buffers_[src_idx];
+                break;
+            case GeneralBuffer:
+                buffers_[dst_idx] = src_set->buffers_[src_idx];
+                break;
+        }
+        SetDescriptorUpdated(dst_start_idx + di, true);
+        some_update_ = true;
     }
 
     InvalidateBoundCmdBuffers();
 }
 
+// Validate each descriptor a template update would write, reading its info from data at the offsets and strides given by the
+//  ops.  Each descriptor is checked as a one-element write pointing into data, so the checks match vkUpdateDescriptorSets.
+bool cvdescriptorset::DescriptorSet::ValidateTemplateUpdate(const std::vector<DESCRIPTOR_TEMPLATE_OP> &ops, const void *data,
+                                                            UNIQUE_VALIDATION_ERROR_CODE *error_code,
+                                                            std::string *error_msg) const {
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set_;
+    write.descriptorCount = 1;
+    for (const auto &op : ops) {
+        write.descriptorType = op.type;
+        const char *src = static_cast<const char *>(data) + op.offset;
+        for (uint32_t di = 0; di < op.count; ++di, src += op.stride) {
+            write.pImageInfo = reinterpret_cast<const VkDescriptorImageInfo *>(src);
+            write.pBufferInfo = reinterpret_cast<const VkDescriptorBufferInfo *>(src);
+            write.pTexelBufferView = reinterpret_cast<const VkBufferView *>(src);
+            if (!VerifyWriteUpdateContents(&write, op.global_index + di, error_code, error_msg)) {
+                std::stringstream error_str;
+                error_str << "Template update of descriptor at global index " << op.global_index + di
+                          << " failed: " << error_msg->c_str();
+                *error_msg = error_str.str();
+                return false;
+            }
+        }
+    }
+    return true;
+}
+// Perform template update, reading each descriptor's info from data at the offsets and strides given by the ops
+void cvdescriptorset::DescriptorSet::PerformTemplateUpdate(const std::vector<DESCRIPTOR_TEMPLATE_OP> &ops, const void *data) {
+    if (ops.empty()) return;
+    for (const auto &op : ops) {
+        for (uint32_t di = 0; di < op.count; ++di) SetDescriptorUpdated(op.global_index + di, true);
+        const char *src = static_cast<const char *>(data) + op.offset;
+        switch (GetDescriptorClassFromType(op.type)) {
+            case PlainSampler:
+                for (uint32_t di = 0; di < op.count; ++di, src += op.stride) {
+                    samplers_[op.class_index + di].sampler = reinterpret_cast<const VkDescriptorImageInfo *>(src)->sampler;
+                }
+                break;
+            case ImageSampler:
+                for (uint32_t di = 0; di < op.count; ++di, src += op.stride) {
+                    const auto &image_info = *reinterpret_cast<const VkDescriptorImageInfo *>(src);
+                    image_samplers_[op.class_index + di] = {image_info.sampler, image_info.imageView, image_info.imageLayout};
+                }
+                break;
+            case Image:
+                for (uint32_t di = 0; di < op.count; ++di, src += op.stride) {
+                    const auto &image_info = *reinterpret_cast<const VkDescriptorImageInfo *>(src);
+                    images_[op.class_index + di] = {image_info.imageView, image_info.imageLayout};
+                }
+                break;
+            case TexelBuffer:
+                for (uint32_t di = 0; di < op.count; ++di, src += op.stride) {
+                    texel_buffers_[op.class_index + di].buffer_view = *reinterpret_cast<const VkBufferView *>(src);
+                }
+                break;
+            case GeneralBuffer:
+                for (uint32_t di = 0; di < op.count; ++di, src += op.stride) {
+                    const auto &buffer_info = *reinterpret_cast<const VkDescriptorBufferInfo *>(src);
+                    buffers_[op.class_index + di] = {buffer_info.buffer, buffer_info.offset, buffer_info.range};
+                }
+                break;
+        }
+    }
+    some_update_ = true;
+
+    InvalidateBoundCmdBuffers();
+}
+
 // Bind cb_node to this set and this set to cb_node.
 // Prereq: This should be called for a set that has been confirmed to be active for the given cb_node, meaning it's going
 //   to be used in a draw by the given cb_node
 void cvdescriptorset::DescriptorSet::BindCommandBuffer(GLOBAL_CB_NODE *cb_node,
                                                        const std::map<uint32_t, descriptor_req> &binding_req_map) {
     // bind cb to this descriptor set
-    cb_bindings.insert(cb_node);
+    core_validation::InsertCommandBufferBinding(&cb_bindings, cb_node);
     // Add bindings for descriptor set, the set's pool, and individual objects in the set
     cb_node->object_bindings.insert({HandleToUint64(set_), kVulkanObjectTypeDescriptorSet});
-    pool_state_->cb_bindings.insert(cb_node);
+    core_validation::InsertCommandBufferBinding(&pool_state_->cb_bindings, cb_node);
     cb_node->object_bindings.insert({HandleToUint64(pool_state_->pool), kVulkanObjectTypeDescriptorPool});
     // For the active slots, use set# to look up descriptorSet from boundDescriptorSets, and bind all of that descriptor set's
     // resources
     for (auto binding_req_pair : binding_req_map) {
-        auto binding = binding_req_pair.first;
-        auto range = p_layout_->GetGlobalIndexRangeFromBinding(binding);
-        for (uint32_t i = range.start; i < range.end; ++i) {
-            descriptors_[i]->BindCommandBuffer(device_data_, cb_node);
+        if (!p_layout_->HasBinding(binding_req_pair.first)) continue;
+        const auto binding_index = p_layout_->GetIndexFromBinding(binding_req_pair.first);
+        const auto class_start = p_layout_->GetClassStartFromIndex(binding_index);
+        const auto count = p_layout_->GetDescriptorCountFromIndex(binding_index);
+        // Immutable samplers are owned by the layout rather than bound through the set
+        const bool immutable = p_layout_->GetImmutableSamplerPtrFromIndex(binding_index) != nullptr;
+        switch (p_layout_->GetClassFromIndex(binding_index)) {
+            case PlainSampler:
+                if (immutable) break;
+                for (uint32_t i = 0; i < count; ++i) {
+                    auto sampler_state = GetSamplerState(device_data_, samplers_[class_start + i].sampler);
+                    if (sampler_state) core_validation::AddCommandBufferBindingSampler(cb_node, sampler_state);
+                }
+                break;
+            case ImageSampler:
+                for (uint32_t i = 0; i < count; ++i) {
+                    const auto &desc = image_samplers_[class_start + i];
+                    // First add binding for any non-immutable sampler
+                    if (!immutable) {
+                        auto sampler_state = GetSamplerState(device_data_, desc.sampler);
+                        if (sampler_state) core_validation::AddCommandBufferBindingSampler(cb_node, sampler_state);
+                    }
+                    // Add binding for image
+                    auto iv_state = GetImageViewState(device_data_, desc.image_view);
+                    if (iv_state) core_validation::AddCommandBufferBindingImageView(device_data_, cb_node, iv_state);
+                }
+                break;
+            case Image:
+                for (uint32_t i = 0; i < count; ++i) {
+                    auto iv_state = GetImageViewState(device_data_, images_[class_start + i].image_view);
+                    if (iv_state) core_validation::AddCommandBufferBindingImageView(device_data_, cb_node, iv_state);
+                }
+                break;
+            case TexelBuffer:
+                for (uint32_t i = 0; i < count; ++i) {
+                    auto bv_state = GetBufferViewState(device_data_, texel_buffers_[class_start + i].buffer_view);
+                    if (bv_state) core_validation::AddCommandBufferBindingBufferView(device_data_, cb_node, bv_state);
+                }
+                break;
+            case GeneralBuffer:
+                for (uint32_t i = 0; i < count; ++i) {
+                    auto buffer_node = GetBufferState(device_data_, buffers_[class_start + i].buffer);
+                    if (buffer_node) core_validation::AddCommandBufferBindingBuffer(device_data_, cb_node, buffer_node);
+                }
+                break;
         }
     }
 }
+
+void cvdescriptorset::DescriptorSet::LocateDescriptor(uint32_t global_index, DescriptorClass *descriptor_class,
+                                                      uint32_t *class_index) const {
+    const auto binding_index = p_layout_->GetIndexFromGlobalIndex(global_index);
+    const auto &range = p_layout_->GetGlobalIndexRangeFromBinding(
+        p_layout_->GetDescriptorSetLayoutBindingPtrFromIndex(binding_index)->binding);
+    *descriptor_class = p_layout_->GetClassFromIndex(binding_index);
+    *class_index = p_layout_->GetClassStartFromIndex(binding_index) + (global_index - range.start);
+}
 void cvdescriptorset::DescriptorSet::FilterAndTrackOneBindingReq(const BindingReqMap::value_type &binding_req_pair,
                                                                  const BindingReqMap &in_req, BindingReqMap *out_req,
                                                                  TrackedBindings *bindings) {
@@ -826,7 +1138,7 @@ void cvdescriptorset::DescriptorSet::FilterAndTrackOneBindingReq(const BindingRe
 
 void cvdescriptorset::DescriptorSet::FilterAndTrackBindingReqs(GLOBAL_CB_NODE *cb_state, const BindingReqMap &in_req,
                                                                BindingReqMap *out_req) {
-    TrackedBindings &bound = cached_validation_[cb_state].command_binding_and_usage;
+    TrackedBindings &bound = GetCachedValidation(cb_state).command_binding_and_usage;
     if (bound.size() == GetBindingCount()) {
         return;  // All bindings are bound, out req is empty
     }
@@ -841,7 +1153,7 @@ void cvdescriptorset::DescriptorSet::FilterAndTrackBindingReqs(GLOBAL_CB_NODE *c
 
 void cvdescriptorset::DescriptorSet::FilterAndTrackBindingReqs(GLOBAL_CB_NODE *cb_state, PIPELINE_STATE *pipeline,
                                                                const BindingReqMap &in_req, BindingReqMap *out_req) {
-    auto &validated = cached_validation_[cb_state];
+    auto &validated = GetCachedValidation(cb_state);
     auto &image_sample_val = validated.image_samplers[pipeline];
     auto *const dynamic_buffers = &validated.dynamic_buffers;
     auto *const non_dynamic_buffers = &validated.non_dynamic_buffers;
@@ -872,15 +1184,6 @@ void cvdescriptorset::DescriptorSet::FilterAndTrackBindingReqs(GLOBAL_CB_NODE *c
     }
 }
 
-cvdescriptorset::SamplerDescriptor::SamplerDescriptor(const VkSampler *immut) : sampler_(VK_NULL_HANDLE), immutable_(false) {
-    updated = false;
-    descriptor_class = PlainSampler;
-    if (immut) {
-        sampler_ = *immut;
-        immutable_ = true;
-        updated = true;
-    }
-}
 // Validate given sampler. Currently this only checks to make sure it exists in the samplerMap
 bool cvdescriptorset::ValidateSampler(const VkSampler sampler, const layer_data *dev_data) {
     return (GetSamplerState(dev_data, sampler) != nullptr);
@@ -1072,156 +1375,6 @@ bool cvdescriptorset::ValidateImageUpdate(VkImageView image_view, VkImageLayout
     return true;
 }
 
-void cvdescriptorset::SamplerDescriptor::WriteUpdate(const VkWriteDescriptorSet *update, const uint32_t index) {
-    sampler_ = update->pImageInfo[index].sampler;
-    updated = true;
-}
-
-void cvdescriptorset::SamplerDescriptor::CopyUpdate(const Descriptor *src) {
-    if (!immutable_) {
-        auto update_sampler = static_cast<const SamplerDescriptor *>(src)->sampler_;
-        sampler_ = update_sampler;
-    }
-    updated = true;
-}
-
-void cvdescriptorset::SamplerDescriptor::BindCommandBuffer(const layer_data *dev_data, GLOBAL_CB_NODE *cb_node) {
-    if (!immutable_) {
-        auto sampler_state = GetSamplerState(dev_data, sampler_);
-        if (sampler_state) core_validation::AddCommandBufferBindingSampler(cb_node, sampler_state);
-    }
-}
-
-cvdescriptorset::ImageSamplerDescriptor::ImageSamplerDescriptor(const VkSampler *immut)
-    : sampler_(VK_NULL_HANDLE), immutable_(false), image_view_(VK_NULL_HANDLE), image_layout_(VK_IMAGE_LAYOUT_UNDEFINED) {
-    updated = false;
-    descriptor_class = ImageSampler;
-    if (immut) {
-        sampler_ = *immut;
-        immutable_ = true;
-    }
-}
-
-void cvdescriptorset::ImageSamplerDescriptor::WriteUpdate(const VkWriteDescriptorSet *update, const uint32_t index) {
-    updated = true;
-    const auto &image_info = update->pImageInfo[index];
-    sampler_ = image_info.sampler;
-    image_view_ = image_info.imageView;
-    image_layout_ = image_info.imageLayout;
-}
-
-void cvdescriptorset::ImageSamplerDescriptor::CopyUpdate(const Descriptor *src) {
-    if (!immutable_) {
-        auto update_sampler = static_cast<const ImageSamplerDescriptor *>(src)->sampler_;
-        sampler_ = update_sampler;
-    }
-    auto image_view = static_cast<const ImageSamplerDescriptor *>(src)->image_view_;
-    auto image_layout = static_cast<const ImageSamplerDescriptor *>(src)->image_layout_;
-    updated = true;
-    image_view_ = image_view;
-    image_layout_ = image_layout;
-}
-
-void cvdescriptorset::ImageSamplerDescriptor::BindCommandBuffer(const layer_data *dev_data, GLOBAL_CB_NODE *cb_node) {
-    // First add binding for any non-immutable sampler
-    if (!immutable_) {
-        auto sampler_state = GetSamplerState(dev_data, sampler_);
-        if (sampler_state) core_validation::AddCommandBufferBindingSampler(cb_node, sampler_state);
-    }
-    // Add binding for image
-    auto iv_state = GetImageViewState(dev_data, image_view_);
-    if (iv_state) {
-        core_validation::AddCommandBufferBindingImageView(dev_data, cb_node, iv_state);
-    }
-}
-
-cvdescriptorset::ImageDescriptor::ImageDescriptor(const VkDescriptorType type)
-    : storage_(false), image_view_(VK_NULL_HANDLE), image_layout_(VK_IMAGE_LAYOUT_UNDEFINED) {
-    updated = false;
-    descriptor_class = Image;
-    if (VK_DESCRIPTOR_TYPE_STORAGE_IMAGE == type) storage_ = true;
-}
-
-void cvdescriptorset::ImageDescriptor::WriteUpdate(const VkWriteDescriptorSet *update, const uint32_t index) {
-    updated = true;
-    const auto &image_info = update->pImageInfo[index];
-    image_view_ = image_info.imageView;
-    image_layout_ = image_info.imageLayout;
-}
-
-void cvdescriptorset::ImageDescriptor::CopyUpdate(const Descriptor *src) {
-    auto image_view = static_cast<const ImageDescriptor *>(src)->image_view_;
-    auto image_layout = static_cast<const ImageDescriptor *>(src)->image_layout_;
-    updated = true;
-    image_view_ = image_view;
-    image_layout_ = image_layout;
-}
-
-void cvdescriptorset::ImageDescriptor::BindCommandBuffer(const layer_data *dev_data, GLOBAL_CB_NODE *cb_node) {
-    // Add binding for image
-    auto iv_state = GetImageViewState(dev_data, image_view_);
-    if (iv_state) {
-        core_validation::AddCommandBufferBindingImageView(dev_data, cb_node, iv_state);
-    }
-}
-
-cvdescriptorset::BufferDescriptor::BufferDescriptor(const VkDescriptorType type)
-    : storage_(false), dynamic_(false), buffer_(VK_NULL_HANDLE), offset_(0), range_(0) {
-    updated = false;
-    descriptor_class = GeneralBuffer;
-    if (VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC == type) {
-        dynamic_ = true;
-    } else if (VK_DESCRIPTOR_TYPE_STORAGE_BUFFER == type) {
-        storage_ = true;
-    } else if (VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC == type) {
-        dynamic_ = true;
-        storage_ = true;
-    }
-}
-void cvdescriptorset::BufferDescriptor::WriteUpdate(const VkWriteDescriptorSet *update, const uint32_t index) {
-    updated = true;
-    const auto &buffer_info = update->pBufferInfo[index];
-    buffer_ = buffer_info.buffer;
-    offset_ = buffer_info.offset;
-    range_ = buffer_info.range;
-}
-
-void cvdescriptorset::BufferDescriptor::CopyUpdate(const Descriptor *src) {
-    auto buff_desc = static_cast<const BufferDescriptor *>(src);
-    updated = true;
-    buffer_ = buff_desc->buffer_;
-    offset_ = buff_desc->offset_;
-    range_ = buff_desc->range_;
-}
-
-void cvdescriptorset::BufferDescriptor::BindCommandBuffer(const layer_data *dev_data, GLOBAL_CB_NODE *cb_node) {
-    auto buffer_node = GetBufferState(dev_data, buffer_);
-    if (buffer_node) core_validation::AddCommandBufferBindingBuffer(dev_data, cb_node, buffer_node);
-}
-
-cvdescriptorset::TexelDescriptor::TexelDescriptor(const VkDescriptorType type) : buffer_view_(VK_NULL_HANDLE), storage_(false) {
-    updated = false;
-    descriptor_class = TexelBuffer;
-    if (VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER == type) storage_ = true;
-}
-
-void cvdescriptorset::TexelDescriptor::WriteUpdate(const VkWriteDescriptorSet *update, const uint32_t index) {
-    updated = true;
-    buffer_view_ = update->pTexelBufferView[index];
-}
-
-void cvdescriptorset::TexelDescriptor::CopyUpdate(const Descriptor *src) {
-    updated = true;
-    buffer_view_ = static_cast<const TexelDescriptor *>(src)->buffer_view_;
-}
-
-void cvdescriptorset::TexelDescriptor::BindCommandBuffer(const layer_data *dev_data, GLOBAL_CB_NODE *cb_node) {
-    auto bv_state = GetBufferViewState(dev_data, buffer_view_);
-    if (bv_state) {
-        core_validation::AddCommandBufferBindingBufferView(dev_data, cb_node, bv_state);
-    }
-}
-
 // This is a helper function that iterates over a set of Write and Copy updates, pulls the DescriptorSet* for updated
 //  sets, and then calls their respective Validate[Write|Copy]Update functions.
 // If the update hits an issue for which the callback returns "true", meaning that the call down the chain should
@@ -1303,72 +1456,81 @@ void cvdescriptorset::PerformUpdateDescriptorSets(const layer_data *dev_data, ui
         }
     }
 }
-// This helper function carries out the state updates for descriptor updates peformed via update templates. It basically collects
-// data and leverages the PerformUpdateDescriptor helper functions to do this.
-void cvdescriptorset::PerformUpdateDescriptorSetsWithTemplateKHR(layer_data *device_data, VkDescriptorSet descriptorSet,
-                                                                 std::unique_ptr<TEMPLATE_STATE> const &template_state,
-                                                                 const void *pData) {
-    auto const &create_info = template_state->create_info;
-
-    // Create a vector of write structs
-    std::vector<VkWriteDescriptorSet> desc_writes;
-    auto layout_obj = GetDescriptorSetLayout(device_data, create_info.descriptorSetLayout);
-
-    // Create a WriteDescriptorSet struct for each template update entry
+// Flatten each template entry into runs of descriptors that stay within one binding, following the same roll-over rules as
+//  write updates.  Runs are resolved to global and per-class indices so that applying the template needs no layout lookups.
+void cvdescriptorset::CompileUpdateTemplate(const DescriptorSetLayout *layout,
+                                            const safe_VkDescriptorUpdateTemplateCreateInfoKHR &create_info,
+                                            std::vector<DESCRIPTOR_TEMPLATE_OP> *ops) {
+    ops->clear();
     for (uint32_t i = 0; i < create_info.descriptorUpdateEntryCount; i++) {
-        auto binding_count = layout_obj->GetDescriptorCountFromBinding(create_info.pDescriptorUpdateEntries[i].dstBinding);
-        auto binding_being_updated = create_info.pDescriptorUpdateEntries[i].dstBinding;
-        auto dst_array_element = create_info.pDescriptorUpdateEntries[i].dstArrayElement;
-
-        desc_writes.reserve(desc_writes.size() + create_info.pDescriptorUpdateEntries[i].descriptorCount);
-        for (uint32_t j = 0; j < create_info.pDescriptorUpdateEntries[i].descriptorCount; j++) {
-            desc_writes.emplace_back();
-            auto &write_entry = desc_writes.back();
-
-            size_t offset = create_info.pDescriptorUpdateEntries[i].offset + j * create_info.pDescriptorUpdateEntries[i].stride;
-            char *update_entry = (char *)(pData) + offset;
-
-            if (dst_array_element >= binding_count) {
-                dst_array_element = 0;
-                binding_being_updated = layout_obj->GetNextValidBinding(binding_being_updated);
-            }
-
-            write_entry.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-            write_entry.pNext = NULL;
-            write_entry.dstSet = descriptorSet;
-            write_entry.dstBinding = binding_being_updated;
-            write_entry.dstArrayElement = dst_array_element;
-            write_entry.descriptorCount = 1;
-            write_entry.descriptorType = create_info.pDescriptorUpdateEntries[i].descriptorType;
-
-            switch (create_info.pDescriptorUpdateEntries[i].descriptorType) {
-                case VK_DESCRIPTOR_TYPE_SAMPLER:
-                case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-                case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
-                case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-                case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-                    write_entry.pImageInfo = reinterpret_cast<VkDescriptorImageInfo *>(update_entry);
-                    break;
-
-                case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
-                case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
-                case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
-                case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
-                    write_entry.pBufferInfo = reinterpret_cast<VkDescriptorBufferInfo *>(update_entry);
-                    break;
-
-                case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
-                case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
-                    write_entry.pTexelBufferView = reinterpret_cast<VkBufferView *>(update_entry);
-                    break;
-                default:
-                    assert(0);
-                    break;
+        const auto &entry = create_info.pDescriptorUpdateEntries[i];
+        auto binding = entry.dstBinding;
+        auto array_element = entry.dstArrayElement;
+        uint32_t compiled = 0;
+        while (compiled < entry.descriptorCount && layout->HasBinding(binding)) {
+            const auto binding_index = layout->GetIndexFromBinding(binding);
+            const auto binding_count = layout->GetDescriptorCountFromIndex(binding_index);
+            if (array_element >= binding_count) {
+                // Roll over to the next binding that has descriptors
+                if (binding >= layout->GetMaxBinding()) break;
+                array_element -= binding_count;
+                binding = layout->GetNextValidBinding(binding);
+                continue;
             }
-            dst_array_element++;
+            const auto count = std::min(entry.descriptorCount - compiled, binding_count - array_element);
+            ops->push_back({layout->GetGlobalIndexRangeFromBinding(binding).start + array_element,
+                            layout->GetClassStartFromIndex(binding_index) + array_element, count,
+                            layout->GetTypeFromIndex(binding_index), entry.offset + compiled * entry.stride, entry.stride});
+            compiled += count;
+            array_element += count;
         }
     }
-    PerformUpdateDescriptorSets(device_data, static_cast<uint32_t>(desc_writes.size()), desc_writes.data(), 0, NULL);
+}
+// Return the ops for applying template_state to set_node, which are the template's own unless the set's layout was not created
+//  from the same definition as the template's, in which case they are compiled into local_ops
+static const std::vector<DESCRIPTOR_TEMPLATE_OP> &GetTemplateOps(const cvdescriptorset::DescriptorSet *set_node,
+                                                                 std::unique_ptr<TEMPLATE_STATE> const &template_state,
+                                                                 std::vector<DESCRIPTOR_TEMPLATE_OP> *local_ops) {
+    if (template_state->layout && template_state->layout->GetLayoutDef() == set_node->GetLayout()->GetLayoutDef()) {
+        return template_state->ops;
+    }
+    cvdescriptorset::CompileUpdateTemplate(set_node->GetLayout().get(), template_state->create_info, local_ops);
+    return *local_ops;
+}
+// Validate the contents of an update via template in the same way as the equivalent write updates, without building them
+bool cvdescriptorset::ValidateUpdateDescriptorSetsWithTemplateKHR(const debug_report_data *report_data, const layer_data *dev_data,
+                                                                  VkDescriptorSet descriptorSet,
+                                                                  std::unique_ptr<TEMPLATE_STATE> const &template_state,
+                                                                  const void *pData) {
+    auto set_node = core_validation::GetSetNode(dev_data, descriptorSet);
+    if (!set_node) {
+        return log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_SET_EXT,
+                       HandleToUint64(descriptorSet), __LINE__, DRAWSTATE_INVALID_DESCRIPTOR_SET, "DS",
+                       "Cannot call vkUpdateDescriptorSetWithTemplateKHR() on descriptor set 0x%" PRIxLEAST64
+                       " that has not been allocated.",
+                       HandleToUint64(descriptorSet));
+    }
+    std::vector<DESCRIPTOR_TEMPLATE_OP> local_ops;
+    UNIQUE_VALIDATION_ERROR_CODE error_code;
+    std::string error_str;
+    if (!set_node->ValidateTemplateUpdate(GetTemplateOps(set_node, template_state, &local_ops), pData, &error_code, &error_str)) {
+        return log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_DESCRIPTOR_SET_EXT,
+                       HandleToUint64(descriptorSet), __LINE__, error_code, "DS",
+                       "vkUpdateDescriptorSetWithTemplateKHR() failed update validation for Descriptor Set 0x%" PRIx64
+                       " with error: %s. %s",
+                       HandleToUint64(descriptorSet), error_str.c_str(), validation_error_map[error_code]);
+    }
+    return false;
+}
+// This helper function carries out the state updates for descriptor updates peformed via update templates. Templates are
+//  compiled against their set layout at creation, so the update is applied straight from pData.
+void cvdescriptorset::PerformUpdateDescriptorSetsWithTemplateKHR(layer_data *device_data, VkDescriptorSet descriptorSet,
+                                                                 std::unique_ptr<TEMPLATE_STATE> const &template_state,
+                                                                 const void *pData) {
+    auto set_node = core_validation::GetSetNode(device_data, descriptorSet);
+    if (!set_node) return;
+    std::vector<DESCRIPTOR_TEMPLATE_OP> local_ops;
+    set_node->PerformTemplateUpdate(GetTemplateOps(set_node, template_state, &local_ops), pData);
 }
 // Validate the state for a given write update but don't actually perform the update
 //  If an error would occur for this update, return false and fill in details in error_msg string
@@ -1421,11 +1583,11 @@ bool cvdescriptorset::DescriptorSet::ValidateWriteUpdate(const debug_report_data
         *error_msg = error_str.str();
         return false;
     }
-    if (update->descriptorCount > (descriptors_.size() - start_idx)) {
+    if (update->descriptorCount > (GetTotalDescriptorCount() - start_idx)) {
         *error_code = VALIDATION_ERROR_15c00282;
         std::stringstream error_str;
         error_str << "Attempting write update to descriptor set " << set_ << " binding #" << update->dstBinding << " with "
-                  << descriptors_.size() - start_idx
+                  << GetTotalDescriptorCount() - start_idx
                   << " descriptors in that binding and all successive bindings of the set, but update of "
                   << update->descriptorCount << " descriptors combined with update array element offset of "
                   << update->dstArrayElement << " oversteps the available number of consecutive descriptors";
@@ -1596,8 +1758,11 @@ bool cvdescriptorset::DescriptorSet::VerifyWriteUpdateContents(const VkWriteDesc
             // Intentional fall-through to validate sampler
         }
         case VK_DESCRIPTOR_TYPE_SAMPLER: {
+            // Updates that cross bindings only cross into bindings with matching immutable sampler use
+            const bool immutable = update->descriptorCount &&
+                                   p_layout_->GetImmutableSamplerPtrFromIndex(p_layout_->GetIndexFromGlobalIndex(index)) != nullptr;
             for (uint32_t di = 0; di < update->descriptorCount; ++di) {
-                if (!descriptors_[index + di].get()->IsImmutableSampler()) {
+                if (!immutable) {
                     if (!ValidateSampler(update->pImageInfo[di].sampler, device_data_)) {
                         *error_code = VALIDATION_ERROR_15c0028a;
                         std::stringstream error_str;
@@ -1686,13 +1851,18 @@ bool cvdescriptorset::DescriptorSet::VerifyCopyUpdateContents(const VkCopyDescri
                                                               std::string *error_msg) const {
     // Note : Repurposing some Write update error codes here as specific details aren't called out for copy updates like they are
     // for write updates
-    switch (src_set->descriptors_[index]->descriptor_class) {
+    if (!update->descriptorCount) return true;
+    DescriptorClass descriptor_class;
+    uint32_t class_index;
+    src_set->LocateDescriptor(index, &descriptor_class, &class_index);
+    const bool immutable =
+        src_set->p_layout_->GetImmutableSamplerPtrFromIndex(src_set->p_layout_->GetIndexFromGlobalIndex(index)) != nullptr;
+    switch (descriptor_class) {
         case PlainSampler: {
             for (uint32_t di = 0; di < update->descriptorCount; ++di) {
-                const auto src_desc = src_set->descriptors_[index + di].get();
-                if (!src_desc->updated) continue;
-                if (!src_desc->IsImmutableSampler()) {
-                    auto update_sampler = static_cast<SamplerDescriptor *>(src_desc)->GetSampler();
+                if (!src_set->IsDescriptorUpdated(index + di)) continue;
+                if (!immutable) {
+                    auto update_sampler = src_set->samplers_[class_index + di].sampler;
                     if (!ValidateSampler(update_sampler, device_data_)) {
                         *error_code = VALIDATION_ERROR_15c0028a;
                         std::stringstream error_str;
@@ -1708,12 +1878,11 @@ bool cvdescriptorset::DescriptorSet::VerifyCopyUpdateContents(const VkCopyDescri
         }
         case ImageSampler: {
             for (uint32_t di = 0; di < update->descriptorCount; ++di) {
-                const auto src_desc = src_set->descriptors_[index + di].get();
-                if (!src_desc->updated) continue;
-                auto img_samp_desc = static_cast<const ImageSamplerDescriptor *>(src_desc);
+                if (!src_set->IsDescriptorUpdated(index + di)) continue;
+                const auto &img_samp_desc = src_set->image_samplers_[class_index + di];
                 // First validate sampler
-                if (!img_samp_desc->IsImmutableSampler()) {
-                    auto update_sampler = img_samp_desc->GetSampler();
+                if (!immutable) {
+                    auto update_sampler = img_samp_desc.sampler;
                     if (!ValidateSampler(update_sampler, device_data_)) {
                         *error_code = VALIDATION_ERROR_15c0028a;
                         std::stringstream error_str;
@@ -1725,8 +1894,8 @@ bool cvdescriptorset::DescriptorSet::VerifyCopyUpdateContents(const VkCopyDescri
                     // TODO : Warn here
                 }
                 // Validate image
-                auto image_view = img_samp_desc->GetImageView();
-                auto image_layout = img_samp_desc->GetImageLayout();
+                auto image_view = img_samp_desc.image_view;
+                auto image_layout = img_samp_desc.image_layout;
                 if (!ValidateImageUpdate(image_view, image_layout, type, device_data_, error_code, error_msg)) {
                     std::stringstream error_str;
                     error_str << "Attempted copy update to combined image sampler descriptor failed due to: " << error_msg->c_str();
@@ -1738,11 +1907,10 @@ bool cvdescriptorset::DescriptorSet::VerifyCopyUpdateContents(const VkCopyDescri
         }
         case Image: {
             for (uint32_t di = 0; di < update->descriptorCount; ++di) {
-                const auto src_desc = src_set->descriptors_[index + di].get();
-                if (!src_desc->updated) continue;
-                auto img_desc = static_cast<const ImageDescriptor *>(src_desc);
-                auto image_view = img_desc->GetImageView();
-                auto image_layout = img_desc->GetImageLayout();
+                if (!src_set->IsDescriptorUpdated(index + di)) continue;
+                const auto &img_desc = src_set->images_[class_index + di];
+                auto image_view = img_desc.image_view;
+                auto image_layout = img_desc.image_layout;
                 if (!ValidateImageUpdate(image_view, image_layout, type, device_data_, error_code, error_msg)) {
                     std::stringstream error_str;
                     error_str << "Attempted copy update to image descriptor failed due to: " << error_msg->c_str();
@@ -1754,9 +1922,8 @@ bool cvdescriptorset::DescriptorSet::VerifyCopyUpdateContents(const VkCopyDescri
         }
         case TexelBuffer: {
             for (uint32_t di = 0; di < update->descriptorCount; ++di) {
-                const auto src_desc = src_set->descriptors_[index + di].get();
-                if (!src_desc->updated) continue;
-                auto buffer_view = static_cast<TexelDescriptor *>(src_desc)->GetBufferView();
+                if (!src_set->IsDescriptorUpdated(index + di)) continue;
+                auto buffer_view = src_set->texel_buffers_[class_index + di].buffer_view;
                 auto bv_state = GetBufferViewState(device_data_, buffer_view);
                 if (!bv_state) {
                     *error_code = VALIDATION_ERROR_15c00286;
@@ -1777,9 +1944,8 @@ bool cvdescriptorset::DescriptorSet::VerifyCopyUpdateContents(const VkCopyDescri
         }
         case GeneralBuffer: {
             for (uint32_t di = 0; di < update->descriptorCount; ++di) {
-                const auto src_desc = src_set->descriptors_[index + di].get();
-                if (!src_desc->updated) continue;
-                auto buffer = static_cast<BufferDescriptor *>(src_desc)->GetBuffer();
+                if (!src_set->IsDescriptorUpdated(index + di)) continue;
+                auto buffer = src_set->buffers_[class_index + di].buffer;
                 if (!ValidateBufferUsage(GetBufferState(device_data_, buffer), type, error_code, error_msg)) {
                     std::stringstream error_str;
                     error_str << "Attempted copy update to buffer descriptor failed due to: " << error_msg->c_str();
@@ -1865,8 +2031,8 @@ bool cvdescriptorset::ValidateAllocateDescriptorSets(const core_validation::laye
 void cvdescriptorset::PerformAllocateDescriptorSets(const VkDescriptorSetAllocateInfo *p_alloc_info,
                                                     const VkDescriptorSet *descriptor_sets,
                                                     const AllocateDescriptorSetsData *ds_data,
-                                                    std::unordered_map<VkDescriptorPool, DESCRIPTOR_POOL_STATE *> *pool_map,
-                                                    std::unordered_map<VkDescriptorSet, cvdescriptorset::DescriptorSet *> *set_map,
+                                                    vl_concurrent_unordered_map<VkDescriptorPool, DESCRIPTOR_POOL_STATE *> *pool_map,
+                                                    vl_concurrent_unordered_map<VkDescriptorSet, DescriptorSet *> *set_map,
                                                     layer_data *dev_data) {
     auto pool_state = (*pool_map)[p_alloc_info->descriptorPool];
     // Account for sets and individual descriptors allocated from pool
@@ -1876,13 +2042,66 @@ void cvdescriptorset::PerformAllocateDescriptorSets(const VkDescriptorSetAllocat
     }
     // Create tracking object for each descriptor set; insert into global map and the pool's set.
     for (uint32_t i = 0; i < p_alloc_info->descriptorSetCount; i++) {
-        auto new_ds = new cvdescriptorset::DescriptorSet(descriptor_sets[i], p_alloc_info->descriptorPool, ds_data->layout_nodes[i],
-                                                         dev_data);
+        cvdescriptorset::DescriptorSet *new_ds = nullptr;
+        if (pool_state->sets_in_arena) {
+            void *memory = pool_state->set_arena.allocate(sizeof(DescriptorSet), std::alignment_of<DescriptorSet>::value);
+            new_ds = new (memory) DescriptorSet(descriptor_sets[i], p_alloc_info->descriptorPool, ds_data->layout_nodes[i],
+                                                dev_data, &pool_state->set_arena);
+        } else {
+            new_ds = new DescriptorSet(descriptor_sets[i], p_alloc_info->descriptorPool, ds_data->layout_nodes[i], dev_data);
+        }
 
-        pool_state->sets.insert(new_ds);
+        new_ds->SetPoolSlot(pool_state->sets.size());
+        pool_state->sets.push_back(new_ds);
         new_ds->in_use.store(0);
-        (*set_map)[descriptor_sets[i]] = new_ds;
+        set_map->insert_or_assign(descriptor_sets[i], new_ds);
+    }
+}
+
+void cvdescriptorset::DestroyDescriptorSet(DescriptorSet *descriptor_set) {
+    if (descriptor_set->IsArenaAllocated()) {
+        descriptor_set->~DescriptorSet();
+    } else {
+        delete descriptor_set;
+    }
+}
+
+size_t cvdescriptorset::GetDescriptorPoolArenaSize(const VkDescriptorPoolCreateInfo *create_info) {
+    // Pools are often created with limits far beyond what they ever hold, so don't commit more than this up front. The
+    // arena grows to the pool's real peak the first time the pool is reset after spilling past it.
+    const size_t kMaxInitialSize = 1024 * 1024;
+    // Each set is the object itself plus its descriptor block: the updated bitset and one array per class, each padded
+    // to a whole word
+    const size_t set_size =
+        sizeof(DescriptorSet) + std::alignment_of<DescriptorSet>::value + (1 + kDescriptorClassCount) * sizeof(uint64_t);
+    if (create_info->maxSets >= kMaxInitialSize / set_size) return kMaxInitialSize;
+    size_t size = create_info->maxSets * set_size;
+    for (uint32_t i = 0; i < create_info->poolSizeCount && size < kMaxInitialSize; ++i) {
+        const auto &pool_size = create_info->pPoolSizes[i];
+        if (static_cast<uint32_t>(pool_size.type) >= VK_DESCRIPTOR_TYPE_RANGE_SIZE) continue;
+        size_t record_size = 0;
+        switch (GetDescriptorClassFromType(pool_size.type)) {
+            case PlainSampler:
+                record_size = sizeof(SamplerDescriptor);
+                break;
+            case ImageSampler:
+                record_size = sizeof(ImageSamplerDescriptor);
+                break;
+            case Image:
+                record_size = sizeof(ImageDescriptor);
+                break;
+            case TexelBuffer:
+                record_size = sizeof(TexelDescriptor);
+                break;
+            case GeneralBuffer:
+                record_size = sizeof(BufferDescriptor);
+                break;
+        }
+        // One record and one updated bit per descriptor
+        if (pool_size.descriptorCount >= kMaxInitialSize / record_size) return kMaxInitialSize;
+        size += pool_size.descriptorCount * record_size + (pool_size.descriptorCount + 7) / 8;
     }
+    return size < kMaxInitialSize ? size : kMaxInitialSize;
 }
 
 cvdescriptorset::PrefilterBindRequestMap::PrefilterBindRequestMap(cvdescriptorset::DescriptorSet &ds, const BindingReqMap &in_map,
@@ -31,6 +31,7 @@
 #include "vk_object_types.h"
 #include <map>
 #include <memory>
+#include <mutex>
 #include <set>
 #include <unordered_map>
 #include <unordered_set>
@@ -51,6 +52,11 @@ struct IndexRange {
 };
 typedef std::map<uint32_t, descriptor_req> BindingReqMap;
 
+// Slightly broader than type, each descriptor type maps to the "DescriptorClass" of the record that stores it
+enum DescriptorClass { PlainSampler, ImageSampler, Image, TexelBuffer, GeneralBuffer };
+static const uint32_t kDescriptorClassCount = GeneralBuffer + 1;
+DescriptorClass GetDescriptorClassFromType(VkDescriptorType);
+
 /*
  * DescriptorSetLayout class
  *
@@ -80,17 +86,19 @@ typedef std::map<uint32_t, descriptor_req> BindingReqMap;
  *  increments from there. So if the lowest binding# in this example had descriptorCount of
  *  10, then the GlobalStartIndex of the 2nd lowest binding# will be 10 where 0-9 are the
  *  global indices for the lowest binding#.
+ *
+ * Definition vs Layout - Everything above is immutable once the layout is created and lives in
+ *  a DescriptorSetLayoutDef. Definitions are interned, so layouts created from equal create
+ *  infos share one and can be compared by pointer. The DescriptorSetLayout itself only adds
+ *  the Vulkan handle and whether that handle has been destroyed.
  */
-class DescriptorSetLayout {
+class DescriptorSetLayoutDef {
    public:
     // Constructors and destructor
-    DescriptorSetLayout(const VkDescriptorSetLayoutCreateInfo *p_create_info, const VkDescriptorSetLayout layout);
-    // Validate create info - should be called prior to creation
-    static bool ValidateCreateInfo(const debug_report_data *, const VkDescriptorSetLayoutCreateInfo *, const bool, const uint32_t);
-    // Straightforward Get functions
-    VkDescriptorSetLayout GetDescriptorSetLayout() const { return layout_; };
-    bool IsDestroyed() const { return layout_destroyed_; }
-    void MarkDestroyed() { layout_destroyed_ = true; }
+    DescriptorSetLayoutDef(const VkDescriptorSetLayoutCreateInfo *p_create_info);
+    // Two definitions are equal if they were created from create infos with the same flags and the same bindings
+    bool operator==(const DescriptorSetLayoutDef &rhs) const;
+    size_t hash() const;
     uint32_t GetTotalDescriptorCount() const { return descriptor_count_; };
     uint32_t GetDynamicDescriptorCount() const { return dynamic_descriptor_count_; };
     VkDescriptorSetLayoutCreateFlags GetCreateFlags() const { return flags_; }
@@ -100,9 +108,6 @@ class DescriptorSetLayout {
     const std::set<uint32_t> &GetSortedBindingSet() const { return non_empty_bindings_; }
     // Return true if given binding is present in this layout
     bool HasBinding(const uint32_t binding) const { return binding_to_index_map_.count(binding) > 0; };
-    // Return true if this layout is compatible with passed in layout from a pipelineLayout,
-    //   else return false and update error_msg with description of incompatibility
-    bool IsCompatible(DescriptorSetLayout const *const, std::string *) const;
     // Return true if binding 1 beyond given exists and has same type, stageFlags & immutable sampler use
     bool IsNextBindingConsistent(const uint32_t) const;
     uint32_t GetIndexFromBinding(uint32_t binding) const;
@@ -127,6 +132,11 @@ class DescriptorSetLayout {
     VkDescriptorType GetTypeFromGlobalIndex(const uint32_t global_index) const {
         return GetTypeFromIndex(GetIndexFromGlobalIndex(global_index));
     }
+    // Descriptors are stored per class, in binding order.  For a binding index, get the class of its descriptors and the
+    //  position of its first descriptor among all of the descriptors of that class in the layout.
+    DescriptorClass GetClassFromIndex(const uint32_t index) const { return binding_storage_[index].descriptor_class; }
+    uint32_t GetClassStartFromIndex(const uint32_t index) const { return binding_storage_[index].class_start; }
+    uint32_t GetClassDescriptorCount(DescriptorClass descriptor_class) const { return class_descriptor_counts_[descriptor_class]; }
     VkSampler const *GetImmutableSamplerPtrFromBinding(const uint32_t) const;
     VkSampler const *GetImmutableSamplerPtrFromIndex(const uint32_t) const;
     // For a given binding and array index, return the corresponding index into the dynamic offset array
@@ -157,8 +167,6 @@ class DescriptorSetLayout {
     const BindingTypeStats &GetBindingTypeStats() const { return binding_type_stats_; }
 
    private:
-    VkDescriptorSetLayout layout_;
-    bool layout_destroyed_;
     std::set<uint32_t> non_empty_bindings_;  // Containing non-emtpy bindings in numerical order
     std::unordered_map<uint32_t, uint32_t> binding_to_index_map_;
     // The following map allows an non-iterative lookup of a binding from a global index...
@@ -172,123 +180,129 @@ class DescriptorSetLayout {
     uint32_t descriptor_count_;  // total # descriptors in this layout
     uint32_t dynamic_descriptor_count_;
     BindingTypeStats binding_type_stats_;
+    struct BindingStorage {
+        DescriptorClass descriptor_class;
+        uint32_t class_start;
+    };
+    std::vector<BindingStorage> binding_storage_;  // Indexed like bindings_
+    uint32_t class_descriptor_counts_[kDescriptorClassCount];
 };
 
-/*
- * Descriptor classes
- *  Descriptor is an abstract base class from which 5 separate descriptor types are derived.
- *   This allows the WriteUpdate() and CopyUpdate() operations to be specialized per
- *   descriptor type, but all descriptors in a set can be accessed via the common Descriptor*.
- */
-
-// Slightly broader than type, each c++ "class" will has a corresponding "DescriptorClass"
-enum DescriptorClass { PlainSampler, ImageSampler, Image, TexelBuffer, GeneralBuffer };
+// Return the definition for the given create info.  Definitions are interned: every layout created from an equal create info
+//  shares one, for as long as any of those layouts is alive, so equal definitions can be recognized by pointer.
+std::shared_ptr<DescriptorSetLayoutDef const> GetCanonicalDescriptorSetLayoutDef(const VkDescriptorSetLayoutCreateInfo *);
 
-class Descriptor {
-   public:
-    virtual ~Descriptor(){};
-    virtual void WriteUpdate(const VkWriteDescriptorSet *, const uint32_t) = 0;
-    virtual void CopyUpdate(const Descriptor *) = 0;
-    // Create binding between resources of this descriptor and given cb_node
-    virtual void BindCommandBuffer(const core_validation::layer_data *, GLOBAL_CB_NODE *) = 0;
-    virtual DescriptorClass GetClass() const { return descriptor_class; };
-    // Special fast-path check for SamplerDescriptors that are immutable
-    virtual bool IsImmutableSampler() const { return false; };
-    // Check for dynamic descriptor type
-    virtual bool IsDynamic() const { return false; };
-    // Check for storage descriptor type
-    virtual bool IsStorage() const { return false; };
-    bool updated;  // Has descriptor been updated?
-    DescriptorClass descriptor_class;
-};
-// Shared helper functions - These are useful because the shared sampler image descriptor type
-//  performs common functions with both sampler and image descriptors so they can share their common functions
-bool ValidateSampler(const VkSampler, const core_validation::layer_data *);
-bool ValidateImageUpdate(VkImageView, VkImageLayout, VkDescriptorType, const core_validation::layer_data *,
-                         UNIQUE_VALIDATION_ERROR_CODE *, std::string *);
-
-class SamplerDescriptor : public Descriptor {
+class DescriptorSetLayout {
    public:
-    SamplerDescriptor(const VkSampler *);
-    void WriteUpdate(const VkWriteDescriptorSet *, const uint32_t) override;
-    void CopyUpdate(const Descriptor *) override;
-    void BindCommandBuffer(const core_validation::layer_data *, GLOBAL_CB_NODE *) override;
-    virtual bool IsImmutableSampler() const override { return immutable_; };
-    VkSampler GetSampler() const { return sampler_; }
+    // Constructors and destructor
+    DescriptorSetLayout(const VkDescriptorSetLayoutCreateInfo *p_create_info, const VkDescriptorSetLayout layout);
+    // Validate create info - should be called prior to creation
+    static bool ValidateCreateInfo(const debug_report_data *, const VkDescriptorSetLayoutCreateInfo *, const bool, const uint32_t);
+    // Straightforward Get functions
+    VkDescriptorSetLayout GetDescriptorSetLayout() const { return layout_; };
+    bool IsDestroyed() const { return layout_destroyed_; }
+    void MarkDestroyed() { layout_destroyed_ = true; }
+    // The interned definition, shared with every other layout created from an equal create info
+    const DescriptorSetLayoutDef *GetLayoutDef() const { return layout_def_.get(); }
+    // Return true if this layout is compatible with passed in layout from a pipelineLayout,
+    //   else return false and update error_msg with description of incompatibility
+    bool IsCompatible(DescriptorSetLayout const *const, std::string *) const;
+    // The remaining functions are those of the definition, see DescriptorSetLayoutDef
+    uint32_t GetTotalDescriptorCount() const { return layout_def_->GetTotalDescriptorCount(); };
+    uint32_t GetDynamicDescriptorCount() const { return layout_def_->GetDynamicDescriptorCount(); };
+    VkDescriptorSetLayoutCreateFlags GetCreateFlags() const { return layout_def_->GetCreateFlags(); }
+    uint32_t GetBindingCount() const { return layout_def_->GetBindingCount(); };
+    const std::set<uint32_t> &GetSortedBindingSet() const { return layout_def_->GetSortedBindingSet(); }
+    bool HasBinding(const uint32_t binding) const { return layout_def_->HasBinding(binding); };
+    bool IsNextBindingConsistent(const uint32_t binding) const { return layout_def_->IsNextBindingConsistent(binding); }
+    uint32_t GetIndexFromBinding(uint32_t binding) const { return layout_def_->GetIndexFromBinding(binding); }
+    uint32_t GetMaxBinding() const { return layout_def_->GetMaxBinding(); }
+    VkDescriptorSetLayoutBinding const *GetDescriptorSetLayoutBindingPtrFromIndex(const uint32_t index) const {
+        return layout_def_->GetDescriptorSetLayoutBindingPtrFromIndex(index);
+    }
+    VkDescriptorSetLayoutBinding const *GetDescriptorSetLayoutBindingPtrFromBinding(uint32_t binding) const {
+        return layout_def_->GetDescriptorSetLayoutBindingPtrFromBinding(binding);
+    }
+    uint32_t GetDescriptorCountFromIndex(const uint32_t index) const { return layout_def_->GetDescriptorCountFromIndex(index); }
+    uint32_t GetDescriptorCountFromBinding(const uint32_t binding) const {
+        return layout_def_->GetDescriptorCountFromBinding(binding);
+    }
+    VkDescriptorType GetTypeFromIndex(const uint32_t index) const { return layout_def_->GetTypeFromIndex(index); }
+    VkDescriptorType GetTypeFromBinding(const uint32_t binding) const { return layout_def_->GetTypeFromBinding(binding); }
+    VkShaderStageFlags GetStageFlagsFromIndex(const uint32_t index) const { return layout_def_->GetStageFlagsFromIndex(index); }
+    VkShaderStageFlags GetStageFlagsFromBinding(const uint32_t binding) const {
+        return layout_def_->GetStageFlagsFromBinding(binding);
+    }
+    uint32_t GetIndexFromGlobalIndex(const uint32_t global_index) const {
+        return layout_def_->GetIndexFromGlobalIndex(global_index);
+    }
+    VkDescriptorType GetTypeFromGlobalIndex(const uint32_t global_index) const {
+        return layout_def_->GetTypeFromGlobalIndex(global_index);
+    }
+    DescriptorClass GetClassFromIndex(const uint32_t index) const { return layout_def_->GetClassFromIndex(index); }
+    uint32_t GetClassStartFromIndex(const uint32_t index) const { return layout_def_->GetClassStartFromIndex(index); }
+    uint32_t GetClassDescriptorCount(DescriptorClass descriptor_class) const {
+        return layout_def_->GetClassDescriptorCount(descriptor_class);
+    }
+    VkSampler const *GetImmutableSamplerPtrFromBinding(const uint32_t binding) const {
+        return layout_def_->GetImmutableSamplerPtrFromBinding(binding);
+    }
+    VkSampler const *GetImmutableSamplerPtrFromIndex(const uint32_t index) const {
+        return layout_def_->GetImmutableSamplerPtrFromIndex(index);
+    }
+    int32_t GetDynamicOffsetIndexFromBinding(uint32_t binding) const {
+        return layout_def_->GetDynamicOffsetIndexFromBinding(binding);
+    }
+    const IndexRange &GetGlobalIndexRangeFromBinding(const uint32_t binding) const {
+        return layout_def_->GetGlobalIndexRangeFromBinding(binding);
+    }
+    uint32_t GetNextValidBinding(const uint32_t binding) const { return layout_def_->GetNextValidBinding(binding); }
+    bool VerifyUpdateConsistency(uint32_t current_binding, uint32_t offset, uint32_t update_count, const char *type,
+                                 const VkDescriptorSet set, std::string *error_msg) const {
+        return layout_def_->VerifyUpdateConsistency(current_binding, offset, update_count, type, set, error_msg);
+    }
+    bool IsPushDescriptor() const { return layout_def_->IsPushDescriptor(); };
+    typedef DescriptorSetLayoutDef::BindingTypeStats BindingTypeStats;
+    const BindingTypeStats &GetBindingTypeStats() const { return layout_def_->GetBindingTypeStats(); }
 
    private:
-    // bool ValidateSampler(const VkSampler) const;
-    VkSampler sampler_;
-    bool immutable_;
+    VkDescriptorSetLayout layout_;
+    bool layout_destroyed_;
+    std::shared_ptr<DescriptorSetLayoutDef const> layout_def_;
 };
 
-class ImageSamplerDescriptor : public Descriptor {
-   public:
-    ImageSamplerDescriptor(const VkSampler *);
-    void WriteUpdate(const VkWriteDescriptorSet *, const uint32_t) override;
-    void CopyUpdate(const Descriptor *) override;
-    void BindCommandBuffer(const core_validation::layer_data *, GLOBAL_CB_NODE *) override;
-    virtual bool IsImmutableSampler() const override { return immutable_; };
-    VkSampler GetSampler() const { return sampler_; }
-    VkImageView GetImageView() const { return image_view_; }
-    VkImageLayout GetImageLayout() const { return image_layout_; }
-
-   private:
-    VkSampler sampler_;
-    bool immutable_;
-    VkImageView image_view_;
-    VkImageLayout image_layout_;
+/*
+ * Descriptor records
+ *  A set stores its descriptors as one plain record per descriptor, with the records of each DescriptorClass kept in
+ *   their own array (see DescriptorSet below).  Whether a descriptor is storage, dynamic or uses an immutable sampler
+ *   follows from its binding, so the records only hold what an update writes.
+ */
+struct SamplerDescriptor {
+    VkSampler sampler;
 };
-
-class ImageDescriptor : public Descriptor {
-   public:
-    ImageDescriptor(const VkDescriptorType);
-    void WriteUpdate(const VkWriteDescriptorSet *, const uint32_t) override;
-    void CopyUpdate(const Descriptor *) override;
-    void BindCommandBuffer(const core_validation::layer_data *, GLOBAL_CB_NODE *) override;
-    virtual bool IsStorage() const override { return storage_; }
-    VkImageView GetImageView() const { return image_view_; }
-    VkImageLayout GetImageLayout() const { return image_layout_; }
-
-   private:
-    bool storage_;
-    VkImageView image_view_;
-    VkImageLayout image_layout_;
+struct ImageSamplerDescriptor {
+    VkSampler sampler;
+    VkImageView image_view;
+    VkImageLayout image_layout;
 };
-
-class TexelDescriptor : public Descriptor {
-   public:
-    TexelDescriptor(const VkDescriptorType);
-    void WriteUpdate(const VkWriteDescriptorSet *, const uint32_t) override;
-    void CopyUpdate(const Descriptor *) override;
-    void BindCommandBuffer(const core_validation::layer_data *, GLOBAL_CB_NODE *) override;
-    virtual bool IsStorage() const override { return storage_; }
-    VkBufferView GetBufferView() const { return buffer_view_; }
-
-   private:
-    VkBufferView buffer_view_;
-    bool storage_;
+struct ImageDescriptor {
+    VkImageView image_view;
+    VkImageLayout image_layout;
 };
-
-class BufferDescriptor : public Descriptor {
-   public:
-    BufferDescriptor(const VkDescriptorType);
-    void WriteUpdate(const VkWriteDescriptorSet *, const uint32_t) override;
-    void CopyUpdate(const Descriptor *) override;
-    void BindCommandBuffer(const core_validation::layer_data *, GLOBAL_CB_NODE *) override;
-    virtual bool IsDynamic() const override { return dynamic_; }
-    virtual bool IsStorage() const override { return storage_; }
-    VkBuffer GetBuffer() const { return buffer_; }
-    VkDeviceSize GetOffset() const { return offset_; }
-    VkDeviceSize GetRange() const { return range_; }
-
-   private:
-    bool storage_;
-    bool dynamic_;
-    VkBuffer buffer_;
-    VkDeviceSize offset_;
-    VkDeviceSize range_;
+struct TexelDescriptor {
+    VkBufferView buffer_view;
+};
+struct BufferDescriptor {
+    VkBuffer buffer;
+    VkDeviceSize offset;
+    VkDeviceSize range;
 };
+// Shared helper functions - These are useful because the shared sampler image descriptor type
+//  performs common functions with both sampler and image descriptors so they can share their common functions
+bool ValidateSampler(const VkSampler, const core_validation::layer_data *);
+bool ValidateImageUpdate(VkImageView, VkImageLayout, VkDescriptorType, const core_validation::layer_data *,
+                         UNIQUE_VALIDATION_ERROR_CODE *, std::string *);
+
 // Structs to contain common elements that need to be shared between Validate* and Perform* calls below
 struct AllocateDescriptorSetsData {
     uint32_t required_descriptors_by_type[VK_DESCRIPTOR_TYPE_RANGE_SIZE];
@@ -302,9 +316,15 @@ bool ValidateUpdateDescriptorSets(const debug_report_data *, const core_validati
 // "Perform" does the update with the assumption that ValidateUpdateDescriptorSets() has passed for the given update
 void PerformUpdateDescriptorSets(const core_validation::layer_data *, uint32_t, const VkWriteDescriptorSet *, uint32_t,
                                  const VkCopyDescriptorSet *);
+// Validate the contents of an update via template, reading each descriptor straight from pData
+bool ValidateUpdateDescriptorSetsWithTemplateKHR(const debug_report_data *, const layer_data *, VkDescriptorSet,
+                                                 std::unique_ptr<TEMPLATE_STATE> const &, const void *);
 // Similar to PerformUpdateDescriptorSets, this function will do the same for updating via templates
 void PerformUpdateDescriptorSetsWithTemplateKHR(layer_data *, VkDescriptorSet, std::unique_ptr<TEMPLATE_STATE> const &,
                                                 const void *);
+// Resolve the entries of a descriptor update template against the layout of the sets that it will update
+void CompileUpdateTemplate(const DescriptorSetLayout *, const safe_VkDescriptorUpdateTemplateCreateInfoKHR &,
+                           std::vector<DESCRIPTOR_TEMPLATE_OP> *);
 // Update the common AllocateDescriptorSetsData struct which can then be shared between Validate* and Perform* funcs below
 void UpdateAllocateDescriptorSetsData(const layer_data *dev_data, const VkDescriptorSetAllocateInfo *,
                                       AllocateDescriptorSetsData *);
@@ -313,9 +333,13 @@ bool ValidateAllocateDescriptorSets(const core_validation::layer_data *, const V
                                     const AllocateDescriptorSetsData *);
 // Update state based on allocating new descriptorsets
 void PerformAllocateDescriptorSets(const VkDescriptorSetAllocateInfo *, const VkDescriptorSet *, const AllocateDescriptorSetsData *,
-                                   std::unordered_map<VkDescriptorPool, DESCRIPTOR_POOL_STATE *> *,
-                                   std::unordered_map<VkDescriptorSet, cvdescriptorset::DescriptorSet *> *,
+                                   vl_concurrent_unordered_map<VkDescriptorPool, DESCRIPTOR_POOL_STATE *> *,
+                                   vl_concurrent_unordered_map<VkDescriptorSet, cvdescriptorset::DescriptorSet *> *,
                                    core_validation::layer_data *);
+// Destroy a set created by PerformAllocateDescriptorSets. A set carved out of its pool's arena leaves its memory there.
+void DestroyDescriptorSet(DescriptorSet *);
+// Size of the block a pool's set arena should start with, based on the pool's limits
+size_t GetDescriptorPoolArenaSize(const VkDescriptorPoolCreateInfo *);
 
 /*
  * DescriptorSet class
@@ -327,18 +351,25 @@ void PerformAllocateDescriptorSets(const VkDescriptorSetAllocateInfo *, const Vk
  *   Please refer to the DescriptorSetLayout comment above for a description of
  *   index, binding, and global index.
  *
- * At construction a vector of Descriptor* is created with types corresponding to the
- *   layout. The primary operation performed on the descriptors is to update them
+ * At construction a single block is allocated for the descriptors of the set. It starts with a
+ *   bitset holding one "updated" bit per global index, followed by one array of records per
+ *   DescriptorClass, each laid out in binding order as described by the layout, so a binding's
+ *   descriptors are contiguous records of a single type. The primary operation performed on the descriptors is to update them
  *   via write or copy updates, and validate that the update contents are correct.
  *   In order to validate update contents, the DescriptorSet stores a bunch of ptrs
  *   to data maps where various Vulkan objects can be looked up. The management of
  *   those maps is performed externally. The set class relies on their contents to
  *   be correct at the time of update.
+ *
+ * Sets allocated from a pool that cannot free individual sets are placed, along with
+ *   their descriptor block, in the pool's arena (DESCRIPTOR_POOL_STATE::set_arena), so
+ *   allocating one is a bump of the arena and resetting the pool releases them all at once.
  */
 class DescriptorSet : public BASE_NODE {
    public:
+    // If arena is given, the descriptor block is allocated from it, and the set must be destroyed with DestroyDescriptorSet
     DescriptorSet(const VkDescriptorSet, const VkDescriptorPool, const std::shared_ptr<DescriptorSetLayout const> &,
-                  core_validation::layer_data *);
+                  core_validation::layer_data *, vl_arena *arena = nullptr);
     ~DescriptorSet();
     // A number of common Get* functions that return data based on layout from which this set was created
     uint32_t GetTotalDescriptorCount() const { return p_layout_->GetTotalDescriptorCount(); };
@@ -364,8 +395,8 @@ class DescriptorSet : public BASE_NODE {
                            const char *caller, std::string *) const;
     // For given set of bindings, add any buffers and images that will be updated to their respective unordered_sets & return number
     // of objects inserted
-    uint32_t GetStorageUpdates(const std::map<uint32_t, descriptor_req> &, std::unordered_set<VkBuffer> *,
-                               std::unordered_set<VkImageView> *) const;
+    uint32_t GetStorageUpdates(const std::map<uint32_t, descriptor_req> &, vl_dense_set<VkBuffer> *,
+                               vl_dense_set<VkImageView> *) const;
 
     // Descriptor Update functions. These functions validate state and perform update separately
     // Validate contents of a WriteUpdate
@@ -378,9 +409,18 @@ class DescriptorSet : public BASE_NODE {
                             UNIQUE_VALIDATION_ERROR_CODE *, std::string *);
     // Perform a CopyUpdate whose contents were just validated using ValidateCopyUpdate
     void PerformCopyUpdate(const VkCopyDescriptorSet *, const DescriptorSet *);
+    // Validate the descriptors a template update would write from the given data, using ops compiled against this set's layout
+    bool ValidateTemplateUpdate(const std::vector<DESCRIPTOR_TEMPLATE_OP> &, const void *, UNIQUE_VALIDATION_ERROR_CODE *,
+                                std::string *) const;
+    // Perform a template update from the given data, using template ops compiled against this set's layout
+    void PerformTemplateUpdate(const std::vector<DESCRIPTOR_TEMPLATE_OP> &, const void *);
 
     std::shared_ptr<DescriptorSetLayout const> const GetLayout() const { return p_layout_; };
     VkDescriptorSet GetSet() const { return set_; };
+    // Position of this set in its pool's list of sets, kept so that a freed set can be unlinked in constant time
+    size_t GetPoolSlot() const { return pool_slot_; }
+    void SetPoolSlot(size_t slot) { pool_slot_ = slot; }
+    bool IsArenaAllocated() const { return arena_allocated_; }
     // Return unordered_set of all command buffers that this set is bound to
     std::unordered_set<GLOBAL_CB_NODE *> GetBoundCmdBuffers() const { return cb_bindings; }
     // Bind given cmd_buffer to this descriptor set
@@ -395,8 +435,11 @@ class DescriptorSet : public BASE_NODE {
                                             BindingReqMap *out_req, TrackedBindings *set, uint32_t limit);
     void FilterAndTrackBindingReqs(GLOBAL_CB_NODE *, const BindingReqMap &in_req, BindingReqMap *out_req);
     void FilterAndTrackBindingReqs(GLOBAL_CB_NODE *, PIPELINE_STATE *, const BindingReqMap &in_req, BindingReqMap *out_req);
-    void ClearCachedDynamicDescriptorValidation(GLOBAL_CB_NODE *cb_state) { cached_validation_[cb_state].dynamic_buffers.clear(); }
-    void ClearCachedValidation(GLOBAL_CB_NODE *cb_state) { cached_validation_.erase(cb_state); }
+    void ClearCachedDynamicDescriptorValidation(GLOBAL_CB_NODE *cb_state) { GetCachedValidation(cb_state).dynamic_buffers.clear(); }
+    void ClearCachedValidation(GLOBAL_CB_NODE *cb_state) {
+        std::lock_guard<std::mutex> lock(cached_validation_lock_);
+        cached_validation_.erase(cb_state);
+    }
     // If given cmd_buffer is in the cb_bindings set, remove it
     void RemoveBoundCommandBuffer(GLOBAL_CB_NODE *cb_node) {
         cb_bindings.erase(cb_node);
@@ -423,11 +466,31 @@ class DescriptorSet : public BASE_NODE {
                               std::string *) const;
     // Private helper to set all bound cmd buffers to INVALID state
     void InvalidateBoundCmdBuffers();
+    // Find the class of the descriptor at the given global index and its index within that class's records
+    void LocateDescriptor(uint32_t global_index, DescriptorClass *descriptor_class, uint32_t *class_index) const;
+    bool IsDescriptorUpdated(uint32_t global_index) const { return (updated_[global_index / 64] >> (global_index % 64)) & 1; }
+    void SetDescriptorUpdated(uint32_t global_index, bool updated) {
+        const uint64_t bit = uint64_t(1) << (global_index % 64);
+        if (updated) {
+            updated_[global_index / 64] |= bit;
+        } else {
+            updated_[global_index / 64] &= ~bit;
+        }
+    }
     bool some_update_;  // has any part of the set ever been updated?
     VkDescriptorSet set_;
     DESCRIPTOR_POOL_STATE *pool_state_;
+    size_t pool_slot_;
+    const bool arena_allocated_;
     const std::shared_ptr<DescriptorSetLayout const> p_layout_;
-    std::vector<std::unique_ptr<Descriptor>> descriptors_;
+    // Descriptor storage, all carved out of one block, owned by storage_ unless the set lives in its pool's arena
+    std::unique_ptr<uint64_t[]> storage_;
+    uint64_t *updated_;
+    SamplerDescriptor *samplers_;
+    ImageSamplerDescriptor *image_samplers_;
+    ImageDescriptor *images_;
+    TexelDescriptor *texel_buffers_;
+    BufferDescriptor *buffers_;
     // Ptr to device data used for various data look-ups
     core_validation::layer_data *const device_data_;
     const VkPhysicalDeviceLimits limits_;
@@ -449,6 +512,12 @@ class DescriptorSet : public BASE_NODE {
     typedef std::unordered_map<GLOBAL_CB_NODE *, CachedValidation> CachedValidationMap;
     // Image and ImageView bindings are validated per pipeline and not invalidate by repeated binding
     CachedValidationMap cached_validation_;
+    // Command buffers recorded on different threads share the map, though each only ever touches its own entry
+    std::mutex cached_validation_lock_;
+    CachedValidation &GetCachedValidation(GLOBAL_CB_NODE *cb_state) {
+        std::lock_guard<std::mutex> lock(cached_validation_lock_);
+        return cached_validation_[cb_state];
+    }
 };
 // For the "bindless" style resource usage with many descriptors, need to optimize binding and validation
 class PrefilterBindRequestMap {
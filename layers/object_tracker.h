@@ -20,6 +20,7 @@
  * Author: Tobin Ehlis <tobin@lunarg.com>
  */
 
+#include <atomic>
 #include <mutex>
 #include <cinttypes>
 #include <stdio.h>
@@ -29,6 +30,7 @@
 
 #include "vk_loader_platform.h"
 #include "vulkan/vulkan.h"
+#include "vk_layer_concurrent_map.h"
 #include "vk_layer_config.h"
 #include "vk_layer_data.h"
 #include "vk_layer_logging.h"
@@ -85,14 +87,18 @@ struct ObjTrackQueueInfo {
 // Layer name string to be logged with validation messages.
 const char LayerName[] = "ObjectTracker";
 
-typedef std::unordered_map<uint64_t, ObjTrackState *> object_map_type;
+// Handle -> state for the live objects of one VulkanObjectType.  Each type has its own sharded, reader/writer locked map, so
+// the lookups made by ValidateObject on nearly every entry point only take one shard's lock in shared mode instead of
+// serializing every thread on global_lock.  States are stored in the map by value; the pointers find() returns stay valid
+// until the object is destroyed.
+typedef vl_concurrent_unordered_map<uint64_t, ObjTrackState> object_map_type;
 
 struct layer_data {
     VkInstance instance;
     VkPhysicalDevice physical_device;
 
-    uint64_t num_objects[kVulkanObjectTypeMax + 1];
-    uint64_t num_total_objects;
+    std::atomic<uint64_t> num_objects[kVulkanObjectTypeMax + 1];
+    std::atomic<uint64_t> num_total_objects;
 
     debug_report_data *report_data;
     std::vector<VkDebugReportCallbackEXT> logging_callback;
@@ -104,11 +110,11 @@ struct layer_data {
 
     std::vector<VkQueueFamilyProperties> queue_family_properties;
 
-    // Vector of unordered_maps per object type to hold ObjTrackState info
-    std::vector<object_map_type> object_map;
+    // One map per object type to hold ObjTrackState info
+    object_map_type object_map[kVulkanObjectTypeMax + 1];
     // Special-case map for swapchain images
-    std::unordered_map<uint64_t, ObjTrackState *> swapchainImageMap;
-    // Map of queue information structures, one per queue
+    object_map_type swapchainImageMap;
+    // Map of queue information structures, one per queue.  Guarded by global_lock.
     std::unordered_map<VkQueue, ObjTrackQueueInfo *> queue_info_map;
 
     VkLayerDispatchTable dispatch_table;
@@ -122,17 +128,17 @@ struct layer_data {
           num_tmp_callbacks(0),
           tmp_dbg_create_infos(nullptr),
           tmp_callbacks(nullptr),
-          object_map{},
-          dispatch_table{} {
-        object_map.resize(kVulkanObjectTypeMax + 1);
-    }
+          dispatch_table{} {}
 };
 
-extern std::unordered_map<void *, layer_data *> layer_data_map;
+extern vl_layer_data_map<layer_data> layer_data_map;
 extern device_table_map ot_device_table_map;
 extern instance_table_map ot_instance_table_map;
+// Serializes the operations that sweep many objects at once (pool resets and destroys, device and instance teardown) and
+// guards queue_info_map and queue_family_properties.  The object maps lock themselves, so validating, creating or
+// destroying a single object does not need it.
 extern std::mutex global_lock;
-extern uint64_t object_track_index;
+extern std::atomic<uint64_t> object_track_index;
 extern uint32_t loader_layer_if_version;
 extern const std::unordered_map<std::string, void *> name_to_funcptr_map;
 
@@ -164,28 +170,27 @@ bool ValidateObject(T1 dispatchable_object, T2 object, VulkanObjectType object_t
 
     layer_data *device_data = GetLayerDataPtr(get_dispatch_key(dispatchable_object), layer_data_map);
     // Look for object in device object map
-    if (device_data->object_map[object_type].find(object_handle) == device_data->object_map[object_type].end()) {
+    if (!device_data->object_map[object_type].contains(object_handle)) {
         // If object is an image, also look for it in the swapchain image map
-        if ((object_type != kVulkanObjectTypeImage) ||
-            (device_data->swapchainImageMap.find(object_handle) == device_data->swapchainImageMap.end())) {
+        if ((object_type != kVulkanObjectTypeImage) || !device_data->swapchainImageMap.contains(object_handle)) {
             // Object not found, look for it in other device object maps
-            for (auto other_device_data : layer_data_map) {
-                if (other_device_data.second != device_data) {
-                    if (other_device_data.second->object_map[object_type].find(object_handle) !=
-                            other_device_data.second->object_map[object_type].end() ||
-                        (object_type == kVulkanObjectTypeImage && other_device_data.second->swapchainImageMap.find(object_handle) !=
-                                                                      other_device_data.second->swapchainImageMap.end())) {
-                        // Object found on other device, report an error if object has a device parent error code
-                        if ((wrong_device_code != VALIDATION_ERROR_UNDEFINED) && (object_type != kVulkanObjectTypeSurfaceKHR)) {
-                            return log_msg(device_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, debug_object_type,
-                                           object_handle, __LINE__, wrong_device_code, LayerName,
-                                           "Object 0x%" PRIxLEAST64
-                                           " was not created, allocated or retrieved from the correct device. %s",
-                                           object_handle, validation_error_map[wrong_device_code]);
-                        } else {
-                            return false;
-                        }
-                    }
+            bool found_on_other_device = false;
+            layer_data_map.for_each([&](void *, layer_data *other_device_data) {
+                if (other_device_data != device_data &&
+                    (other_device_data->object_map[object_type].contains(object_handle) ||
+                     (object_type == kVulkanObjectTypeImage && other_device_data->swapchainImageMap.contains(object_handle)))) {
+                    found_on_other_device = true;
+                }
+            });
+            if (found_on_other_device) {
+                // Object found on other device, report an error if object has a device parent error code
+                if ((wrong_device_code != VALIDATION_ERROR_UNDEFINED) && (object_type != kVulkanObjectTypeSurfaceKHR)) {
+                    return log_msg(device_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, debug_object_type, object_handle,
+                                   __LINE__, wrong_device_code, LayerName,
+                                   "Object 0x%" PRIxLEAST64 " was not created, allocated or retrieved from the correct device. %s",
+                                   object_handle, validation_error_map[wrong_device_code]);
+                } else {
+                    return false;
                 }
             }
             // Report an error if object was not found anywhere
@@ -204,18 +209,17 @@ void CreateObject(T1 dispatchable_object, T2 object, VulkanObjectType object_typ
     auto object_handle = HandleToUint64(object);
     bool custom_allocator = pAllocator != nullptr;
 
-    if (!instance_data->object_map[object_type].count(object_handle)) {
+    ObjTrackState new_obj_node = {};
+    new_obj_node.object_type = object_type;
+    new_obj_node.status = custom_allocator ? OBJSTATUS_CUSTOM_ALLOCATOR : OBJSTATUS_NONE;
+    new_obj_node.handle = object_handle;
+
+    if (instance_data->object_map[object_type].insert(object_handle, new_obj_node)) {
         VkDebugReportObjectTypeEXT debug_object_type = get_debug_report_enum[object_type];
         log_msg(instance_data->report_data, VK_DEBUG_REPORT_INFORMATION_BIT_EXT, debug_object_type, object_handle, __LINE__,
                 OBJTRACK_NONE, LayerName, "OBJ[0x%" PRIxLEAST64 "] : CREATE %s object 0x%" PRIxLEAST64, object_track_index++,
                 object_string[object_type], object_handle);
 
-        ObjTrackState *pNewObjNode = new ObjTrackState;
-        pNewObjNode->object_type = object_type;
-        pNewObjNode->status = custom_allocator ? OBJSTATUS_CUSTOM_ALLOCATOR : OBJSTATUS_NONE;
-        pNewObjNode->handle = object_handle;
-
-        instance_data->object_map[object_type][object_handle] = pNewObjNode;
         instance_data->num_objects[object_type]++;
         instance_data->num_total_objects++;
     }
@@ -232,21 +236,23 @@ void DestroyObject(T1 dispatchable_object, T2 object, VulkanObjectType object_ty
     VkDebugReportObjectTypeEXT debug_object_type = get_debug_report_enum[object_type];
 
     if (object_handle != VK_NULL_HANDLE) {
-        auto item = device_data->object_map[object_type].find(object_handle);
-        if (item != device_data->object_map[object_type].end()) {
-            ObjTrackState *pNode = item->second;
+        ObjTrackState *pNode = device_data->object_map[object_type].find(object_handle);
+        if (pNode) {
+            const ObjectStatusFlags status = pNode->status;
+            device_data->object_map[object_type].erase(object_handle);
+
             assert(device_data->num_total_objects > 0);
-            device_data->num_total_objects--;
-            assert(device_data->num_objects[pNode->object_type] > 0);
-            device_data->num_objects[pNode->object_type]--;
+            const uint64_t num_total_objects = --device_data->num_total_objects;
+            assert(device_data->num_objects[object_type] > 0);
+            const uint64_t num_objects = --device_data->num_objects[object_type];
 
             log_msg(device_data->report_data, VK_DEBUG_REPORT_INFORMATION_BIT_EXT, debug_object_type, object_handle, __LINE__,
                     OBJTRACK_NONE, LayerName,
                     "OBJ_STAT Destroy %s obj 0x%" PRIxLEAST64 " (%" PRIu64 " total objs remain & %" PRIu64 " %s objs).",
-                    object_string[object_type], HandleToUint64(object), device_data->num_total_objects,
-                    device_data->num_objects[pNode->object_type], object_string[object_type]);
+                    object_string[object_type], HandleToUint64(object), num_total_objects, num_objects,
+                    object_string[object_type]);
 
-            auto allocated_with_custom = (pNode->status & OBJSTATUS_CUSTOM_ALLOCATOR) ? true : false;
+            auto allocated_with_custom = (status & OBJSTATUS_CUSTOM_ALLOCATOR) ? true : false;
             if (allocated_with_custom && !custom_allocator && expected_custom_allocator_code != VALIDATION_ERROR_UNDEFINED) {
                 // This check only verifies that custom allocation callbacks were provided to both Create and Destroy calls,
                 // it cannot verify that these allocation callbacks are compatible with each other.
@@ -261,9 +267,6 @@ void DestroyObject(T1 dispatchable_object, T2 object, VulkanObjectType object_ty
                         "Custom allocator specified while destroying %s obj 0x%" PRIxLEAST64 " but not specified at creation. %s",
                         object_string[object_type], object_handle, validation_error_map[expected_default_allocator_code]);
             }
-
-            delete pNode;
-            device_data->object_map[object_type].erase(item);
         } else {
             log_msg(device_data->report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, object_handle,
                     __LINE__, OBJTRACK_UNKNOWN_OBJECT, LayerName,
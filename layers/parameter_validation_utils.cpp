@@ -79,8 +79,8 @@ extern bool parameter_validation_vkDestroyRenderPass(VkDevice device, VkRenderPa
 std::mutex global_lock;
 
 static uint32_t loader_layer_if_version = CURRENT_LOADER_LAYER_INTERFACE_VERSION;
-std::unordered_map<void *, layer_data *> layer_data_map;
-std::unordered_map<void *, instance_layer_data *> instance_layer_data_map;
+vl_layer_data_map<layer_data> layer_data_map;
+vl_layer_data_map<instance_layer_data> instance_layer_data_map;
 
 void InitializeManualParameterValidationFunctionPointers(void);
 
@@ -498,7 +498,7 @@ VKAPI_ATTR void VKAPI_CALL vkDestroyDevice(VkDevice device, const VkAllocationCa
     }
 
     if (!skip) {
-        layer_debug_report_destroy_device(device);
+        layer_debug_report_destroy_device(device_data->report_data, device);
         device_data->dispatch_table.DestroyDevice(device, pAllocator);
     }
     FreeLayerDataPtr(key, layer_data_map);
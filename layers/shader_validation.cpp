@@ -20,6 +20,10 @@
 
 #include <cinttypes>
 #include <cassert>
+#include <algorithm>
+#include <cstdio>
+#include <iterator>
+#include <random>
 #include <vector>
 #include <unordered_map>
 #include <string>
@@ -43,18 +47,6 @@ enum FORMAT_TYPE {
     FORMAT_TYPE_UINT = 4,
 };
 
-typedef std::pair<unsigned, unsigned> location_t;
-
-struct interface_var {
-    uint32_t id;
-    uint32_t type_id;
-    uint32_t offset;
-    bool is_patch;
-    bool is_block_member;
-    bool is_relaxed_precision;
-    // TODO: collect the name, too? Isn't required to be present.
-};
-
 struct shader_stage_attributes {
     char const *const name;
     bool arrayed_input;
@@ -67,9 +59,67 @@ static shader_stage_attributes shader_stage_attribs[] = {
 };
 
 // SPIRV utility functions
+void decoration_set::add(uint32_t decoration, uint32_t value) {
+    switch (decoration) {
+        case spv::DecorationLocation:
+            flags |= location_bit;
+            location = value;
+            break;
+        case spv::DecorationPatch:
+            flags |= patch_bit;
+            break;
+        case spv::DecorationRelaxedPrecision:
+            flags |= relaxed_precision_bit;
+            break;
+        case spv::DecorationBlock:
+            flags |= block_bit;
+            break;
+        case spv::DecorationBufferBlock:
+            flags |= buffer_block_bit;
+            break;
+        case spv::DecorationComponent:
+            flags |= component_bit;
+            component = value;
+            break;
+        case spv::DecorationDescriptorSet:
+            flags |= descriptor_set_bit;
+            descriptor_set = value;
+            break;
+        case spv::DecorationBinding:
+            flags |= binding_bit;
+            binding = value;
+            break;
+        case spv::DecorationBuiltIn:
+            flags |= builtin_bit;
+            builtin = value;
+            break;
+    }
+}
+
 void shader_module::build_def_index() {
+    // A module can't define more ids than it has words, so a bound beyond that would leave the table mostly empty; ids
+    // outside the table (all of them then, or only out-of-bound ones in a module that skipped validation) go in the
+    // sparse index instead.
+    const uint32_t bound = words.size() > 3 ? words[3] : 0;
+    if (bound <= words.size()) def_index.resize(bound, 0);
+    auto add_def = [this](uint32_t id, uint32_t offset) {
+        if (id < def_index.size()) {
+            def_index[id] = offset;
+        } else {
+            sparse_def_index.emplace_back(id, offset);
+        }
+    };
+
     for (auto insn : *this) {
         switch (insn.opcode()) {
+            case spv::OpCapability:
+                capabilities.push_back(insn.word(1));
+                break;
+
+            case spv::OpDecorate:
+                decorations[insn.word(1)].add(insn.word(2), insn.len() > 3 ? insn.word(3) : 0);
+                break;
+
             // Types
             case spv::OpTypeVoid:
             case spv::OpTypeBool:
@@ -91,7 +141,7 @@ void shader_module::build_def_index() {
             case spv::OpTypeReserveId:
             case spv::OpTypeQueue:
             case spv::OpTypePipe:
-                def_index[insn.word(1)] = insn.offset();
+                add_def(insn.word(1), insn.offset());
                 break;
 
                 // Fixed constants
@@ -101,7 +151,7 @@ void shader_module::build_def_index() {
             case spv::OpConstantComposite:
             case spv::OpConstantSampler:
             case spv::OpConstantNull:
-                def_index[insn.word(2)] = insn.offset();
+                add_def(insn.word(2), insn.offset());
                 break;
 
                 // Specialization constants
@@ -110,17 +160,17 @@ void shader_module::build_def_index() {
             case spv::OpSpecConstant:
             case spv::OpSpecConstantComposite:
             case spv::OpSpecConstantOp:
-                def_index[insn.word(2)] = insn.offset();
+                add_def(insn.word(2), insn.offset());
                 break;
 
                 // Variables
             case spv::OpVariable:
-                def_index[insn.word(2)] = insn.offset();
+                add_def(insn.word(2), insn.offset());
                 break;
 
                 // Functions
             case spv::OpFunction:
-                def_index[insn.word(2)] = insn.offset();
+                add_def(insn.word(2), insn.offset());
                 break;
 
             default:
@@ -128,6 +178,9 @@ void shader_module::build_def_index() {
                 break;
         }
     }
+
+    // Ids are defined once each, so sorting is enough for get_def to binary search
+    std::sort(sparse_def_index.begin(), sparse_def_index.end());
 }
 
 static spirv_inst_iter find_entrypoint(shader_module const *src, char const *name, VkShaderStageFlagBits stageBits) {
@@ -341,14 +394,6 @@ static bool types_match(shader_module const *a, shader_module const *b, unsigned
     }
 }
 
-static unsigned value_or_default(std::unordered_map<unsigned, unsigned> const &map, unsigned id, unsigned def) {
-    auto it = map.find(id);
-    if (it == map.end())
-        return def;
-    else
-        return it->second;
-}
-
 static unsigned get_locations_consumed_by_type(shader_module const *src, unsigned type, bool strip_array_level) {
     auto insn = src->get_def(type);
     assert(insn != src->end());
@@ -453,11 +498,11 @@ static spirv_inst_iter get_struct_type(shader_module const *src, spirv_inst_iter
 }
 
 static bool collect_interface_block_members(shader_module const *src, std::map<location_t, interface_var> *out,
-                                            std::unordered_map<unsigned, unsigned> const &blocks, bool is_array_of_verts,
-                                            uint32_t id, uint32_t type_id, bool is_patch, int /*first_location*/) {
+                                            bool is_array_of_verts, uint32_t id, uint32_t type_id, bool is_patch,
+                                            int /*first_location*/) {
     // Walk down the type_id presented, trying to determine whether it's actually an interface block.
     auto type = get_struct_type(src, src->get_def(type_id), is_array_of_verts && !is_patch);
-    if (type == src->end() || blocks.find(type.word(1)) == blocks.end()) {
+    if (type == src->end() || !(src->get_decorations(type.word(1)).flags & decoration_set::block_bit)) {
         // This isn't an interface block.
         return false;
     }
@@ -522,43 +567,8 @@ static bool collect_interface_block_members(shader_module const *src, std::map<l
 
 static std::map<location_t, interface_var> collect_interface_by_location(shader_module const *src, spirv_inst_iter entrypoint,
                                                                          spv::StorageClass sinterface, bool is_array_of_verts) {
-    std::unordered_map<unsigned, unsigned> var_locations;
-    std::unordered_map<unsigned, unsigned> var_builtins;
-    std::unordered_map<unsigned, unsigned> var_components;
-    std::unordered_map<unsigned, unsigned> blocks;
-    std::unordered_map<unsigned, unsigned> var_patch;
-    std::unordered_map<unsigned, unsigned> var_relaxed_precision;
-
-    for (auto insn : *src) {
-        // We consider two interface models: SSO rendezvous-by-location, and builtins. Complain about anything that
-        // fits neither model.
-        if (insn.opcode() == spv::OpDecorate) {
-            if (insn.word(2) == spv::DecorationLocation) {
-                var_locations[insn.word(1)] = insn.word(3);
-            }
-
-            if (insn.word(2) == spv::DecorationBuiltIn) {
-                var_builtins[insn.word(1)] = insn.word(3);
-            }
-
-            if (insn.word(2) == spv::DecorationComponent) {
-                var_components[insn.word(1)] = insn.word(3);
-            }
-
-            if (insn.word(2) == spv::DecorationBlock) {
-                blocks[insn.word(1)] = 1;
-            }
-
-            if (insn.word(2) == spv::DecorationPatch) {
-                var_patch[insn.word(1)] = 1;
-            }
-
-            if (insn.word(2) == spv::DecorationRelaxedPrecision) {
-                var_relaxed_precision[insn.word(1)] = 1;
-            }
-        }
-    }
-
+    // We consider two interface models: SSO rendezvous-by-location, and builtins. Complain about anything that
+    // fits neither model.
     // TODO: handle grouped decorations
     // TODO: handle index=1 dual source outputs from FS -- two vars will have the same location, and we DON'T want to clobber.
 
@@ -581,15 +591,15 @@ static std::map<location_t, interface_var> collect_interface_by_location(shader_
             unsigned id = insn.word(2);
             unsigned type = insn.word(1);
 
-            int location = value_or_default(var_locations, id, static_cast<unsigned>(-1));
-            int builtin = value_or_default(var_builtins, id, static_cast<unsigned>(-1));
-            unsigned component = value_or_default(var_components, id, 0);  // Unspecified is OK, is 0
-            bool is_patch = var_patch.find(id) != var_patch.end();
-            bool is_relaxed_precision = var_relaxed_precision.find(id) != var_relaxed_precision.end();
+            auto decorations = src->get_decorations(id);
+            int location = decorations.location;
+            unsigned component = decorations.component;  // Unspecified is OK, is 0
+            bool is_patch = (decorations.flags & decoration_set::patch_bit) != 0;
+            bool is_relaxed_precision = (decorations.flags & decoration_set::relaxed_precision_bit) != 0;
 
-            if (builtin != -1)
+            if (decorations.flags & decoration_set::builtin_bit)
                 continue;
-            else if (!collect_interface_block_members(src, &out, blocks, is_array_of_verts, id, type, is_patch, location)) {
+            else if (!collect_interface_block_members(src, &out, is_array_of_verts, id, type, is_patch, location)) {
                 // A user-defined interface variable, with a location. Where a variable occupied multiple locations, emit
                 // one result for each.
                 unsigned num_locations = get_locations_consumed_by_type(src, type, is_array_of_verts && !is_patch);
@@ -642,24 +652,7 @@ static std::vector<std::pair<uint32_t, interface_var>> collect_interface_by_inpu
 }
 
 static std::vector<std::pair<descriptor_slot_t, interface_var>> collect_interface_by_descriptor_slot(
-    debug_report_data const *report_data, shader_module const *src, std::unordered_set<uint32_t> const &accessible_ids) {
-    std::unordered_map<unsigned, unsigned> var_sets;
-    std::unordered_map<unsigned, unsigned> var_bindings;
-
-    for (auto insn : *src) {
-        // All variables in the Uniform or UniformConstant storage classes are required to be decorated with both
-        // DecorationDescriptorSet and DecorationBinding.
-        if (insn.opcode() == spv::OpDecorate) {
-            if (insn.word(2) == spv::DecorationDescriptorSet) {
-                var_sets[insn.word(1)] = insn.word(3);
-            }
-
-            if (insn.word(2) == spv::DecorationBinding) {
-                var_bindings[insn.word(1)] = insn.word(3);
-            }
-        }
-    }
-
+    shader_module const *src, std::unordered_set<uint32_t> const &accessible_ids) {
     std::vector<std::pair<descriptor_slot_t, interface_var>> out;
 
     for (auto id : accessible_ids) {
@@ -668,8 +661,11 @@ static std::vector<std::pair<descriptor_slot_t, interface_var>> collect_interfac
 
         if (insn.opcode() == spv::OpVariable &&
             (insn.word(3) == spv::StorageClassUniform || insn.word(3) == spv::StorageClassUniformConstant)) {
-            unsigned set = value_or_default(var_sets, insn.word(2), 0);
-            unsigned binding = value_or_default(var_bindings, insn.word(2), 0);
+            // All variables in the Uniform or UniformConstant storage classes are required to be decorated with both
+            // DecorationDescriptorSet and DecorationBinding.
+            auto decorations = src->get_decorations(insn.word(2));
+            unsigned set = decorations.descriptor_set;
+            unsigned binding = decorations.binding;
 
             interface_var v = {};
             v.id = insn.word(2);
@@ -681,6 +677,9 @@ static std::vector<std::pair<descriptor_slot_t, interface_var>> collect_interfac
     return out;
 }
 
+static std::map<location_t, interface_var> const &get_interface_by_location(shader_module const *src, spirv_inst_iter entrypoint,
+                                                                            spv::StorageClass sinterface, bool is_array_of_verts);
+
 static bool validate_vi_consistency(debug_report_data const *report_data, VkPipelineVertexInputStateCreateInfo const *vi) {
     // Walk the binding descriptions, which describe the step rate and stride of each vertex buffer.  Each binding should
     // be specified only once.
@@ -707,7 +706,7 @@ static bool validate_vi_against_vs_inputs(debug_report_data const *report_data,
                                           shader_module const *vs, spirv_inst_iter entrypoint) {
     bool skip = false;
 
-    auto inputs = collect_interface_by_location(vs, entrypoint, spv::StorageClassInput, false);
+    auto const &inputs = get_interface_by_location(vs, entrypoint, spv::StorageClassInput, false);
 
     // Build index by location
     std::map<uint32_t, VkVertexInputAttributeDescription const *> attribs;
@@ -782,7 +781,7 @@ static bool validate_fs_outputs_against_render_pass(debug_report_data const *rep
 
     // TODO: dual source blend index (spv::DecIndex, zero if not provided)
 
-    auto outputs = collect_interface_by_location(fs, entrypoint, spv::StorageClassOutput, false);
+    auto const &outputs = get_interface_by_location(fs, entrypoint, spv::StorageClassOutput, false);
 
     auto it_a = outputs.begin();
     auto it_b = color_attachments.begin();
@@ -946,63 +945,92 @@ static std::unordered_set<uint32_t> mark_accessible_ids(shader_module const *src
     return ids;
 }
 
-static bool validate_push_constant_block_against_pipeline(debug_report_data const *report_data,
-                                                          std::vector<VkPushConstantRange> const *push_constant_ranges,
-                                                          shader_module const *src, spirv_inst_iter type,
-                                                          VkShaderStageFlagBits stage) {
-    bool skip = false;
-
-    // Strip off ptrs etc
-    type = get_struct_type(src, type, false);
-    assert(type != src->end());
-
-    // Validate directly off the offsets. this isn't quite correct for arrays and matrices, but is a good first step.
-    // TODO: arrays, matrices, weird sizes
-    for (auto insn : *src) {
-        if (insn.opcode() == spv::OpMemberDecorate && insn.word(1) == type.word(1)) {
-            if (insn.word(3) == spv::DecorationOffset) {
-                unsigned offset = insn.word(4);
-                auto size = 4;  // Bytes; TODO: calculate this based on the type
-
-                bool found_range = false;
-                for (auto const &range : *push_constant_ranges) {
-                    if (range.offset <= offset && range.offset + range.size >= offset + size) {
-                        found_range = true;
-
-                        if ((range.stageFlags & stage) == 0) {
-                            skip |=
-                                log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0,
-                                        __LINE__, SHADER_CHECKER_PUSH_CONSTANT_NOT_ACCESSIBLE_FROM_STAGE, "SC",
-                                        "Push constant range covering variable starting at offset %u not accessible from stage %s",
-                                        offset, string_VkShaderStageFlagBits(stage));
-                        }
-
-                        break;
-                    }
-                }
+// Offsets of the members of the push constant blocks among accessible_ids
+static std::vector<uint32_t> collect_push_constant_offsets(shader_module const *src,
+                                                           std::unordered_set<uint32_t> const &accessible_ids) {
+    std::vector<uint32_t> offsets;
 
-                if (!found_range) {
-                    skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0,
-                                    __LINE__, SHADER_CHECKER_PUSH_CONSTANT_OUT_OF_RANGE, "SC",
-                                    "Push constant range covering variable starting at offset %u not declared in layout", offset);
+    for (auto id : accessible_ids) {
+        auto def_insn = src->get_def(id);
+        if (def_insn.opcode() == spv::OpVariable && def_insn.word(3) == spv::StorageClassPushConstant) {
+            // Strip off ptrs etc
+            auto type = get_struct_type(src, src->get_def(def_insn.word(1)), false);
+            assert(type != src->end());
+
+            for (auto insn : *src) {
+                if (insn.opcode() == spv::OpMemberDecorate && insn.word(1) == type.word(1) &&
+                    insn.word(3) == spv::DecorationOffset) {
+                    offsets.push_back(insn.word(4));
                 }
             }
         }
     }
 
-    return skip;
+    return offsets;
+}
+
+// Reflection for the given entrypoint, derived from the module the first time a pipeline asks for it. Caller holds
+// src->reflection_lock.
+static entrypoint_reflection &get_entrypoint_reflection_locked(shader_module const *src, spirv_inst_iter entrypoint) {
+    auto &reflection = src->reflection[entrypoint.offset()];
+    if (!reflection) {
+        reflection.reset(new entrypoint_reflection());
+        reflection->accessible_ids = mark_accessible_ids(src, entrypoint);
+        reflection->descriptor_uses = collect_interface_by_descriptor_slot(src, reflection->accessible_ids);
+        reflection->input_attachment_uses = collect_interface_by_input_attachment_index(src, reflection->accessible_ids);
+        reflection->push_constant_offsets = collect_push_constant_offsets(src, reflection->accessible_ids);
+    }
+    return *reflection;
+}
+
+static entrypoint_reflection const &get_entrypoint_reflection(shader_module const *src, spirv_inst_iter entrypoint) {
+    std::lock_guard<std::mutex> lock(src->reflection_lock);
+    return get_entrypoint_reflection_locked(src, entrypoint);
+}
+
+// Interface variables of the given storage class by location, derived on first use like the rest of the reflection
+static std::map<location_t, interface_var> const &get_interface_by_location(shader_module const *src, spirv_inst_iter entrypoint,
+                                                                            spv::StorageClass sinterface, bool is_array_of_verts) {
+    std::lock_guard<std::mutex> lock(src->reflection_lock);
+    auto &interfaces = get_entrypoint_reflection_locked(src, entrypoint).interfaces;
+    const auto key = std::make_pair(static_cast<uint32_t>(sinterface), is_array_of_verts);
+    auto it = interfaces.find(key);
+    if (it == interfaces.end()) {
+        it = interfaces.emplace(key, collect_interface_by_location(src, entrypoint, sinterface, is_array_of_verts)).first;
+    }
+    return it->second;
 }
 
 static bool validate_push_constant_usage(debug_report_data const *report_data,
-                                         std::vector<VkPushConstantRange> const *push_constant_ranges, shader_module const *src,
-                                         std::unordered_set<uint32_t> accessible_ids, VkShaderStageFlagBits stage) {
+                                         std::vector<VkPushConstantRange> const *push_constant_ranges,
+                                         std::vector<uint32_t> const &push_constant_offsets, VkShaderStageFlagBits stage) {
     bool skip = false;
 
-    for (auto id : accessible_ids) {
-        auto def_insn = src->get_def(id);
-        if (def_insn.opcode() == spv::OpVariable && def_insn.word(3) == spv::StorageClassPushConstant) {
-            skip |= validate_push_constant_block_against_pipeline(report_data, push_constant_ranges, src,
-                                                                  src->get_def(def_insn.word(1)), stage);
+    // Validate directly off the offsets. this isn't quite correct for arrays and matrices, but is a good first step.
+    // TODO: arrays, matrices, weird sizes
+    for (auto offset : push_constant_offsets) {
+        auto size = 4;  // Bytes; TODO: calculate this based on the type
+
+        bool found_range = false;
+        for (auto const &range : *push_constant_ranges) {
+            if (range.offset <= offset && range.offset + range.size >= offset + size) {
+                found_range = true;
+
+                if ((range.stageFlags & stage) == 0) {
+                    skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0, __LINE__,
+                                    SHADER_CHECKER_PUSH_CONSTANT_NOT_ACCESSIBLE_FROM_STAGE, "SC",
+                                    "Push constant range covering variable starting at offset %u not accessible from stage %s",
+                                    offset, string_VkShaderStageFlagBits(stage));
+                }
+
+                break;
+            }
+        }
+
+        if (!found_range) {
+            skip |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0, __LINE__,
+                            SHADER_CHECKER_PUSH_CONSTANT_OUT_OF_RANGE, "SC",
+                            "Push constant range covering variable starting at offset %u not declared in layout", offset);
         }
     }
 
@@ -1051,16 +1079,13 @@ static bool descriptor_type_match(shader_module const *module, uint32_t type_id,
 
     switch (type.opcode()) {
         case spv::OpTypeStruct: {
-            for (auto insn : *module) {
-                if (insn.opcode() == spv::OpDecorate && insn.word(1) == type.word(1)) {
-                    if (insn.word(2) == spv::DecorationBlock) {
-                        return descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
-                               descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
-                    } else if (insn.word(2) == spv::DecorationBufferBlock) {
-                        return descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
-                               descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
-                    }
-                }
+            auto decorations = module->get_decorations(type.word(1));
+            if (decorations.flags & decoration_set::block_bit) {
+                return descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER ||
+                       descriptor_type == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            } else if (decorations.flags & decoration_set::buffer_block_bit) {
+                return descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER ||
+                       descriptor_type == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
             }
 
             // Invalid
@@ -1133,10 +1158,9 @@ static bool require_extension(debug_report_data const *report_data, bool extensi
     return false;
 }
 
-static bool validate_shader_capabilities(layer_data *dev_data, shader_module const *src) {
+static bool validate_shader_capabilities(layer_data *dev_data, debug_report_data const *report_data, shader_module const *src) {
     bool skip = false;
 
-    auto report_data = GetReportData(dev_data);
     auto const &enabledFeatures = GetEnabledFeatures(dev_data);
     auto const &extensions = GetEnabledExtensions(dev_data);
 
@@ -1202,11 +1226,11 @@ static bool validate_shader_capabilities(layer_data *dev_data, shader_module con
     };
     // clang-format on
 
-    for (auto insn : *src) {
-        if (insn.opcode() == spv::OpCapability) {
-            size_t n = capabilities.count(insn.word(1));
+    for (auto capability : src->capabilities) {
+        {
+            size_t n = capabilities.count(capability);
             if (1 == n) {  // key occurs exactly once
-                auto it = capabilities.find(insn.word(1));
+                auto it = capabilities.find(capability);
                 if (it != capabilities.end()) {
                     if (it->second.feature) {
                         skip |= require_feature(report_data, enabledFeatures->*(it->second.feature), it->second.name);
@@ -1220,7 +1244,7 @@ static bool validate_shader_capabilities(layer_data *dev_data, shader_module con
                 bool needs_ext = false, has_ext = false;
                 std::string feature_names = "(one of) [ ";
                 std::string extension_names = feature_names;
-                auto caps = capabilities.equal_range(insn.word(1));
+                auto caps = capabilities.equal_range(capability);
                 for (auto it = caps.first; it != caps.second; ++it) {
                     if (it->second.feature) {
                         needs_feature = true;
@@ -1300,14 +1324,15 @@ static VkDescriptorSetLayoutBinding const *get_descriptor_binding(PIPELINE_LAYOU
     return pipelineLayout->set_layouts[slot.first]->GetDescriptorSetLayoutBindingPtrFromBinding(slot.second);
 }
 
-static bool validate_pipeline_shader_stage(layer_data *dev_data, VkPipelineShaderStageCreateInfo const *pStage,
-                                           PIPELINE_STATE *pipeline, shader_module const **out_module,
-                                           spirv_inst_iter *out_entrypoint) {
+static bool validate_pipeline_shader_stage(layer_data *dev_data, debug_report_data const *report_data,
+                                           VkPipelineShaderStageCreateInfo const *pStage, PIPELINE_STATE *pipeline,
+                                           shader_module const **out_module, spirv_inst_iter *out_entrypoint) {
     bool skip = false;
     auto module = *out_module = GetShaderModuleState(dev_data, pStage->module);
-    auto report_data = GetReportData(dev_data);
 
-    if (!module->has_valid_spirv) return false;
+    // A module still being validated in the background has nothing to check against until that finishes
+    skip |= module->wait_for_validation(report_data);
+    if (!module->has_valid_spirv) return skip;
 
     // Find the entrypoint
     auto entrypoint = *out_entrypoint = find_entrypoint(module, pStage->pName, pStage->stage);
@@ -1320,20 +1345,17 @@ static bool validate_pipeline_shader_stage(layer_data *dev_data, VkPipelineShade
     }
 
     // Validate shader capabilities against enabled device features
-    skip |= validate_shader_capabilities(dev_data, module);
+    skip |= validate_shader_capabilities(dev_data, report_data, module);
 
-    // Mark accessible ids
-    auto accessible_ids = mark_accessible_ids(module, entrypoint);
-
-    // Validate descriptor set layout against what the entrypoint actually uses
-    auto descriptor_uses = collect_interface_by_descriptor_slot(report_data, module, accessible_ids);
+    // Accessible ids, and what the entrypoint uses through them, are worked out once per module
+    auto const &reflection = get_entrypoint_reflection(module, entrypoint);
 
     skip |= validate_specialization_offsets(report_data, pStage);
-    skip |= validate_push_constant_usage(report_data, &pipeline->pipeline_layout.push_constant_ranges, module, accessible_ids,
-                                         pStage->stage);
+    skip |= validate_push_constant_usage(report_data, &pipeline->pipeline_layout.push_constant_ranges,
+                                         reflection.push_constant_offsets, pStage->stage);
 
-    // Validate descriptor use
-    for (auto use : descriptor_uses) {
+    // Validate descriptor set layout against what the entrypoint actually uses
+    for (auto const &use : reflection.descriptor_uses) {
         // While validating shaders capture which slots are used by the pipeline
         auto &reqs = pipeline->active_slots[use.first.first][use.first.second];
         reqs = descriptor_req(reqs | descriptor_type_to_reqs(module, use.second.type_id));
@@ -1370,12 +1392,10 @@ static bool validate_pipeline_shader_stage(layer_data *dev_data, VkPipelineShade
 
     // Validate use of input attachments against subpass structure
     if (pStage->stage == VK_SHADER_STAGE_FRAGMENT_BIT) {
-        auto input_attachment_uses = collect_interface_by_input_attachment_index(module, accessible_ids);
-
         auto rpci = pipeline->rp_state->createInfo.ptr();
         auto subpass = pipeline->graphicsPipelineCI.subpass;
 
-        for (auto use : input_attachment_uses) {
+        for (auto const &use : reflection.input_attachment_uses) {
             auto input_attachments = rpci->pSubpasses[subpass].pInputAttachments;
             auto index = (input_attachments && use.first < rpci->pSubpasses[subpass].inputAttachmentCount)
                              ? input_attachments[use.first].attachment
@@ -1404,10 +1424,10 @@ static bool validate_interface_between_stages(debug_report_data const *report_da
                                               shader_stage_attributes const *consumer_stage) {
     bool skip = false;
 
-    auto outputs =
-        collect_interface_by_location(producer, producer_entrypoint, spv::StorageClassOutput, producer_stage->arrayed_output);
-    auto inputs =
-        collect_interface_by_location(consumer, consumer_entrypoint, spv::StorageClassInput, consumer_stage->arrayed_input);
+    auto const &outputs =
+        get_interface_by_location(producer, producer_entrypoint, spv::StorageClassOutput, producer_stage->arrayed_output);
+    auto const &inputs =
+        get_interface_by_location(consumer, consumer_entrypoint, spv::StorageClassInput, consumer_stage->arrayed_input);
 
     auto a_it = outputs.begin();
     auto b_it = inputs.begin();
@@ -1466,11 +1486,11 @@ static bool validate_interface_between_stages(debug_report_data const *report_da
 
 // Validate that the shaders used by the given pipeline and store the active_slots
 //  that are actually used by the pipeline into pPipeline->active_slots
-bool validate_and_capture_pipeline_shader_state(layer_data *dev_data, PIPELINE_STATE *pipeline) {
+bool validate_and_capture_pipeline_shader_state(layer_data *dev_data, debug_report_data const *report_data,
+                                                 PIPELINE_STATE *pipeline) {
     auto pCreateInfo = pipeline->graphicsPipelineCI.ptr();
     int vertex_stage = get_shader_stage_id(VK_SHADER_STAGE_VERTEX_BIT);
     int fragment_stage = get_shader_stage_id(VK_SHADER_STAGE_FRAGMENT_BIT);
-    auto report_data = GetReportData(dev_data);
 
     shader_module const *shaders[5];
     memset(shaders, 0, sizeof(shaders));
@@ -1481,7 +1501,8 @@ bool validate_and_capture_pipeline_shader_state(layer_data *dev_data, PIPELINE_S
     for (uint32_t i = 0; i < pCreateInfo->stageCount; i++) {
         auto pStage = &pCreateInfo->pStages[i];
         auto stage_id = get_shader_stage_id(pStage->stage);
-        skip |= validate_pipeline_shader_stage(dev_data, pStage, pipeline, &shaders[stage_id], &entrypoints[stage_id]);
+        skip |=
+            validate_pipeline_shader_stage(dev_data, report_data, pStage, pipeline, &shaders[stage_id], &entrypoints[stage_id]);
     }
 
     // if the shader stages are no good individually, cross-stage validation is pointless.
@@ -1526,16 +1547,152 @@ bool validate_and_capture_pipeline_shader_state(layer_data *dev_data, PIPELINE_S
     return skip;
 }
 
-bool validate_compute_pipeline(layer_data *dev_data, PIPELINE_STATE *pipeline) {
+bool validate_compute_pipeline(layer_data *dev_data, debug_report_data const *report_data, PIPELINE_STATE *pipeline) {
     auto pCreateInfo = pipeline->computePipelineCI.ptr();
 
     shader_module const *module;
     spirv_inst_iter entrypoint;
 
-    return validate_pipeline_shader_stage(dev_data, &pCreateInfo->stage, pipeline, &module, &entrypoint);
+    return validate_pipeline_shader_stage(dev_data, report_data, &pCreateInfo->stage, pipeline, &module, &entrypoint);
+}
+
+shader_hash ValidationCache::MakeShaderHash(VkShaderModuleCreateInfo const *smci) {
+    // The xxhash shipped here predates XXH128; two XXH64 over the code with different seeds make up the width
+    shader_hash hash;
+    hash.lo = XXH64(smci->pCode, smci->codeSize, 0);
+    hash.hi = XXH64(smci->pCode, smci->codeSize, 0x9e3779b97f4a7c15ull);
+    return hash;
+}
+
+void ValidationCache::Load(void const *pInitialData, size_t initialDataSize) {
+    if (!pInitialData || initialDataSize < header_size + format_header_size) return;
+
+    uint32_t const *data = (uint32_t const *)pInitialData;
+    if (data[0] != header_size) return;
+    if (data[1] != VK_VALIDATION_CACHE_HEADER_VERSION_ONE_EXT) return;
+    uint8_t expected_uuid[VK_UUID_SIZE];
+    Sha1ToVkUuid(SPIRV_TOOLS_COMMIT_ID, expected_uuid);
+    if (memcmp(&data[2], expected_uuid, VK_UUID_SIZE) != 0) return;  // different version
+
+    data = (uint32_t const *)(reinterpret_cast<uint8_t const *>(data) + header_size);
+    if (data[0] != FORMAT_VERSION) return;
+    // Take no more hashes than the data has room for, so a cache cut short still gives the ones before the cut
+    size_t count = std::min<size_t>(data[1], (initialDataSize - header_size - format_header_size) / sizeof(shader_hash));
+
+    std::vector<shader_hash> hashes(count);
+    memcpy(hashes.data(), data + 2, count * sizeof(shader_hash));
+    // Lookups binary search the array, so its order can't be taken on trust
+    if (std::adjacent_find(hashes.begin(), hashes.end(),
+                           [](shader_hash const &a, shader_hash const &b) { return !(a < b); }) != hashes.end()) {
+        std::sort(hashes.begin(), hashes.end());
+        hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+    }
+
+    std::lock_guard<std::mutex> guard(lock);
+    sorted_hashes.swap(hashes);
+    for (auto it = added_hashes.begin(); it != added_hashes.end();) {
+        it = std::binary_search(sorted_hashes.begin(), sorted_hashes.end(), *it) ? added_hashes.erase(it) : std::next(it);
+    }
+}
+
+std::vector<shader_hash> ValidationCache::SortedHashes() const {
+    std::vector<shader_hash> added(added_hashes.begin(), added_hashes.end());
+    std::sort(added.begin(), added.end());
+    std::vector<shader_hash> hashes;
+    hashes.reserve(sorted_hashes.size() + added.size());
+    std::merge(sorted_hashes.begin(), sorted_hashes.end(), added.begin(), added.end(), std::back_inserter(hashes));
+    return hashes;
+}
+
+void ValidationCache::Write(size_t *pDataSize, void *pData) {
+    std::lock_guard<std::mutex> guard(lock);
+    if (!pData) {
+        *pDataSize = header_size + format_header_size + (sorted_hashes.size() + added_hashes.size()) * sizeof(shader_hash);
+        return;
+    }
+
+    if (*pDataSize < header_size + format_header_size) {
+        *pDataSize = 0;
+        return;  // Too small for even the header!
+    }
+
+    auto hashes = SortedHashes();
+    size_t count = std::min(hashes.size(), (*pDataSize - header_size - format_header_size) / sizeof(shader_hash));
+
+    uint32_t *out = (uint32_t *)pData;
+
+    // Write the header
+    *out++ = header_size;
+    *out++ = VK_VALIDATION_CACHE_HEADER_VERSION_ONE_EXT;
+    Sha1ToVkUuid(SPIRV_TOOLS_COMMIT_ID, reinterpret_cast<uint8_t *>(out));
+    out = (uint32_t *)(reinterpret_cast<uint8_t *>(out) + VK_UUID_SIZE);
+
+    *out++ = FORMAT_VERSION;
+    *out++ = static_cast<uint32_t>(count);
+    memcpy(out, hashes.data(), count * sizeof(shader_hash));
+
+    *pDataSize = header_size + format_header_size + count * sizeof(shader_hash);
+}
+
+void ValidationCache::Merge(ValidationCache const *other) {
+    if (other == this) return;
+    std::unique_lock<std::mutex> guard(lock, std::defer_lock), other_guard(other->lock, std::defer_lock);
+    std::lock(guard, other_guard);
+
+    auto hashes = SortedHashes();
+    auto other_hashes = other->SortedHashes();
+    std::vector<shader_hash> merged;
+    merged.reserve(hashes.size() + other_hashes.size());
+    std::set_union(hashes.begin(), hashes.end(), other_hashes.begin(), other_hashes.end(), std::back_inserter(merged));
+    sorted_hashes.swap(merged);
+    added_hashes.clear();
+}
+
+ValidationCache *ValidationCache::LoadFile(char const *path) {
+    auto cache = new ValidationCache();
+    FILE *file = fopen(path, "rb");
+    if (!file) return cache;
+
+    std::vector<uint8_t> data;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        long size = ftell(file);
+        if (size > 0 && fseek(file, 0, SEEK_SET) == 0) {
+            data.resize(static_cast<size_t>(size));
+            data.resize(fread(data.data(), 1, data.size(), file));
+        }
+    }
+    fclose(file);
+
+    cache->Load(data.data(), data.size());
+    return cache;
 }
 
-uint32_t ValidationCache::MakeShaderHash(VkShaderModuleCreateInfo const *smci) { return XXH32(smci->pCode, smci->codeSize, 0); }
+bool ValidationCache::StoreFile(char const *path) {
+    // Another process using the same file may have added to it since this one loaded it; keep its hashes too
+    std::unique_ptr<ValidationCache> on_disk(LoadFile(path));
+    Merge(on_disk.get());
+
+    size_t size = 0;
+    Write(&size, nullptr);
+    std::vector<uint8_t> data(size);
+    Write(&size, data.data());
+
+    // Write a file of our own and move it over the old one, so readers only ever see a whole cache
+    std::string temp_path = std::string(path) + "." + std::to_string(std::random_device()()) + ".tmp";
+    FILE *file = fopen(temp_path.c_str(), "wb");
+    if (!file) return false;
+    bool written = fwrite(data.data(), 1, size, file) == size;
+    written &= fclose(file) == 0;
+#ifdef _WIN32
+    // rename won't replace an existing file here
+    if (written) remove(path);
+#endif
+    if (!written || rename(temp_path.c_str(), path) != 0) {
+        remove(temp_path.c_str());
+        return false;
+    }
+    return true;
+}
 
 static ValidationCache *GetValidationCacheInfo(VkShaderModuleCreateInfo const *pCreateInfo) {
     while ((pCreateInfo = (VkShaderModuleCreateInfo const *)pCreateInfo->pNext) != nullptr) {
@@ -1546,10 +1703,33 @@ static ValidationCache *GetValidationCacheInfo(VkShaderModuleCreateInfo const *p
     return nullptr;
 }
 
-bool PreCallValidateCreateShaderModule(layer_data *dev_data, VkShaderModuleCreateInfo const *pCreateInfo, bool *spirv_valid) {
+// Run spirv-val over the code, reporting what it finds to report_data
+static bool validate_spirv(debug_report_data const *report_data, spv_const_context ctx, uint32_t const *code, size_t code_size,
+                           bool have_glsl_shader, bool *spirv_valid) {
+    bool skip = false;
+    spv_const_binary_t binary{code, code_size / sizeof(uint32_t)};
+    spv_diagnostic diag = nullptr;
+
+    spv_result_t spv_valid = spvValidate(ctx, &binary, &diag);
+    if (spv_valid != SPV_SUCCESS) {
+        if (!have_glsl_shader || (code[0] == spv::MagicNumber)) {
+            skip |= log_msg(report_data, spv_valid == SPV_WARNING ? VK_DEBUG_REPORT_WARNING_BIT_EXT : VK_DEBUG_REPORT_ERROR_BIT_EXT,
+                            VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0, __LINE__, SHADER_CHECKER_INCONSISTENT_SPIRV, "SC",
+                            "SPIR-V module not valid: %s", diag && diag->error ? diag->error : "(no error text)");
+        }
+    }
+
+    spvDiagnosticDestroy(diag);
+    *spirv_valid = (spv_valid == SPV_SUCCESS);
+    return skip;
+}
+
+bool PreCallValidateCreateShaderModule(layer_data *dev_data, VkShaderModuleCreateInfo const *pCreateInfo, bool *spirv_valid,
+                                       bool *spirv_deferred) {
     bool skip = false;
-    spv_result_t spv_valid = SPV_SUCCESS;
     auto report_data = GetReportData(dev_data);
+    *spirv_valid = true;
+    *spirv_deferred = false;
 
     if (GetDisables(dev_data)->shader_validation) {
         return false;
@@ -1564,35 +1744,82 @@ bool PreCallValidateCreateShaderModule(layer_data *dev_data, VkShaderModuleCreat
                         pCreateInfo->codeSize, validation_error_map[VALIDATION_ERROR_12a00ac0]);
     } else {
         auto cache = GetValidationCacheInfo(pCreateInfo);
-        uint32_t hash = 0;
-        if (cache) {
+        auto implicit_cache = GetImplicitValidationCache(dev_data);
+        shader_hash hash = {};
+        if (cache || implicit_cache) {
             hash = ValidationCache::MakeShaderHash(pCreateInfo);
-            if (cache->Contains(hash)) return false;
+            if ((cache && cache->Contains(hash)) || (implicit_cache && implicit_cache->Contains(hash))) {
+                // A module that passed once is good for either cache
+                if (cache) cache->Insert(hash);
+                if (implicit_cache) implicit_cache->Insert(hash);
+                return false;
+            }
         }
 
-        // Use SPIRV-Tools validator to try and catch any issues with the module itself
-        spv_context ctx = spvContextCreate(SPV_ENV_VULKAN_1_0);
-        spv_const_binary_t binary{pCreateInfo->pCode, pCreateInfo->codeSize / sizeof(uint32_t)};
-        spv_diagnostic diag = nullptr;
+        auto validator = GetSpirvValidator(dev_data);
+        if (validator->background && !(pCreateInfo->codeSize % 4)) {
+            // Leave spirv-val to PostCallRecordCreateShaderModule's background task
+            *spirv_deferred = true;
+            return false;
+        }
 
-        spv_valid = spvValidate(ctx, &binary, &diag);
-        if (spv_valid != SPV_SUCCESS) {
-            if (!have_glsl_shader || (pCreateInfo->pCode[0] == spv::MagicNumber)) {
-                skip |=
-                    log_msg(report_data, spv_valid == SPV_WARNING ? VK_DEBUG_REPORT_WARNING_BIT_EXT : VK_DEBUG_REPORT_ERROR_BIT_EXT,
-                            VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0, __LINE__, SHADER_CHECKER_INCONSISTENT_SPIRV, "SC",
-                            "SPIR-V module not valid: %s", diag && diag->error ? diag->error : "(no error text)");
-            }
-        } else {
+        // Use SPIRV-Tools validator to try and catch any issues with the module itself
+        skip |= validate_spirv(report_data, validator->context, pCreateInfo->pCode, pCreateInfo->codeSize, have_glsl_shader,
+                               spirv_valid);
+        if (*spirv_valid) {
             if (cache) {
                 cache->Insert(hash);
             }
+            if (implicit_cache) {
+                implicit_cache->Insert(hash);
+            }
         }
-
-        spvDiagnosticDestroy(diag);
-        spvContextDestroy(ctx);
     }
 
-    *spirv_valid = (spv_valid == SPV_SUCCESS);
     return skip;
 }
+
+std::unique_ptr<shader_module> PostCallRecordCreateShaderModule(layer_data *dev_data, VkShaderModuleCreateInfo const *pCreateInfo,
+                                                                bool spirv_valid, bool spirv_deferred) {
+    if (!spirv_valid) return std::unique_ptr<shader_module>(new shader_module());
+    if (!spirv_deferred) return std::unique_ptr<shader_module>(new shader_module(pCreateInfo));
+
+    // Messages are captured in the background and reported by the first pipeline to use the module. The application's
+    // own validation cache may be gone by the time spirv-val finishes, so only the implicit cache learns the result.
+    std::unique_ptr<shader_module> module(new shader_module(
+        pCreateInfo, std::unique_ptr<deferred_spirv_validation>(new deferred_spirv_validation(GetReportData(dev_data)))));
+    auto validator = GetSpirvValidator(dev_data);
+    auto implicit_cache = GetImplicitValidationCache(dev_data);
+    auto have_glsl_shader = GetEnabledExtensions(dev_data)->vk_nv_glsl_shader;
+    shader_module *state = module.get();
+    validator->background->push([state, validator, implicit_cache, have_glsl_shader]() {
+        auto deferred = state->deferred.get();
+        bool spirv_valid = false;
+        validate_spirv(deferred->capture->report_data(), validator->context, state->words.data(),
+                       state->words.size() * sizeof(uint32_t), have_glsl_shader, &spirv_valid);
+        if (spirv_valid) {
+            state->build_def_index();
+            if (implicit_cache) {
+                VkShaderModuleCreateInfo code = {};
+                code.codeSize = state->words.size() * sizeof(uint32_t);
+                code.pCode = state->words.data();
+                implicit_cache->Insert(ValidationCache::MakeShaderHash(&code));
+            }
+        }
+        state->has_valid_spirv = spirv_valid;
+
+        std::lock_guard<std::mutex> lock(deferred->lock);
+        deferred->done = true;
+        deferred->done_cv.notify_all();
+    });
+    return module;
+}
+
+bool shader_module::wait_for_validation(debug_report_data const *report_data) const {
+    if (!deferred) return false;
+    std::unique_lock<std::mutex> lock(deferred->lock);
+    deferred->done_cv.wait(lock, [this]() { return deferred->done; });
+    if (!report_data || !deferred->capture) return false;
+    std::unique_ptr<debug_report_capture> capture(std::move(deferred->capture));
+    return capture->replay(report_data);
+}
@@ -21,6 +21,13 @@
 #define VULKAN_SHADER_VALIDATION_H
 
 #include <spirv_tools_commit_id.h>
+#include <algorithm>
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include "spirv-tools/libspirv.h"
+#include "vk_layer_thread_pool.h"
 
 // A forward iterator over spirv instructions. Provides easy access to len, opcode, and content words
 // without the caller needing to care too much about the physical SPIRV module layout.
@@ -67,23 +74,111 @@ struct spirv_inst_iter {
     spirv_inst_iter const &operator*() const { return *this; }
 };
 
+typedef std::pair<unsigned, unsigned> location_t;
+typedef std::pair<unsigned, unsigned> descriptor_slot_t;
+
+struct interface_var {
+    uint32_t id;
+    uint32_t type_id;
+    uint32_t offset;
+    bool is_patch;
+    bool is_block_member;
+    bool is_relaxed_precision;
+    // TODO: collect the name, too? Isn't required to be present.
+};
+
+// What pipeline validation needs to know about one entrypoint of a module. It depends only on the SPIR-V, so it is
+// derived the first time a pipeline uses the entrypoint and then shared by every later pipeline that uses it.
+struct entrypoint_reflection {
+    // All ids referenced by the static call tree of the entrypoint
+    std::unordered_set<uint32_t> accessible_ids;
+    // Resource variables used by the entrypoint
+    std::vector<std::pair<descriptor_slot_t, interface_var>> descriptor_uses;
+    // Input attachments used by the entrypoint; only consulted for fragment entrypoints
+    std::vector<std::pair<uint32_t, interface_var>> input_attachment_uses;
+    // Offsets of the members of the push constant blocks used by the entrypoint
+    std::vector<uint32_t> push_constant_offsets;
+    // Interface variables by location, for each storage class and arrayedness they have been asked for with
+    std::map<std::pair<uint32_t, bool>, std::map<location_t, interface_var>> interfaces;
+};
+
+// The OpDecorate decorations of one id that shader validation looks at, decoded once when the module is created
+struct decoration_set {
+    enum {
+        location_bit = 1 << 0,
+        patch_bit = 1 << 1,
+        relaxed_precision_bit = 1 << 2,
+        block_bit = 1 << 3,
+        buffer_block_bit = 1 << 4,
+        component_bit = 1 << 5,
+        descriptor_set_bit = 1 << 6,
+        binding_bit = 1 << 7,
+        builtin_bit = 1 << 8,
+    };
+    uint32_t flags = 0;
+    uint32_t location = static_cast<uint32_t>(-1);
+    uint32_t component = 0;
+    uint32_t descriptor_set = 0;
+    uint32_t binding = 0;
+    uint32_t builtin = static_cast<uint32_t>(-1);
+
+    void add(uint32_t decoration, uint32_t value);
+};
+
+// spirv-val of a shader module running in the background; see async_shader_module_validation
+struct deferred_spirv_validation {
+    explicit deferred_spirv_validation(debug_report_data const *report_data) : capture(new debug_report_capture(report_data)) {}
+
+    std::mutex lock;
+    std::condition_variable done_cv;
+    bool done = false;
+    // What spirv-val reported, held until the first pipeline to use the module reports it
+    std::unique_ptr<debug_report_capture> capture;
+};
+
 struct shader_module {
     // The spirv image itself
     std::vector<uint32_t> words;
-    // A mapping of <id> to the first word of its def. this is useful because walking type
-    // trees, constant expressions, etc requires jumping all over the instruction stream.
-    std::unordered_map<unsigned, unsigned> def_index;
+    // A mapping of <id> to the first word of its def, indexed by id, with 0 for ids that have none. this is useful
+    // because walking type trees, constant expressions, etc requires jumping all over the instruction stream. SPIR-V
+    // keeps every id below the header's bound, so this is sized by that.
+    std::vector<uint32_t> def_index;
+    // The same mapping as (id, offset) pairs sorted by id, for ids def_index doesn't cover. That is all of them when the
+    // bound is out of proportion to the size of the module.
+    std::vector<std::pair<uint32_t, uint32_t>> sparse_def_index;
+    // Decorations of each decorated id
+    std::unordered_map<uint32_t, decoration_set> decorations;
+    // Capabilities declared by the module, gathered along with def_index
+    std::vector<uint32_t> capabilities;
     bool has_valid_spirv;
+    // Reflection for each entrypoint that a pipeline has used so far, by the entrypoint's offset. Pipelines can be
+    // validated concurrently, so entries are added under reflection_lock; once added they never change or move.
+    mutable std::mutex reflection_lock;
+    mutable std::unordered_map<uint32_t, std::unique_ptr<entrypoint_reflection>> reflection;
+    // Set while spirv-val runs on the module in the background. Until it finishes, has_valid_spirv, def_index and the
+    // rest of what is derived from the code are not yet filled in; wait_for_validation() waits for them.
+    std::unique_ptr<deferred_spirv_validation> deferred;
 
     shader_module(VkShaderModuleCreateInfo const *pCreateInfo)
         : words((uint32_t *)pCreateInfo->pCode, (uint32_t *)pCreateInfo->pCode + pCreateInfo->codeSize / sizeof(uint32_t)),
-          def_index(),
           has_valid_spirv(true) {
         build_def_index();
     }
 
+    // Takes the code, but leaves deciding whether it is valid, and indexing it, to background validation
+    shader_module(VkShaderModuleCreateInfo const *pCreateInfo, std::unique_ptr<deferred_spirv_validation> &&deferred_validation)
+        : words((uint32_t *)pCreateInfo->pCode, (uint32_t *)pCreateInfo->pCode + pCreateInfo->codeSize / sizeof(uint32_t)),
+          has_valid_spirv(false),
+          deferred(std::move(deferred_validation)) {}
+
     shader_module() : has_valid_spirv(false) {}
 
+    ~shader_module() { wait_for_validation(nullptr); }
+
+    // Wait for any background validation of the module to finish, then report what it found to report_data if nobody
+    // has yet. Returns true if a callback asks to bail.
+    bool wait_for_validation(debug_report_data const *report_data) const;
+
     // Expose begin() / end() to enable range-based for
     spirv_inst_iter begin() const { return spirv_inst_iter(words.begin(), words.begin() + 5); }  // First insn
     spirv_inst_iter end() const { return spirv_inst_iter(words.begin(), words.end()); }          // Just past last insn
@@ -92,91 +187,109 @@ struct shader_module {
 
     // Gets an iterator to the definition of an id
     spirv_inst_iter get_def(unsigned id) const {
-        auto it = def_index.find(id);
-        if (it == def_index.end()) {
+        if (id < def_index.size()) {
+            return def_index[id] ? at(def_index[id]) : end();
+        }
+        auto it = std::lower_bound(sparse_def_index.begin(), sparse_def_index.end(), std::make_pair(id, 0u));
+        if (it == sparse_def_index.end() || it->first != id) {
             return end();
         }
         return at(it->second);
     }
 
+    // Gets the decorations of an id; an undecorated id gets the defaults
+    decoration_set get_decorations(unsigned id) const {
+        auto it = decorations.find(id);
+        return it == decorations.end() ? decoration_set() : it->second;
+    }
+
     void build_def_index();
 };
 
+// 128 bits of hash over a shader module's code. At 32 bits, a library of a few hundred thousand modules would make it
+// likely that some invalid module shares the hash of a valid one and so skips validation.
+struct shader_hash {
+    uint64_t lo;
+    uint64_t hi;
+
+    bool operator==(shader_hash const &rhs) const { return lo == rhs.lo && hi == rhs.hi; }
+    bool operator<(shader_hash const &rhs) const { return hi < rhs.hi || (hi == rhs.hi && lo < rhs.lo); }
+};
+
+namespace std {
+template <>
+struct hash<shader_hash> {
+    size_t operator()(shader_hash const &h) const { return static_cast<size_t>(h.lo); }
+};
+}  // namespace std
+
 class ValidationCache {
     // hashes of shaders that have passed validation before, and can be skipped.
     // we don't store negative results, as we would have to also store what was
     // wrong with them; also, we expect they will get fixed, so we're less
     // likely to see them again.
-    std::unordered_set<uint32_t> good_shader_hashes;
+    //
+    // Hashes loaded from serialized data are kept as the sorted array they were stored as and binary searched, so
+    // loading a cache is a copy rather than a set insertion per entry. Hashes added since go in added_hashes.
+    std::vector<shader_hash> sorted_hashes;
+    std::unordered_set<shader_hash> added_hashes;
+    // Shader modules can be created from several threads at once, against the same cache
+    mutable std::mutex lock;
     ValidationCache() {}
 
+    // Layout of the data following the VK_VALIDATION_CACHE_HEADER_VERSION_ONE_EXT header:
+    //   uint32_t format version, currently FORMAT_VERSION
+    //   uint32_t hash count
+    //   shader_hash hashes[hash count], sorted and without duplicates
+    // Data written with a different format version, such as the plain array of 32 bit hashes that preceded this one, is
+    // treated as empty.
+    enum { FORMAT_VERSION = 2 };
+
    public:
     static VkValidationCacheEXT Create(VkValidationCacheCreateInfoEXT const *pCreateInfo) {
         auto cache = new ValidationCache();
-        cache->Load(pCreateInfo);
+        cache->Load(pCreateInfo->pInitialData, pCreateInfo->initialDataSize);
         return VkValidationCacheEXT(cache);
     }
 
-    void Load(VkValidationCacheCreateInfoEXT const *pCreateInfo) {
-        const auto headerSize = 2 * sizeof(uint32_t) + VK_UUID_SIZE;
-        auto size = headerSize;
-        if (!pCreateInfo->pInitialData || pCreateInfo->initialDataSize < size) return;
+    // The layer's own cache, kept in a file rather than by the application; see the validation_cache_file setting.
+    // A missing or stale file gives an empty cache.
+    static ValidationCache *LoadFile(char const *path);
+    // Write the cache back to its file, merged with whatever other processes have written to it since it was loaded
+    bool StoreFile(char const *path);
 
-        uint32_t const *data = (uint32_t const *)pCreateInfo->pInitialData;
-        if (data[0] != size) return;
-        if (data[1] != VK_VALIDATION_CACHE_HEADER_VERSION_ONE_EXT) return;
-        uint8_t expected_uuid[VK_UUID_SIZE];
-        Sha1ToVkUuid(SPIRV_TOOLS_COMMIT_ID, expected_uuid);
-        if (memcmp(&data[2], expected_uuid, VK_UUID_SIZE) != 0) return;  // different version
+    void Load(void const *pInitialData, size_t initialDataSize);
 
-        data = (uint32_t const *)(reinterpret_cast<uint8_t const *>(data) + headerSize);
+    void Write(size_t *pDataSize, void *pData);
 
-        for (; size < pCreateInfo->initialDataSize; data++, size += sizeof(uint32_t)) {
-            good_shader_hashes.insert(*data);
-        }
-    }
+    void Merge(ValidationCache const *other);
 
-    void Write(size_t *pDataSize, void *pData) {
-        const auto headerSize = 2 * sizeof(uint32_t) + VK_UUID_SIZE;  // 4 bytes for header size + 4 bytes for version number + UUID
-        if (!pData) {
-            *pDataSize = headerSize + good_shader_hashes.size() * sizeof(uint32_t);
-            return;
-        }
+    static shader_hash MakeShaderHash(VkShaderModuleCreateInfo const *smci);
 
-        if (*pDataSize < headerSize) {
-            *pDataSize = 0;
-            return;  // Too small for even the header!
-        }
-
-        uint32_t *out = (uint32_t *)pData;
-        size_t actualSize = headerSize;
-
-        // Write the header
-        *out++ = headerSize;
-        *out++ = VK_VALIDATION_CACHE_HEADER_VERSION_ONE_EXT;
-        Sha1ToVkUuid(SPIRV_TOOLS_COMMIT_ID, reinterpret_cast<uint8_t *>(out));
-        out = (uint32_t *)(reinterpret_cast<uint8_t *>(out) + VK_UUID_SIZE);
-
-        for (auto it = good_shader_hashes.begin(); it != good_shader_hashes.end() && actualSize < *pDataSize;
-             it++, out++, actualSize += sizeof(uint32_t)) {
-            *out = *it;
-        }
-
-        *pDataSize = actualSize;
+    bool Contains(shader_hash hash) {
+        std::lock_guard<std::mutex> guard(lock);
+        return std::binary_search(sorted_hashes.begin(), sorted_hashes.end(), hash) || added_hashes.count(hash) != 0;
     }
 
-    void Merge(ValidationCache const *other) {
-        good_shader_hashes.reserve(good_shader_hashes.size() + other->good_shader_hashes.size());
-        for (auto h : other->good_shader_hashes) good_shader_hashes.insert(h);
+    void Insert(shader_hash hash) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!std::binary_search(sorted_hashes.begin(), sorted_hashes.end(), hash)) added_hashes.insert(hash);
     }
 
-    static uint32_t MakeShaderHash(VkShaderModuleCreateInfo const *smci);
+    size_t Size() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return sorted_hashes.size() + added_hashes.size();
+    }
 
-    bool Contains(uint32_t hash) { return good_shader_hashes.count(hash) != 0; }
+   private:
+    // 4 bytes for header size + 4 bytes for version number + UUID
+    static const size_t header_size = 2 * sizeof(uint32_t) + VK_UUID_SIZE;
+    // Format version + hash count
+    static const size_t format_header_size = 2 * sizeof(uint32_t);
 
-    void Insert(uint32_t hash) { good_shader_hashes.insert(hash); }
+    // Every hash in the cache, sorted; caller holds lock
+    std::vector<shader_hash> SortedHashes() const;
 
-   private:
     void Sha1ToVkUuid(const char *sha1_str, uint8_t uuid[VK_UUID_SIZE]) {
         // Convert sha1_str from a hex string to binary. We only need VK_UUID_BYTES of
         // output, so pad with zeroes if the input string is shorter than that, and truncate
@@ -192,9 +305,33 @@ class ValidationCache {
     }
 };
 
-bool validate_and_capture_pipeline_shader_state(layer_data *dev_data, PIPELINE_STATE *pPipeline);
-bool validate_compute_pipeline(layer_data *dev_data, PIPELINE_STATE *pPipeline);
-typedef std::pair<unsigned, unsigned> descriptor_slot_t;
-bool PreCallValidateCreateShaderModule(layer_data *dev_data, VkShaderModuleCreateInfo const *pCreateInfo, bool *spirv_valid);
+// A device's SPIR-V validator. The context is created once and shared by every vkCreateShaderModule on the device, which
+// validate concurrently without global_lock. With async_shader_module_validation, background holds the workers that
+// validate modules after vkCreateShaderModule has returned.
+struct spirv_validator {
+    explicit spirv_validator(bool async) : context(spvContextCreate(SPV_ENV_VULKAN_1_0)) {
+        if (async) background.reset(new vl_task_queue(std::max(1u, std::thread::hardware_concurrency())));
+    }
+    spirv_validator(const spirv_validator &) = delete;
+    spirv_validator &operator=(const spirv_validator &) = delete;
+    ~spirv_validator() {
+        // Validation still running in the background uses the context
+        background.reset();
+        spvContextDestroy(context);
+    }
+
+    spv_context context;
+    std::unique_ptr<vl_task_queue> background;
+};
+
+// Pipeline validation reports through report_data rather than the device's own, so that it can run on a worker thread
+bool validate_and_capture_pipeline_shader_state(layer_data *dev_data, debug_report_data const *report_data,
+                                                 PIPELINE_STATE *pPipeline);
+bool validate_compute_pipeline(layer_data *dev_data, debug_report_data const *report_data, PIPELINE_STATE *pPipeline);
+bool PreCallValidateCreateShaderModule(layer_data *dev_data, VkShaderModuleCreateInfo const *pCreateInfo, bool *spirv_valid,
+                                       bool *spirv_deferred);
+// State for a module that has been created; spirv_deferred starts its validation in the background
+std::unique_ptr<shader_module> PostCallRecordCreateShaderModule(layer_data *dev_data, VkShaderModuleCreateInfo const *pCreateInfo,
+                                                                bool spirv_valid, bool spirv_deferred);
 
 #endif  // VULKAN_SHADER_VALIDATION_H
@@ -43,6 +43,7 @@ static uint32_t loader_layer_if_version = CURRENT_LOADER_LAYER_INTERFACE_VERSION
 
 static void initThreading(layer_data *my_data, const VkAllocationCallbacks *pAllocator) {
     layer_debug_actions(my_data->report_data, my_data->logging_callback, pAllocator, "google_threading");
+    my_data->sampler.configure("google_threading");
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL CreateInstance(const VkInstanceCreateInfo *pCreateInfo, const VkAllocationCallbacks *pAllocator,
@@ -93,16 +94,19 @@ VKAPI_ATTR void VKAPI_CALL DestroyInstance(VkInstance instance, const VkAllocati
     }
 
     bool threadChecks = startMultiThread();
-    if (threadChecks) {
+    bool sampled = threadChecks && my_data->sampler.sample_call();
+    if (sampled) {
         startWriteObject(my_data, instance);
     }
     pTable->DestroyInstance(instance, pAllocator);
-    if (threadChecks) {
+    if (sampled) {
         finishWriteObject(my_data, instance);
-    } else {
+    } else if (!threadChecks) {
         finishMultiThread();
     }
 
+    my_data->sampler.log_summary(my_data->report_data, VK_DEBUG_REPORT_OBJECT_TYPE_INSTANCE_EXT, HandleToUint64(instance));
+
     // Disable and cleanup the temporary callback(s):
     if (callback_setup) {
         layer_disable_tmp_callbacks(my_data->report_data, my_data->num_tmp_callbacks, my_data->tmp_callbacks);
@@ -152,6 +156,7 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateDevice(VkPhysicalDevice gpu, const VkDevice
     layer_init_device_dispatch_table(*pDevice, my_device_data->device_dispatch_table, fpGetDeviceProcAddr);
 
     my_device_data->report_data = layer_debug_report_create_device(my_instance_data->report_data, *pDevice);
+    my_device_data->sampler.configure(my_instance_data->sampler);
     return result;
 }
 
@@ -159,16 +164,19 @@ VKAPI_ATTR void VKAPI_CALL DestroyDevice(VkDevice device, const VkAllocationCall
     dispatch_key key = get_dispatch_key(device);
     layer_data *dev_data = GetLayerDataPtr(key, layer_data_map);
     bool threadChecks = startMultiThread();
-    if (threadChecks) {
+    bool sampled = threadChecks && dev_data->sampler.sample_call();
+    if (sampled) {
         startWriteObject(dev_data, device);
     }
     dev_data->device_dispatch_table->DestroyDevice(device, pAllocator);
-    if (threadChecks) {
+    if (sampled) {
         finishWriteObject(dev_data, device);
-    } else {
+    } else if (!threadChecks) {
         finishMultiThread();
     }
 
+    dev_data->sampler.log_summary(dev_data->report_data, VK_DEBUG_REPORT_OBJECT_TYPE_DEVICE_EXT, HandleToUint64(device));
+    layer_debug_report_destroy_device(dev_data->report_data, device);
     delete dev_data->device_dispatch_table;
     FreeLayerDataPtr(key, layer_data_map);
 }
@@ -180,15 +188,16 @@ VKAPI_ATTR VkResult VKAPI_CALL GetSwapchainImagesKHR(VkDevice device, VkSwapchai
     VkLayerDispatchTable *pTable = my_data->device_dispatch_table;
     VkResult result;
     bool threadChecks = startMultiThread();
-    if (threadChecks) {
+    bool sampled = threadChecks && my_data->sampler.sample_call();
+    if (sampled) {
         startReadObject(my_data, device);
         startReadObject(my_data, swapchain);
     }
     result = pTable->GetSwapchainImagesKHR(device, swapchain, pSwapchainImageCount, pSwapchainImages);
-    if (threadChecks) {
+    if (sampled) {
         finishReadObject(my_data, device);
         finishReadObject(my_data, swapchain);
-    } else {
+    } else if (!threadChecks) {
         finishMultiThread();
     }
     return result;
@@ -278,7 +287,8 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateDebugReportCallbackEXT(VkInstance instance,
                                                             VkDebugReportCallbackEXT *pMsgCallback) {
     layer_data *my_data = GetLayerDataPtr(get_dispatch_key(instance), layer_data_map);
     bool threadChecks = startMultiThread();
-    if (threadChecks) {
+    bool sampled = threadChecks && my_data->sampler.sample_call();
+    if (sampled) {
         startReadObject(my_data, instance);
     }
     VkResult result =
@@ -286,9 +296,9 @@ VKAPI_ATTR VkResult VKAPI_CALL CreateDebugReportCallbackEXT(VkInstance instance,
     if (VK_SUCCESS == result) {
         result = layer_create_msg_callback(my_data->report_data, false, pCreateInfo, pAllocator, pMsgCallback);
     }
-    if (threadChecks) {
+    if (sampled) {
         finishReadObject(my_data, instance);
-    } else {
+    } else if (!threadChecks) {
         finishMultiThread();
     }
     return result;
@@ -298,18 +308,20 @@ VKAPI_ATTR void VKAPI_CALL DestroyDebugReportCallbackEXT(VkInstance instance, Vk
                                                          const VkAllocationCallbacks *pAllocator) {
     layer_data *my_data = GetLayerDataPtr(get_dispatch_key(instance), layer_data_map);
     bool threadChecks = startMultiThread();
-    if (threadChecks) {
+    bool sampled = threadChecks && my_data->sampler.sample_call();
+    if (sampled) {
         startReadObject(my_data, instance);
         startWriteObject(my_data, callback);
     }
     my_data->instance_dispatch_table->DestroyDebugReportCallbackEXT(instance, callback, pAllocator);
     layer_destroy_msg_callback(my_data->report_data, callback, pAllocator);
-    if (threadChecks) {
+    if (sampled) {
         finishReadObject(my_data, instance);
         finishWriteObject(my_data, callback);
-    } else {
+    } else if (!threadChecks) {
         finishMultiThread();
     }
+    destroyObject(my_data, callback);
 }
 
 VKAPI_ATTR VkResult VKAPI_CALL AllocateCommandBuffers(VkDevice device, const VkCommandBufferAllocateInfo *pAllocateInfo,
@@ -319,16 +331,17 @@ VKAPI_ATTR VkResult VKAPI_CALL AllocateCommandBuffers(VkDevice device, const VkC
     VkLayerDispatchTable *pTable = my_data->device_dispatch_table;
     VkResult result;
     bool threadChecks = startMultiThread();
-    if (threadChecks) {
+    bool sampled = threadChecks && my_data->sampler.sample_call();
+    if (sampled) {
         startReadObject(my_data, device);
         startWriteObject(my_data, pAllocateInfo->commandPool);
     }
 
     result = pTable->AllocateCommandBuffers(device, pAllocateInfo, pCommandBuffers);
-    if (threadChecks) {
+    if (sampled) {
         finishReadObject(my_data, device);
         finishWriteObject(my_data, pAllocateInfo->commandPool);
-    } else {
+    } else if (!threadChecks) {
         finishMultiThread();
     }
 
@@ -350,22 +363,137 @@ VKAPI_ATTR VkResult VKAPI_CALL AllocateDescriptorSets(VkDevice device, const VkD
     VkLayerDispatchTable *pTable = my_data->device_dispatch_table;
     VkResult result;
     bool threadChecks = startMultiThread();
-    if (threadChecks) {
+    bool sampled = threadChecks && my_data->sampler.sample_call();
+    if (sampled) {
         startReadObject(my_data, device);
         startWriteObject(my_data, pAllocateInfo->descriptorPool);
         // Host access to pAllocateInfo::descriptorPool must be externally synchronized
     }
     result = pTable->AllocateDescriptorSets(device, pAllocateInfo, pDescriptorSets);
-    if (threadChecks) {
+    if (sampled) {
         finishReadObject(my_data, device);
         finishWriteObject(my_data, pAllocateInfo->descriptorPool);
         // Host access to pAllocateInfo::descriptorPool must be externally synchronized
+    } else if (!threadChecks) {
+        finishMultiThread();
+    }
+
+    // Record the sets allocated from the pool
+    if (VK_SUCCESS == result) {
+        std::lock_guard<std::mutex> lock(descriptor_pool_lock);
+        auto &pool_sets = descriptor_pool_map[pAllocateInfo->descriptorPool];
+        pool_sets.insert(pDescriptorSets, pDescriptorSets + pAllocateInfo->descriptorSetCount);
+    }
+    return result;
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL FreeDescriptorSets(VkDevice device, VkDescriptorPool descriptorPool, uint32_t descriptorSetCount,
+                                                  const VkDescriptorSet *pDescriptorSets) {
+    dispatch_key key = get_dispatch_key(device);
+    layer_data *my_data = GetLayerDataPtr(key, layer_data_map);
+    VkLayerDispatchTable *pTable = my_data->device_dispatch_table;
+    VkResult result;
+    bool threadChecks = startMultiThread();
+    bool sampled = threadChecks && my_data->sampler.sample_call();
+    if (sampled) {
+        startReadObject(my_data, device);
+        startWriteObject(my_data, descriptorPool);
+        for (uint32_t index = 0; index < descriptorSetCount; index++) {
+            startWriteObject(my_data, pDescriptorSets[index]);
+        }
+        // Host access to descriptorPool must be externally synchronized
+        // Host access to each member of pDescriptorSets must be externally synchronized
+    }
+    result = pTable->FreeDescriptorSets(device, descriptorPool, descriptorSetCount, pDescriptorSets);
+    if (sampled) {
+        finishReadObject(my_data, device);
+        finishWriteObject(my_data, descriptorPool);
+        for (uint32_t index = 0; index < descriptorSetCount; index++) {
+            finishWriteObject(my_data, pDescriptorSets[index]);
+        }
+        // Host access to descriptorPool must be externally synchronized
+        // Host access to each member of pDescriptorSets must be externally synchronized
+    } else if (!threadChecks) {
+        finishMultiThread();
+    }
+
+    std::lock_guard<std::mutex> lock(descriptor_pool_lock);
+    auto &pool_sets = descriptor_pool_map[descriptorPool];
+    for (uint32_t index = 0; index < descriptorSetCount; index++) {
+        destroyObject(my_data, pDescriptorSets[index]);
+        pool_sets.erase(pDescriptorSets[index]);
+    }
+    return result;
+}
+
+// Stop tracking every set allocated from a pool that is being reset or destroyed
+static void destroyPoolDescriptorSets(layer_data *my_data, VkDescriptorPool descriptorPool, bool destroyPool) {
+    std::lock_guard<std::mutex> lock(descriptor_pool_lock);
+    auto pool_sets = descriptor_pool_map.find(descriptorPool);
+    if (pool_sets == descriptor_pool_map.end()) return;
+    for (auto descriptor_set : pool_sets->second) {
+        destroyObject(my_data, descriptor_set);
+    }
+    if (destroyPool) {
+        descriptor_pool_map.erase(pool_sets);
     } else {
+        pool_sets->second.clear();
+    }
+}
+
+VKAPI_ATTR VkResult VKAPI_CALL ResetDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool,
+                                                   VkDescriptorPoolResetFlags flags) {
+    dispatch_key key = get_dispatch_key(device);
+    layer_data *my_data = GetLayerDataPtr(key, layer_data_map);
+    VkLayerDispatchTable *pTable = my_data->device_dispatch_table;
+    VkResult result;
+    bool threadChecks = startMultiThread();
+    bool sampled = threadChecks && my_data->sampler.sample_call();
+    if (sampled) {
+        startReadObject(my_data, device);
+        startWriteObject(my_data, descriptorPool);
+        // Host access to descriptorPool must be externally synchronized
+        // any sname:VkDescriptorSet objects allocated from pname:descriptorPool must be externally synchronized between host
+        // accesses
+    }
+    result = pTable->ResetDescriptorPool(device, descriptorPool, flags);
+    if (sampled) {
+        finishReadObject(my_data, device);
+        finishWriteObject(my_data, descriptorPool);
+        // Host access to descriptorPool must be externally synchronized
+        // any sname:VkDescriptorSet objects allocated from pname:descriptorPool must be externally synchronized between host
+        // accesses
+    } else if (!threadChecks) {
         finishMultiThread();
     }
+    destroyPoolDescriptorSets(my_data, descriptorPool, false);
     return result;
 }
 
+VKAPI_ATTR void VKAPI_CALL DestroyDescriptorPool(VkDevice device, VkDescriptorPool descriptorPool,
+                                                 const VkAllocationCallbacks *pAllocator) {
+    dispatch_key key = get_dispatch_key(device);
+    layer_data *my_data = GetLayerDataPtr(key, layer_data_map);
+    VkLayerDispatchTable *pTable = my_data->device_dispatch_table;
+    bool threadChecks = startMultiThread();
+    bool sampled = threadChecks && my_data->sampler.sample_call();
+    if (sampled) {
+        startReadObject(my_data, device);
+        startWriteObject(my_data, descriptorPool);
+        // Host access to descriptorPool must be externally synchronized
+    }
+    pTable->DestroyDescriptorPool(device, descriptorPool, pAllocator);
+    if (sampled) {
+        finishReadObject(my_data, device);
+        finishWriteObject(my_data, descriptorPool);
+        // Host access to descriptorPool must be externally synchronized
+    } else if (!threadChecks) {
+        finishMultiThread();
+    }
+    destroyPoolDescriptorSets(my_data, descriptorPool, true);
+    destroyObject(my_data, descriptorPool);
+}
+
 VKAPI_ATTR void VKAPI_CALL FreeCommandBuffers(VkDevice device, VkCommandPool commandPool, uint32_t commandBufferCount,
                                               const VkCommandBuffer *pCommandBuffers) {
     dispatch_key key = get_dispatch_key(device);
@@ -373,28 +501,66 @@ VKAPI_ATTR void VKAPI_CALL FreeCommandBuffers(VkDevice device, VkCommandPool com
     VkLayerDispatchTable *pTable = my_data->device_dispatch_table;
     const bool lockCommandPool = false;  // pool is already directly locked
     bool threadChecks = startMultiThread();
-    if (threadChecks) {
+    bool sampled = threadChecks && my_data->sampler.sample_call();
+    if (sampled) {
         startReadObject(my_data, device);
         startWriteObject(my_data, commandPool);
         for (uint32_t index = 0; index < commandBufferCount; index++) {
             startWriteObject(my_data, pCommandBuffers[index], lockCommandPool);
         }
-        // The driver may immediately reuse command buffers in another thread.
-        // These updates need to be done before calling down to the driver.
-        for (uint32_t index = 0; index < commandBufferCount; index++) {
-            finishWriteObject(my_data, pCommandBuffers[index], lockCommandPool);
+    }
+    // The driver may immediately reuse command buffers in another thread.
+    // These updates need to be done before calling down to the driver.
+    for (uint32_t index = 0; index < commandBufferCount; index++) {
+        if (sampled) finishWriteObject(my_data, pCommandBuffers[index], lockCommandPool);
+        my_data->c_VkCommandBuffer.destroyObject(pCommandBuffers[index]);
+        if (threadChecks) {
             std::lock_guard<std::mutex> lock(command_pool_lock);
             command_pool_map.erase(pCommandBuffers[index]);
         }
     }
 
     pTable->FreeCommandBuffers(device, commandPool, commandBufferCount, pCommandBuffers);
-    if (threadChecks) {
+    if (sampled) {
         finishReadObject(my_data, device);
         finishWriteObject(my_data, commandPool);
-    } else {
+    } else if (!threadChecks) {
+        finishMultiThread();
+    }
+}
+
+VKAPI_ATTR void VKAPI_CALL DestroyCommandPool(VkDevice device, VkCommandPool commandPool, const VkAllocationCallbacks *pAllocator) {
+    dispatch_key key = get_dispatch_key(device);
+    layer_data *my_data = GetLayerDataPtr(key, layer_data_map);
+    VkLayerDispatchTable *pTable = my_data->device_dispatch_table;
+    bool threadChecks = startMultiThread();
+    bool sampled = threadChecks && my_data->sampler.sample_call();
+    if (sampled) {
+        startReadObject(my_data, device);
+        startWriteObject(my_data, commandPool);
+        // Host access to commandPool must be externally synchronized
+    }
+    {
+        // The pool's command buffers are freed with it, and the driver may reuse them as soon as it returns
+        std::lock_guard<std::mutex> lock(command_pool_lock);
+        for (auto item = command_pool_map.begin(); item != command_pool_map.end();) {
+            if (item->second == commandPool) {
+                my_data->c_VkCommandBuffer.destroyObject(item->first);
+                item = command_pool_map.erase(item);
+            } else {
+                ++item;
+            }
+        }
+    }
+    pTable->DestroyCommandPool(device, commandPool, pAllocator);
+    if (sampled) {
+        finishReadObject(my_data, device);
+        finishWriteObject(my_data, commandPool);
+        // Host access to commandPool must be externally synchronized
+    } else if (!threadChecks) {
         finishMultiThread();
     }
+    destroyObject(my_data, commandPool);
 }
 
 }  // namespace threading
@@ -20,11 +20,13 @@
 
 #ifndef THREADING_H
 #define THREADING_H
-#include <condition_variable>
 #include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 #include "vk_layer_config.h"
 #include "vk_layer_logging.h"
+#include "vk_layer_thread_counter.h"
 
 #if defined(__LP64__) || defined(_WIN64) || defined(__x86_64__) || defined(_M_X64) || defined(__ia64) || defined(_M_IA64) || \
     defined(__aarch64__) || defined(__powerpc64__)
@@ -33,19 +35,6 @@
 #define DISTINCT_NONDISPATCHABLE_HANDLES
 #endif
 
-// Draw State ERROR codes
-enum THREADING_CHECKER_ERROR {
-    THREADING_CHECKER_NONE,                 // Used for INFO & other non-error messages
-    THREADING_CHECKER_MULTIPLE_THREADS,     // Object used simultaneously by multiple threads
-    THREADING_CHECKER_SINGLE_THREAD_REUSE,  // Object used simultaneously by recursion in single thread
-};
-
-struct object_use_data {
-    loader_platform_thread_id thread;
-    int reader_count;
-    int writer_count;
-};
-
 struct layer_data;
 
 namespace threading {
@@ -68,165 +57,11 @@ inline bool startMultiThread() {
 inline void finishMultiThread() { vulkan_in_use = false; }
 }  // namespace threading
 
-template <typename T>
-class counter {
-   public:
-    const char *typeName;
-    VkDebugReportObjectTypeEXT objectType;
-    std::unordered_map<T, object_use_data> uses;
-    std::mutex counter_lock;
-    std::condition_variable counter_condition;
-    void startWrite(debug_report_data *report_data, T object) {
-        if (object == VK_NULL_HANDLE) {
-            return;
-        }
-        bool skipCall = false;
-        loader_platform_thread_id tid = loader_platform_get_thread_id();
-        std::unique_lock<std::mutex> lock(counter_lock);
-        if (uses.find(object) == uses.end()) {
-            // There is no current use of the object.  Record writer thread.
-            struct object_use_data *use_data = &uses[object];
-            use_data->reader_count = 0;
-            use_data->writer_count = 1;
-            use_data->thread = tid;
-        } else {
-            struct object_use_data *use_data = &uses[object];
-            if (use_data->reader_count == 0) {
-                // There are no readers.  Two writers just collided.
-                if (use_data->thread != tid) {
-                    skipCall |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, objectType, (uint64_t)(object), 0,
-                                        THREADING_CHECKER_MULTIPLE_THREADS, "THREADING",
-                                        "THREADING ERROR : object of type %s is simultaneously used in "
-                                        "thread 0x%" PRIx64 " and thread 0x%" PRIx64,
-                                        typeName, (uint64_t)use_data->thread, (uint64_t)tid);
-                    if (skipCall) {
-                        // Wait for thread-safe access to object instead of skipping call.
-                        while (uses.find(object) != uses.end()) {
-                            counter_condition.wait(lock);
-                        }
-                        // There is now no current use of the object.  Record writer thread.
-                        struct object_use_data *new_use_data = &uses[object];
-                        new_use_data->thread = tid;
-                        new_use_data->reader_count = 0;
-                        new_use_data->writer_count = 1;
-                    } else {
-                        // Continue with an unsafe use of the object.
-                        use_data->thread = tid;
-                        use_data->writer_count += 1;
-                    }
-                } else {
-                    // This is either safe multiple use in one call, or recursive use.
-                    // There is no way to make recursion safe.  Just forge ahead.
-                    use_data->writer_count += 1;
-                }
-            } else {
-                // There are readers.  This writer collided with them.
-                if (use_data->thread != tid) {
-                    skipCall |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, objectType, (uint64_t)(object), 0,
-                                        THREADING_CHECKER_MULTIPLE_THREADS, "THREADING",
-                                        "THREADING ERROR : object of type %s is simultaneously used in "
-                                        "thread 0x%" PRIx64 " and thread 0x%" PRIx64,
-                                        typeName, (uint64_t)use_data->thread, (uint64_t)tid);
-                    if (skipCall) {
-                        // Wait for thread-safe access to object instead of skipping call.
-                        while (uses.find(object) != uses.end()) {
-                            counter_condition.wait(lock);
-                        }
-                        // There is now no current use of the object.  Record writer thread.
-                        struct object_use_data *new_use_data = &uses[object];
-                        new_use_data->thread = tid;
-                        new_use_data->reader_count = 0;
-                        new_use_data->writer_count = 1;
-                    } else {
-                        // Continue with an unsafe use of the object.
-                        use_data->thread = tid;
-                        use_data->writer_count += 1;
-                    }
-                } else {
-                    // This is either safe multiple use in one call, or recursive use.
-                    // There is no way to make recursion safe.  Just forge ahead.
-                    use_data->writer_count += 1;
-                }
-            }
-        }
-    }
-
-    void finishWrite(T object) {
-        if (object == VK_NULL_HANDLE) {
-            return;
-        }
-        // Object is no longer in use
-        std::unique_lock<std::mutex> lock(counter_lock);
-        uses[object].writer_count -= 1;
-        if ((uses[object].reader_count == 0) && (uses[object].writer_count == 0)) {
-            uses.erase(object);
-        }
-        // Notify any waiting threads that this object may be safe to use
-        lock.unlock();
-        counter_condition.notify_all();
-    }
-
-    void startRead(debug_report_data *report_data, T object) {
-        if (object == VK_NULL_HANDLE) {
-            return;
-        }
-        bool skipCall = false;
-        loader_platform_thread_id tid = loader_platform_get_thread_id();
-        std::unique_lock<std::mutex> lock(counter_lock);
-        if (uses.find(object) == uses.end()) {
-            // There is no current use of the object.  Record reader count
-            struct object_use_data *use_data = &uses[object];
-            use_data->reader_count = 1;
-            use_data->writer_count = 0;
-            use_data->thread = tid;
-        } else if (uses[object].writer_count > 0 && uses[object].thread != tid) {
-            // There is a writer of the object.
-            skipCall |= log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, objectType, (uint64_t)(object), 0,
-                                THREADING_CHECKER_MULTIPLE_THREADS, "THREADING",
-                                "THREADING ERROR : object of type %s is simultaneously used in "
-                                "thread 0x%" PRIx64 " and thread 0x%" PRIx64,
-                                typeName, (uint64_t)uses[object].thread, (uint64_t)tid);
-            if (skipCall) {
-                // Wait for thread-safe access to object instead of skipping call.
-                while (uses.find(object) != uses.end()) {
-                    counter_condition.wait(lock);
-                }
-                // There is no current use of the object.  Record reader count
-                struct object_use_data *use_data = &uses[object];
-                use_data->reader_count = 1;
-                use_data->writer_count = 0;
-                use_data->thread = tid;
-            } else {
-                uses[object].reader_count += 1;
-            }
-        } else {
-            // There are other readers of the object.  Increase reader count
-            uses[object].reader_count += 1;
-        }
-    }
-    void finishRead(T object) {
-        if (object == VK_NULL_HANDLE) {
-            return;
-        }
-        std::unique_lock<std::mutex> lock(counter_lock);
-        uses[object].reader_count -= 1;
-        if ((uses[object].reader_count == 0) && (uses[object].writer_count == 0)) {
-            uses.erase(object);
-        }
-        // Notify any waiting threads that this object may be safe to use
-        lock.unlock();
-        counter_condition.notify_all();
-    }
-    counter(const char *name = "", VkDebugReportObjectTypeEXT type = VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT) {
-        typeName = name;
-        objectType = type;
-    }
-};
-
 struct layer_data {
     VkInstance instance;
 
     debug_report_data *report_data;
+    call_sampler sampler;
     std::vector<VkDebugReportCallbackEXT> logging_callback;
     VkLayerDispatchTable *device_dispatch_table;
     VkLayerInstanceDispatchTable *instance_dispatch_table;
@@ -323,13 +158,18 @@ struct layer_data {
 
 #define WRAPPER(type)                                                                                                 \
     static void startWriteObject(struct layer_data *my_data, type object) {                                           \
-        my_data->c_##type.startWrite(my_data->report_data, object);                                                   \
+        my_data->c_##type.startWrite(my_data->report_data, object, my_data->sampler.object_limit);                    \
+    }                                                                                                                 \
+    static void finishWriteObject(struct layer_data *my_data, type object) {                                          \
+        my_data->c_##type.finishWrite(object, my_data->sampler.object_limit);                                         \
     }                                                                                                                 \
-    static void finishWriteObject(struct layer_data *my_data, type object) { my_data->c_##type.finishWrite(object); } \
     static void startReadObject(struct layer_data *my_data, type object) {                                            \
-        my_data->c_##type.startRead(my_data->report_data, object);                                                    \
+        my_data->c_##type.startRead(my_data->report_data, object, my_data->sampler.object_limit);                     \
+    }                                                                                                                 \
+    static void finishReadObject(struct layer_data *my_data, type object) {                                           \
+        my_data->c_##type.finishRead(object, my_data->sampler.object_limit);                                          \
     }                                                                                                                 \
-    static void finishReadObject(struct layer_data *my_data, type object) { my_data->c_##type.finishRead(object); }
+    static void destroyObject(struct layer_data *my_data, type object) { my_data->c_##type.destroyObject(object); }
 
 WRAPPER(VkDevice)
 WRAPPER(VkInstance)
@@ -369,9 +209,12 @@ WRAPPER(VkSamplerYcbcrConversionKHR)
 WRAPPER(uint64_t)
 #endif  // DISTINCT_NONDISPATCHABLE_HANDLES
 
-static std::unordered_map<void *, layer_data *> layer_data_map;
+static vl_layer_data_map<layer_data> layer_data_map;
 static std::mutex command_pool_lock;
 static std::unordered_map<VkCommandBuffer, VkCommandPool> command_pool_map;
+// Descriptor sets allocated from each pool, so that they stop being tracked when the pool is reset or destroyed
+static std::mutex descriptor_pool_lock;
+static std::unordered_map<VkDescriptorPool, std::unordered_set<VkDescriptorSet>> descriptor_pool_map;
 
 // VkCommandBuffer needs check for implicit use of command pool
 static void startWriteObject(struct layer_data *my_data, VkCommandBuffer object, bool lockPool = true) {
@@ -381,10 +224,10 @@ static void startWriteObject(struct layer_data *my_data, VkCommandBuffer object,
         lock.unlock();
         startWriteObject(my_data, pool);
     }
-    my_data->c_VkCommandBuffer.startWrite(my_data->report_data, object);
+    my_data->c_VkCommandBuffer.startWrite(my_data->report_data, object, my_data->sampler.object_limit);
 }
 static void finishWriteObject(struct layer_data *my_data, VkCommandBuffer object, bool lockPool = true) {
-    my_data->c_VkCommandBuffer.finishWrite(object);
+    my_data->c_VkCommandBuffer.finishWrite(object, my_data->sampler.object_limit);
     if (lockPool) {
         std::unique_lock<std::mutex> lock(command_pool_lock);
         VkCommandPool pool = command_pool_map[object];
@@ -397,10 +240,10 @@ static void startReadObject(struct layer_data *my_data, VkCommandBuffer object)
     VkCommandPool pool = command_pool_map[object];
     lock.unlock();
     startReadObject(my_data, pool);
-    my_data->c_VkCommandBuffer.startRead(my_data->report_data, object);
+    my_data->c_VkCommandBuffer.startRead(my_data->report_data, object, my_data->sampler.object_limit);
 }
 static void finishReadObject(struct layer_data *my_data, VkCommandBuffer object) {
-    my_data->c_VkCommandBuffer.finishRead(object);
+    my_data->c_VkCommandBuffer.finishRead(object, my_data->sampler.object_limit);
     std::unique_lock<std::mutex> lock(command_pool_lock);
     VkCommandPool pool = command_pool_map[object];
     lock.unlock();
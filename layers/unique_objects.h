@@ -25,6 +25,7 @@
 #include <unordered_set>
 
 #include "vk_layer_data.h"
+#include "vk_layer_handle_table.h"
 #include "vk_safe_struct.h"
 #include "vk_layer_utils.h"
 #include "mutex"
@@ -33,9 +34,8 @@
 
 namespace unique_objects {
 
-// All increments must be guarded by global_lock
-static uint64_t global_unique_id = 1;
-static std::unordered_map<uint64_t, uint64_t> unique_id_mapping;  // Map uniqueID to actual object handle
+// Map uniqueID to actual object handle.  Wait-free to read and safe to update from any thread without global_lock.
+static vl_handle_table unique_id_mapping;
 
 struct TEMPLATE_STATE {
     VkDescriptorUpdateTemplateKHR desc_update_template;
@@ -83,10 +83,10 @@ struct layer_data {
     layer_data() : wsi_enabled(false), gpu(VK_NULL_HANDLE){};
 };
 
-static std::unordered_map<void *, instance_layer_data *> instance_layer_data_map;
-static std::unordered_map<void *, layer_data *> layer_data_map;
+static vl_layer_data_map<instance_layer_data> instance_layer_data_map;
+static vl_layer_data_map<layer_data> layer_data_map;
 
-static std::mutex global_lock;  // Protect map accesses and unique_id increments
+static std::mutex global_lock;  // Protect the layer_data maps; unique_id_mapping needs no lock
 
 struct GenericHeader {
     VkStructureType sType;
@@ -111,19 +111,21 @@ bool ContainsExtStruct(const T *target, VkStructureType ext_type) {
 }
 
 /* Unwrap a handle. */
-// must hold lock!
 template <typename HandleType>
 HandleType Unwrap(HandleType wrappedHandle) {
-    // TODO: don't use operator[] here.
-    return (HandleType)unique_id_mapping[reinterpret_cast<uint64_t const &>(wrappedHandle)];
+    return (HandleType)unique_id_mapping.find(reinterpret_cast<uint64_t const &>(wrappedHandle));
 }
 
-// Wrap a newly created handle with a new unique ID, and return the new ID -- must hold lock!
+// Wrap a newly created handle with a new unique ID, and return the new ID
 template <typename HandleType>
 HandleType WrapNew(HandleType newlyCreatedHandle) {
-    auto unique_id = global_unique_id++;
-    unique_id_mapping[unique_id] = reinterpret_cast<uint64_t const &>(newlyCreatedHandle);
-    return (HandleType)unique_id;
+    return (HandleType)unique_id_mapping.insert(reinterpret_cast<uint64_t const &>(newlyCreatedHandle));
+}
+
+// Forget a wrapped handle that is being destroyed, and return the handle it wrapped
+template <typename HandleType>
+HandleType UnwrapAndErase(HandleType wrappedHandle) {
+    return (HandleType)unique_id_mapping.erase(reinterpret_cast<uint64_t const &>(wrappedHandle));
 }
 
 }  // namespace unique_objects
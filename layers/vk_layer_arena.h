@@ -0,0 +1,295 @@
+/* Copyright (c) 2015-2017 The Khronos Group Inc.
+ * Copyright (c) 2015-2017 Valve Corporation
+ * Copyright (c) 2015-2017 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VK_LAYER_ARENA_H
+#define VK_LAYER_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// Free list of fixed-size memory blocks shared by a group of arenas, e.g. all of the command buffers of one command pool.
+// Blocks handed back by an arena are kept for the next arena that needs one, so arenas that are reset and refilled over
+// and over stop reaching the global allocator once the group has warmed up.  The free list is locked, but arenas only
+// come here when their current block is exhausted.
+class vl_arena_block_pool {
+   public:
+    static const size_t kBlockSize = 4096;
+
+    struct Block {
+        Block *next;
+        size_t size;  // Usable bytes following the header
+    };
+
+    vl_arena_block_pool() : free_list_(nullptr) {}
+    vl_arena_block_pool(const vl_arena_block_pool &) = delete;
+    vl_arena_block_pool &operator=(const vl_arena_block_pool &) = delete;
+    ~vl_arena_block_pool() { trim(); }
+
+    // Get a block with at least min_size usable bytes
+    Block *acquire(size_t min_size) {
+        if (min_size <= kBlockSize) {
+            std::lock_guard<std::mutex> lock(lock_);
+            if (free_list_) {
+                Block *block = free_list_;
+                free_list_ = block->next;
+                return block;
+            }
+        }
+        return NewBlock(min_size > kBlockSize ? min_size : kBlockSize);
+    }
+
+    // Take back a chain of blocks linked through Block::next.  Oversized blocks are freed rather than kept.
+    void release(Block *chain) {
+        std::lock_guard<std::mutex> lock(lock_);
+        while (chain) {
+            Block *next = chain->next;
+            if (chain->size == kBlockSize) {
+                chain->next = free_list_;
+                free_list_ = chain;
+            } else {
+                ::operator delete(chain);
+            }
+            chain = next;
+        }
+    }
+
+    // Return all of the idle blocks to the global allocator
+    void trim() {
+        std::lock_guard<std::mutex> lock(lock_);
+        while (free_list_) {
+            Block *next = free_list_->next;
+            ::operator delete(free_list_);
+            free_list_ = next;
+        }
+    }
+
+    static Block *NewBlock(size_t size) {
+        Block *block = static_cast<Block *>(::operator new(sizeof(Block) + size));
+        block->next = nullptr;
+        block->size = size;
+        return block;
+    }
+
+   private:
+    std::mutex lock_;
+    Block *free_list_;
+};
+
+// Bump allocator for state whose lifetime ends all at once, such as the validation work recorded into a command buffer,
+// which is all discarded when the command buffer is reset.  Memory is carved out of blocks from a vl_arena_block_pool
+// (or straight from the global allocator if the arena has no pool) and only given back, in bulk, by reset().  The arena
+// never runs destructors; owners of non-trivial objects allocated from it must destroy them before resetting it.
+class vl_arena {
+   public:
+    vl_arena() : block_pool_(nullptr), blocks_(nullptr), reserved_(nullptr), cursor_(nullptr), limit_(nullptr) {}
+    vl_arena(const vl_arena &) = delete;
+    vl_arena &operator=(const vl_arena &) = delete;
+    ~vl_arena() {
+        ReleaseBlocks();
+        ::operator delete(reserved_);
+    }
+
+    // Draw blocks from (and return them to) block_pool.  Only valid while the arena holds no blocks.
+    void set_block_pool(vl_arena_block_pool *block_pool) { block_pool_ = block_pool; }
+
+    // Keep a block of at least size bytes for the life of the arena and allocate from it first.  reset() rewinds the
+    // reserved block instead of freeing it, and if the arena had spilled past it, regrows it to cover everything that was
+    // in use, so an arena refilled to the same peak over and over settles into a single block.  Only valid while the
+    // arena is empty.
+    void reserve(size_t size) {
+        if (!reserved_ || reserved_->size < size) {
+            ::operator delete(reserved_);
+            reserved_ = vl_arena_block_pool::NewBlock(size);
+        }
+        Rewind();
+    }
+
+    void *allocate(size_t size, size_t alignment) {
+        uintptr_t address = (reinterpret_cast<uintptr_t>(cursor_) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        if (!cursor_ || address + size > reinterpret_cast<uintptr_t>(limit_)) {
+            const size_t needed = size + alignment;
+            vl_arena_block_pool::Block *block =
+                block_pool_ ? block_pool_->acquire(needed)
+                            : vl_arena_block_pool::NewBlock(needed > kDefaultBlockSize ? needed : kDefaultBlockSize);
+            block->next = blocks_;
+            blocks_ = block;
+            cursor_ = reinterpret_cast<char *>(block + 1);
+            limit_ = cursor_ + block->size;
+            address = (reinterpret_cast<uintptr_t>(cursor_) + alignment - 1) & ~(uintptr_t(alignment) - 1);
+        }
+        cursor_ = reinterpret_cast<char *>(address + size);
+        return reinterpret_cast<void *>(address);
+    }
+
+    // Give every block back at once
+    void reset() {
+        const size_t spilled = ReleaseBlocks();
+        if (reserved_ && spilled) {
+            const size_t size = reserved_->size + spilled;
+            ::operator delete(reserved_);
+            reserved_ = vl_arena_block_pool::NewBlock(size);
+        }
+        Rewind();
+    }
+
+   private:
+    static const size_t kDefaultBlockSize = vl_arena_block_pool::kBlockSize;
+
+    // Hand back every block but the reserved one, returning how many usable bytes they held
+    size_t ReleaseBlocks() {
+        size_t released = 0;
+        for (vl_arena_block_pool::Block *block = blocks_; block; block = block->next) released += block->size;
+        if (block_pool_) {
+            block_pool_->release(blocks_);
+        } else {
+            while (blocks_) {
+                vl_arena_block_pool::Block *next = blocks_->next;
+                ::operator delete(blocks_);
+                blocks_ = next;
+            }
+        }
+        blocks_ = nullptr;
+        return released;
+    }
+
+    void Rewind() {
+        cursor_ = reserved_ ? reinterpret_cast<char *>(reserved_ + 1) : nullptr;
+        limit_ = reserved_ ? cursor_ + reserved_->size : nullptr;
+    }
+
+    vl_arena_block_pool *block_pool_;
+    vl_arena_block_pool::Block *blocks_;    // Most recent first; once past the reserved block, cursor_ points into the head
+    vl_arena_block_pool::Block *reserved_;  // Kept across resets, see reserve()
+    char *cursor_;
+    char *limit_;
+};
+
+// Ordered list of deferred validation calls, each a closure stored in a vl_arena instead of behind a std::function (which
+// heap allocates any capture bigger than a couple of pointers).  Calls run in the order they were added.
+//
+// clear() destroys the stored closures but leaves their memory to the arena, so it must be called before the arena is
+// reset, and the list must not outlive its arena.
+template <typename Signature>
+class vl_deferred_calls;
+
+template <typename R, typename... Args>
+class vl_deferred_calls<R(Args...)> {
+   public:
+    class call {
+       public:
+        virtual R operator()(Args... args) const = 0;
+
+       protected:
+        call() : next_(nullptr) {}
+        virtual ~call() {}
+        virtual call *clone(vl_arena *arena) const = 0;
+
+       private:
+        friend class vl_deferred_calls;
+        call *next_;
+    };
+
+    class iterator {
+       public:
+        explicit iterator(call *node) : node_(node) {}
+        call &operator*() const { return *node_; }
+        call *operator->() const { return node_; }
+        iterator &operator++() {
+            node_ = node_->next_;
+            return *this;
+        }
+        bool operator==(const iterator &other) const { return node_ == other.node_; }
+        bool operator!=(const iterator &other) const { return node_ != other.node_; }
+
+       private:
+        call *node_;
+    };
+
+    explicit vl_deferred_calls(vl_arena *arena) : arena_(arena), head_(nullptr), tail_(nullptr), size_(0) {}
+    vl_deferred_calls(const vl_deferred_calls &) = delete;
+    vl_deferred_calls &operator=(const vl_deferred_calls &) = delete;
+    ~vl_deferred_calls() { clear(); }
+
+    template <typename F>
+    void emplace_back(F &&function) {
+        typedef typename std::decay<F>::type Function;
+        void *memory = arena_->allocate(sizeof(stored_call<Function>), std::alignment_of<stored_call<Function>>::value);
+        Append(new (memory) stored_call<Function>(std::forward<F>(function)));
+    }
+
+    // Copy all of other's calls onto the end of this list, e.g. to hand a secondary command buffer's work to a primary
+    void append(const vl_deferred_calls &other) {
+        for (call *node = other.head_; node; node = node->next_) Append(node->clone(arena_));
+    }
+
+    void clear() {
+        call *node = head_;
+        while (node) {
+            call *next = node->next_;
+            node->~call();
+            node = next;
+        }
+        head_ = nullptr;
+        tail_ = nullptr;
+        size_ = 0;
+    }
+
+    iterator begin() const { return iterator(head_); }
+    iterator end() const { return iterator(nullptr); }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+   private:
+    template <typename Function>
+    class stored_call : public call {
+       public:
+        template <typename F>
+        explicit stored_call(F &&function) : function_(std::forward<F>(function)) {}
+        R operator()(Args... args) const override { return function_(args...); }
+
+       protected:
+        call *clone(vl_arena *arena) const override {
+            void *memory = arena->allocate(sizeof(stored_call), std::alignment_of<stored_call>::value);
+            return new (memory) stored_call(function_);
+        }
+
+       private:
+        Function function_;
+    };
+
+    void Append(call *node) {
+        if (tail_) {
+            tail_->next_ = node;
+        } else {
+            head_ = node;
+        }
+        tail_ = node;
+        ++size_;
+    }
+
+    vl_arena *arena_;
+    call *head_;
+    call *tail_;
+    size_t size_;
+};
+
+#endif  // VK_LAYER_ARENA_H
@@ -0,0 +1,144 @@
+/* Copyright (c) 2015-2017 The Khronos Group Inc.
+ * Copyright (c) 2015-2017 Valve Corporation
+ * Copyright (c) 2015-2017 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VK_LAYER_CONCURRENT_MAP_H
+#define VK_LAYER_CONCURRENT_MAP_H
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "vk_layer_shared_mutex.h"
+
+// Handle -> state map that may be searched from any thread without external locking.
+//
+// The map is split into 2^BUCKETSLOG2 shards, each an unordered_map behind its own SharedMutex, so lookups only take one
+// uncontended shared lock and creates/destroys of unrelated objects rarely touch the same shard.  find() hands back a
+// pointer to the mapped value rather than an iterator: unordered_map never moves its nodes, so the pointer stays valid
+// until that key is erased, which Vulkan's object lifetime rules already keep from racing with any use of the object.
+//
+// Only the map structure is protected.  The mapped state objects still rely on whatever lock guards their contents.
+template <typename Key, typename T, int BUCKETSLOG2 = 4, typename Hash = std::hash<Key>>
+class vl_concurrent_unordered_map {
+   public:
+    // Return a pointer to the value mapped to key, or nullptr if there is none
+    T *find(const Key &key) { return FindValue(key); }
+    const T *find(const Key &key) const { return FindValue(key); }
+
+    bool contains(const Key &key) const { return find(key) != nullptr; }
+
+    // Return the value mapped to key, default-constructing it first if necessary
+    T &operator[](const Key &key) {
+        Shard &shard = GetShard(key);
+        std::lock_guard<SharedMutex> lock(shard.lock);
+        return shard.map[key];
+    }
+
+    // Map key to value unless key is already present; returns whether the value was inserted
+    template <typename V>
+    bool insert(const Key &key, V &&value) {
+        Shard &shard = GetShard(key);
+        std::lock_guard<SharedMutex> lock(shard.lock);
+        return shard.map.emplace(key, std::forward<V>(value)).second;
+    }
+
+    template <typename V>
+    void insert_or_assign(const Key &key, V &&value) {
+        Shard &shard = GetShard(key);
+        std::lock_guard<SharedMutex> lock(shard.lock);
+        shard.map[key] = std::forward<V>(value);
+    }
+
+    size_t erase(const Key &key) {
+        Shard &shard = GetShard(key);
+        std::lock_guard<SharedMutex> lock(shard.lock);
+        return shard.map.erase(key);
+    }
+
+    void clear() {
+        for (auto &shard : shards_) {
+            std::lock_guard<SharedMutex> lock(shard.lock);
+            shard.map.clear();
+        }
+    }
+
+    size_t size() const {
+        size_t count = 0;
+        for (auto &shard : shards_) {
+            SharedLock<SharedMutex> lock(shard.lock);
+            count += shard.map.size();
+        }
+        return count;
+    }
+    bool empty() const { return size() == 0; }
+
+    // Call func(key, value) for every entry, holding each shard's lock in shared mode while its entries are visited, so
+    // that the values cannot be erased out from under func.  func must not insert into or erase from the map.
+    template <typename F>
+    void for_each(F func) const {
+        for (auto &shard : shards_) {
+            SharedLock<SharedMutex> lock(shard.lock);
+            for (auto &entry : shard.map) {
+                func(entry.first, entry.second);
+            }
+        }
+    }
+
+    // Copy out (key, value pointer) pairs for iteration.  Entries erased after the snapshot is taken leave dangling
+    // pointers behind, so callers that erase while walking the result must only erase entries they have finished with.
+    std::vector<std::pair<Key, T *>> snapshot() {
+        std::vector<std::pair<Key, T *>> entries;
+        for (auto &shard : shards_) {
+            SharedLock<SharedMutex> lock(shard.lock);
+            for (auto &entry : shard.map) {
+                entries.emplace_back(entry.first, &entry.second);
+            }
+        }
+        return entries;
+    }
+
+   private:
+    static const size_t kShardCount = size_t(1) << BUCKETSLOG2;
+
+    struct Shard {
+        SharedMutex lock;
+        std::unordered_map<Key, T, Hash> map;
+    };
+
+    T *FindValue(const Key &key) const {
+        Shard &shard = GetShard(key);
+        SharedLock<SharedMutex> lock(shard.lock);
+        auto it = shard.map.find(key);
+        return (it == shard.map.end()) ? nullptr : &it->second;
+    }
+
+    // Handles are frequently aligned pointers with constant low bits, so pick the shard with a multiplicative hash taken
+    // from the high bits
+    Shard &GetShard(const Key &key) const {
+        const uint64_t hash = static_cast<uint64_t>(Hash()(key)) * 0x9E3779B97F4A7C15ull;
+        return shards_[static_cast<size_t>(hash >> (64 - BUCKETSLOG2))];
+    }
+
+    // Mutable so that const lookups can take the shard locks
+    mutable std::array<Shard, kShardCount> shards_;
+};
+
+#endif  // VK_LAYER_CONCURRENT_MAP_H
@@ -20,10 +20,140 @@
 #ifndef LAYER_DATA_H
 #define LAYER_DATA_H
 
+#include <atomic>
 #include <cassert>
+#include <cstdint>
+#include <mutex>
 #include <unordered_map>
 #include "vk_layer_table.h"
 
+// Dispatch key -> layer data registry.  Every intercepted call starts with a lookup here, from whatever thread the
+// application makes it on, so find() takes no lock: the entries live in a fixed table of atomic (key, value) slots that
+// is searched by linear probing, which for the handful of live instances and devices is a couple of loads.
+//
+// Inserts and erases only happen at instance/device creation and destruction and are serialized by write_lock_.  An
+// erased slot keeps a tombstone key so that probe sequences running through it stay intact, and is reused by the next
+// insert that passes over it.  If the table ever fills up, further entries spill into an ordinary map behind the same
+// lock; readers only look there once the overflow flag is set.
+template <typename DATA_T>
+class vl_layer_data_map {
+   public:
+    vl_layer_data_map() : overflowed_(false) {
+        for (auto &slot : slots_) {
+            slot.key.store(nullptr, std::memory_order_relaxed);
+            slot.value.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+    vl_layer_data_map(const vl_layer_data_map &) = delete;
+    vl_layer_data_map &operator=(const vl_layer_data_map &) = delete;
+
+    // Return the data registered for key, or nullptr if there is none
+    DATA_T *find(void *key) const {
+        size_t index = HashIndex(key);
+        for (size_t probe = 0; probe < kCapacity; ++probe, index = (index + 1) & (kCapacity - 1)) {
+            void *slot_key = slots_[index].key.load(std::memory_order_acquire);
+            if (slot_key == key) return slots_[index].value.load(std::memory_order_acquire);
+            if (slot_key == nullptr) break;
+        }
+        if (!overflowed_.load(std::memory_order_acquire)) return nullptr;
+        std::lock_guard<std::mutex> lock(write_lock_);
+        auto it = overflow_.find(key);
+        return (it == overflow_.end()) ? nullptr : it->second;
+    }
+
+    // Return the data registered for key, allocating and registering a new DATA_T if there is none
+    DATA_T *get_or_create(void *key) {
+        DATA_T *data = find(key);
+        if (data) return data;
+
+        std::lock_guard<std::mutex> lock(write_lock_);
+        // Another thread may have registered key between the lookup above and taking the lock
+        Slot *free_slot = nullptr;
+        size_t index = HashIndex(key);
+        for (size_t probe = 0; probe < kCapacity; ++probe, index = (index + 1) & (kCapacity - 1)) {
+            void *slot_key = slots_[index].key.load(std::memory_order_relaxed);
+            if (slot_key == key) return slots_[index].value.load(std::memory_order_relaxed);
+            if (slot_key == Tombstone()) {
+                if (!free_slot) free_slot = &slots_[index];
+            } else if (slot_key == nullptr) {
+                if (!free_slot) free_slot = &slots_[index];
+                break;
+            }
+        }
+        auto it = overflow_.find(key);
+        if (it != overflow_.end()) return it->second;
+
+        data = new DATA_T;
+        if (free_slot) {
+            // Publish the value before the key so that a reader that sees the key also sees the value
+            free_slot->value.store(data, std::memory_order_release);
+            free_slot->key.store(key, std::memory_order_release);
+        } else {
+            overflow_[key] = data;
+            overflowed_.store(true, std::memory_order_release);
+        }
+        return data;
+    }
+
+    // Unregister key and return the data it mapped to (nullptr if there was none); the caller owns the result
+    DATA_T *erase(void *key) {
+        std::lock_guard<std::mutex> lock(write_lock_);
+        size_t index = HashIndex(key);
+        for (size_t probe = 0; probe < kCapacity; ++probe, index = (index + 1) & (kCapacity - 1)) {
+            void *slot_key = slots_[index].key.load(std::memory_order_relaxed);
+            if (slot_key == key) {
+                DATA_T *data = slots_[index].value.load(std::memory_order_relaxed);
+                slots_[index].key.store(Tombstone(), std::memory_order_release);
+                slots_[index].value.store(nullptr, std::memory_order_relaxed);
+                return data;
+            }
+            if (slot_key == nullptr) break;
+        }
+        auto it = overflow_.find(key);
+        if (it == overflow_.end()) return nullptr;
+        DATA_T *data = it->second;
+        overflow_.erase(it);
+        return data;
+    }
+
+    // Call func(key, data) for every registered entry.  Registration and removal are blocked for the duration, so func
+    // must not create or free layer data itself.
+    template <typename FUNC>
+    void for_each(FUNC func) const {
+        std::lock_guard<std::mutex> lock(write_lock_);
+        for (auto &slot : slots_) {
+            void *slot_key = slot.key.load(std::memory_order_relaxed);
+            if (slot_key != nullptr && slot_key != Tombstone()) func(slot_key, slot.value.load(std::memory_order_relaxed));
+        }
+        for (auto &entry : overflow_) func(entry.first, entry.second);
+    }
+
+   private:
+    // Power of two, comfortably above the number of instances and devices an application keeps alive at once
+    static const int kCapacityLog2 = 8;
+    static const size_t kCapacity = size_t(1) << kCapacityLog2;
+
+    struct Slot {
+        std::atomic<void *> key;
+        std::atomic<DATA_T *> value;
+    };
+
+    // Dispatch keys are pointers, so never collide with the all-ones pattern
+    static void *Tombstone() { return reinterpret_cast<void *>(~uintptr_t(0)); }
+
+    // Dispatch keys point at loader-allocated tables with constant low bits; take the index from the high bits of a
+    // multiplicative hash
+    static size_t HashIndex(void *key) {
+        const uint64_t hash = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(hash >> (64 - kCapacityLog2));
+    }
+
+    Slot slots_[kCapacity];
+    std::atomic<bool> overflowed_;
+    std::unordered_map<void *, DATA_T *> overflow_;
+    mutable std::mutex write_lock_;
+};
+
 // For the given data key, look up the layer_data instance from given layer_data_map
 template <typename DATA_T>
 DATA_T *GetLayerDataPtr(void *data_key, std::unordered_map<void *, DATA_T *> &layer_data_map) {
@@ -43,6 +173,11 @@ DATA_T *GetLayerDataPtr(void *data_key, std::unordered_map<void *, DATA_T *> &la
     return debug_data;
 }
 
+template <typename DATA_T>
+DATA_T *GetLayerDataPtr(void *data_key, vl_layer_data_map<DATA_T> &layer_data_map) {
+    return layer_data_map.get_or_create(data_key);
+}
+
 template <typename DATA_T>
 void FreeLayerDataPtr(void *data_key, std::unordered_map<void *, DATA_T *> &layer_data_map) {
     auto got = layer_data_map.find(data_key);
@@ -52,4 +187,11 @@ void FreeLayerDataPtr(void *data_key, std::unordered_map<void *, DATA_T *> &laye
     layer_data_map.erase(got);
 }
 
+template <typename DATA_T>
+void FreeLayerDataPtr(void *data_key, vl_layer_data_map<DATA_T> &layer_data_map) {
+    DATA_T *data = layer_data_map.erase(data_key);
+    assert(data);
+    delete data;
+}
+
 #endif  // LAYER_DATA_H
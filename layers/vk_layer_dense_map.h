@@ -0,0 +1,221 @@
+/* Copyright (c) 2015-2017 The Khronos Group Inc.
+ * Copyright (c) 2015-2017 Valve Corporation
+ * Copyright (c) 2015-2017 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VK_LAYER_DENSE_MAP_H
+#define VK_LAYER_DENSE_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+// Set/map containers for state that is rebuilt from scratch over and over, such as the per command buffer tracking in
+// GLOBAL_CB_NODE which is thrown away on every reset and re-record.
+//
+// Entries are stored contiguously in a vector (in insertion order until something is erased), and clear() keeps its
+// capacity, so once a command buffer has been recorded a few times recording it again allocates nothing.  Containers of
+// up to kLinearSearchMax entries are searched linearly and never build an index.  Larger ones are indexed by an
+// open-addressed table of (generation, entry index) slots; clear() just bumps the generation, which retires every slot
+// at once without touching the table.
+//
+// Iterators are plain pointers into the entry vector: any insert may invalidate them, and erase() moves the last entry
+// into the erased one's place.
+template <typename Key, typename Value, typename KeyOf, typename Hash>
+class vl_dense_table {
+   public:
+    typedef Key key_type;
+    typedef Value value_type;
+    typedef Value *iterator;
+    typedef const Value *const_iterator;
+
+    vl_dense_table() : generation_(1), shift_(64), indexed_(false) {}
+
+    iterator begin() { return entries_.data(); }
+    iterator end() { return entries_.data() + entries_.size(); }
+    const_iterator begin() const { return entries_.data(); }
+    const_iterator end() const { return entries_.data() + entries_.size(); }
+
+    size_t size() const { return entries_.size(); }
+    bool empty() const { return entries_.empty(); }
+
+    iterator find(const Key &key) {
+        size_t entry = FindEntry(key);
+        return (entry == kNotFound) ? end() : begin() + entry;
+    }
+    const_iterator find(const Key &key) const {
+        size_t entry = FindEntry(key);
+        return (entry == kNotFound) ? end() : begin() + entry;
+    }
+    size_t count(const Key &key) const { return FindEntry(key) == kNotFound ? 0 : 1; }
+
+    std::pair<iterator, bool> insert(const Value &value) {
+        size_t entry = FindEntry(KeyOf()(value));
+        if (entry != kNotFound) return std::make_pair(begin() + entry, false);
+        entries_.push_back(value);
+        AddToIndex(entries_.size() - 1);
+        return std::make_pair(end() - 1, true);
+    }
+
+    size_t erase(const Key &key) {
+        if (!indexed_) {
+            size_t entry = FindEntry(key);
+            if (entry == kNotFound) return 0;
+            RemoveEntry(entry);
+            return 1;
+        }
+        size_t slot = FindSlot(key);
+        if (slot == kNotFound) return 0;
+        size_t entry = slots_[slot].entry;
+        RemoveSlot(slot);
+        const size_t last = entries_.size() - 1;
+        if (entry != last) {
+            // The last entry moves into the hole, so repoint its slot
+            slots_[FindSlot(KeyOf()(entries_[last]))].entry = static_cast<uint32_t>(entry);
+        }
+        RemoveEntry(entry);
+        return 1;
+    }
+
+    // Forget every entry, keeping both the entry storage and the index table for reuse
+    void clear() {
+        entries_.clear();
+        indexed_ = false;
+    }
+
+   private:
+    static const size_t kLinearSearchMax = 8;
+    static const size_t kNotFound = ~size_t(0);
+
+    struct Slot {
+        uint32_t generation;  // The slot is occupied only while this matches generation_
+        uint32_t entry;
+    };
+
+    size_t HomeSlot(const Key &key) const {
+        // Handles and pointers have constant low bits, so take the index from the top bits of a multiplicative hash
+        const uint64_t hash = static_cast<uint64_t>(Hash()(key)) * 0x9E3779B97F4A7C15ull;
+        return static_cast<size_t>(hash >> shift_);
+    }
+
+    size_t FindSlot(const Key &key) const {
+        const size_t mask = slots_.size() - 1;
+        for (size_t slot = HomeSlot(key); slots_[slot].generation == generation_; slot = (slot + 1) & mask) {
+            if (KeyOf()(entries_[slots_[slot].entry]) == key) return slot;
+        }
+        return kNotFound;
+    }
+
+    size_t FindEntry(const Key &key) const {
+        if (indexed_) {
+            size_t slot = FindSlot(key);
+            return (slot == kNotFound) ? kNotFound : slots_[slot].entry;
+        }
+        for (size_t entry = 0; entry < entries_.size(); ++entry) {
+            if (KeyOf()(entries_[entry]) == key) return entry;
+        }
+        return kNotFound;
+    }
+
+    void InsertSlot(size_t entry) {
+        const size_t mask = slots_.size() - 1;
+        size_t slot = HomeSlot(KeyOf()(entries_[entry]));
+        while (slots_[slot].generation == generation_) slot = (slot + 1) & mask;
+        slots_[slot].generation = generation_;
+        slots_[slot].entry = static_cast<uint32_t>(entry);
+    }
+
+    void AddToIndex(size_t entry) {
+        if (indexed_ && entries_.size() * 2 <= slots_.size()) {
+            InsertSlot(entry);
+        } else if (indexed_ || entries_.size() > kLinearSearchMax) {
+            Reindex();
+        }
+    }
+
+    // Rebuild the index over all entries, growing the table if it would be more than half full
+    void Reindex() {
+        size_t slot_count = slots_.empty() ? 32 : slots_.size();
+        while (slot_count < entries_.size() * 2) slot_count *= 2;
+        if (slot_count != slots_.size()) {
+            slots_.assign(slot_count, Slot{0, 0});
+            generation_ = 1;
+            shift_ = 64;
+            for (size_t n = slot_count; n > 1; n >>= 1) --shift_;
+        } else if (++generation_ == 0) {
+            // Generation wrapped; the stale slots could alias it, so wipe them for real
+            slots_.assign(slot_count, Slot{0, 0});
+            generation_ = 1;
+        }
+        indexed_ = true;
+        for (size_t entry = 0; entry < entries_.size(); ++entry) InsertSlot(entry);
+    }
+
+    // Empty a slot with backward-shift deletion so that no probe sequence passes through a hole
+    void RemoveSlot(size_t hole) {
+        const size_t mask = slots_.size() - 1;
+        for (size_t slot = (hole + 1) & mask; slots_[slot].generation == generation_; slot = (slot + 1) & mask) {
+            size_t home = HomeSlot(KeyOf()(entries_[slots_[slot].entry]));
+            // Move the slot back into the hole unless its home lies cyclically in (hole, slot]
+            bool stays = (hole <= slot) ? (hole < home && home <= slot) : (hole < home || home <= slot);
+            if (!stays) {
+                slots_[hole] = slots_[slot];
+                hole = slot;
+            }
+        }
+        slots_[hole].generation = 0;
+    }
+
+    void RemoveEntry(size_t entry) {
+        if (entry != entries_.size() - 1) entries_[entry] = std::move(entries_.back());
+        entries_.pop_back();
+    }
+
+    std::vector<Value> entries_;
+    std::vector<Slot> slots_;
+    uint32_t generation_;
+    int shift_;
+    bool indexed_;
+};
+
+template <typename Key>
+struct vl_dense_set_key {
+    const Key &operator()(const Key &value) const { return value; }
+};
+
+template <typename Key, typename Mapped>
+struct vl_dense_map_key {
+    const Key &operator()(const std::pair<Key, Mapped> &value) const { return value.first; }
+};
+
+// Drop-in replacement for the subset of std::unordered_set that the per command buffer state uses
+template <typename Key, typename Hash = std::hash<Key>>
+class vl_dense_set : public vl_dense_table<Key, Key, vl_dense_set_key<Key>, Hash> {};
+
+// Drop-in replacement for the subset of std::unordered_map that the per command buffer state uses
+template <typename Key, typename Mapped, typename Hash = std::hash<Key>>
+class vl_dense_map : public vl_dense_table<Key, std::pair<Key, Mapped>, vl_dense_map_key<Key, Mapped>, Hash> {
+   public:
+    Mapped &operator[](const Key &key) {
+        auto it = this->find(key);
+        if (it == this->end()) it = this->insert(std::make_pair(key, Mapped())).first;
+        return it->second;
+    }
+};
+
+#endif  // VK_LAYER_DENSE_MAP_H
@@ -0,0 +1,210 @@
+/* Copyright (c) 2015-2017 The Khronos Group Inc.
+ * Copyright (c) 2015-2017 Valve Corporation
+ * Copyright (c) 2015-2017 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VK_LAYER_HANDLE_TABLE_H
+#define VK_LAYER_HANDLE_TABLE_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// Map from sequentially allocated 64-bit IDs to 64-bit values, for layers that hand the application their own IDs in place
+// of the driver's handles.  IDs index a three-level radix table directly, so find() is a handful of atomic loads and never
+// waits or locks; insert() is lock-free apart from taking a page the first time an ID in it is handed out, and erase()
+// takes one of a set of striped locks.
+//
+// IDs are never reused.  Instead each page counts the IDs that it has yet to see erased, and once every ID in it has been
+// handed out and erased the page is retired and kept for reuse by a later page, so memory follows the peak number of pages
+// holding live IDs rather than the number of IDs ever created.  Pages are never freed while the table lives, so a find() or
+// erase() of a stale ID that races with its page being retired still reads valid memory: find() checks the page's tag after
+// reading and returns 0 if the page has moved on, and erase() holds the lock for the ID's page, under which pages are
+// retired, so it cannot clear an entry that a recycled page has since handed to another ID.  A value of 0 reads as "no
+// entry", so an ID inserted with value 0 keeps its page alive for good.
+//
+// The table covers the first 2^40 IDs; any beyond that fall back to a locked hash map.
+class vl_handle_table {
+   public:
+    static const uint64_t kPageSize = uint64_t(1) << 12;
+    static const uint64_t kIdLimit = uint64_t(1) << 40;
+
+    // first_id lets tests start near a page boundary or the end of the table
+    explicit vl_handle_table(uint64_t first_id = 1) : first_id_(first_id), next_id_(first_id), roots_() {}
+    vl_handle_table(const vl_handle_table &) = delete;
+    vl_handle_table &operator=(const vl_handle_table &) = delete;
+    ~vl_handle_table() {
+        for (auto &root : roots_) {
+            Mid *mid = root.load(std::memory_order_relaxed);
+            if (!mid) continue;
+            for (auto &leaf : mid->leaves) delete leaf.load(std::memory_order_relaxed);
+            delete mid;
+        }
+        for (auto leaf : free_leaves_) delete leaf;
+    }
+
+    // Allocate a new ID that maps to value and return it
+    uint64_t insert(uint64_t value) {
+        const uint64_t id = next_id_.fetch_add(1, std::memory_order_relaxed);
+        if (id >= kIdLimit) {
+            std::lock_guard<std::mutex> lock(overflow_lock_);
+            overflow_[id] = value;
+        } else {
+            GetOrCreateLeaf(id)->values[id & kLeafMask].store(value, std::memory_order_release);
+        }
+        return id;
+    }
+
+    // Return the value id maps to, or 0 if there is none
+    uint64_t find(uint64_t id) const {
+        if (id >= kIdLimit) {
+            std::lock_guard<std::mutex> lock(overflow_lock_);
+            auto it = overflow_.find(id);
+            return (it == overflow_.end()) ? 0 : it->second;
+        }
+        Leaf *leaf = FindLeaf(id);
+        if (!leaf) return 0;
+        const uint64_t value = leaf->values[id & kLeafMask].load(std::memory_order_acquire);
+        // If the page was retired and reused after FindLeaf, value may belong to another ID.  Any value stored for the new
+        // page was stored after the page was retagged, and the acquire above makes that retagging visible here.
+        return (leaf->page.load(std::memory_order_relaxed) == PageOf(id)) ? value : 0;
+    }
+
+    bool contains(uint64_t id) const { return find(id) != 0; }
+
+    // Remove id from the table, returning the value it mapped to or 0 if there was none
+    uint64_t erase(uint64_t id) {
+        if (id >= kIdLimit) {
+            std::lock_guard<std::mutex> lock(overflow_lock_);
+            auto it = overflow_.find(id);
+            if (it == overflow_.end()) return 0;
+            const uint64_t value = it->second;
+            overflow_.erase(it);
+            return value;
+        }
+        // Pages are only retired under their lock, so the leaf found here stays this page's until the lock is dropped
+        std::lock_guard<std::mutex> lock(page_locks_[PageOf(id) % kPageLockCount]);
+        Leaf *leaf = FindLeaf(id);
+        if (!leaf) return 0;
+        // Only the thread that actually clears the entry counts it, so a repeated erase cannot retire the page early
+        const uint64_t value = leaf->values[id & kLeafMask].exchange(0, std::memory_order_acq_rel);
+        if (value && leaf->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) RetireLeaf(id, leaf);
+        return value;
+    }
+
+   private:
+    static const int kLeafBits = 12;
+    static const int kMidBits = 14;
+    static const int kRootBits = 14;
+    static const uint64_t kLeafSize = uint64_t(1) << kLeafBits;
+    static const uint64_t kMidSize = uint64_t(1) << kMidBits;
+    static const uint64_t kRootSize = uint64_t(1) << kRootBits;
+    static const uint64_t kLeafMask = kLeafSize - 1;
+    static const uint64_t kMidMask = kMidSize - 1;
+    static const uint64_t kNoPage = ~uint64_t(0);
+    static const size_t kPageLockCount = 64;
+
+    struct Leaf {
+        std::atomic<uint64_t> values[kLeafSize];
+        std::atomic<uint64_t> page;       // Page this leaf currently serves, or kNoPage while it is waiting for reuse
+        std::atomic<uint32_t> remaining;  // IDs on this page not yet erased, including those not yet handed out
+    };
+    // Mids cover 2^26 IDs each and are only freed with the table
+    struct Mid {
+        std::atomic<Leaf *> leaves[kMidSize];
+    };
+
+    static uint64_t PageOf(uint64_t id) { return id >> kLeafBits; }
+    static size_t RootIndex(uint64_t id) { return static_cast<size_t>(id >> (kLeafBits + kMidBits)); }
+    static size_t MidIndex(uint64_t id) { return static_cast<size_t>((id >> kLeafBits) & kMidMask); }
+
+    Leaf *FindLeaf(uint64_t id) const {
+        Mid *mid = roots_[RootIndex(id)].load(std::memory_order_acquire);
+        return mid ? mid->leaves[MidIndex(id)].load(std::memory_order_acquire) : nullptr;
+    }
+
+    // A retired leaf if there is one, else a new one; its values are all 0 either way
+    Leaf *TakeLeaf(uint64_t page) {
+        Leaf *leaf = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(free_lock_);
+            if (!free_leaves_.empty()) {
+                leaf = free_leaves_.back();
+                free_leaves_.pop_back();
+            }
+        }
+        if (!leaf) leaf = new Leaf();
+        // Fewer IDs to wait for on the page holding the first ID, as none below it are ever handed out
+        const uint64_t page_start = page << kLeafBits;
+        const uint64_t skipped = (first_id_ > page_start) ? first_id_ - page_start : 0;
+        leaf->remaining.store(static_cast<uint32_t>(kLeafSize - skipped), std::memory_order_relaxed);
+        leaf->page.store(page, std::memory_order_relaxed);
+        return leaf;
+    }
+
+    void ReturnLeaf(Leaf *leaf) {
+        leaf->page.store(kNoPage, std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(free_lock_);
+        free_leaves_.push_back(leaf);
+    }
+
+    Leaf *GetOrCreateLeaf(uint64_t id) {
+        std::atomic<Mid *> &root = roots_[RootIndex(id)];
+        Mid *mid = root.load(std::memory_order_acquire);
+        if (!mid) {
+            Mid *fresh = new Mid();
+            Mid *current = nullptr;
+            if (root.compare_exchange_strong(current, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                mid = fresh;
+            } else {
+                delete fresh;
+                mid = current;
+            }
+        }
+        std::atomic<Leaf *> &slot = mid->leaves[MidIndex(id)];
+        Leaf *leaf = slot.load(std::memory_order_acquire);
+        if (!leaf) {
+            Leaf *fresh = TakeLeaf(PageOf(id));
+            // The release half publishes the new tag, so finds that reach the leaf through this page see it
+            if (slot.compare_exchange_strong(leaf, fresh, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                leaf = fresh;
+            } else {
+                ReturnLeaf(fresh);
+            }
+        }
+        return leaf;
+    }
+
+    // Every ID on id's page has been handed out and erased, so no new lookup can reach the page; ones already past
+    // FindLeaf see its tag change.  Called with the page's lock held.
+    void RetireLeaf(uint64_t id, Leaf *leaf) {
+        roots_[RootIndex(id)].load(std::memory_order_acquire)->leaves[MidIndex(id)].store(nullptr, std::memory_order_release);
+        ReturnLeaf(leaf);
+    }
+
+    const uint64_t first_id_;
+    std::atomic<uint64_t> next_id_;
+    std::atomic<Mid *> roots_[kRootSize];
+    std::mutex page_locks_[kPageLockCount];
+    std::mutex free_lock_;
+    std::vector<Leaf *> free_leaves_;
+    mutable std::mutex overflow_lock_;
+    std::unordered_map<uint64_t, uint64_t> overflow_;
+};
+
+#endif  // VK_LAYER_HANDLE_TABLE_H
@@ -0,0 +1,184 @@
+/* Copyright (c) 2015-2017 The Khronos Group Inc.
+ * Copyright (c) 2015-2017 Valve Corporation
+ * Copyright (c) 2015-2017 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VK_LAYER_INTERVAL_TREE_H
+#define VK_LAYER_INTERVAL_TREE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+// Set of possibly overlapping closed intervals [first, last], each tagged with a value, that can report every interval
+// overlapping a query in O(log n + k).  Used to find the resources bound to a memory allocation that a new binding or a
+// mapped/flushed region touches without walking every binding.
+//
+// The intervals are kept in a treap ordered by (first, value) in which every node also records the largest last in its
+// subtree, so a search can skip any subtree that ends before the query starts.  An interval is identified by its first and
+// its value, so (first, value) pairs must be unique; values are compared with std::less.  Nodes live in one vector and are
+// linked by index, and erased nodes are recycled, so a tree that is filled and emptied repeatedly stops allocating.
+template <typename Key, typename T>
+class vl_interval_tree {
+   public:
+    vl_interval_tree() : root_(kNull), free_list_(kNull), size_(0), seed_(0x2545F491u) {}
+
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    void clear() {
+        nodes_.clear();
+        root_ = kNull;
+        free_list_ = kNull;
+        size_ = 0;
+    }
+
+    void insert(Key first, Key last, const T &value) {
+        const uint32_t node = NewNode(first, last, value);
+        uint32_t left, right;
+        Split(root_, first, value, &left, &right);
+        root_ = Merge(Merge(left, node), right);
+        ++size_;
+    }
+
+    // Remove the interval that starts at first and holds value; returns whether there was one
+    bool erase(Key first, const T &value) {
+        bool found = false;
+        root_ = Erase(root_, first, value, &found);
+        if (found) --size_;
+        return found;
+    }
+
+    // Call func(first, last, value) for every interval that overlaps [first, last], in order of first.  func must not
+    // modify the tree.
+    template <typename F>
+    void for_each_overlapping(Key first, Key last, F func) const {
+        Visit(root_, first, last, func);
+    }
+
+   private:
+    static const uint32_t kNull = ~0u;
+
+    struct node {
+        Key first;
+        Key last;
+        Key max_last;  // Largest last in this subtree
+        T value;
+        uint32_t priority;
+        uint32_t left;
+        uint32_t right;  // Next free node while on the free list
+    };
+
+    uint32_t NewNode(Key first, Key last, const T &value) {
+        // xorshift32; the priorities only need to look random to keep the tree balanced
+        seed_ ^= seed_ << 13;
+        seed_ ^= seed_ >> 17;
+        seed_ ^= seed_ << 5;
+        const node fresh = {first, last, last, value, seed_, kNull, kNull};
+        uint32_t index = free_list_;
+        if (index != kNull) {
+            free_list_ = nodes_[index].right;
+            nodes_[index] = fresh;
+        } else {
+            index = static_cast<uint32_t>(nodes_.size());
+            nodes_.push_back(fresh);
+        }
+        return index;
+    }
+
+    bool Less(Key first_a, const T &value_a, Key first_b, const T &value_b) const {
+        return first_a < first_b || (!(first_b < first_a) && std::less<T>()(value_a, value_b));
+    }
+
+    void Update(uint32_t t) {
+        node &n = nodes_[t];
+        n.max_last = n.last;
+        if (n.left != kNull && n.max_last < nodes_[n.left].max_last) n.max_last = nodes_[n.left].max_last;
+        if (n.right != kNull && n.max_last < nodes_[n.right].max_last) n.max_last = nodes_[n.right].max_last;
+    }
+
+    // Split t into the nodes ordered before (first, value) and the rest
+    void Split(uint32_t t, Key first, const T &value, uint32_t *left, uint32_t *right) {
+        if (t == kNull) {
+            *left = *right = kNull;
+        } else if (Less(nodes_[t].first, nodes_[t].value, first, value)) {
+            uint32_t split_left;
+            Split(nodes_[t].right, first, value, &split_left, right);
+            nodes_[t].right = split_left;
+            Update(t);
+            *left = t;
+        } else {
+            uint32_t split_right;
+            Split(nodes_[t].left, first, value, left, &split_right);
+            nodes_[t].left = split_right;
+            Update(t);
+            *right = t;
+        }
+    }
+
+    // Join two trees where every node of left is ordered before every node of right
+    uint32_t Merge(uint32_t left, uint32_t right) {
+        if (left == kNull) return right;
+        if (right == kNull) return left;
+        if (nodes_[left].priority > nodes_[right].priority) {
+            nodes_[left].right = Merge(nodes_[left].right, right);
+            Update(left);
+            return left;
+        }
+        nodes_[right].left = Merge(left, nodes_[right].left);
+        Update(right);
+        return right;
+    }
+
+    uint32_t Erase(uint32_t t, Key first, const T &value, bool *found) {
+        if (t == kNull) return kNull;
+        node &n = nodes_[t];
+        if (Less(first, value, n.first, n.value)) {
+            n.left = Erase(n.left, first, value, found);
+        } else if (Less(n.first, n.value, first, value)) {
+            n.right = Erase(n.right, first, value, found);
+        } else {
+            *found = true;
+            const uint32_t joined = Merge(n.left, n.right);
+            nodes_[t].right = free_list_;
+            free_list_ = t;
+            return joined;
+        }
+        Update(t);
+        return t;
+    }
+
+    template <typename F>
+    void Visit(uint32_t t, Key first, Key last, F &func) const {
+        // Nothing in this subtree ends at or after first
+        if (t == kNull || nodes_[t].max_last < first) return;
+        const node &n = nodes_[t];
+        Visit(n.left, first, last, func);
+        // This node and everything to its right start after last
+        if (last < n.first) return;
+        if (!(n.last < first)) func(n.first, n.last, n.value);
+        Visit(n.right, first, last, func);
+    }
+
+    std::vector<node> nodes_;
+    uint32_t root_;
+    uint32_t free_list_;
+    size_t size_;
+    uint32_t seed_;
+};
+
+#endif  // VK_LAYER_INTERVAL_TREE_H
@@ -27,21 +27,38 @@
 #include "vk_layer_data.h"
 #include "vk_layer_table.h"
 #include "vk_loader_platform.h"
+#include "vk_layer_mpsc_ring.h"
 #include "vulkan/vk_layer.h"
 #include <signal.h>
+#include <atomic>
 #include <cinttypes>
+#include <condition_variable>
+#include <list>
+#include <mutex>
 #include <stdarg.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <new>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+class debug_report_async_logger;
+class debug_report_duplicate_filter;
+
 typedef struct _debug_report_data {
     VkLayerDbgFunctionNode *debug_callback_list;
     VkLayerDbgFunctionNode *default_debug_callback_list;
     VkFlags active_flags;
     bool g_DEBUG_REPORT;
     std::unordered_map<uint64_t, std::string> *debugObjectNameMap;
+    // Messages that passed active_flags, so that a caller can tell whether a check it ran reported anything
+    mutable std::atomic<uint64_t> message_count;
+    // Set when messages are delivered on a logger thread instead of the thread that logs them
+    debug_report_async_logger *async_logger;
+    // Set when log_msg drops repeats of a message before formatting them
+    debug_report_duplicate_filter *duplicate_filter;
 } debug_report_data;
 
 template debug_report_data *GetLayerDataPtr<debug_report_data>(void *data_key,
@@ -51,6 +68,134 @@ template debug_report_data *GetLayerDataPtr<debug_report_data>(void *data_key,
 static inline bool debug_report_log_msg(const debug_report_data *debug_data, VkFlags msgFlags,
                                         VkDebugReportObjectTypeEXT objectType, uint64_t srcObject, size_t location, int32_t msgCode,
                                         const char *pLayerPrefix, const char *pMsg);
+static inline bool debug_report_dispatch_msg(const debug_report_data *debug_data, VkFlags msgFlags,
+                                             VkDebugReportObjectTypeEXT objectType, uint64_t srcObject, size_t location,
+                                             int32_t msgCode, const char *pLayerPrefix, const char *pMsg);
+
+// A message held for delivery later
+struct debug_report_message {
+    VkFlags flags;
+    VkDebugReportObjectTypeEXT object_type;
+    uint64_t object;
+    size_t location;
+    int32_t code;
+    std::string layer_prefix;
+    std::string text;
+};
+
+// Delivers the messages logged through one debug_report_data on a thread of its own, so that logging costs the calling
+// thread a push into a lock-free ring rather than a trip through every callback.  The logger thread takes messages off in
+// batches and flushes the log files once per batch instead of once per message.  Messages that find the ring full are
+// dropped, and the next batch says how many were.  Callbacks run on the logger thread after the API call that logged the
+// message has usually returned, so a callback returning VK_TRUE no longer makes that call fail.
+class debug_report_async_logger {
+   public:
+    debug_report_async_logger(const debug_report_data *debug_data, size_t capacity)
+        : debug_data_(debug_data), ring_(capacity), pushed_(0), dropped_(0), sleeping_(false), delivered_(0), stop_(false) {
+        thread_ = std::thread(&debug_report_async_logger::LoggerMain, this);
+    }
+    debug_report_async_logger(const debug_report_async_logger &) = delete;
+    debug_report_async_logger &operator=(const debug_report_async_logger &) = delete;
+    // Delivers everything still queued before returning
+    ~debug_report_async_logger() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        wake_cv_.notify_one();
+        thread_.join();
+    }
+
+    void push(debug_report_message &&message) {
+        if (!ring_.try_push(std::move(message))) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        pushed_.fetch_add(1);
+        if (sleeping_.load()) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wake_cv_.notify_one();
+        }
+    }
+
+    // Wait until every message pushed before the call has reached the callbacks
+    void flush() {
+        const uint64_t target = pushed_.load();
+        std::unique_lock<std::mutex> lock(mutex_);
+        wake_cv_.notify_one();
+        done_cv_.wait(lock, [this, target]() { return delivered_ >= target; });
+    }
+
+    // Held while the logger thread calls callbacks.  Flush, then hold it, to change the callback lists.
+    std::mutex &delivery_lock() { return delivery_lock_; }
+
+    // Flush file after each batch, for a callback that writes to it without flushing
+    void add_log_file(FILE *file) {
+        std::lock_guard<std::mutex> lock(delivery_lock_);
+        log_files_.push_back(file);
+    }
+
+   private:
+    static const size_t kBatchSize = 256;
+
+    void LoggerMain() {
+        std::vector<debug_report_message> batch;
+        batch.reserve(kBatchSize);
+        debug_report_message message;
+        uint64_t popped = 0;
+        while (true) {
+            while (batch.size() < kBatchSize && ring_.try_pop(message)) batch.push_back(std::move(message));
+            popped += batch.size();
+            const uint64_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+            if (batch.empty() && !dropped) {
+                std::unique_lock<std::mutex> lock(mutex_);
+                // A push counts itself before it looks at sleeping_, and this looks at the count after setting sleeping_, so
+                // either the push sees sleeping_ and notifies under mutex_ or the wait below sees the pushed message
+                sleeping_.store(true);
+                wake_cv_.wait(lock, [this, popped]() { return stop_ || pushed_.load() != popped; });
+                sleeping_.store(false);
+                if (stop_ && pushed_.load() == popped) return;
+                continue;
+            }
+            Deliver(batch, dropped);
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                delivered_ += batch.size();
+            }
+            done_cv_.notify_all();
+            batch.clear();
+        }
+    }
+
+    void Deliver(const std::vector<debug_report_message> &batch, uint64_t dropped) {
+        std::lock_guard<std::mutex> lock(delivery_lock_);
+        for (const auto &message : batch) {
+            debug_report_dispatch_msg(debug_data_, message.flags, message.object_type, message.object, message.location,
+                                      message.code, message.layer_prefix.c_str(), message.text.c_str());
+        }
+        if (dropped) {
+            const std::string text = std::to_string(dropped) + " messages were dropped because the debug report queue of " +
+                                     std::to_string(ring_.capacity()) + " messages was full.";
+            debug_report_dispatch_msg(debug_data_, VK_DEBUG_REPORT_WARNING_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0,
+                                      0, 0, "DebugReport", text.c_str());
+        }
+        for (FILE *file : log_files_) fflush(file);
+    }
+
+    const debug_report_data *debug_data_;
+    vl_mpsc_ring<debug_report_message> ring_;
+    std::atomic<uint64_t> pushed_;
+    std::atomic<uint64_t> dropped_;  // Since the last batch
+    std::atomic<bool> sleeping_;     // Set while the logger thread may be waiting for a push
+    std::mutex mutex_;               // Guards the fields below other than the atomics
+    std::condition_variable wake_cv_;
+    std::condition_variable done_cv_;
+    uint64_t delivered_;
+    bool stop_;
+    std::mutex delivery_lock_;
+    std::vector<FILE *> log_files_;  // Guarded by delivery_lock_
+    std::thread thread_;
+};
 
 // Add a debug message callback node structure to the specified callback linked list
 static inline void AddDebugMessageCallback(debug_report_data *debug_data, VkLayerDbgFunctionNode **list_head,
@@ -110,6 +255,27 @@ static inline void RemoveAllMessageCallbacks(debug_report_data *debug_data, VkLa
 static inline bool debug_report_log_msg(const debug_report_data *debug_data, VkFlags msgFlags,
                                         VkDebugReportObjectTypeEXT objectType, uint64_t srcObject, size_t location, int32_t msgCode,
                                         const char *pLayerPrefix, const char *pMsg) {
+    std::string newMsg;
+    auto it = debug_data->debugObjectNameMap->find(srcObject);
+    if (it != debug_data->debugObjectNameMap->end()) {
+        newMsg = "SrcObject name = ";
+        newMsg.append(it->second.c_str());
+        newMsg.append(" ");
+        newMsg.append(pMsg);
+        pMsg = newMsg.c_str();
+    }
+
+    if (debug_data->async_logger) {
+        debug_data->async_logger->push({msgFlags, objectType, srcObject, location, msgCode, pLayerPrefix, pMsg});
+        return false;
+    }
+    return debug_report_dispatch_msg(debug_data, msgFlags, objectType, srcObject, location, msgCode, pLayerPrefix, pMsg);
+}
+
+// Pass a message, object name and all, to each callback that wants it
+static inline bool debug_report_dispatch_msg(const debug_report_data *debug_data, VkFlags msgFlags,
+                                             VkDebugReportObjectTypeEXT objectType, uint64_t srcObject, size_t location,
+                                             int32_t msgCode, const char *pLayerPrefix, const char *pMsg) {
     bool bail = false;
     VkLayerDbgFunctionNode *pTrav = NULL;
 
@@ -121,21 +287,8 @@ static inline bool debug_report_log_msg(const debug_report_data *debug_data, VkF
 
     while (pTrav) {
         if (pTrav->msgFlags & msgFlags) {
-            auto it = debug_data->debugObjectNameMap->find(srcObject);
-            if (it == debug_data->debugObjectNameMap->end()) {
-                if (pTrav->pfnMsgCallback(msgFlags, objectType, srcObject, location, msgCode, pLayerPrefix, pMsg,
-                                          pTrav->pUserData)) {
-                    bail = true;
-                }
-            } else {
-                std::string newMsg = "SrcObject name = ";
-                newMsg.append(it->second.c_str());
-                newMsg.append(" ");
-                newMsg.append(pMsg);
-                if (pTrav->pfnMsgCallback(msgFlags, objectType, srcObject, location, msgCode, pLayerPrefix, newMsg.c_str(),
-                                          pTrav->pUserData)) {
-                    bail = true;
-                }
+            if (pTrav->pfnMsgCallback(msgFlags, objectType, srcObject, location, msgCode, pLayerPrefix, pMsg, pTrav->pUserData)) {
+                bail = true;
             }
         }
         pTrav = pTrav->pNext;
@@ -144,14 +297,141 @@ static inline bool debug_report_log_msg(const debug_report_data *debug_data, VkF
     return bail;
 }
 
+// Counts the occurrences of each message, told apart by message code, object and location, so that log_msg can drop
+// repeats before spending any time formatting them.  The first first_reports occurrences of a message are reported, then
+// every report_period-th one, which says how many were dropped since the one before.  A report_period of 0 reports no
+// more after the first ones.  A dropped message returns what its last reported occurrence did, so that a callback
+// asking to skip an API call keeps getting its way.
+//
+// Messages name objects that come and go, so only the max_messages messages seen most recently are counted.  Each shard
+// keeps its messages in least recently seen order and forgets the oldest to make room; a forgotten message is counted
+// afresh if it turns up again.
+class debug_report_duplicate_filter {
+   public:
+    debug_report_duplicate_filter(uint32_t first_reports, uint32_t report_period, size_t max_messages = 4096)
+        : first_reports_(first_reports), report_period_(report_period), shard_capacity_(max_messages / kShards + 1) {}
+
+    // Count an occurrence of a message.  Returns 0 if the occurrence is to be dropped, setting *bail to what the last
+    // reported occurrence returned, and otherwise 1 more than the number of duplicates dropped since the last one reported.
+    uint64_t count(int32_t code, uint64_t object, size_t location, bool *bail) {
+        const key message = {code, object, location};
+        shard &target = shards_[key_hash()(message) % kShards];
+        std::lock_guard<std::mutex> lock(target.lock);
+        counts &entry = target.Touch(message, shard_capacity_);
+        entry.occurrences++;
+        if (entry.occurrences <= first_reports_ || (report_period_ && (entry.occurrences - first_reports_) % report_period_ == 0)) {
+            const uint64_t suppressed = entry.suppressed + 1;
+            entry.suppressed = 0;
+            return suppressed;
+        }
+        entry.suppressed++;
+        *bail = entry.bail;
+        return 0;
+    }
+
+    // Record what the callbacks returned for a reported occurrence, for the duplicates dropped after it
+    void set_bail(int32_t code, uint64_t object, size_t location, bool bail) {
+        const key message = {code, object, location};
+        shard &target = shards_[key_hash()(message) % kShards];
+        std::lock_guard<std::mutex> lock(target.lock);
+        auto found = target.index.find(message);
+        if (found != target.index.end()) found->second->second.bail = bail;
+    }
+
+    // Report the duplicates dropped since their messages were last reported, naming the most repeated message
+    void log_summary(const debug_report_data *debug_data);
+
+   private:
+    static const size_t kShards = 16;
+
+    struct key {
+        int32_t code;
+        uint64_t object;
+        size_t location;
+        bool operator==(const key &other) const {
+            return code == other.code && object == other.object && location == other.location;
+        }
+    };
+    struct key_hash {
+        size_t operator()(const key &message) const {
+            return std::hash<uint64_t>()(message.object ^ (static_cast<uint64_t>(message.location) << 20) ^
+                                         static_cast<uint32_t>(message.code));
+        }
+    };
+    struct counts {
+        counts() : occurrences(0), suppressed(0), bail(false) {}
+        uint64_t occurrences;
+        uint64_t suppressed;  // Since the last report
+        bool bail;
+    };
+    typedef std::list<std::pair<key, counts>> recency_list;
+
+    struct shard {
+        shard() : forgotten_suppressed(0) {}
+        // Return the counts of a message, moved to the front of the list, first making room for it if it is new
+        counts &Touch(const key &message, size_t capacity) {
+            auto found = index.find(message);
+            if (found != index.end()) {
+                recent.splice(recent.begin(), recent, found->second);
+                return found->second->second;
+            }
+            if (index.size() >= capacity) {
+                forgotten_suppressed += recent.back().second.suppressed;
+                index.erase(recent.back().first);
+                recent.pop_back();
+            }
+            recent.emplace_front(message, counts());
+            index[message] = recent.begin();
+            return recent.front().second;
+        }
+
+        std::mutex lock;
+        recency_list recent;  // Most recently seen first
+        std::unordered_map<key, recency_list::iterator, key_hash> index;
+        uint64_t forgotten_suppressed;  // Dropped duplicates of messages no longer counted, for the summary
+    };
+
+    const uint64_t first_reports_;
+    const uint64_t report_period_;
+    const size_t shard_capacity_;
+    shard shards_[kShards];
+};
+
+inline void debug_report_duplicate_filter::log_summary(const debug_report_data *debug_data) {
+    uint64_t total = 0, most = 0;
+    key most_repeated = {};
+    for (auto &target : shards_) {
+        std::lock_guard<std::mutex> lock(target.lock);
+        total += target.forgotten_suppressed;
+        for (const auto &entry : target.recent) {
+            total += entry.second.suppressed;
+            if (entry.second.suppressed > most) {
+                most = entry.second.suppressed;
+                most_repeated = entry.first;
+            }
+        }
+    }
+    if (!total) return;
+    char text[256];
+    if (most) {
+        snprintf(text, sizeof(text),
+                 "%" PRIu64 " duplicate messages were suppressed since their last report. The most repeated, message code %d "
+                 "for object 0x%" PRIx64 " at location %" PRIu64 ", was suppressed %" PRIu64 " times.",
+                 total, most_repeated.code, most_repeated.object, static_cast<uint64_t>(most_repeated.location), most);
+    } else {
+        snprintf(text, sizeof(text), "%" PRIu64 " duplicate messages were suppressed since their last report.", total);
+    }
+    debug_report_log_msg(debug_data, VK_DEBUG_REPORT_WARNING_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, 0, 0, 0,
+                         "DebugReport", text);
+}
+
 static inline debug_report_data *debug_report_create_instance(
     VkLayerInstanceDispatchTable *table, VkInstance inst, uint32_t extension_count,
     const char *const *ppEnabledExtensions)  // layer or extension name to be enabled
 {
-    debug_report_data *debug_data = (debug_report_data *)malloc(sizeof(debug_report_data));
+    debug_report_data *debug_data = new (std::nothrow) debug_report_data();
     if (!debug_data) return NULL;
 
-    memset(debug_data, 0, sizeof(debug_report_data));
     for (uint32_t i = 0; i < extension_count; i++) {
         // TODO: Check other property fields
         if (strcmp(ppEnabledExtensions[i], VK_EXT_DEBUG_REPORT_EXTENSION_NAME) == 0) {
@@ -164,10 +444,18 @@ static inline debug_report_data *debug_report_create_instance(
 
 static inline void layer_debug_report_destroy_instance(debug_report_data *debug_data) {
     if (debug_data) {
+        if (debug_data->duplicate_filter) {
+            debug_data->duplicate_filter->log_summary(debug_data);
+            delete debug_data->duplicate_filter;
+            debug_data->duplicate_filter = nullptr;
+        }
+        // Deliver what is still queued, and have anything logged from here on delivered in place
+        delete debug_data->async_logger;
+        debug_data->async_logger = nullptr;
         RemoveAllMessageCallbacks(debug_data, &debug_data->default_debug_callback_list);
         RemoveAllMessageCallbacks(debug_data, &debug_data->debug_callback_list);
         delete debug_data->debugObjectNameMap;
-        free(debug_data);
+        delete debug_data;
     }
 }
 
@@ -177,12 +465,22 @@ static inline debug_report_data *layer_debug_report_create_device(debug_report_d
     return instance_debug_data;
 }
 
-static inline void layer_debug_report_destroy_device(VkDevice device) {
-    // Nothing to do since we're using instance data record
+static inline void layer_debug_report_destroy_device(debug_report_data *debug_data, VkDevice device) {
+    // The instance's data record outlives the device, but the messages logged about the device are due by now
+    if (debug_data && debug_data->async_logger) debug_data->async_logger->flush();
+}
+
+// Hold off asynchronous delivery while a callback list changes, once the messages logged so far have gone to the callbacks
+// that were registered when they were logged
+static inline std::unique_lock<std::mutex> debug_report_lock_callbacks(debug_report_data *debug_data) {
+    if (!debug_data->async_logger) return std::unique_lock<std::mutex>();
+    debug_data->async_logger->flush();
+    return std::unique_lock<std::mutex>(debug_data->async_logger->delivery_lock());
 }
 
 static inline void layer_destroy_msg_callback(debug_report_data *debug_data, VkDebugReportCallbackEXT callback,
                                               const VkAllocationCallbacks *pAllocator) {
+    auto lock = debug_report_lock_callbacks(debug_data);
     RemoveDebugMessageCallback(debug_data, &debug_data->debug_callback_list, callback);
     RemoveDebugMessageCallback(debug_data, &debug_data->default_debug_callback_list, callback);
 }
@@ -200,6 +498,7 @@ static inline VkResult layer_create_msg_callback(debug_report_data *debug_data,
     pNewDbgFuncNode->msgFlags = pCreateInfo->flags;
     pNewDbgFuncNode->pUserData = pCreateInfo->pUserData;
 
+    auto lock = debug_report_lock_callbacks(debug_data);
     if (default_callback) {
         AddDebugMessageCallback(debug_data, &debug_data->default_debug_callback_list, pNewDbgFuncNode);
         debug_data->active_flags |= pCreateInfo->flags;
@@ -207,6 +506,7 @@ static inline VkResult layer_create_msg_callback(debug_report_data *debug_data,
         AddDebugMessageCallback(debug_data, &debug_data->debug_callback_list, pNewDbgFuncNode);
         debug_data->active_flags = pCreateInfo->flags;
     }
+    lock = std::unique_lock<std::mutex>();
 
     debug_report_log_msg(debug_data, VK_DEBUG_REPORT_DEBUG_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_DEBUG_REPORT_EXT,
                          (uint64_t)*pCallback, 0, 0, "DebugReport", "Added callback");
@@ -369,6 +669,14 @@ static inline bool log_msg(const debug_report_data *debug_data, VkFlags msgFlags
         // Message is not wanted
         return false;
     }
+    debug_data->message_count.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t suppressed = 0;
+    if (debug_data->duplicate_filter) {
+        bool bail = false;
+        suppressed = debug_data->duplicate_filter->count(msgCode, srcObject, location, &bail);
+        if (!suppressed) return bail;
+    }
 
     va_list argptr;
     va_start(argptr, format);
@@ -378,21 +686,94 @@ static inline bool log_msg(const debug_report_data *debug_data, VkFlags msgFlags
         str = nullptr;
     }
     va_end(argptr);
-    bool result = debug_report_log_msg(debug_data, msgFlags, objectType, srcObject, location, msgCode, pLayerPrefix,
-                                       str ? str : "Allocation failure");
+    const char *text = str ? str : "Allocation failure";
+    std::string annotated;
+    if (suppressed > 1) {
+        annotated = text;
+        annotated.append(" [" + std::to_string(suppressed - 1) + " duplicates of this message were suppressed]");
+        text = annotated.c_str();
+    }
+    bool result = debug_report_log_msg(debug_data, msgFlags, objectType, srcObject, location, msgCode, pLayerPrefix, text);
     free(str);
+    if (debug_data->duplicate_filter) debug_data->duplicate_filter->set_bail(msgCode, srcObject, location, result);
     return result;
 }
 
-static inline VKAPI_ATTR VkBool32 VKAPI_CALL log_callback(VkFlags msgFlags, VkDebugReportObjectTypeEXT objType, uint64_t srcObject,
-                                                          size_t location, int32_t msgCode, const char *pLayerPrefix,
-                                                          const char *pMsg, void *pUserData) {
+// Stand-in report data that records the messages logged through it instead of delivering them, so that validation run on
+// a worker thread can hand its output back to the thread that made the API call.  replay() then passes the messages to the
+// real callbacks, in the order they were logged.  While capturing, log_msg always returns false, as whether a callback
+// asks to bail is only known once the message is replayed.
+class debug_report_capture {
+   public:
+    explicit debug_report_capture(const debug_report_data *target) : target_(target), capture_data_() {
+        capture_node_.msgCallback = VK_NULL_HANDLE;
+        capture_node_.pfnMsgCallback = Capture;
+        capture_node_.msgFlags = target->active_flags;
+        capture_node_.pUserData = this;
+        capture_node_.pNext = nullptr;
+        capture_data_.debug_callback_list = &capture_node_;
+        capture_data_.default_debug_callback_list = nullptr;
+        capture_data_.active_flags = target->active_flags;
+        capture_data_.g_DEBUG_REPORT = target->g_DEBUG_REPORT;
+        // Repeats are counted against the target's, and dropped before they are captured
+        capture_data_.duplicate_filter = target->duplicate_filter;
+        // Object names are looked up when the messages are replayed
+        capture_data_.debugObjectNameMap = &no_names_;
+    }
+    debug_report_capture(const debug_report_capture &) = delete;
+    debug_report_capture &operator=(const debug_report_capture &) = delete;
+
+    const debug_report_data *report_data() const { return &capture_data_; }
+
+    // Deliver the captured messages to the target's callbacks and forget them.  Returns true if any callback asked to bail.
+    bool replay() { return replay(target_); }
+
+    // As replay(), but to other report data of the same device, such as another capture's
+    bool replay(const debug_report_data *target) {
+        bool bail = false;
+        for (const auto &message : messages_) {
+            bail |= debug_report_log_msg(target, message.flags, message.object_type, message.object, message.location,
+                                         message.code, message.layer_prefix.c_str(), message.text.c_str());
+        }
+        target->message_count.fetch_add(messages_.size(), std::memory_order_relaxed);
+        messages_.clear();
+        return bail;
+    }
+
+   private:
+    static VKAPI_ATTR VkBool32 VKAPI_CALL Capture(VkFlags msgFlags, VkDebugReportObjectTypeEXT objType, uint64_t srcObject,
+                                                  size_t location, int32_t msgCode, const char *pLayerPrefix, const char *pMsg,
+                                                  void *pUserData) {
+        auto capture = static_cast<debug_report_capture *>(pUserData);
+        capture->messages_.push_back({msgFlags, objType, srcObject, location, msgCode, pLayerPrefix, pMsg});
+        return VK_FALSE;
+    }
+
+    const debug_report_data *target_;
+    debug_report_data capture_data_;
+    VkLayerDbgFunctionNode capture_node_;
+    std::unordered_map<uint64_t, std::string> no_names_;
+    std::vector<debug_report_message> messages_;
+};
+
+// As log_callback, but leaves flushing the file to the asynchronous logger, which does it once per batch
+static inline VKAPI_ATTR VkBool32 VKAPI_CALL buffered_log_callback(VkFlags msgFlags, VkDebugReportObjectTypeEXT objType,
+                                                                   uint64_t srcObject, size_t location, int32_t msgCode,
+                                                                   const char *pLayerPrefix, const char *pMsg, void *pUserData) {
     char msg_flags[30];
 
     print_msg_flags(msgFlags, msg_flags);
 
     fprintf((FILE *)pUserData, "%s(%s): object: 0x%" PRIx64 " type: %d location: %lu msgCode: %d: %s\n", pLayerPrefix, msg_flags,
             srcObject, objType, (unsigned long)location, msgCode, pMsg);
+
+    return false;
+}
+
+static inline VKAPI_ATTR VkBool32 VKAPI_CALL log_callback(VkFlags msgFlags, VkDebugReportObjectTypeEXT objType, uint64_t srcObject,
+                                                          size_t location, int32_t msgCode, const char *pLayerPrefix,
+                                                          const char *pMsg, void *pUserData) {
+    buffered_log_callback(msgFlags, objType, srcObject, location, msgCode, pLayerPrefix, pMsg, pUserData);
     fflush((FILE *)pUserData);
 
     return false;
@@ -0,0 +1,98 @@
+/* Copyright (c) 2015-2017 The Khronos Group Inc.
+ * Copyright (c) 2015-2017 Valve Corporation
+ * Copyright (c) 2015-2017 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VK_LAYER_MPSC_RING_H
+#define VK_LAYER_MPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+// Bounded ring that any number of threads push into without locking and one thread pops from.  Each cell carries a
+// sequence number saying whose turn it is: a producer claims the next position with a compare-and-swap on the tail and
+// publishes its value by bumping the cell's sequence, which is what the consumer waits for.  A push that finds the ring
+// full fails rather than waiting.  Pops come out in the order positions were claimed, so a producer that has claimed a
+// position but not yet filled it holds up the values behind it until it does.
+template <typename T>
+class vl_mpsc_ring {
+   public:
+    // capacity is rounded up to a power of two
+    explicit vl_mpsc_ring(size_t capacity) : head_(0), tail_(0) {
+        size_t size = 2;
+        while (size < capacity) size *= 2;
+        mask_ = size - 1;
+        cells_.reset(new cell[size]);
+        for (size_t i = 0; i < size; ++i) cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+    vl_mpsc_ring(const vl_mpsc_ring &) = delete;
+    vl_mpsc_ring &operator=(const vl_mpsc_ring &) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    // Safe from any thread; returns false, leaving value alone, when the ring is full
+    bool try_push(T &&value) {
+        size_t position = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            cell &target = cells_[position & mask_];
+            const size_t sequence = target.sequence.load(std::memory_order_acquire);
+            const intptr_t turn = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (turn == 0) {
+                if (tail_.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    target.value = std::move(value);
+                    target.sequence.store(position + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (turn < 0) {
+                // The consumer hasn't taken the value a whole lap ago out of this cell yet
+                return false;
+            } else {
+                position = tail_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Consumer thread only; returns false when the next value hasn't been published yet
+    bool try_pop(T &value) {
+        cell &source = cells_[head_ & mask_];
+        if (source.sequence.load(std::memory_order_acquire) != head_ + 1) return false;
+        value = std::move(source.value);
+        source.sequence.store(head_ + mask_ + 1, std::memory_order_release);
+        ++head_;
+        return true;
+    }
+
+    // Consumer thread only
+    bool empty() const { return cells_[head_ & mask_].sequence.load(std::memory_order_acquire) != head_ + 1; }
+
+   private:
+    struct cell {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<cell[]> cells_;
+    size_t mask_;
+    size_t head_;  // Next position to pop, touched only by the consumer
+    // Kept off the consumer's cache line, as every producer hammers it
+    char padding_[64];
+    std::atomic<size_t> tail_;  // Next position to claim
+};
+
+#endif  // VK_LAYER_MPSC_RING_H
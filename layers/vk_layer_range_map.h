@@ -0,0 +1,135 @@
+/* Copyright (c) 2015-2017 The Khronos Group Inc.
+ * Copyright (c) 2015-2017 Valve Corporation
+ * Copyright (c) 2015-2017 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VK_LAYER_RANGE_MAP_H
+#define VK_LAYER_RANGE_MAP_H
+
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+// Interval map from an integer index to a value, for state that is usually the same across long runs of indices, such as
+// the layouts of the (linearized) subresources of an image.
+//
+// The map is a vector of disjoint half-open ranges sorted by their start, and adjacent ranges holding equal values are
+// merged, so a value set across a million indices at once costs one entry.  Lookups are a binary search and updates touch
+// only the ranges they overlap.  T must be copyable and comparable with ==.
+//
+// Iterators are plain pointers into the range vector and are invalidated by any update.
+template <typename Index, typename T>
+class vl_range_map {
+   public:
+    struct range {
+        Index begin;
+        Index end;  // One past the last index
+        T value;
+    };
+    typedef const range *const_iterator;
+
+    const_iterator begin() const { return ranges_.data(); }
+    const_iterator end() const { return ranges_.data() + ranges_.size(); }
+    size_t size() const { return ranges_.size(); }
+    bool empty() const { return ranges_.empty(); }
+    void clear() { ranges_.clear(); }
+
+    // Return the value stored for index, or nullptr if there is none
+    const T *find(Index index) const {
+        const_iterator it = FirstOverlapping(index);
+        return (it != end() && it->begin <= index) ? &it->value : nullptr;
+    }
+
+    // Call func(begin, end, value) for each stored range that overlaps [begin, end), clipped to [begin, end)
+    template <typename F>
+    void for_each(Index begin, Index end, F func) const {
+        for (const_iterator it = FirstOverlapping(begin); it != this->end() && it->begin < end; ++it) {
+            func(std::max(it->begin, begin), std::min(it->end, end), it->value);
+        }
+    }
+
+    // Map every index in [begin, end) to value
+    void insert_or_assign(Index begin, Index end, const T &value) {
+        update(begin, end, [&value](const T *) { return value; });
+    }
+
+    // Map every index in [begin, end) to func(current), where current points to the value previously stored for the index or
+    // is nullptr if there was none.  func is called once per stored range and once per gap, not once per index.
+    template <typename F>
+    void update(Index begin, Index end, F func) {
+        if (begin >= end) return;
+        const size_t first = FirstOverlapping(begin) - this->begin();
+        size_t last = first;
+        scratch_.clear();
+        Index cursor = begin;
+        for (; last < ranges_.size() && ranges_[last].begin < end; ++last) {
+            const range &existing = ranges_[last];
+            // Keep whatever part of the existing range lies outside [begin, end)
+            if (existing.begin < begin) scratch_.push_back(range{existing.begin, begin, existing.value});
+            if (cursor < existing.begin) scratch_.push_back(range{cursor, existing.begin, func(nullptr)});
+            const Index clipped_end = std::min(existing.end, end);
+            scratch_.push_back(range{std::max(existing.begin, begin), clipped_end, func(&existing.value)});
+            if (existing.end > end) scratch_.push_back(range{end, existing.end, existing.value});
+            cursor = clipped_end;
+        }
+        if (cursor < end) scratch_.push_back(range{cursor, end, func(nullptr)});
+        Splice(first, last);
+    }
+
+    // Forget the values stored for [begin, end)
+    void erase(Index begin, Index end) {
+        if (begin >= end) return;
+        const size_t first = FirstOverlapping(begin) - this->begin();
+        size_t last = first;
+        scratch_.clear();
+        for (; last < ranges_.size() && ranges_[last].begin < end; ++last) {
+            const range &existing = ranges_[last];
+            if (existing.begin < begin) scratch_.push_back(range{existing.begin, begin, existing.value});
+            if (existing.end > end) scratch_.push_back(range{end, existing.end, existing.value});
+        }
+        Splice(first, last);
+    }
+
+   private:
+    // First range that ends after index
+    const_iterator FirstOverlapping(Index index) const {
+        return std::upper_bound(begin(), end(), index, [](Index i, const range &r) { return i < r.end; });
+    }
+
+    // Replace ranges_[first, last) with scratch_, merging equal neighbours
+    void Splice(size_t first, size_t last) {
+        size_t lo = first;
+        if (lo > 0) --lo;  // The range before the change may now merge with it
+        ranges_.erase(ranges_.begin() + first, ranges_.begin() + last);
+        ranges_.insert(ranges_.begin() + first, scratch_.begin(), scratch_.end());
+        size_t hi = std::min(first + scratch_.size() + 1, ranges_.size());
+        size_t out = lo;
+        for (size_t in = lo + 1; in < hi; ++in) {
+            if (ranges_[out].end == ranges_[in].begin && ranges_[out].value == ranges_[in].value) {
+                ranges_[out].end = ranges_[in].end;
+            } else {
+                ++out;
+                if (out != in) ranges_[out] = ranges_[in];
+            }
+        }
+        if (hi > lo && out + 1 != hi) ranges_.erase(ranges_.begin() + out + 1, ranges_.begin() + hi);
+    }
+
+    std::vector<range> ranges_;
+    std::vector<range> scratch_;  // Kept between updates so that they do not allocate
+};
+
+#endif  // VK_LAYER_RANGE_MAP_H
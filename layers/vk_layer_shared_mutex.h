@@ -0,0 +1,119 @@
+/* Copyright (c) 2015-2017 The Khronos Group Inc.
+ * Copyright (c) 2015-2017 Valve Corporation
+ * Copyright (c) 2015-2017 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VK_LAYER_SHARED_MUTEX_H
+#define VK_LAYER_SHARED_MUTEX_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Reader/writer lock with the std::shared_timed_mutex interface (lock/unlock, lock_shared/unlock_shared), usable with
+// std::unique_lock and std::lock_guard.  The layers still build as C++11 (and with VS2013), so the C++14/17 library
+// versions are not available.
+//
+// Writers are serialized by writer_mutex_ and, once they own it, set kWriterBit to keep new readers out and then wait for
+// the readers already inside to drain.  Uncontended exclusive locking therefore costs one mutex acquire plus one atomic,
+// and uncontended shared locking costs a single compare-exchange.  Readers that find a writer active block on
+// writer_mutex_ instead of spinning.
+class SharedMutex {
+   public:
+    SharedMutex() : state_(0) {}
+    SharedMutex(const SharedMutex &) = delete;
+    SharedMutex &operator=(const SharedMutex &) = delete;
+
+    void lock() {
+        writer_mutex_.lock();
+        state_.fetch_or(kWriterBit, std::memory_order_acquire);
+        while (state_.load(std::memory_order_acquire) != kWriterBit) {
+            std::this_thread::yield();
+        }
+    }
+
+    bool try_lock() {
+        if (!writer_mutex_.try_lock()) return false;
+        uint32_t expected = 0;
+        if (!state_.compare_exchange_strong(expected, kWriterBit, std::memory_order_acquire)) {
+            writer_mutex_.unlock();
+            return false;
+        }
+        return true;
+    }
+
+    void unlock() {
+        // No reader can have registered while the writer bit was set
+        state_.store(0, std::memory_order_release);
+        writer_mutex_.unlock();
+    }
+
+    void lock_shared() {
+        for (;;) {
+            uint32_t state = state_.load(std::memory_order_relaxed);
+            if (!(state & kWriterBit)) {
+                if (state_.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed)) return;
+            } else {
+                // A writer owns or is waiting for the lock; sleep until it is done rather than spin.
+                std::lock_guard<std::mutex> wait_for_writer(writer_mutex_);
+            }
+        }
+    }
+
+    bool try_lock_shared() {
+        uint32_t state = state_.load(std::memory_order_relaxed);
+        return !(state & kWriterBit) &&
+               state_.compare_exchange_strong(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed);
+    }
+
+    void unlock_shared() { state_.fetch_sub(1, std::memory_order_release); }
+
+   private:
+    static const uint32_t kWriterBit = 0x80000000u;
+    // kWriterBit | number of readers currently holding the lock
+    std::atomic<uint32_t> state_;
+    std::mutex writer_mutex_;
+};
+
+// RAII shared (reader) ownership of a SharedMutex, the C++11 stand-in for std::shared_lock.
+template <typename Mutex>
+class SharedLock {
+   public:
+    explicit SharedLock(Mutex &mutex) : mutex_(&mutex), owns_(true) { mutex_->lock_shared(); }
+    SharedLock(Mutex &mutex, std::defer_lock_t) : mutex_(&mutex), owns_(false) {}
+    SharedLock(const SharedLock &) = delete;
+    SharedLock &operator=(const SharedLock &) = delete;
+    ~SharedLock() {
+        if (owns_) mutex_->unlock_shared();
+    }
+
+    void lock() {
+        mutex_->lock_shared();
+        owns_ = true;
+    }
+    void unlock() {
+        mutex_->unlock_shared();
+        owns_ = false;
+    }
+    bool owns_lock() const { return owns_; }
+
+   private:
+    Mutex *mutex_;
+    bool owns_;
+};
+
+#endif  // VK_LAYER_SHARED_MUTEX_H
@@ -0,0 +1,413 @@
+/* Copyright (c) 2015-2016 The Khronos Group Inc.
+ * Copyright (c) 2015-2016 Valve Corporation
+ * Copyright (c) 2015-2016 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * Author: Cody Northrop <cody@lunarg.com>
+ * Author: Mike Stroyan <mike@LunarG.com>
+ */
+
+// The threading checker's tracking of object uses, and its choice of which calls to check, kept apart from the layer's
+// own state so that they can be included and tested on their own
+
+#ifndef VK_LAYER_THREAD_COUNTER_H
+#define VK_LAYER_THREAD_COUNTER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "vk_layer_config.h"
+#include "vk_layer_logging.h"
+
+// Draw State ERROR codes
+enum THREADING_CHECKER_ERROR {
+    THREADING_CHECKER_NONE,                 // Used for INFO & other non-error messages
+    THREADING_CHECKER_MULTIPLE_THREADS,     // Object used simultaneously by multiple threads
+    THREADING_CHECKER_SINGLE_THREAD_REUSE,  // Object used simultaneously by recursion in single thread
+};
+
+// Use of one object: its reader and writer counts and a tag for the thread that started the current use, packed into one
+// word so that a use can be started or finished with a single compare-and-swap.  A word of 0 means the object is idle.
+//
+// Words live in an open-addressing table keyed by handle.  Lookups never take a lock; claiming and freeing slots take
+// one, so that two threads can't claim slots for the same handle.  When a handle's probe window is full a table of twice
+// the size is chained on, and later handles go there.  Handles below unique_objects are never reused, so the slot of a
+// destroyed object is marked as a tombstone, which lookups step over and later claims take back; otherwise every object
+// ever created would keep a slot and the probe windows of the first tables would stay full for good.
+class object_use_table {
+   public:
+    static const uint64_t kWriter = 1;
+    static const uint64_t kReader = uint64_t(1) << 16;
+    static uint64_t writers(uint64_t use) { return use & 0xffff; }
+    static uint64_t readers(uint64_t use) { return (use >> 16) & 0xffff; }
+    static uint32_t tag(uint64_t use) { return static_cast<uint32_t>(use >> 32); }
+    // Use word of an object that has had its share of checked uses, or has been destroyed; it is not tracked any further
+    static const uint64_t kRetired = ~uint64_t(0);
+    static uint64_t make_use(uint32_t thread_tag, uint64_t reader_count, uint64_t writer_count) {
+        return (uint64_t(thread_tag) << 32) | (reader_count * kReader) | (writer_count * kWriter);
+    }
+    static uint32_t thread_tag(loader_platform_thread_id tid) {
+        uint64_t id = (uint64_t)tid;
+        return static_cast<uint32_t>(id ^ (id >> 32));
+    }
+
+    struct slot {
+        slot() : key(0), use(0), thread(0), checks(0) {}
+        std::atomic<uint64_t> key;
+        std::atomic<uint64_t> use;
+        // Full id of the thread whose tag is in use, for messages only
+        std::atomic<uint64_t> thread;
+        // Uses started so far, counted only when checks per object are limited
+        std::atomic<uint32_t> checks;
+    };
+
+    object_use_table() : first_(kFirstCapacity) {}
+    ~object_use_table() {
+        table *next = first_.next.load();
+        while (next) {
+            table *grown = next->next.load();
+            delete next;
+            next = grown;
+        }
+    }
+    object_use_table(const object_use_table &) = delete;
+    object_use_table &operator=(const object_use_table &) = delete;
+
+    // Return the slot for key, claiming one if insert is set and it has none yet; key must not be 0 or kTombstone
+    slot *find(uint64_t key, bool insert) {
+        const uint64_t hash = Hash(key);
+        slot *found = Lookup(key, hash);
+        if (found || !insert) return found;
+        std::lock_guard<std::mutex> lock(claim_lock_);
+        // Another thread may have claimed a slot for key since the lookup above
+        found = Lookup(key, hash);
+        if (found) return found;
+        for (table *t = &first_;; t = t->next.load(std::memory_order_relaxed)) {
+            for (uint64_t probe = 0; probe < kMaxProbe; ++probe) {
+                slot &s = t->slots[(hash + probe) & t->mask];
+                const uint64_t current = s.key.load(std::memory_order_relaxed);
+                if (current == 0 || current == kTombstone) {
+                    s.use.store(0, std::memory_order_relaxed);
+                    s.thread.store(0, std::memory_order_relaxed);
+                    s.checks.store(0, std::memory_order_relaxed);
+                    s.key.store(key, std::memory_order_release);
+                    return &s;
+                }
+            }
+            if (!t->next.load(std::memory_order_relaxed)) t->next.store(new table((t->mask + 1) * 2), std::memory_order_release);
+        }
+    }
+
+    // Give up the slot of a destroyed object so that a later handle can claim it
+    void erase(slot *s) {
+        std::lock_guard<std::mutex> lock(claim_lock_);
+        s->key.store(kTombstone, std::memory_order_release);
+    }
+
+   private:
+    static const uint64_t kFirstCapacity = 64;
+    static const uint64_t kMaxProbe = 16;
+    // Key of a slot whose object was destroyed
+    static const uint64_t kTombstone = ~uint64_t(0);
+
+    static uint64_t Hash(uint64_t key) {
+        key ^= key >> 33;
+        key *= 0xff51afd7ed558ccdull;
+        key ^= key >> 33;
+        return key;
+    }
+
+    slot *Lookup(uint64_t key, uint64_t hash) {
+        for (table *t = &first_; t; t = t->next.load(std::memory_order_acquire)) {
+            for (uint64_t probe = 0; probe < kMaxProbe; ++probe) {
+                slot &s = t->slots[(hash + probe) & t->mask];
+                const uint64_t current = s.key.load(std::memory_order_acquire);
+                if (current == key) return &s;
+                // Slots fill in probe order and never go back to empty, so key can't be further along, nor in a later table
+                if (current == 0) return nullptr;
+            }
+        }
+        return nullptr;
+    }
+
+    struct table {
+        explicit table(uint64_t capacity) : mask(capacity - 1), slots(new slot[capacity]), next(nullptr) {}
+        const uint64_t mask;
+        std::unique_ptr<slot[]> slots;
+        std::atomic<table *> next;
+    };
+
+    table first_;
+    std::mutex claim_lock_;
+};
+
+template <typename T>
+class counter {
+   public:
+    const char *typeName;
+    VkDebugReportObjectTypeEXT objectType;
+    object_use_table uses;
+    // Only a thread that must wait for an object to go idle takes these
+    std::mutex counter_lock;
+    std::condition_variable counter_condition;
+    std::atomic<uint32_t> waiters;
+
+    // A use_limit other than 0 stops checking an object once that many uses of it have been checked
+    void startWrite(debug_report_data *report_data, T object, uint32_t use_limit = 0) {
+        if (object == VK_NULL_HANDLE) {
+            return;
+        }
+        loader_platform_thread_id tid = loader_platform_get_thread_id();
+        const uint32_t tid_tag = object_use_table::thread_tag(tid);
+        object_use_table::slot *use_data = uses.find((uint64_t)(object), true);
+        bool reported = false;
+        uint64_t use = use_data->use.load(std::memory_order_acquire);
+        while (true) {
+            uint64_t new_use;
+            if (use == object_use_table::kRetired) {
+                return;
+            } else if (use == 0) {
+                // There is no current use of the object.  Record writer thread.
+                new_use = object_use_table::make_use(tid_tag, 0, 1);
+            } else if (object_use_table::tag(use) == tid_tag) {
+                // This is either safe multiple use in one call, or recursive use.
+                // There is no way to make recursion safe.  Just forge ahead.
+                new_use = use + object_use_table::kWriter;
+            } else {
+                // There are readers or a writer in another thread.  This writer collided with them.
+                if (!reported) {
+                    reported = true;
+                    if (ReportCollision(report_data, object, use_data, tid)) {
+                        // Wait for thread-safe access to object instead of skipping call.
+                        WaitToClaim(use_data, object_use_table::make_use(tid_tag, 0, 1), tid, use_limit);
+                        return;
+                    }
+                }
+                // Continue with an unsafe use of the object.
+                new_use = object_use_table::make_use(tid_tag, object_use_table::readers(use), object_use_table::writers(use) + 1);
+            }
+            if (use_data->use.compare_exchange_weak(use, new_use)) break;
+        }
+        if (use == 0 || object_use_table::tag(use) != tid_tag) use_data->thread.store((uint64_t)tid, std::memory_order_relaxed);
+        if (use_limit) use_data->checks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void finishWrite(T object, uint32_t use_limit = 0) {
+        if (object == VK_NULL_HANDLE) {
+            return;
+        }
+        // Object is no longer in use
+        Finish(object, object_use_table::kWriter, use_limit);
+    }
+
+    void startRead(debug_report_data *report_data, T object, uint32_t use_limit = 0) {
+        if (object == VK_NULL_HANDLE) {
+            return;
+        }
+        loader_platform_thread_id tid = loader_platform_get_thread_id();
+        const uint32_t tid_tag = object_use_table::thread_tag(tid);
+        object_use_table::slot *use_data = uses.find((uint64_t)(object), true);
+        bool reported = false;
+        uint64_t use = use_data->use.load(std::memory_order_acquire);
+        while (true) {
+            uint64_t new_use;
+            if (use == object_use_table::kRetired) {
+                return;
+            } else if (use == 0) {
+                // There is no current use of the object.  Record reader count
+                new_use = object_use_table::make_use(tid_tag, 1, 0);
+            } else if (object_use_table::writers(use) > 0 && object_use_table::tag(use) != tid_tag) {
+                // There is a writer of the object.
+                if (!reported) {
+                    reported = true;
+                    if (ReportCollision(report_data, object, use_data, tid)) {
+                        // Wait for thread-safe access to object instead of skipping call.
+                        WaitToClaim(use_data, object_use_table::make_use(tid_tag, 1, 0), tid, use_limit);
+                        return;
+                    }
+                }
+                new_use = use + object_use_table::kReader;
+            } else {
+                // There are other readers of the object.  Increase reader count
+                new_use = use + object_use_table::kReader;
+            }
+            if (use_data->use.compare_exchange_weak(use, new_use)) break;
+        }
+        if (use == 0) use_data->thread.store((uint64_t)tid, std::memory_order_relaxed);
+        if (use_limit) use_data->checks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void finishRead(T object, uint32_t use_limit = 0) {
+        if (object == VK_NULL_HANDLE) {
+            return;
+        }
+        Finish(object, object_use_table::kReader, use_limit);
+    }
+
+    // Stop tracking a destroyed object.  Any thread still waiting to use it gives up, as the object is gone.
+    void destroyObject(T object) {
+        if (object == VK_NULL_HANDLE) {
+            return;
+        }
+        object_use_table::slot *use_data = uses.find((uint64_t)(object), false);
+        if (!use_data) return;
+        use_data->use.store(object_use_table::kRetired);
+        if (waiters.load() != 0) {
+            { std::lock_guard<std::mutex> lock(counter_lock); }
+            counter_condition.notify_all();
+        }
+        uses.erase(use_data);
+    }
+
+    counter(const char *name = "", VkDebugReportObjectTypeEXT type = VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT) : waiters(0) {
+        typeName = name;
+        objectType = type;
+    }
+
+   private:
+    bool ReportCollision(debug_report_data *report_data, T object, object_use_table::slot *use_data,
+                         loader_platform_thread_id tid) {
+        return log_msg(report_data, VK_DEBUG_REPORT_ERROR_BIT_EXT, objectType, (uint64_t)(object), 0,
+                       THREADING_CHECKER_MULTIPLE_THREADS, "THREADING",
+                       "THREADING ERROR : object of type %s is simultaneously used in "
+                       "thread 0x%" PRIx64 " and thread 0x%" PRIx64,
+                       typeName, use_data->thread.load(std::memory_order_relaxed), (uint64_t)tid);
+    }
+
+    // Block until the object is idle, then start the given use of it.  Gives up if the object is retired meanwhile.
+    void WaitToClaim(object_use_table::slot *use_data, uint64_t new_use, loader_platform_thread_id tid, uint32_t use_limit) {
+        std::unique_lock<std::mutex> lock(counter_lock);
+        waiters.fetch_add(1);
+        uint64_t idle = 0;
+        while (!use_data->use.compare_exchange_strong(idle, new_use)) {
+            if (idle == object_use_table::kRetired) break;
+            idle = 0;
+            counter_condition.wait(lock);
+        }
+        waiters.fetch_sub(1);
+        if (idle == object_use_table::kRetired) return;
+        use_data->thread.store((uint64_t)tid, std::memory_order_relaxed);
+        if (use_limit) use_data->checks.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void Finish(T object, uint64_t unit, uint32_t use_limit) {
+        object_use_table::slot *use_data = uses.find((uint64_t)(object), false);
+        if (!use_data) return;
+        uint64_t use = use_data->use.load(std::memory_order_acquire);
+        uint64_t new_use;
+        do {
+            // A retired object had no uses in flight when it was retired, so this use was never started
+            if (use == object_use_table::kRetired) return;
+            new_use = use - unit;
+            if (object_use_table::readers(new_use) == 0 && object_use_table::writers(new_use) == 0) {
+                // Retiring only once the object goes idle keeps every started use paired with its finish
+                bool spent = use_limit && use_data->checks.load(std::memory_order_relaxed) >= use_limit;
+                new_use = spent ? object_use_table::kRetired : 0;
+            }
+        } while (!use_data->use.compare_exchange_weak(use, new_use));
+        // Notify any waiting threads that this object may be safe to use
+        if ((new_use == 0 || new_use == object_use_table::kRetired) && waiters.load() != 0) {
+            { std::lock_guard<std::mutex> lock(counter_lock); }
+            counter_condition.notify_all();
+        }
+    }
+};
+
+// Picks the calls whose objects the threading checker tracks, so that it can stay enabled where checking every call costs
+// too much.  A call is checked only if it is one of every call_period calls made on its thread and falls in the first
+// duty_on_ms of a duty_period_ms period.  The same choice covers every object a call uses, so uses start and finish in
+// pairs.  Threads share call counts when their ids hash alike, so call_period is followed per thread only approximately.
+class call_sampler {
+   public:
+    uint32_t call_period = 1;
+    uint32_t duty_on_ms = 0;
+    uint32_t duty_period_ms = 0;
+    // Uses of one object checked before it is no longer tracked, 0 for no limit
+    uint32_t object_limit = 0;
+
+    call_sampler() : epoch_(std::chrono::steady_clock::now()) {}
+
+    bool sampling() const { return call_period > 1 || duty_period_ms != 0 || object_limit != 0; }
+
+    void configure(const char *layer_identifier) {
+        const std::string prefix = layer_identifier;
+        call_period = option_value((prefix + ".sample_call_period").c_str(), 1);
+        duty_on_ms = option_value((prefix + ".sample_duty_on_ms").c_str(), 0);
+        duty_period_ms = option_value((prefix + ".sample_duty_period_ms").c_str(), 0);
+        object_limit = option_value((prefix + ".sample_object_limit").c_str(), 0);
+        if (!call_period) call_period = 1;
+        if (duty_on_ms >= duty_period_ms) duty_period_ms = 0;
+    }
+
+    void configure(const call_sampler &other) {
+        call_period = other.call_period;
+        duty_on_ms = other.duty_on_ms;
+        duty_period_ms = other.duty_period_ms;
+        object_limit = other.object_limit;
+    }
+
+    bool sample_call() {
+        if (!sampling()) return true;
+        uint32_t stripe = object_use_table::thread_tag(loader_platform_get_thread_id());
+        stripe = (stripe ^ (stripe >> 16)) * 0x45d9f3bu;
+        call_counts &counts = stripes_[(stripe >> 16) % kStripes];
+        uint64_t call = counts.calls.fetch_add(1, std::memory_order_relaxed);
+        if (call % call_period) return false;
+        if (duty_period_ms) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch_);
+            if (static_cast<uint64_t>(elapsed.count()) % duty_period_ms >= duty_on_ms) return false;
+        }
+        counts.checked.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    // Report how many calls were checked, so the cost of the chosen settings can be weighed against their coverage
+    void log_summary(debug_report_data *report_data, VkDebugReportObjectTypeEXT object_type, uint64_t object) const {
+        if (!sampling()) return;
+        uint64_t calls = 0, checked = 0;
+        for (uint32_t i = 0; i < kStripes; ++i) {
+            calls += stripes_[i].calls.load(std::memory_order_relaxed);
+            checked += stripes_[i].checked.load(std::memory_order_relaxed);
+        }
+        log_msg(report_data, VK_DEBUG_REPORT_INFORMATION_BIT_EXT, object_type, object, 0, THREADING_CHECKER_NONE, "THREADING",
+                "Threading checks sampled %" PRIu64 " of %" PRIu64 " multi-threaded calls (call period %u, duty cycle %u/%u ms, "
+                "object limit %u).",
+                checked, calls, call_period, duty_on_ms, duty_period_ms, object_limit);
+    }
+
+   private:
+    static const uint32_t kStripes = 16;
+
+    static uint32_t option_value(const char *option, uint32_t default_value) {
+        const char *value = getLayerOption(option);
+        return *value ? static_cast<uint32_t>(strtoul(value, NULL, 10)) : default_value;
+    }
+
+    // Padded so that threads counting calls in different stripes don't share a cache line
+    struct call_counts {
+        call_counts() : calls(0), checked(0) {}
+        std::atomic<uint64_t> calls;
+        std::atomic<uint64_t> checked;
+        char padding[64 - 2 * sizeof(std::atomic<uint64_t>)];
+    };
+
+    std::chrono::steady_clock::time_point epoch_;
+    call_counts stripes_[kStripes];
+};
+
+#endif  // VK_LAYER_THREAD_COUNTER_H
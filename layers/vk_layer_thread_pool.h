@@ -0,0 +1,174 @@
+/* Copyright (c) 2015-2017 The Khronos Group Inc.
+ * Copyright (c) 2015-2017 Valve Corporation
+ * Copyright (c) 2015-2017 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#ifndef VK_LAYER_THREAD_POOL_H
+#define VK_LAYER_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads for splitting independent pieces of one API call's validation, such as the pipelines of a
+// vkCreateGraphicsPipelines batch, across cores.  The pool runs one parallel_for at a time, with the calling thread taking
+// part.  A call that arrives while another thread's parallel_for is running does its work on its own thread rather than
+// waiting, so callers never block on each other.
+class vl_thread_pool {
+   public:
+    // thread_count counts the calling thread, so a pool of 1 (or 0) has no workers and runs everything inline
+    explicit vl_thread_pool(uint32_t thread_count) : task_(nullptr), count_(0), generation_(0), active_(0), stop_(false) {
+        for (uint32_t i = 1; i < thread_count; ++i) {
+            workers_.emplace_back(&vl_thread_pool::WorkerMain, this);
+        }
+    }
+    vl_thread_pool(const vl_thread_pool &) = delete;
+    vl_thread_pool &operator=(const vl_thread_pool &) = delete;
+    ~vl_thread_pool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto &worker : workers_) worker.join();
+    }
+
+    uint32_t thread_count() const { return static_cast<uint32_t>(workers_.size()) + 1; }
+
+    // Call task(i) once for each i in [0, count), spread over the pool, and return when every call has finished.  Tasks
+    // are handed out in index order but may finish in any order; task must be safe to run concurrently with itself.
+    void parallel_for(uint32_t count, const std::function<void(uint32_t)> &task) {
+        std::unique_lock<std::mutex> busy(busy_, std::try_to_lock);
+        if (workers_.empty() || count < 2 || !busy.owns_lock()) {
+            for (uint32_t i = 0; i < count; ++i) task(i);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task_ = &task;
+            count_ = count;
+            next_.store(0, std::memory_order_relaxed);
+            ++generation_;
+        }
+        work_cv_.notify_all();
+        RunTasks(task, count);
+        // Every task has been claimed by now; wait for the workers still running theirs to let go of this batch
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this]() { return active_ == 0; });
+        task_ = nullptr;
+    }
+
+   private:
+    // Claim and run tasks until none are left
+    void RunTasks(const std::function<void(uint32_t)> &task, uint32_t count) {
+        for (uint32_t i = next_.fetch_add(1, std::memory_order_relaxed); i < count;
+             i = next_.fetch_add(1, std::memory_order_relaxed)) {
+            task(i);
+        }
+    }
+
+    void WorkerMain() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            work_cv_.wait(lock, [this, seen]() { return stop_ || generation_ != seen; });
+            if (stop_) return;
+            seen = generation_;
+            // A worker that wakes after its batch has already finished has nothing to join
+            if (!task_) continue;
+            const std::function<void(uint32_t)> *task = task_;
+            const uint32_t count = count_;
+            ++active_;
+            lock.unlock();
+            RunTasks(*task, count);
+            lock.lock();
+            --active_;
+            done_cv_.notify_one();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex busy_;   // Held by the thread running a parallel_for
+    std::mutex mutex_;  // Guards the fields below other than the atomics
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    const std::function<void(uint32_t)> *task_;
+    uint32_t count_;
+    uint64_t generation_;  // Bumped for each parallel_for, so workers can tell a new batch from the one they just ran
+    uint32_t active_;      // Workers that have joined the current batch and not yet left it
+    std::atomic<uint32_t> next_;  // Index of the next task to hand out
+    bool stop_;
+};
+
+// Worker threads that run tasks in the background, started in the order they are pushed.  Unlike vl_thread_pool nobody
+// waits on a batch; whoever needs a task's result synchronizes with the task itself.  The destructor runs whatever is
+// still queued before returning.
+class vl_task_queue {
+   public:
+    explicit vl_task_queue(uint32_t thread_count) : stop_(false) {
+        for (uint32_t i = 0; i < thread_count || workers_.empty(); ++i) {
+            workers_.emplace_back(&vl_task_queue::WorkerMain, this);
+        }
+    }
+    vl_task_queue(const vl_task_queue &) = delete;
+    vl_task_queue &operator=(const vl_task_queue &) = delete;
+    ~vl_task_queue() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto &worker : workers_) worker.join();
+    }
+
+    uint32_t thread_count() const { return static_cast<uint32_t>(workers_.size()); }
+
+    void push(std::function<void()> &&task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        work_cv_.notify_one();
+    }
+
+   private:
+    void WorkerMain() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (true) {
+            work_cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+            // Stopping still drains the queue
+            if (tasks_.empty()) return;
+            std::function<void()> task = std::move(tasks_.front());
+            tasks_.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::mutex mutex_;  // Guards the fields below
+    std::condition_variable work_cv_;
+    std::deque<std::function<void()>> tasks_;
+    bool stop_;
+};
+
+#endif  // VK_LAYER_THREAD_POOL_H
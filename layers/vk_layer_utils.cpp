@@ -98,9 +98,17 @@ VK_LAYER_EXPORT void layer_debug_actions(debug_report_data *report_data, std::ve
     std::string report_flags_key = layer_identifier;
     std::string debug_action_key = layer_identifier;
     std::string log_filename_key = layer_identifier;
+    std::string async_key = layer_identifier;
+    std::string async_queue_size_key = layer_identifier;
+    std::string duplicate_limit_key = layer_identifier;
+    std::string duplicate_period_key = layer_identifier;
     report_flags_key.append(".report_flags");
     debug_action_key.append(".debug_action");
     log_filename_key.append(".log_filename");
+    async_key.append(".async_debug_report");
+    async_queue_size_key.append(".async_debug_report_queue_size");
+    duplicate_limit_key.append(".duplicate_message_limit");
+    duplicate_period_key.append(".duplicate_message_period");
 
     // Initialize layer options
     VkDebugReportFlagsEXT report_flags = GetLayerOptionFlags(report_flags_key, report_flags_option_definitions, 0);
@@ -108,6 +116,18 @@ VK_LAYER_EXPORT void layer_debug_actions(debug_report_data *report_data, std::ve
     // Flag as default if these settings are not from a vk_layer_settings.txt file
     bool default_layer_callback = (debug_action & VK_DBG_LAYER_ACTION_DEFAULT) ? true : false;
 
+    if (!strcmp(getLayerOption(async_key.c_str()), "true") && !report_data->async_logger) {
+        const char *queue_size = getLayerOption(async_queue_size_key.c_str());
+        size_t capacity = *queue_size ? static_cast<size_t>(strtoul(queue_size, NULL, 10)) : 0;
+        report_data->async_logger = new debug_report_async_logger(report_data, capacity ? capacity : 4096);
+    }
+
+    const uint32_t duplicate_limit = static_cast<uint32_t>(strtoul(getLayerOption(duplicate_limit_key.c_str()), NULL, 10));
+    if (duplicate_limit && !report_data->duplicate_filter) {
+        const uint32_t duplicate_period = static_cast<uint32_t>(strtoul(getLayerOption(duplicate_period_key.c_str()), NULL, 10));
+        report_data->duplicate_filter = new debug_report_duplicate_filter(duplicate_limit, duplicate_period);
+    }
+
     if (debug_action & VK_DBG_LAYER_ACTION_LOG_MSG) {
         const char *log_filename = getLayerOption(log_filename_key.c_str());
         FILE *log_output = getLayerLogOutput(log_filename, layer_identifier);
@@ -117,6 +137,10 @@ VK_LAYER_EXPORT void layer_debug_actions(debug_report_data *report_data, std::ve
         dbgCreateInfo.flags = report_flags;
         dbgCreateInfo.pfnCallback = log_callback;
         dbgCreateInfo.pUserData = (void *)log_output;
+        if (report_data->async_logger) {
+            dbgCreateInfo.pfnCallback = buffered_log_callback;
+            report_data->async_logger->add_log_file(log_output);
+        }
         layer_create_msg_callback(report_data, default_layer_callback, &dbgCreateInfo, pAllocator, &callback);
         logging_callback.push_back(callback);
     }
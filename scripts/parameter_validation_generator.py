@@ -297,8 +297,8 @@ class ParameterValidationOutputGenerator(OutputGenerator):
         write('namespace parameter_validation {', file = self.outFile)
         self.newline()
         write('extern std::mutex global_lock;', file = self.outFile)
-        write('extern std::unordered_map<void *, layer_data *> layer_data_map;', file = self.outFile)
-        write('extern std::unordered_map<void *, instance_layer_data *> instance_layer_data_map;', file = self.outFile)
+        write('extern vl_layer_data_map<layer_data> layer_data_map;', file = self.outFile)
+        write('extern vl_layer_data_map<instance_layer_data> instance_layer_data_map;', file = self.outFile)
         self.newline()
         #
         # FuncPtrMap
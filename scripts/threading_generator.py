@@ -250,6 +250,27 @@ class ThreadOutputGenerator(OutputGenerator):
             return None
         else:
             return paramdecl
+    # Generate calls that stop tracking the objects a vkDestroy* or vkFree* command destroys, whether or not the call
+    # was checked.  The destroyed objects are its last externally synchronized handle parameter.
+    def makeDestroyedObjectBlock(self, cmd):
+        name = cmd.find('proto/name').text
+        if not name.startswith('vkDestroy') and not name.startswith('vkFree'):
+            return None
+        destroyed = None
+        for param in cmd.findall('param'):
+            paramtype = param.find('type').text
+            if param.attrib.get('externsync') == 'true' and (self.isHandleTypeDispatchable(paramtype) or self.isHandleTypeNonDispatchable(paramtype)):
+                destroyed = param
+        if destroyed is None:
+            return None
+        paramname = destroyed.find('name').text
+        if self.paramIsArray(destroyed):
+            paramdecl = '    for (uint32_t index = 0; index < ' + destroyed.attrib.get('len') + '; index++) {\n'
+            paramdecl += '        destroyObject(my_data, ' + paramname + '[index]);\n'
+            paramdecl += '    }\n'
+        else:
+            paramdecl = '    destroyObject(my_data, ' + paramname + ');\n'
+        return paramdecl
     def beginFile(self, genOpts):
         OutputGenerator.beginFile(self, genOpts)
         # C-specific
@@ -377,6 +398,10 @@ class ThreadOutputGenerator(OutputGenerator):
             'vkCreateDebugReportCallbackEXT',
             'vkDestroyDebugReportCallbackEXT',
             'vkAllocateDescriptorSets',
+            'vkFreeDescriptorSets',
+            'vkResetDescriptorPool',
+            'vkDestroyDescriptorPool',
+            'vkDestroyCommandPool',
             'vkGetSwapchainImagesKHR',
             'vkEnumerateInstanceLayerProperties',
             'vkEnumerateInstanceExtensionProperties',
@@ -432,18 +457,22 @@ class ThreadOutputGenerator(OutputGenerator):
             assignresult = ''
 
         self.appendSection('command', '    bool threadChecks = startMultiThread();')
-        self.appendSection('command', '    if (threadChecks) {')
+        self.appendSection('command', '    bool sampled = threadChecks && my_data->sampler.sample_call();')
+        self.appendSection('command', '    if (sampled) {')
         self.appendSection('command', "    "+"\n    ".join(str(startthreadsafety).rstrip().split("\n")))
         self.appendSection('command', '    }')
         params = cmdinfo.elem.findall('param/name')
         paramstext = ','.join([str(param.text) for param in params])
         API = cmdinfo.elem.attrib.get('name').replace('vk','pTable->',1)
         self.appendSection('command', '    ' + assignresult + API + '(' + paramstext + ');')
-        self.appendSection('command', '    if (threadChecks) {')
+        self.appendSection('command', '    if (sampled) {')
         self.appendSection('command', "    "+"\n    ".join(str(finishthreadsafety).rstrip().split("\n")))
-        self.appendSection('command', '    } else {')
+        self.appendSection('command', '    } else if (!threadChecks) {')
         self.appendSection('command', '        finishMultiThread();')
         self.appendSection('command', '    }')
+        destroyed = self.makeDestroyedObjectBlock(cmdinfo.elem)
+        if destroyed is not None:
+            self.appendSection('command', destroyed.rstrip())
         # Return result variable, if any.
         if (resulttype != None):
             self.appendSection('command', '    return result;')
@@ -34,6 +34,33 @@ if ($lastexitcode -ne 0) {
    exit 1
 }
 
+# Run the tests of validation done on worker threads again with those threads turned on
+$env:VK_LAYER_SETTINGS_PATH = "vk_layer_settings_threaded.txt"
+& $dPath\vk_layer_validation_tests --gtest_filter=VkThreadedValidationTest.*
+$threadedResult = $lastexitcode
+Remove-Item env:VK_LAYER_SETTINGS_PATH
+if ($threadedResult -ne 0) {
+   exit 1
+}
+
+# Run the tests of asynchronous debug report delivery again with it turned on
+$env:VK_LAYER_SETTINGS_PATH = "vk_layer_settings_async_report.txt"
+& $dPath\vk_layer_validation_tests --gtest_filter=VkAsyncReportTest.*
+$asyncReportResult = $lastexitcode
+Remove-Item env:VK_LAYER_SETTINGS_PATH
+if ($asyncReportResult -ne 0) {
+   exit 1
+}
+
+# Run the tests of the layer's own validation cache file again with a file named
+$env:VK_LAYER_SETTINGS_PATH = "vk_layer_settings_validation_cache.txt"
+& $dPath\vk_layer_validation_tests --gtest_filter=VkValidationCacheFileTest.*
+$validationCacheResult = $lastexitcode
+Remove-Item env:VK_LAYER_SETTINGS_PATH
+if ($validationCacheResult -ne 0) {
+   exit 1
+}
+
 & .\vkvalidatelayerdoc.ps1
 
 exit $lastexitcode
@@ -0,0 +1,473 @@
+/*
+ * Copyright (c) 2015-2017 The Khronos Group Inc.
+ * Copyright (c) 2015-2017 Valve Corporation
+ * Copyright (c) 2015-2017 LunarG, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ */
+
+// Throughput measurements for the validation layers.  These time hot paths and print rates rather than check behavior,
+// so they live apart from vk_layer_validation_tests and run_all_tests.sh does not run them.  Run vk_layer_benchmarks by
+// hand, against the mock ICD to time the layers alone, and compare rates across vk_layer_settings.txt values.
+
+#ifdef ANDROID
+#include "vulkan_wrapper.h"
+#else
+#define NOMINMAX
+#include <vulkan/vulkan.h>
+#endif
+
+#include "test_common.h"
+#include "test_environment.h"
+#include "vkrenderframework.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <memory>
+
+// Benchmarks run valid workloads only; any error means the numbers aren't measuring what they claim to
+static VKAPI_ATTR VkBool32 VKAPI_CALL benchmarkDbgFunc(VkFlags msgFlags, VkDebugReportObjectTypeEXT objType,
+                                                       uint64_t srcObject, size_t location, int32_t msgCode,
+                                                       const char *pLayerPrefix, const char *pMsg, void *pUserData) {
+    if (msgFlags & VK_DEBUG_REPORT_ERROR_BIT_EXT) {
+        printf("Unexpected: %s\n", pMsg);
+        static_cast<std::atomic<uint32_t> *>(pUserData)->fetch_add(1);
+    }
+    return VK_FALSE;
+}
+
+class VkLayerBenchmark : public VkRenderFramework {
+   public:
+    void Init() {
+        InitFramework(benchmarkDbgFunc, &error_count_);
+        InitState();
+    }
+
+   protected:
+    std::atomic<uint32_t> error_count_;
+
+    virtual void SetUp() {
+        m_instance_layer_names.clear();
+        m_instance_extension_names.clear();
+        m_device_extension_names.clear();
+
+        m_instance_extension_names.push_back(VK_EXT_DEBUG_REPORT_EXTENSION_NAME);
+
+        // Same layer order as vk_layer_validation_tests
+        m_instance_layer_names.push_back("VK_LAYER_GOOGLE_threading");
+        m_instance_layer_names.push_back("VK_LAYER_LUNARG_parameter_validation");
+        m_instance_layer_names.push_back("VK_LAYER_LUNARG_object_tracker");
+        m_instance_layer_names.push_back("VK_LAYER_LUNARG_core_validation");
+        m_instance_layer_names.push_back("VK_LAYER_GOOGLE_unique_objects");
+
+        this->app_info.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO;
+        this->app_info.pNext = NULL;
+        this->app_info.pApplicationName = "layer_benchmarks";
+        this->app_info.applicationVersion = 1;
+        this->app_info.pEngineName = "unittest";
+        this->app_info.engineVersion = 1;
+        this->app_info.apiVersion = VK_API_VERSION_1_0;
+
+        error_count_ = 0;
+    }
+
+    virtual void TearDown() {
+        ShutdownFramework();
+        EXPECT_EQ(0u, error_count_.load());
+    }
+};
+
+#if GTEST_IS_THREADSAFE
+struct record_thread_data {
+    VkCommandBuffer command_buffer;
+    VkEvent event;
+    uint32_t iterations;
+};
+
+extern "C" void *RecordCommandBuffer(void *arg) {
+    auto data = reinterpret_cast<record_thread_data *>(arg);
+    VkViewport viewport = {0.0f, 0.0f, 16.0f, 16.0f, 0.0f, 1.0f};
+    VkRect2D scissor = {{0, 0}, {16, 16}};
+
+    for (uint32_t i = 0; i < data->iterations; i++) {
+        vkCmdSetViewport(data->command_buffer, 0, 1, &viewport);
+        vkCmdSetScissor(data->command_buffer, 0, 1, &scissor);
+        vkCmdSetEvent(data->command_buffer, data->event, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+        vkCmdResetEvent(data->command_buffer, data->event, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+    }
+    return NULL;
+}
+
+TEST_F(VkLayerBenchmark, ThreadedCommandBufferRecording) {
+    TEST_DESCRIPTION(
+        "Record the same commands into one command buffer per thread and report throughput for increasing thread counts. "
+        "Compare runs with lunarg_core_validation.command_buffer_locking set to true and false to see how recording scales.");
+
+    ASSERT_NO_FATAL_FAILURE(Init());
+
+    const uint32_t max_threads = 4;
+    const uint32_t iterations = 10000;
+    const uint32_t commands_per_iteration = 4;
+
+    VkEventCreateInfo event_info = {VK_STRUCTURE_TYPE_EVENT_CREATE_INFO, nullptr, 0};
+    VkEvent event;
+    ASSERT_VK_SUCCESS(vkCreateEvent(device(), &event_info, nullptr, &event));
+
+    // Command buffers from one pool may not be recorded concurrently, so give every thread its own pool
+    std::vector<std::unique_ptr<VkCommandPoolObj>> pools;
+    std::vector<std::unique_ptr<VkCommandBufferObj>> command_buffers;
+    std::vector<record_thread_data> data(max_threads);
+    for (uint32_t i = 0; i < max_threads; i++) {
+        pools.emplace_back(
+            new VkCommandPoolObj(m_device, m_device->graphics_queue_node_index_, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT));
+        command_buffers.emplace_back(new VkCommandBufferObj(m_device, pools.back().get()));
+        data[i] = {command_buffers.back()->handle(), event, iterations};
+    }
+
+    for (uint32_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+        std::vector<test_platform_thread> threads(thread_count);
+        for (uint32_t i = 0; i < thread_count; i++) {
+            command_buffers[i]->begin();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 1; i < thread_count; i++) {
+            test_platform_thread_create(&threads[i], RecordCommandBuffer, &data[i]);
+        }
+        RecordCommandBuffer(&data[0]);
+        for (uint32_t i = 1; i < thread_count; i++) {
+            test_platform_thread_join(threads[i], NULL);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        for (uint32_t i = 0; i < thread_count; i++) {
+            command_buffers[i]->end();
+        }
+        double commands = double(thread_count) * iterations * commands_per_iteration;
+        printf("             %u recording thread(s): %.0f commands/s\n", thread_count, commands / elapsed.count());
+    }
+
+    vkDestroyEvent(device(), event, nullptr);
+}
+
+struct shader_module_thread_data {
+    VkDevice device;
+    const std::vector<unsigned int> *spv;
+    uint32_t iterations;
+};
+
+extern "C" void *CreateShaderModules(void *arg) {
+    auto data = reinterpret_cast<shader_module_thread_data *>(arg);
+    VkShaderModuleCreateInfo module_ci = {};
+    module_ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    module_ci.codeSize = data->spv->size() * sizeof(unsigned int);
+    module_ci.pCode = data->spv->data();
+
+    for (uint32_t i = 0; i < data->iterations; i++) {
+        VkShaderModule module;
+        if (vkCreateShaderModule(data->device, &module_ci, nullptr, &module) == VK_SUCCESS) {
+            vkDestroyShaderModule(data->device, module, nullptr);
+        }
+    }
+    return NULL;
+}
+
+TEST_F(VkLayerBenchmark, ThreadedShaderModuleCreation) {
+    TEST_DESCRIPTION(
+        "Create shader modules from increasing numbers of threads and report throughput. SPIR-V validation shares one "
+        "context per device and takes no device-wide lock, so creation should scale with the thread count; compare runs "
+        "with lunarg_core_validation.async_shader_module_validation set to true and false.");
+
+    ASSERT_NO_FATAL_FAILURE(Init());
+
+    const uint32_t max_threads = 4;
+    const uint32_t iterations = 200;
+
+    static const char fs_source[] =
+        "#version 450\n"
+        "layout(location = 0) out vec4 color;\n"
+        "void main() {\n"
+        "   color = vec4(0, 1, 0, 1);\n"
+        "}\n";
+    std::vector<unsigned int> spv;
+    this->GLSLtoSPV(VK_SHADER_STAGE_FRAGMENT_BIT, fs_source, spv);
+    std::vector<shader_module_thread_data> data(max_threads, {device(), &spv, iterations});
+
+    for (uint32_t thread_count = 1; thread_count <= max_threads; thread_count *= 2) {
+        std::vector<test_platform_thread> threads(thread_count);
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 1; i < thread_count; i++) {
+            test_platform_thread_create(&threads[i], CreateShaderModules, &data[i]);
+        }
+        CreateShaderModules(&data[0]);
+        for (uint32_t i = 1; i < thread_count; i++) {
+            test_platform_thread_join(threads[i], NULL);
+        }
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        double modules = double(thread_count) * iterations;
+        printf("             %u creating thread(s): %.0f shader modules/s\n", thread_count, modules / elapsed.count());
+    }
+}
+#endif  // GTEST_IS_THREADSAFE
+
+TEST_F(VkLayerBenchmark, BindManyBuffersToOneAllocation) {
+    TEST_DESCRIPTION(
+        "Bind 100k buffers side by side into a single memory allocation and report bind throughput. Each bind is checked for "
+        "aliasing against the ranges already bound to the allocation, so this shows how that check scales.");
+
+    ASSERT_NO_FATAL_FAILURE(Init());
+
+    const uint32_t buffer_count = 100000;
+
+    VkBufferCreateInfo buffer_ci = {};
+    buffer_ci.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buffer_ci.size = 256;
+    buffer_ci.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    buffer_ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    std::vector<VkBuffer> buffers(buffer_count, VK_NULL_HANDLE);
+    for (auto &buffer : buffers) {
+        ASSERT_VK_SUCCESS(vkCreateBuffer(m_device->device(), &buffer_ci, NULL, &buffer));
+    }
+
+    VkMemoryRequirements mem_reqs;
+    vkGetBufferMemoryRequirements(m_device->device(), buffers[0], &mem_reqs);
+    const VkDeviceSize stride = (mem_reqs.size + mem_reqs.alignment - 1) & ~(mem_reqs.alignment - 1);
+
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = stride * buffer_count;
+    bool pass = m_device->phy().set_memory_type(mem_reqs.memoryTypeBits, &alloc_info, 0);
+    VkDeviceMemory mem = VK_NULL_HANDLE;
+    if (pass) pass = (vkAllocateMemory(m_device->device(), &alloc_info, NULL, &mem) == VK_SUCCESS);
+    if (!pass) {
+        printf("             Could not allocate memory for %u buffers; skipped.\n", buffer_count);
+        for (auto buffer : buffers) vkDestroyBuffer(m_device->device(), buffer, NULL);
+        return;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < buffer_count; i++) {
+        vkBindBufferMemory(m_device->device(), buffers[i], mem, i * stride);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("             %u buffer binds: %.0f binds/s\n", buffer_count, buffer_count / elapsed.count());
+
+    for (auto buffer : buffers) vkDestroyBuffer(m_device->device(), buffer, NULL);
+    vkFreeMemory(m_device->device(), mem, NULL);
+}
+
+TEST_F(VkLayerBenchmark, DescriptorUpdateTemplate) {
+    TEST_DESCRIPTION(
+        "Update a large uniform buffer array repeatedly, once with vkUpdateDescriptorSets and once with an equivalent descriptor "
+        "update template, and report the descriptor update rate of each.");
+
+    ASSERT_NO_FATAL_FAILURE(InitFramework(benchmarkDbgFunc, &error_count_));
+    if (DeviceExtensionSupported(gpu(), nullptr, VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME)) {
+        m_device_extension_names.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+    } else {
+        printf("             %s Extension not supported, skipping tests\n", VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+        return;
+    }
+    ASSERT_NO_FATAL_FAILURE(InitState());
+
+    auto vkCreateDescriptorUpdateTemplateKHR =
+        (PFN_vkCreateDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(m_device->device(), "vkCreateDescriptorUpdateTemplateKHR");
+    auto vkDestroyDescriptorUpdateTemplateKHR =
+        (PFN_vkDestroyDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(m_device->device(), "vkDestroyDescriptorUpdateTemplateKHR");
+    auto vkUpdateDescriptorSetWithTemplateKHR =
+        (PFN_vkUpdateDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(m_device->device(), "vkUpdateDescriptorSetWithTemplateKHR");
+    ASSERT_TRUE(vkCreateDescriptorUpdateTemplateKHR && vkDestroyDescriptorUpdateTemplateKHR &&
+                vkUpdateDescriptorSetWithTemplateKHR);
+
+    const uint32_t descriptor_count = std::min(256u, m_device->props.limits.maxPerStageDescriptorUniformBuffers);
+    const uint32_t iterations = 2000;
+
+    const VkDescriptorSetLayoutObj ds_layout(
+        m_device, {{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, descriptor_count, VK_SHADER_STAGE_ALL, nullptr}});
+    VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, descriptor_count};
+    VkDescriptorPoolCreateInfo pool_ci = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, nullptr, 0, 1, 1, &pool_size};
+    VkDescriptorPool pool;
+    ASSERT_VK_SUCCESS(vkCreateDescriptorPool(m_device->device(), &pool_ci, nullptr, &pool));
+    VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, pool, 1,
+                                              &ds_layout.handle()};
+    VkDescriptorSet set;
+    ASSERT_VK_SUCCESS(vkAllocateDescriptorSets(m_device->device(), &alloc_info, &set));
+
+    vk_testing::Buffer buffer;
+    buffer.init(*m_device, vk_testing::Buffer::create_info(256, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
+    const VkDescriptorBufferInfo buffer_info = {buffer.handle(), 0, VK_WHOLE_SIZE};
+    std::vector<VkDescriptorBufferInfo> buffer_infos(descriptor_count, buffer_info);
+
+    VkDescriptorUpdateTemplateEntryKHR entry = {0, 0, descriptor_count, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0,
+                                                sizeof(VkDescriptorBufferInfo)};
+    VkDescriptorUpdateTemplateCreateInfoKHR template_ci = {};
+    template_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+    template_ci.descriptorUpdateEntryCount = 1;
+    template_ci.pDescriptorUpdateEntries = &entry;
+    template_ci.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+    template_ci.descriptorSetLayout = ds_layout.handle();
+    VkDescriptorUpdateTemplateKHR update_template;
+    ASSERT_VK_SUCCESS(vkCreateDescriptorUpdateTemplateKHR(m_device->device(), &template_ci, nullptr, &update_template));
+
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = set;
+    write.dstBinding = 0;
+    write.descriptorCount = descriptor_count;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.pBufferInfo = buffer_infos.data();
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        vkUpdateDescriptorSets(m_device->device(), 1, &write, 0, nullptr);
+    }
+    std::chrono::duration<double> write_elapsed = std::chrono::steady_clock::now() - start;
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < iterations; i++) {
+        vkUpdateDescriptorSetWithTemplateKHR(m_device->device(), set, update_template, buffer_infos.data());
+    }
+    std::chrono::duration<double> template_elapsed = std::chrono::steady_clock::now() - start;
+
+    const double descriptors = double(iterations) * descriptor_count;
+    printf("             vkUpdateDescriptorSets: %.0f descriptors/s\n", descriptors / write_elapsed.count());
+    printf("             vkUpdateDescriptorSetWithTemplateKHR: %.0f descriptors/s\n", descriptors / template_elapsed.count());
+
+    vkDestroyDescriptorUpdateTemplateKHR(m_device->device(), update_template, nullptr);
+    vkDestroyDescriptorPool(m_device->device(), pool, nullptr);
+}
+
+TEST_F(VkLayerBenchmark, DescriptorPoolReset) {
+    TEST_DESCRIPTION(
+        "Allocate a pool's worth of descriptor sets and reset the pool, over and over, and report the allocation rate. Sets from "
+        "a pool without VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT come out of the pool's arena, which a reset rewinds.");
+
+    ASSERT_NO_FATAL_FAILURE(Init());
+
+    const uint32_t set_count = 1024;
+    const uint32_t frames = 100;
+
+    VkDescriptorSetLayoutBinding bindings[] = {
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, VK_SHADER_STAGE_ALL, nullptr},
+        {1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_ALL, nullptr},
+    };
+    const VkDescriptorSetLayoutObj ds_layout(m_device, {bindings[0], bindings[1]});
+    std::vector<VkDescriptorSetLayout> layouts(set_count, ds_layout.handle());
+
+    VkDescriptorPoolSize pool_sizes[] = {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 * set_count},
+                                         {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, set_count}};
+    VkDescriptorPoolCreateInfo pool_ci = {};
+    pool_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_ci.maxSets = set_count;
+    pool_ci.poolSizeCount = 2;
+    pool_ci.pPoolSizes = pool_sizes;
+    VkDescriptorPool pool;
+    ASSERT_VK_SUCCESS(vkCreateDescriptorPool(m_device->device(), &pool_ci, nullptr, &pool));
+
+    VkDescriptorSetAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = pool;
+    alloc_info.descriptorSetCount = set_count;
+    alloc_info.pSetLayouts = layouts.data();
+    std::vector<VkDescriptorSet> sets(set_count);
+
+    vk_testing::Buffer buffer;
+    buffer.init(*m_device, vk_testing::Buffer::create_info(256, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
+    const VkDescriptorBufferInfo buffer_info[] = {{buffer.handle(), 0, VK_WHOLE_SIZE}, {buffer.handle(), 0, VK_WHOLE_SIZE}};
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstBinding = 0;
+    write.descriptorCount = 2;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.pBufferInfo = buffer_info;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < frames; frame++) {
+        ASSERT_VK_SUCCESS(vkAllocateDescriptorSets(m_device->device(), &alloc_info, sets.data()));
+        write.dstSet = sets[frame % set_count];
+        vkUpdateDescriptorSets(m_device->device(), 1, &write, 0, nullptr);
+        ASSERT_VK_SUCCESS(vkResetDescriptorPool(m_device->device(), pool, 0));
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    printf("             vkAllocateDescriptorSets + vkResetDescriptorPool: %.0f sets/s\n",
+           double(frames) * set_count / elapsed.count());
+
+    vkDestroyDescriptorPool(m_device->device(), pool, nullptr);
+}
+
+TEST_F(VkLayerBenchmark, CreateGraphicsPipelinesBatch) {
+    TEST_DESCRIPTION(
+        "Create a large batch of graphics pipelines in one vkCreateGraphicsPipelines call and report the pipeline creation rate. "
+        "Against the mock ICD, where pipeline creation itself is nearly free, this measures pipeline validation; compare runs "
+        "with different lunarg_core_validation.pipeline_validation_threads settings.");
+
+    ASSERT_NO_FATAL_FAILURE(Init());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    const uint32_t pipeline_count = 512;
+
+    static const char vs_source[] =
+        "#version 450\n"
+        "void main() {\n"
+        "   gl_Position = vec4(float(gl_VertexIndex % 2), float(gl_VertexIndex / 2), 0.0, 1.0);\n"
+        "}\n";
+    static const char fs_source[] =
+        "#version 450\n"
+        "layout(location = 0) out vec4 color;\n"
+        "void main() {\n"
+        "   color = vec4(0, 1, 0, 1);\n"
+        "}\n";
+    VkShaderObj vs(m_device, vs_source, VK_SHADER_STAGE_VERTEX_BIT, this);
+    VkShaderObj fs(m_device, fs_source, VK_SHADER_STAGE_FRAGMENT_BIT, this);
+    VkPipelineObj pipe(m_device);
+    pipe.AddShader(&vs);
+    pipe.AddShader(&fs);
+    pipe.AddDefaultColorAttachment();
+    const VkPipelineLayoutObj pipeline_layout(m_device);
+
+    VkGraphicsPipelineCreateInfo gp_ci = {};
+    pipe.InitGraphicsPipelineCreateInfo(&gp_ci);
+    gp_ci.layout = pipeline_layout.handle();
+    gp_ci.renderPass = renderPass();
+    std::vector<VkGraphicsPipelineCreateInfo> create_infos(pipeline_count, gp_ci);
+    std::vector<VkPipeline> pipelines(pipeline_count, VK_NULL_HANDLE);
+
+    auto start = std::chrono::steady_clock::now();
+    VkResult err = vkCreateGraphicsPipelines(m_device->device(), VK_NULL_HANDLE, pipeline_count, create_infos.data(), nullptr,
+                                             pipelines.data());
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    ASSERT_VK_SUCCESS(err);
+    printf("             vkCreateGraphicsPipelines: %.0f pipelines/s\n", pipeline_count / elapsed.count());
+
+    for (auto pipeline : pipelines) {
+        vkDestroyPipeline(m_device->device(), pipeline, nullptr);
+    }
+}
+
+int main(int argc, char **argv) {
+    int result;
+
+#ifdef ANDROID
+    int vulkanSupport = InitVulkan();
+    if (vulkanSupport == 0) return 1;
+#endif
+
+    ::testing::InitGoogleTest(&argc, argv);
+    VkTestFramework::InitArgs(&argc, argv);
+
+    ::testing::AddGlobalTestEnvironment(new TestEnvironment);
+
+    result = RUN_ALL_TESTS();
+
+    VkTestFramework::Finish();
+    return result;
+}
@@ -39,16 +39,26 @@
 #include "icd-spv.h"
 #include "test_common.h"
 #include "vk_layer_config.h"
+#include "vk_layer_handle_table.h"
+#include "vk_layer_logging.h"
+#include "vk_layer_thread_counter.h"
 #include "vk_format_utils.h"
 #include "vk_validation_error_messages.h"
 #include "vkrenderframework.h"
 #include "vk_typemap_helper.h"
+// The validation cache file tests hash shader modules the way core_validation does
+#define XXH_PRIVATE_API
+#include "xxhash.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
 #include <functional>
 #include <limits>
 #include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 #include <unordered_set>
 
 //--------------------------------------------------------------------------------------
@@ -696,6 +706,47 @@ class VkWsiEnabledLayerTest : public VkLayerTest {
     VkWsiEnabledLayerTest() { m_enableWSI = true; }
 };
 
+// Tests of validation that the layers can spread across worker threads.  They skip unless vk_layer_settings.txt turns those
+// threads on, which vk_layer_settings_threaded.txt does; run_all_tests.sh runs them again with it.
+class VkThreadedValidationTest : public VkLayerTest {
+   public:
+   protected:
+};
+
+// Tests of debug report messages delivered on a logger thread.  They skip unless vk_layer_settings.txt turns
+// async_debug_report on, which vk_layer_settings_async_report.txt does; run_all_tests.sh runs them again with it.
+class VkAsyncReportTest : public VkLayerTest {
+   public:
+   protected:
+};
+
+// Tests of the validation cache that core_validation keeps in a file of its own.  They skip unless vk_layer_settings.txt
+// names the file, which vk_layer_settings_validation_cache.txt does; run_all_tests.sh runs them again with it.
+class VkValidationCacheFileTest : public VkLayerTest {
+   public:
+   protected:
+};
+
+// Collects the error messages reported to it, and the thread each one was reported on, for tests that check message order
+// or delivery themselves rather than through ErrorMonitor
+struct debug_message_log {
+    std::mutex lock;
+    std::vector<std::string> messages;
+    std::vector<std::thread::id> threads;
+};
+
+static VKAPI_ATTR VkBool32 VKAPI_CALL recordDbgFunc(VkFlags msgFlags, VkDebugReportObjectTypeEXT objType, uint64_t srcObject,
+                                                    size_t location, int32_t msgCode, const char *pLayerPrefix, const char *pMsg,
+                                                    void *pUserData) {
+    if (!(msgFlags & VK_DEBUG_REPORT_ERROR_BIT_EXT)) return VK_FALSE;
+    auto log = static_cast<debug_message_log *>(pUserData);
+    std::lock_guard<std::mutex> lock(log->lock);
+    log->messages.push_back(pMsg);
+    log->threads.push_back(std::this_thread::get_id());
+    // Skip the call, as ErrorMonitor does for the errors it expects
+    return VK_TRUE;
+}
+
 class VkBufferTest {
    public:
     enum eTestEnFlags {
@@ -2030,6 +2081,98 @@ TEST_F(VkLayerTest, InvalidMemoryAliasing) {
     vkFreeMemory(m_device->device(), mem_img, NULL);
 }
 
+TEST_F(VkLayerTest, MemoryAliasingAtGranularityEdges) {
+    TEST_DESCRIPTION(
+        "Bind buffers just below, across, and just above an optimally tiled image in one allocation, and check that only the "
+        "binds sharing a bufferImageGranularity page with the image warn about aliasing.");
+    ASSERT_NO_FATAL_FAILURE(Init());
+
+    const VkDeviceSize granularity = m_device->props.limits.bufferImageGranularity;
+    auto round_down = [](VkDeviceSize value, VkDeviceSize align) { return value & ~(align - 1); };
+    auto round_up = [](VkDeviceSize value, VkDeviceSize align) { return (value + align - 1) & ~(align - 1); };
+
+    VkBufferCreateInfo buf_info = {};
+    buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buf_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    buf_info.size = 256;
+    buf_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer below, across, above, padded;
+    ASSERT_VK_SUCCESS(vkCreateBuffer(m_device->device(), &buf_info, NULL, &below));
+    ASSERT_VK_SUCCESS(vkCreateBuffer(m_device->device(), &buf_info, NULL, &across));
+    ASSERT_VK_SUCCESS(vkCreateBuffer(m_device->device(), &buf_info, NULL, &above));
+    ASSERT_VK_SUCCESS(vkCreateBuffer(m_device->device(), &buf_info, NULL, &padded));
+    VkMemoryRequirements buf_reqs;
+    vkGetBufferMemoryRequirements(m_device->device(), below, &buf_reqs);
+
+    VkImageCreateInfo image_create_info = {};
+    image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_create_info.imageType = VK_IMAGE_TYPE_2D;
+    image_create_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+    image_create_info.extent = {64, 64, 1};
+    image_create_info.mipLevels = 1;
+    image_create_info.arrayLayers = 1;
+    image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image_create_info.usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    image_create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkImage image;
+    ASSERT_VK_SUCCESS(vkCreateImage(m_device->device(), &image_create_info, NULL, &image));
+    VkMemoryRequirements img_reqs;
+    vkGetImageMemoryRequirements(m_device->device(), image, &img_reqs);
+
+    // The image starts on a granularity page boundary with room for a buffer below it
+    const VkDeviceSize page = std::max(granularity, std::max(buf_reqs.alignment, img_reqs.alignment));
+    const VkDeviceSize image_offset = round_up(buf_reqs.size, page) + page;
+    const VkDeviceSize image_end = image_offset + img_reqs.size - 1;
+    // Last byte just below the image's first page, then one alignment step higher so it runs into the image
+    const VkDeviceSize below_offset = round_down(image_offset - buf_reqs.size, buf_reqs.alignment);
+    const VkDeviceSize across_offset = below_offset + buf_reqs.alignment;
+    // First page past the image's last byte
+    const VkDeviceSize above_offset = round_up(image_end + 1, page);
+    // Right after the image; this only shares the image's last page when the image doesn't end on a page boundary
+    const VkDeviceSize padded_offset = round_up(image_end + 1, buf_reqs.alignment);
+    const bool padded_aliases = round_down(padded_offset, granularity) == round_down(image_end, granularity);
+
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.allocationSize = above_offset + buf_reqs.size;
+    bool pass = m_device->phy().set_memory_type(buf_reqs.memoryTypeBits & img_reqs.memoryTypeBits, &alloc_info, 0);
+    VkDeviceMemory mem = VK_NULL_HANDLE;
+    if (pass) pass = (vkAllocateMemory(m_device->device(), &alloc_info, NULL, &mem) == VK_SUCCESS);
+    if (!pass) {
+        printf("             No memory type shared by the buffers and the image; skipped.\n");
+    } else {
+        m_errorMonitor->ExpectSuccess(VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT);
+        vkBindImageMemory(m_device->device(), image, mem, image_offset);
+        vkBindBufferMemory(m_device->device(), below, mem, below_offset);
+        vkBindBufferMemory(m_device->device(), above, mem, above_offset);
+        m_errorMonitor->VerifyNotFound();
+
+        // Overlaps the image by at least one byte, and also overlaps the linear buffer below, which is fine
+        m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_WARNING_BIT_EXT, "is aliased with non-linear image 0x");
+        vkBindBufferMemory(m_device->device(), across, mem, across_offset);
+        m_errorMonitor->VerifyFound();
+
+        if (padded_aliases) {
+            m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_WARNING_BIT_EXT, "is aliased with non-linear image 0x");
+            vkBindBufferMemory(m_device->device(), padded, mem, padded_offset);
+            m_errorMonitor->VerifyFound();
+        } else {
+            m_errorMonitor->ExpectSuccess(VK_DEBUG_REPORT_ERROR_BIT_EXT | VK_DEBUG_REPORT_WARNING_BIT_EXT);
+            vkBindBufferMemory(m_device->device(), padded, mem, padded_offset);
+            m_errorMonitor->VerifyNotFound();
+        }
+    }
+
+    vkDestroyBuffer(m_device->device(), below, NULL);
+    vkDestroyBuffer(m_device->device(), across, NULL);
+    vkDestroyBuffer(m_device->device(), above, NULL);
+    vkDestroyBuffer(m_device->device(), padded, NULL);
+    vkDestroyImage(m_device->device(), image, NULL);
+    if (mem != VK_NULL_HANDLE) vkFreeMemory(m_device->device(), mem, NULL);
+}
+
 TEST_F(VkLayerTest, InvalidMemoryMapping) {
     TEST_DESCRIPTION("Attempt to map memory in a number of incorrect ways");
     VkResult err;
@@ -10203,6 +10346,63 @@ TEST_F(VkLayerTest, DynViewportAndScissorUndefinedDrawState) {
     m_errorMonitor->VerifyFound();
 }
 
+TEST_F(VkLayerTest, DrawStateRevalidatedAfterRebind) {
+    TEST_DESCRIPTION("Repeat draws with unchanged state, then check that rebinding and dynamic state changes are still validated");
+
+    ASSERT_NO_FATAL_FAILURE(Init());
+    ASSERT_NO_FATAL_FAILURE(InitViewport());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    VkShaderObj vs(m_device, bindStateVertShaderText, VK_SHADER_STAGE_VERTEX_BIT, this);
+    VkShaderObj fs(m_device, bindStateFragShaderText, VK_SHADER_STAGE_FRAGMENT_BIT, this);
+
+    const VkPipelineLayoutObj pipeline_layout(m_device);
+
+    VkPipelineObj pipeline_static(m_device);
+    pipeline_static.AddShader(&vs);
+    pipeline_static.AddShader(&fs);
+    pipeline_static.AddDefaultColorAttachment();
+    pipeline_static.SetViewport(m_viewports);
+    pipeline_static.SetScissor(m_scissors);
+    ASSERT_VK_SUCCESS(pipeline_static.CreateVKPipeline(pipeline_layout.handle(), m_renderPass));
+
+    VkPipelineObj pipeline_dyn_vp(m_device);
+    pipeline_dyn_vp.AddShader(&vs);
+    pipeline_dyn_vp.AddShader(&fs);
+    pipeline_dyn_vp.AddDefaultColorAttachment();
+    pipeline_dyn_vp.MakeDynamic(VK_DYNAMIC_STATE_VIEWPORT);
+    pipeline_dyn_vp.SetScissor(m_scissors);
+    ASSERT_VK_SUCCESS(pipeline_dyn_vp.CreateVKPipeline(pipeline_layout.handle(), m_renderPass));
+
+    m_commandBuffer->begin();
+    m_commandBuffer->BeginRenderPass(m_renderPassBeginInfo);
+
+    m_errorMonitor->ExpectSuccess();
+    vkCmdBindPipeline(m_commandBuffer->handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_static.handle());
+    for (uint32_t i = 0; i < 8; i++) {
+        m_commandBuffer->Draw(1, 0, 0, 0);
+    }
+    m_errorMonitor->VerifyNotFound();
+
+    // Rebinding must be noticed even after many identical draws, and a bad draw must keep reporting while nothing changes
+    vkCmdBindPipeline(m_commandBuffer->handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_dyn_vp.handle());
+    for (uint32_t i = 0; i < 2; i++) {
+        m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT,
+                                             "Dynamic viewport(s) 0 are used by pipeline state object, ");
+        m_commandBuffer->Draw(1, 0, 0, 0);
+        m_errorMonitor->VerifyFound();
+    }
+
+    m_errorMonitor->ExpectSuccess();
+    vkCmdSetViewport(m_commandBuffer->handle(), 0, 1, &m_viewports[0]);
+    m_commandBuffer->Draw(1, 0, 0, 0);
+    m_commandBuffer->Draw(1, 0, 0, 0);
+    m_errorMonitor->VerifyNotFound();
+
+    m_commandBuffer->EndRenderPass();
+    m_commandBuffer->end();
+}
+
 TEST_F(VkLayerTest, PSOLineWidthInvalid) {
     TEST_DESCRIPTION("Test non-1.0 lineWidth errors when pipeline is created and in vkCmdSetLineWidth");
     VkPhysicalDeviceFeatures features{};
@@ -12090,6 +12290,82 @@ TEST_F(VkLayerTest, ValidationCacheTestBadMerge) {
     fpDestroyValidationCache(m_device->device(), validationCache, nullptr);
 }
 
+TEST_F(VkPositiveLayerTest, ValidationCacheRoundTrip) {
+    TEST_DESCRIPTION("Check that validation cache data survives being loaded into a new cache and written out again.");
+
+    ASSERT_NO_FATAL_FAILURE(InitFramework(myDbgFunc, m_errorMonitor));
+    if (DeviceExtensionSupported(gpu(), "VK_LAYER_LUNARG_core_validation", VK_EXT_VALIDATION_CACHE_EXTENSION_NAME)) {
+        m_device_extension_names.push_back(VK_EXT_VALIDATION_CACHE_EXTENSION_NAME);
+    } else {
+        printf("             %s not supported, skipping test\n", VK_EXT_VALIDATION_CACHE_EXTENSION_NAME);
+        return;
+    }
+    ASSERT_NO_FATAL_FAILURE(InitState());
+
+    auto fpCreateValidationCache =
+        (PFN_vkCreateValidationCacheEXT)vkGetDeviceProcAddr(m_device->device(), "vkCreateValidationCacheEXT");
+    auto fpDestroyValidationCache =
+        (PFN_vkDestroyValidationCacheEXT)vkGetDeviceProcAddr(m_device->device(), "vkDestroyValidationCacheEXT");
+    auto fpGetValidationCacheData =
+        (PFN_vkGetValidationCacheDataEXT)vkGetDeviceProcAddr(m_device->device(), "vkGetValidationCacheDataEXT");
+    if (!fpCreateValidationCache || !fpDestroyValidationCache || !fpGetValidationCacheData) {
+        printf("             Failed to load function pointers for %s\n", VK_EXT_VALIDATION_CACHE_EXTENSION_NAME);
+        return;
+    }
+
+    m_errorMonitor->ExpectSuccess();
+
+    VkValidationCacheCreateInfoEXT cache_ci = {};
+    cache_ci.sType = VK_STRUCTURE_TYPE_VALIDATION_CACHE_CREATE_INFO_EXT;
+    VkValidationCacheEXT cache = VK_NULL_HANDLE;
+    ASSERT_VK_SUCCESS(fpCreateValidationCache(m_device->device(), &cache_ci, nullptr, &cache));
+
+    size_t empty_size = 0;
+    fpGetValidationCacheData(m_device->device(), cache, &empty_size, nullptr);
+
+    // Each module that passes validation adds an entry
+    VkShaderModuleValidationCacheCreateInfoEXT module_cache_ci = {};
+    module_cache_ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_VALIDATION_CACHE_CREATE_INFO_EXT;
+    module_cache_ci.validationCache = cache;
+    char const *sources[2] = {bindStateVertShaderText, bindStateFragShaderText};
+    VkShaderStageFlagBits stages[2] = {VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT};
+    for (uint32_t i = 0; i < 2; i++) {
+        std::vector<unsigned int> spv;
+        this->GLSLtoSPV(stages[i], sources[i], spv);
+        VkShaderModuleCreateInfo module_ci = {};
+        module_ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        module_ci.pNext = &module_cache_ci;
+        module_ci.codeSize = spv.size() * sizeof(unsigned int);
+        module_ci.pCode = spv.data();
+        VkShaderModule module;
+        ASSERT_VK_SUCCESS(vkCreateShaderModule(m_device->device(), &module_ci, nullptr, &module));
+        vkDestroyShaderModule(m_device->device(), module, nullptr);
+    }
+
+    size_t size = 0;
+    fpGetValidationCacheData(m_device->device(), cache, &size, nullptr);
+    ASSERT_GT(size, empty_size);
+    std::vector<uint8_t> data(size);
+    fpGetValidationCacheData(m_device->device(), cache, &size, data.data());
+    ASSERT_EQ(data.size(), size);
+
+    cache_ci.initialDataSize = data.size();
+    cache_ci.pInitialData = data.data();
+    VkValidationCacheEXT reloaded = VK_NULL_HANDLE;
+    ASSERT_VK_SUCCESS(fpCreateValidationCache(m_device->device(), &cache_ci, nullptr, &reloaded));
+
+    size_t reloaded_size = 0;
+    fpGetValidationCacheData(m_device->device(), reloaded, &reloaded_size, nullptr);
+    ASSERT_EQ(size, reloaded_size);
+    std::vector<uint8_t> reloaded_data(reloaded_size);
+    fpGetValidationCacheData(m_device->device(), reloaded, &reloaded_size, reloaded_data.data());
+    ASSERT_TRUE(data == reloaded_data);
+
+    fpDestroyValidationCache(m_device->device(), reloaded, nullptr);
+    fpDestroyValidationCache(m_device->device(), cache, nullptr);
+    m_errorMonitor->VerifyNotFound();
+}
+
 TEST_F(VkPositiveLayerTest, LayoutFromPresentWithoutAccessMemoryRead) {
     // Transition an image away from PRESENT_SRC_KHR without ACCESS_MEMORY_READ
     // in srcAccessMask.
@@ -14000,6 +14276,73 @@ TEST_F(VkLayerTest, InvalidImageLayout) {
     vkDestroyImage(m_device->device(), depth_image, NULL);
 }
 
+TEST_F(VkLayerTest, ImageLayoutSubresourceRanges) {
+    TEST_DESCRIPTION("Track layouts of overlapping subresource ranges of a mipmapped array image through barriers and submits.");
+    ASSERT_NO_FATAL_FAILURE(Init());
+
+    VkImageObj image(m_device);
+    VkImageCreateInfo image_create_info = {};
+    image_create_info.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+    image_create_info.imageType = VK_IMAGE_TYPE_2D;
+    image_create_info.format = VK_FORMAT_R8G8B8A8_UNORM;
+    image_create_info.extent = {32, 32, 1};
+    image_create_info.mipLevels = 4;
+    image_create_info.arrayLayers = 8;
+    image_create_info.samples = VK_SAMPLE_COUNT_1_BIT;
+    image_create_info.tiling = VK_IMAGE_TILING_OPTIMAL;
+    image_create_info.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    image_create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    image.init(&image_create_info);
+    ASSERT_TRUE(image.initialized());
+
+    VkImageMemoryBarrier barrier = {};
+    barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = image.handle();
+    const VkImageSubresourceRange whole_image = {VK_IMAGE_ASPECT_COLOR_BIT, 0, VK_REMAINING_MIP_LEVELS, 0,
+                                                 VK_REMAINING_ARRAY_LAYERS};
+    const VkImageSubresourceRange middle_layers = {VK_IMAGE_ASPECT_COLOR_BIT, 1, 2, 2, 4};
+    auto transition = [&](VkImageSubresourceRange range, VkImageLayout old_layout, VkImageLayout new_layout) {
+        barrier.subresourceRange = range;
+        barrier.oldLayout = old_layout;
+        barrier.newLayout = new_layout;
+        vkCmdPipelineBarrier(m_commandBuffer->handle(), VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0,
+                             0, nullptr, 0, nullptr, 1, &barrier);
+    };
+
+    m_errorMonitor->ExpectSuccess();
+    m_commandBuffer->begin();
+    transition(whole_image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    transition(middle_layers, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+    m_errorMonitor->VerifyNotFound();
+
+    // Only the middle layers of levels 1 and 2 are in the wrong layout
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT,
+                                         "you cannot transition the layout of aspect 1 from VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL "
+                                         "when current layout is VK_IMAGE_LAYOUT_GENERAL.");
+    transition(whole_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    m_errorMonitor->VerifyFound();
+
+    // The failed barrier was skipped, so bring the middle layers back first.  The submit must then carry the whole image's
+    // SHADER_READ_ONLY_OPTIMAL layout over to the next command buffer.
+    m_errorMonitor->ExpectSuccess();
+    transition(middle_layers, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+    transition(whole_image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    m_commandBuffer->end();
+    m_commandBuffer->QueueCommandBuffer(false);
+    m_errorMonitor->VerifyNotFound();
+
+    m_commandBuffer->begin();
+    transition(middle_layers, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_GENERAL);
+    m_commandBuffer->end();
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT,
+                                         "with layout VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL when first use is "
+                                         "VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL.");
+    m_commandBuffer->QueueCommandBuffer(false);
+    m_errorMonitor->VerifyFound();
+}
+
 TEST_F(VkLayerTest, InvalidStorageImageLayout) {
     TEST_DESCRIPTION("Attempt to update a STORAGE_IMAGE descriptor w/o GENERAL layout.");
 
@@ -15471,112 +15814,400 @@ TEST_F(VkLayerTest, ThreadCommandBufferCollision) {
 }
 #endif  // GTEST_IS_THREADSAFE
 
-TEST_F(VkLayerTest, InvalidSPIRVCodeSize) {
-    TEST_DESCRIPTION("Test that errors are produced for a spirv modules with invalid code sizes");
-
-    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, "Invalid SPIR-V header");
-
-    ASSERT_NO_FATAL_FAILURE(Init());
-    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
-
-    VkShaderModule module;
-    VkShaderModuleCreateInfo moduleCreateInfo;
-    struct icd_spv_header spv;
-
-    spv.magic = ICD_SPV_MAGIC;
-    spv.version = ICD_SPV_VERSION;
-    spv.gen_magic = 0;
-
-    moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    moduleCreateInfo.pNext = NULL;
-    moduleCreateInfo.pCode = (const uint32_t *)&spv;
-    moduleCreateInfo.codeSize = 4;
-    moduleCreateInfo.flags = 0;
-    vkCreateShaderModule(m_device->device(), &moduleCreateInfo, NULL, &module);
-
-    m_errorMonitor->VerifyFound();
-
+// SPIR-V that spirv-val rejects, but that async_shader_module_validation lets vkCreateShaderModule accept
+static std::vector<unsigned int> InvalidSpirv(VkRenderFramework *framework) {
     char const *vsSource =
         "#version 450\n"
         "\n"
-        "layout(location=0) out float x;\n"
+        "layout(xfb_buffer = 1) out;\n"
         "void main(){\n"
         "   gl_Position = vec4(1);\n"
-        "   x = 0;\n"
         "}\n";
+    std::vector<unsigned int> spv;
+    framework->GLSLtoSPV(VK_SHADER_STAGE_VERTEX_BIT, vsSource, spv);
+    return spv;
+}
 
-    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, VALIDATION_ERROR_12a00ac0);
-    std::vector<unsigned int> shader;
-    VkShaderModuleCreateInfo module_create_info;
-    VkShaderModule shader_module;
-    module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    module_create_info.pNext = NULL;
-    this->GLSLtoSPV(VK_SHADER_STAGE_VERTEX_BIT, vsSource, shader);
-    module_create_info.pCode = shader.data();
-    // Introduce failure by making codeSize a non-multiple of 4
-    module_create_info.codeSize = shader.size() * sizeof(unsigned int) - 1;
-    module_create_info.flags = 0;
-    vkCreateShaderModule(m_device->handle(), &module_create_info, NULL, &shader_module);
-
-    m_errorMonitor->VerifyFound();
+static VkResult CreateModuleWithInvalidSpirv(VkRenderFramework *framework, VkDevice device, VkShaderModule *module) {
+    std::vector<unsigned int> spv = InvalidSpirv(framework);
+    VkShaderModuleCreateInfo module_ci = {};
+    module_ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    module_ci.codeSize = spv.size() * sizeof(unsigned int);
+    module_ci.pCode = spv.data();
+    return vkCreateShaderModule(device, &module_ci, nullptr, module);
 }
 
-TEST_F(VkLayerTest, InvalidSPIRVMagic) {
-    TEST_DESCRIPTION("Test that an error is produced for a spirv module with a bad magic number");
+static const char kInvalidSpirvMessage[] = "Capability TransformFeedback is not allowed by Vulkan";
 
-    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, "Invalid SPIR-V magic number");
+TEST_F(VkThreadedValidationTest, AsyncShaderModuleErrorAtPipelineCreation) {
+    TEST_DESCRIPTION(
+        "With async_shader_module_validation, create a shader module that spirv-val rejects. vkCreateShaderModule succeeds, "
+        "and the first pipeline to use the module reports the error and fails; destroying the module then reports nothing "
+        "more.");
 
+    if (strcmp(getLayerOption("lunarg_core_validation.async_shader_module_validation"), "true")) {
+        printf("             lunarg_core_validation.async_shader_module_validation is not set; skipped.\n");
+        return;
+    }
     ASSERT_NO_FATAL_FAILURE(Init());
     ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
 
     VkShaderModule module;
-    VkShaderModuleCreateInfo moduleCreateInfo;
-    struct icd_spv_header spv;
-
-    spv.magic = (uint32_t)~ICD_SPV_MAGIC;
-    spv.version = ICD_SPV_VERSION;
-    spv.gen_magic = 0;
-
-    moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-    moduleCreateInfo.pNext = NULL;
-    moduleCreateInfo.pCode = (const uint32_t *)&spv;
-    moduleCreateInfo.codeSize = sizeof(spv) + 16;
-    moduleCreateInfo.flags = 0;
-    vkCreateShaderModule(m_device->device(), &moduleCreateInfo, NULL, &module);
+    m_errorMonitor->ExpectSuccess();
+    ASSERT_VK_SUCCESS(CreateModuleWithInvalidSpirv(this, m_device->device(), &module));
+    m_errorMonitor->VerifyNotFound();
 
+    CreatePipelineHelper pipe(*this);
+    pipe.InitInfo();
+    pipe.shader_stages_[0].module = module;
+    pipe.InitState();
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, kInvalidSpirvMessage);
+    EXPECT_EQ(VK_ERROR_VALIDATION_FAILED_EXT, pipe.CreateGraphicsPipeline());
     m_errorMonitor->VerifyFound();
+
+    m_errorMonitor->ExpectSuccess();
+    vkDestroyShaderModule(m_device->device(), module, nullptr);
+    m_errorMonitor->VerifyNotFound();
 }
 
-TEST_F(VkLayerTest, CreatePipelineVertexOutputNotConsumed) {
-    TEST_DESCRIPTION("Test that a warning is produced for a vertex output that is not consumed by the fragment stage");
-    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, "not consumed by fragment shader");
+TEST_F(VkThreadedValidationTest, AsyncShaderModuleErrorAtDestroy) {
+    TEST_DESCRIPTION(
+        "With async_shader_module_validation, create shader modules that spirv-val rejects and that no pipeline uses. The "
+        "error is reported when the module is destroyed, or, for a module left alive, when its device is.");
 
+    if (strcmp(getLayerOption("lunarg_core_validation.async_shader_module_validation"), "true")) {
+        printf("             lunarg_core_validation.async_shader_module_validation is not set; skipped.\n");
+        return;
+    }
     ASSERT_NO_FATAL_FAILURE(Init());
-    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
-
-    char const *vsSource =
-        "#version 450\n"
-        "\n"
-        "layout(location=0) out float x;\n"
-        "void main(){\n"
-        "   gl_Position = vec4(1);\n"
-        "   x = 0;\n"
-        "}\n";
-    char const *fsSource =
-        "#version 450\n"
-        "\n"
-        "layout(location=0) out vec4 color;\n"
-        "void main(){\n"
-        "   color = vec4(1);\n"
-        "}\n";
 
-    VkShaderObj vs(m_device, vsSource, VK_SHADER_STAGE_VERTEX_BIT, this);
-    VkShaderObj fs(m_device, fsSource, VK_SHADER_STAGE_FRAGMENT_BIT, this);
+    VkShaderModule module;
+    m_errorMonitor->ExpectSuccess();
+    ASSERT_VK_SUCCESS(CreateModuleWithInvalidSpirv(this, m_device->device(), &module));
+    m_errorMonitor->VerifyNotFound();
 
-    VkPipelineObj pipe(m_device);
-    pipe.AddDefaultColorAttachment();
-    pipe.AddShader(&vs);
-    pipe.AddShader(&fs);
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, kInvalidSpirvMessage);
+    vkDestroyShaderModule(m_device->device(), module, nullptr);
+    m_errorMonitor->VerifyFound();
+
+    std::vector<const char *> device_extension_names;
+    std::unique_ptr<VkDeviceObj> test_device(new VkDeviceObj(0, gpu(), device_extension_names));
+    m_errorMonitor->ExpectSuccess();
+    ASSERT_VK_SUCCESS(CreateModuleWithInvalidSpirv(this, test_device->device(), &module));
+    m_errorMonitor->VerifyNotFound();
+
+    // object_tracker reports the leaked module too
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, kInvalidSpirvMessage);
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, VALIDATION_ERROR_24a002f4);
+    test_device.reset();
+    m_errorMonitor->VerifyFound();
+}
+
+static std::vector<uint8_t> ReadWholeFile(const char *path) {
+    std::vector<uint8_t> data;
+    FILE *file = fopen(path, "rb");
+    if (!file) return data;
+    uint8_t buffer[4096];
+    size_t read;
+    while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0) data.insert(data.end(), buffer, buffer + read);
+    fclose(file);
+    return data;
+}
+
+static void WriteWholeFile(const char *path, const std::vector<uint8_t> &data) {
+    FILE *file = fopen(path, "wb");
+    ASSERT_TRUE(file != nullptr) << path;
+    EXPECT_EQ(data.size(), fwrite(data.data(), 1, data.size(), file));
+    fclose(file);
+}
+
+static void AppendBytes(std::vector<uint8_t> *data, const void *bytes, size_t size) {
+    data->insert(data->end(), static_cast<const uint8_t *>(bytes), static_cast<const uint8_t *>(bytes) + size);
+}
+
+// A device that can create VkValidationCacheEXT objects.  core_validation loads its validation cache file when the device is
+// created, and stores it when the device is destroyed.
+static std::unique_ptr<VkDeviceObj> CreateValidationCacheDevice(VkPhysicalDevice gpu) {
+    std::vector<const char *> device_extension_names = {VK_EXT_VALIDATION_CACHE_EXTENSION_NAME};
+    std::unique_ptr<VkDeviceObj> device(new VkDeviceObj(0, gpu, device_extension_names));
+    return device;
+}
+
+// The data of a validation cache that is created from initial_data, then has module_ci created against it
+static std::vector<uint8_t> ValidationCacheDataAfterModule(VkDevice device, const std::vector<uint8_t> &initial_data,
+                                                           VkShaderModuleCreateInfo module_ci) {
+    auto fpCreateValidationCache = (PFN_vkCreateValidationCacheEXT)vkGetDeviceProcAddr(device, "vkCreateValidationCacheEXT");
+    auto fpDestroyValidationCache = (PFN_vkDestroyValidationCacheEXT)vkGetDeviceProcAddr(device, "vkDestroyValidationCacheEXT");
+    auto fpGetValidationCacheData = (PFN_vkGetValidationCacheDataEXT)vkGetDeviceProcAddr(device, "vkGetValidationCacheDataEXT");
+    std::vector<uint8_t> data;
+    if (!fpCreateValidationCache || !fpDestroyValidationCache || !fpGetValidationCacheData) {
+        ADD_FAILURE() << "Failed to load function pointers for " << VK_EXT_VALIDATION_CACHE_EXTENSION_NAME;
+        return data;
+    }
+
+    VkValidationCacheCreateInfoEXT cache_ci = {};
+    cache_ci.sType = VK_STRUCTURE_TYPE_VALIDATION_CACHE_CREATE_INFO_EXT;
+    cache_ci.initialDataSize = initial_data.size();
+    cache_ci.pInitialData = initial_data.data();
+    VkValidationCacheEXT cache = VK_NULL_HANDLE;
+    EXPECT_EQ(VK_SUCCESS, fpCreateValidationCache(device, &cache_ci, nullptr, &cache));
+
+    if (module_ci.codeSize) {
+        VkShaderModuleValidationCacheCreateInfoEXT module_cache_ci = {};
+        module_cache_ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_VALIDATION_CACHE_CREATE_INFO_EXT;
+        module_cache_ci.validationCache = cache;
+        module_ci.pNext = &module_cache_ci;
+        VkShaderModule module;
+        EXPECT_EQ(VK_SUCCESS, vkCreateShaderModule(device, &module_ci, nullptr, &module));
+        vkDestroyShaderModule(device, module, nullptr);
+    }
+
+    size_t size = 0;
+    fpGetValidationCacheData(device, cache, &size, nullptr);
+    data.resize(size);
+    fpGetValidationCacheData(device, cache, &size, data.data());
+    data.resize(size);
+    fpDestroyValidationCache(device, cache, nullptr);
+    return data;
+}
+
+TEST_F(VkValidationCacheFileTest, StoredModuleLoadsBack) {
+    TEST_DESCRIPTION(
+        "With validation_cache_file set, create a valid shader module and destroy its device, then check that the file "
+        "written loads back with the module's hash, and that a second device creating the module still validates clean.");
+
+    const char *path = getLayerOption("lunarg_core_validation.validation_cache_file");
+    if (!*path) {
+        printf("             lunarg_core_validation.validation_cache_file is not set; skipped.\n");
+        return;
+    }
+    ASSERT_NO_FATAL_FAILURE(InitFramework(myDbgFunc, m_errorMonitor));
+    if (!DeviceExtensionSupported(gpu(), "VK_LAYER_LUNARG_core_validation", VK_EXT_VALIDATION_CACHE_EXTENSION_NAME)) {
+        printf("             %s not supported, skipping test\n", VK_EXT_VALIDATION_CACHE_EXTENSION_NAME);
+        return;
+    }
+    remove(path);
+
+    std::vector<unsigned int> spv;
+    GLSLtoSPV(VK_SHADER_STAGE_VERTEX_BIT, bindStateVertShaderText, spv);
+    VkShaderModuleCreateInfo module_ci = {};
+    module_ci.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    module_ci.codeSize = spv.size() * sizeof(unsigned int);
+    module_ci.pCode = spv.data();
+
+    m_errorMonitor->ExpectSuccess();
+    std::unique_ptr<VkDeviceObj> test_device = CreateValidationCacheDevice(gpu());
+    VkShaderModule module;
+    ASSERT_VK_SUCCESS(vkCreateShaderModule(test_device->device(), &module_ci, nullptr, &module));
+    vkDestroyShaderModule(test_device->device(), module, nullptr);
+    test_device.reset();
+    m_errorMonitor->VerifyNotFound();
+
+    const std::vector<uint8_t> file_data = ReadWholeFile(path);
+    ASSERT_FALSE(file_data.empty()) << path;
+
+    // An application's cache loaded from the file already holds the module, so creating the module against it adds
+    // nothing; against an empty cache, the same module adds the one hash the file holds
+    m_errorMonitor->ExpectSuccess();
+    test_device = CreateValidationCacheDevice(gpu());
+    const VkShaderModuleCreateInfo no_module = {};
+    EXPECT_TRUE(file_data == ValidationCacheDataAfterModule(test_device->device(), file_data, no_module));
+    EXPECT_TRUE(file_data == ValidationCacheDataAfterModule(test_device->device(), file_data, module_ci));
+    const std::vector<uint8_t> no_data;
+    EXPECT_TRUE(file_data == ValidationCacheDataAfterModule(test_device->device(), no_data, module_ci));
+
+    ASSERT_VK_SUCCESS(vkCreateShaderModule(test_device->device(), &module_ci, nullptr, &module));
+    vkDestroyShaderModule(test_device->device(), module, nullptr);
+    test_device.reset();
+    m_errorMonitor->VerifyNotFound();
+
+    remove(path);
+}
+
+TEST_F(VkValidationCacheFileTest, StaleFileLoadsEmpty) {
+    TEST_DESCRIPTION(
+        "With validation_cache_file set, write files holding the hash of a module that spirv-val rejects, cut short or in the "
+        "format of 32 bit hashes that came before the current one. Check that each loads as an empty cache, so the module is "
+        "still validated, while the same hash in a whole current file skips validation.");
+
+    const char *path = getLayerOption("lunarg_core_validation.validation_cache_file");
+    if (!*path) {
+        printf("             lunarg_core_validation.validation_cache_file is not set; skipped.\n");
+        return;
+    }
+    ASSERT_NO_FATAL_FAILURE(InitFramework(myDbgFunc, m_errorMonitor));
+    if (!DeviceExtensionSupported(gpu(), "VK_LAYER_LUNARG_core_validation", VK_EXT_VALIDATION_CACHE_EXTENSION_NAME)) {
+        printf("             %s not supported, skipping test\n", VK_EXT_VALIDATION_CACHE_EXTENSION_NAME);
+        return;
+    }
+    remove(path);
+
+    // Take the header, which carries the SPIRV-Tools version, from the data of an empty cache
+    std::vector<uint8_t> empty_data;
+    {
+        m_errorMonitor->ExpectSuccess();
+        std::unique_ptr<VkDeviceObj> test_device = CreateValidationCacheDevice(gpu());
+        const std::vector<uint8_t> no_data;
+        const VkShaderModuleCreateInfo no_module = {};
+        empty_data = ValidationCacheDataAfterModule(test_device->device(), no_data, no_module);
+        test_device.reset();
+        m_errorMonitor->VerifyNotFound();
+    }
+    // Header size, header version and UUID, then format version and hash count
+    const size_t header_size = 2 * sizeof(uint32_t) + VK_UUID_SIZE;
+    ASSERT_EQ(header_size + 2 * sizeof(uint32_t), empty_data.size());
+    const std::vector<uint8_t> header(empty_data.begin(), empty_data.begin() + header_size);
+
+    std::vector<unsigned int> spv = InvalidSpirv(this);
+    const size_t code_size = spv.size() * sizeof(unsigned int);
+    const uint64_t hash[2] = {XXH64(spv.data(), code_size, 0), XXH64(spv.data(), code_size, 0x9e3779b97f4a7c15ull)};
+    std::vector<unsigned int> valid_spv;
+    GLSLtoSPV(VK_SHADER_STAGE_VERTEX_BIT, bindStateVertShaderText, valid_spv);
+    const uint32_t old_hashes[2] = {XXH32(spv.data(), code_size, 0),
+                                    XXH32(valid_spv.data(), valid_spv.size() * sizeof(unsigned int), 0)};
+
+    const uint32_t format[2] = {2, 1};
+    std::vector<uint8_t> whole = header;
+    AppendBytes(&whole, format, sizeof(format));
+    AppendBytes(&whole, hash, sizeof(hash));
+    const std::vector<uint8_t> cut_in_hash(whole.begin(), whole.end() - sizeof(uint64_t));
+    const std::vector<uint8_t> cut_in_header(whole.begin(), whole.begin() + header_size / 2);
+    std::vector<uint8_t> old_format = header;
+    AppendBytes(&old_format, old_hashes, sizeof(old_hashes));
+
+    // The whole file shows that the hash is the one core_validation looks for
+    WriteWholeFile(path, whole);
+    m_errorMonitor->ExpectSuccess();
+    std::unique_ptr<VkDeviceObj> test_device = CreateValidationCacheDevice(gpu());
+    VkShaderModule module;
+    ASSERT_VK_SUCCESS(CreateModuleWithInvalidSpirv(this, test_device->device(), &module));
+    vkDestroyShaderModule(test_device->device(), module, nullptr);
+    test_device.reset();
+    m_errorMonitor->VerifyNotFound();
+
+    const struct {
+        const char *name;
+        const std::vector<uint8_t> &data;
+    } stale_files[] = {{"cut in hash", cut_in_hash}, {"cut in header", cut_in_header}, {"old format", old_format}};
+    for (const auto &stale_file : stale_files) {
+        SCOPED_TRACE(stale_file.name);
+        WriteWholeFile(path, stale_file.data);
+        test_device = CreateValidationCacheDevice(gpu());
+        m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, kInvalidSpirvMessage);
+        EXPECT_EQ(VK_ERROR_VALIDATION_FAILED_EXT, CreateModuleWithInvalidSpirv(this, test_device->device(), &module));
+        m_errorMonitor->VerifyFound();
+        test_device.reset();
+    }
+
+    remove(path);
+}
+
+TEST_F(VkLayerTest, InvalidSPIRVCodeSize) {
+    TEST_DESCRIPTION("Test that errors are produced for a spirv modules with invalid code sizes");
+
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, "Invalid SPIR-V header");
+
+    ASSERT_NO_FATAL_FAILURE(Init());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    VkShaderModule module;
+    VkShaderModuleCreateInfo moduleCreateInfo;
+    struct icd_spv_header spv;
+
+    spv.magic = ICD_SPV_MAGIC;
+    spv.version = ICD_SPV_VERSION;
+    spv.gen_magic = 0;
+
+    moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleCreateInfo.pNext = NULL;
+    moduleCreateInfo.pCode = (const uint32_t *)&spv;
+    moduleCreateInfo.codeSize = 4;
+    moduleCreateInfo.flags = 0;
+    vkCreateShaderModule(m_device->device(), &moduleCreateInfo, NULL, &module);
+
+    m_errorMonitor->VerifyFound();
+
+    char const *vsSource =
+        "#version 450\n"
+        "\n"
+        "layout(location=0) out float x;\n"
+        "void main(){\n"
+        "   gl_Position = vec4(1);\n"
+        "   x = 0;\n"
+        "}\n";
+
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, VALIDATION_ERROR_12a00ac0);
+    std::vector<unsigned int> shader;
+    VkShaderModuleCreateInfo module_create_info;
+    VkShaderModule shader_module;
+    module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    module_create_info.pNext = NULL;
+    this->GLSLtoSPV(VK_SHADER_STAGE_VERTEX_BIT, vsSource, shader);
+    module_create_info.pCode = shader.data();
+    // Introduce failure by making codeSize a non-multiple of 4
+    module_create_info.codeSize = shader.size() * sizeof(unsigned int) - 1;
+    module_create_info.flags = 0;
+    vkCreateShaderModule(m_device->handle(), &module_create_info, NULL, &shader_module);
+
+    m_errorMonitor->VerifyFound();
+}
+
+TEST_F(VkLayerTest, InvalidSPIRVMagic) {
+    TEST_DESCRIPTION("Test that an error is produced for a spirv module with a bad magic number");
+
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, "Invalid SPIR-V magic number");
+
+    ASSERT_NO_FATAL_FAILURE(Init());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    VkShaderModule module;
+    VkShaderModuleCreateInfo moduleCreateInfo;
+    struct icd_spv_header spv;
+
+    spv.magic = (uint32_t)~ICD_SPV_MAGIC;
+    spv.version = ICD_SPV_VERSION;
+    spv.gen_magic = 0;
+
+    moduleCreateInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+    moduleCreateInfo.pNext = NULL;
+    moduleCreateInfo.pCode = (const uint32_t *)&spv;
+    moduleCreateInfo.codeSize = sizeof(spv) + 16;
+    moduleCreateInfo.flags = 0;
+    vkCreateShaderModule(m_device->device(), &moduleCreateInfo, NULL, &module);
+
+    m_errorMonitor->VerifyFound();
+}
+
+TEST_F(VkLayerTest, CreatePipelineVertexOutputNotConsumed) {
+    TEST_DESCRIPTION("Test that a warning is produced for a vertex output that is not consumed by the fragment stage");
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_PERFORMANCE_WARNING_BIT_EXT, "not consumed by fragment shader");
+
+    ASSERT_NO_FATAL_FAILURE(Init());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    char const *vsSource =
+        "#version 450\n"
+        "\n"
+        "layout(location=0) out float x;\n"
+        "void main(){\n"
+        "   gl_Position = vec4(1);\n"
+        "   x = 0;\n"
+        "}\n";
+    char const *fsSource =
+        "#version 450\n"
+        "\n"
+        "layout(location=0) out vec4 color;\n"
+        "void main(){\n"
+        "   color = vec4(1);\n"
+        "}\n";
+
+    VkShaderObj vs(m_device, vsSource, VK_SHADER_STAGE_VERTEX_BIT, this);
+    VkShaderObj fs(m_device, fsSource, VK_SHADER_STAGE_FRAGMENT_BIT, this);
+
+    VkPipelineObj pipe(m_device);
+    pipe.AddDefaultColorAttachment();
+    pipe.AddShader(&vs);
+    pipe.AddShader(&fs);
 
     VkDescriptorSetObj descriptorSet(m_device);
     descriptorSet.AppendDummy();
@@ -16111,6 +16742,62 @@ TEST_F(VkLayerTest, CreatePipelineFragmentInputNotProvided) {
     m_errorMonitor->VerifyFound();
 }
 
+TEST_F(VkLayerTest, CreatePipelineFragmentInputNotProvidedLargeIdBound) {
+    TEST_DESCRIPTION(
+        "Test that interface validation still finds the definitions in modules whose id bound is far larger than the module");
+
+    ASSERT_NO_FATAL_FAILURE(Init());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    char const *vsSource =
+        "#version 450\n"
+        "\n"
+        "void main(){\n"
+        "   gl_Position = vec4(1);\n"
+        "}\n";
+    char const *fsSource =
+        "#version 450\n"
+        "\n"
+        "layout(location=0) in float x;\n"
+        "layout(location=0) out vec4 color;\n"
+        "void main(){\n"
+        "   color = vec4(x);\n"
+        "}\n";
+
+    VkShaderModule modules[2];
+    VkShaderStageFlagBits stages[2] = {VK_SHADER_STAGE_VERTEX_BIT, VK_SHADER_STAGE_FRAGMENT_BIT};
+    char const *sources[2] = {vsSource, fsSource};
+    for (uint32_t i = 0; i < 2; i++) {
+        std::vector<unsigned int> spv;
+        this->GLSLtoSPV(stages[i], sources[i], spv);
+        spv[3] = 0x100000;  // Bound
+
+        VkShaderModuleCreateInfo module_create_info = {};
+        module_create_info.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+        module_create_info.pCode = spv.data();
+        module_create_info.codeSize = spv.size() * sizeof(unsigned int);
+        m_errorMonitor->ExpectSuccess();
+        VkResult err = vkCreateShaderModule(m_device->device(), &module_create_info, nullptr, &modules[i]);
+        m_errorMonitor->VerifyNotFound();
+        ASSERT_VK_SUCCESS(err);
+    }
+
+    CreatePipelineHelper pipe(*this);
+    pipe.InitInfo();
+    pipe.InitState();
+    for (uint32_t i = 0; i < 2; i++) {
+        pipe.shader_stages_[i].module = modules[i];
+    }
+
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, "not written by vertex shader");
+    pipe.CreateGraphicsPipeline();
+    m_errorMonitor->VerifyFound();
+
+    for (uint32_t i = 0; i < 2; i++) {
+        vkDestroyShaderModule(m_device->device(), modules[i], nullptr);
+    }
+}
+
 TEST_F(VkLayerTest, CreatePipelineFragmentInputNotProvidedInBlock) {
     TEST_DESCRIPTION(
         "Test that an error is produced for a fragment shader input within an interace block, which is not present in the outputs "
@@ -21195,6 +21882,35 @@ TEST_F(VkPositiveLayerTest, DeleteDescriptorSetLayoutsBeforeDescriptorSets) {
     m_errorMonitor->VerifyNotFound();
 }
 
+TEST_F(VkPositiveLayerTest, BindDescriptorSetFromIdenticalLayout) {
+    TEST_DESCRIPTION(
+        "Bind a descriptor set whose layout is a separately created duplicate of the one in the pipeline layout, including "
+        "immutable samplers; identically defined layouts are compatible.");
+    ASSERT_NO_FATAL_FAILURE(Init());
+
+    VkSamplerCreateInfo sampler_ci = SafeSaneSamplerCreateInfo();
+    VkSampler sampler;
+    ASSERT_VK_SUCCESS(vkCreateSampler(m_device->device(), &sampler_ci, NULL, &sampler));
+
+    const std::vector<VkDescriptorSetLayoutBinding> bindings = {
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, VK_SHADER_STAGE_ALL, nullptr},
+        {1, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, &sampler},
+    };
+    OneOffDescriptorSet ds(m_device, bindings);
+    ASSERT_TRUE(ds.Initialized());
+    const VkDescriptorSetLayoutObj duplicate_layout(m_device, bindings);
+    const VkPipelineLayoutObj pipeline_layout(m_device, {&duplicate_layout});
+
+    m_errorMonitor->ExpectSuccess();
+    m_commandBuffer->begin();
+    vkCmdBindDescriptorSets(m_commandBuffer->handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout.handle(), 0, 1, &ds.set_, 0,
+                            nullptr);
+    m_commandBuffer->end();
+    m_errorMonitor->VerifyNotFound();
+
+    vkDestroySampler(m_device->device(), sampler, NULL);
+}
+
 TEST_F(VkPositiveLayerTest, CommandPoolDeleteWithReferences) {
     TEST_DESCRIPTION("Ensure the validation layers bookkeeping tracks the implicit command buffer frees.");
     ASSERT_NO_FATAL_FAILURE(Init());
@@ -27294,6 +28010,1076 @@ TEST_F(VkPositiveLayerTest, BindMemory2) {
     m_errorMonitor->VerifyNotFound();
 }
 
+TEST_F(VkLayerTest, DescriptorUpdateTemplateRollsOverBindings) {
+    TEST_DESCRIPTION(
+        "Update sets through template entries that run off the end of one array binding into the next, which has a different "
+        "descriptorCount, and check at draw time which descriptors the templates wrote.");
+
+    ASSERT_NO_FATAL_FAILURE(InitFramework(myDbgFunc, m_errorMonitor));
+    if (DeviceExtensionSupported(gpu(), nullptr, VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME)) {
+        m_device_extension_names.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+    } else {
+        printf("             %s Extension not supported, skipping tests\n", VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+        return;
+    }
+    ASSERT_NO_FATAL_FAILURE(InitState());
+    ASSERT_NO_FATAL_FAILURE(InitViewport());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    auto vkCreateDescriptorUpdateTemplateKHR =
+        (PFN_vkCreateDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(m_device->device(), "vkCreateDescriptorUpdateTemplateKHR");
+    auto vkDestroyDescriptorUpdateTemplateKHR =
+        (PFN_vkDestroyDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(m_device->device(), "vkDestroyDescriptorUpdateTemplateKHR");
+    auto vkUpdateDescriptorSetWithTemplateKHR =
+        (PFN_vkUpdateDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(m_device->device(), "vkUpdateDescriptorSetWithTemplateKHR");
+    ASSERT_TRUE(vkCreateDescriptorUpdateTemplateKHR && vkDestroyDescriptorUpdateTemplateKHR &&
+                vkUpdateDescriptorSetWithTemplateKHR);
+
+    // Five descriptors in all: two in binding 0, then three in binding 1
+    const OneOffDescriptorSet::Bindings bindings = {{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, VK_SHADER_STAGE_ALL, nullptr},
+                                                    {1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3, VK_SHADER_STAGE_ALL, nullptr}};
+    OneOffDescriptorSet full_ds(m_device, bindings);
+    OneOffDescriptorSet partial_ds(m_device, bindings);
+    ASSERT_TRUE(full_ds.Initialized() && partial_ds.Initialized());
+    const VkPipelineLayoutObj pipeline_layout(m_device, {&full_ds.layout_});
+
+    vk_testing::Buffer buffer;
+    buffer.init(*m_device, vk_testing::Buffer::create_info(256, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
+    const VkDescriptorBufferInfo buffer_info = {buffer.handle(), 0, VK_WHOLE_SIZE};
+    const std::vector<VkDescriptorBufferInfo> buffer_infos(5, buffer_info);
+
+    // One entry covering all five descriptors, and one that stops a descriptor short of the end of binding 1
+    VkDescriptorUpdateTemplateEntryKHR entry = {0, 0, 5, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, sizeof(VkDescriptorBufferInfo)};
+    VkDescriptorUpdateTemplateCreateInfoKHR template_ci = {};
+    template_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+    template_ci.descriptorUpdateEntryCount = 1;
+    template_ci.pDescriptorUpdateEntries = &entry;
+    template_ci.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+    template_ci.descriptorSetLayout = full_ds.layout_.handle();
+    VkDescriptorUpdateTemplateKHR full_template, partial_template;
+    ASSERT_VK_SUCCESS(vkCreateDescriptorUpdateTemplateKHR(m_device->device(), &template_ci, nullptr, &full_template));
+    entry.descriptorCount = 4;
+    ASSERT_VK_SUCCESS(vkCreateDescriptorUpdateTemplateKHR(m_device->device(), &template_ci, nullptr, &partial_template));
+
+    m_errorMonitor->ExpectSuccess();
+    vkUpdateDescriptorSetWithTemplateKHR(m_device->device(), full_ds.set_, full_template, buffer_infos.data());
+    vkUpdateDescriptorSetWithTemplateKHR(m_device->device(), partial_ds.set_, partial_template, buffer_infos.data());
+    m_errorMonitor->VerifyNotFound();
+
+    char const *fsSource =
+        "#version 450\n"
+        "\n"
+        "layout(set=0, binding=0) uniform foo { float x; } a[2];\n"
+        "layout(set=0, binding=1) uniform bar { float y; } b[3];\n"
+        "layout(location=0) out vec4 color;\n"
+        "void main(){\n"
+        "   color = vec4(a[0].x + a[1].x + b[0].y + b[1].y + b[2].y);\n"
+        "}\n";
+    VkShaderObj vs(m_device, bindStateVertShaderText, VK_SHADER_STAGE_VERTEX_BIT, this);
+    VkShaderObj fs(m_device, fsSource, VK_SHADER_STAGE_FRAGMENT_BIT, this);
+    VkPipelineObj pipe(m_device);
+    pipe.AddShader(&vs);
+    pipe.AddShader(&fs);
+    pipe.AddDefaultColorAttachment();
+    pipe.CreateVKPipeline(pipeline_layout.handle(), renderPass());
+
+    m_commandBuffer->begin();
+    m_commandBuffer->BeginRenderPass(m_renderPassBeginInfo);
+    VkViewport viewport = {0, 0, 16, 16, 0, 1};
+    vkCmdSetViewport(m_commandBuffer->handle(), 0, 1, &viewport);
+    VkRect2D scissor = {{0, 0}, {16, 16}};
+    vkCmdSetScissor(m_commandBuffer->handle(), 0, 1, &scissor);
+    vkCmdBindPipeline(m_commandBuffer->handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipe.handle());
+
+    // Binding 1 holds three descriptors, so the five-descriptor entry fills it after rolling over from binding 0
+    m_errorMonitor->ExpectSuccess();
+    vkCmdBindDescriptorSets(m_commandBuffer->handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout.handle(), 0, 1,
+                            &full_ds.set_, 0, nullptr);
+    m_commandBuffer->Draw(1, 0, 0, 0);
+    m_errorMonitor->VerifyNotFound();
+
+    // The four-descriptor entry leaves the last element of binding 1, global index 4, unwritten
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT,
+                                         "Descriptor in binding #1 at global descriptor index 4 is being used in draw but has "
+                                         "not been updated.");
+    vkCmdBindDescriptorSets(m_commandBuffer->handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout.handle(), 0, 1,
+                            &partial_ds.set_, 0, nullptr);
+    m_commandBuffer->Draw(1, 0, 0, 0);
+    m_errorMonitor->VerifyFound();
+
+    m_commandBuffer->EndRenderPass();
+    m_commandBuffer->end();
+
+    vkDestroyDescriptorUpdateTemplateKHR(m_device->device(), full_template, nullptr);
+    vkDestroyDescriptorUpdateTemplateKHR(m_device->device(), partial_template, nullptr);
+}
+
+TEST_F(VkLayerTest, DescriptorUpdateTemplateInvalidData) {
+    TEST_DESCRIPTION(
+        "Update a set through a template whose data names a buffer without uniform buffer usage in the binding it rolls "
+        "over into, and check that the update is rejected as the equivalent vkUpdateDescriptorSets would be.");
+
+    ASSERT_NO_FATAL_FAILURE(InitFramework(myDbgFunc, m_errorMonitor));
+    if (DeviceExtensionSupported(gpu(), nullptr, VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME)) {
+        m_device_extension_names.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+    } else {
+        printf("             %s Extension not supported, skipping tests\n", VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+        return;
+    }
+    ASSERT_NO_FATAL_FAILURE(InitState());
+
+    auto vkCreateDescriptorUpdateTemplateKHR =
+        (PFN_vkCreateDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(m_device->device(), "vkCreateDescriptorUpdateTemplateKHR");
+    auto vkDestroyDescriptorUpdateTemplateKHR =
+        (PFN_vkDestroyDescriptorUpdateTemplateKHR)vkGetDeviceProcAddr(m_device->device(), "vkDestroyDescriptorUpdateTemplateKHR");
+    auto vkUpdateDescriptorSetWithTemplateKHR =
+        (PFN_vkUpdateDescriptorSetWithTemplateKHR)vkGetDeviceProcAddr(m_device->device(), "vkUpdateDescriptorSetWithTemplateKHR");
+    ASSERT_TRUE(vkCreateDescriptorUpdateTemplateKHR && vkDestroyDescriptorUpdateTemplateKHR &&
+                vkUpdateDescriptorSetWithTemplateKHR);
+
+    OneOffDescriptorSet ds(m_device, {{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, VK_SHADER_STAGE_ALL, nullptr},
+                                      {1, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 3, VK_SHADER_STAGE_ALL, nullptr}});
+    ASSERT_TRUE(ds.Initialized());
+
+    vk_testing::Buffer uniform_buffer, storage_buffer;
+    uniform_buffer.init(*m_device, vk_testing::Buffer::create_info(256, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
+    storage_buffer.init(*m_device, vk_testing::Buffer::create_info(256, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT));
+
+    // Interleave the buffer infos with padding to exercise the entry's stride
+    struct padded_buffer_info {
+        VkDescriptorBufferInfo info;
+        uint64_t padding;
+    };
+    std::vector<padded_buffer_info> data(5, {{uniform_buffer.handle(), 0, VK_WHOLE_SIZE}, 0});
+    VkDescriptorUpdateTemplateEntryKHR entry = {0, 0, 5, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 0, sizeof(padded_buffer_info)};
+    VkDescriptorUpdateTemplateCreateInfoKHR template_ci = {};
+    template_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR;
+    template_ci.descriptorUpdateEntryCount = 1;
+    template_ci.pDescriptorUpdateEntries = &entry;
+    template_ci.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+    template_ci.descriptorSetLayout = ds.layout_.handle();
+    VkDescriptorUpdateTemplateKHR update_template;
+    ASSERT_VK_SUCCESS(vkCreateDescriptorUpdateTemplateKHR(m_device->device(), &template_ci, nullptr, &update_template));
+
+    m_errorMonitor->ExpectSuccess();
+    vkUpdateDescriptorSetWithTemplateKHR(m_device->device(), ds.set_, update_template, data.data());
+    m_errorMonitor->VerifyNotFound();
+
+    // The fourth descriptor is binding 1, element 1
+    data[3].info.buffer = storage_buffer.handle();
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, VALIDATION_ERROR_15c00292);
+    vkUpdateDescriptorSetWithTemplateKHR(m_device->device(), ds.set_, update_template, data.data());
+    m_errorMonitor->VerifyFound();
+
+    vkDestroyDescriptorUpdateTemplateKHR(m_device->device(), update_template, nullptr);
+}
+
+TEST_F(VkLayerTest, DescriptorSetsFromResetOrDestroyedArenaPool) {
+    TEST_DESCRIPTION(
+        "Sets allocated from a pool without VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT live in the pool's arena. Reset "
+        "and destroy such a pool while a recorded command buffer uses one of its sets, and check that the command buffer and "
+        "the set are both reported as invalid afterwards.");
+
+    ASSERT_NO_FATAL_FAILURE(Init(nullptr, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT));
+    ASSERT_NO_FATAL_FAILURE(InitViewport());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    const VkDescriptorSetLayoutObj ds_layout(m_device, {{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr}});
+    const VkPipelineLayoutObj pipeline_layout(m_device, {&ds_layout});
+
+    VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1};
+    VkDescriptorPoolCreateInfo pool_ci = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, nullptr, 0, 1, 1, &pool_size};
+    VkDescriptorPool pool;
+    ASSERT_VK_SUCCESS(vkCreateDescriptorPool(m_device->device(), &pool_ci, nullptr, &pool));
+    VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, pool, 1,
+                                              &ds_layout.handle()};
+
+    vk_testing::Buffer buffer;
+    buffer.init(*m_device, vk_testing::Buffer::create_info(256, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
+    const VkDescriptorBufferInfo buffer_info = {buffer.handle(), 0, VK_WHOLE_SIZE};
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.pBufferInfo = &buffer_info;
+
+    char const *fsSource =
+        "#version 450\n"
+        "\n"
+        "layout(set=0, binding=0) uniform foo { float x; } a;\n"
+        "layout(location=0) out vec4 color;\n"
+        "void main(){\n"
+        "   color = vec4(a.x);\n"
+        "}\n";
+    VkShaderObj vs(m_device, bindStateVertShaderText, VK_SHADER_STAGE_VERTEX_BIT, this);
+    VkShaderObj fs(m_device, fsSource, VK_SHADER_STAGE_FRAGMENT_BIT, this);
+    VkPipelineObj pipe(m_device);
+    pipe.AddShader(&vs);
+    pipe.AddShader(&fs);
+    pipe.AddDefaultColorAttachment();
+    pipe.CreateVKPipeline(pipeline_layout.handle(), renderPass());
+
+    VkViewport viewport = {0, 0, 16, 16, 0, 1};
+    VkRect2D scissor = {{0, 0}, {16, 16}};
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &m_commandBuffer->handle();
+
+    // Allocate a set, update it and record a draw that uses it
+    auto record_draw = [&](VkDescriptorSet *set) {
+        ASSERT_VK_SUCCESS(vkAllocateDescriptorSets(m_device->device(), &alloc_info, set));
+        write.dstSet = *set;
+        vkUpdateDescriptorSets(m_device->device(), 1, &write, 0, nullptr);
+        m_commandBuffer->begin();
+        m_commandBuffer->BeginRenderPass(m_renderPassBeginInfo);
+        vkCmdSetViewport(m_commandBuffer->handle(), 0, 1, &viewport);
+        vkCmdSetScissor(m_commandBuffer->handle(), 0, 1, &scissor);
+        vkCmdBindPipeline(m_commandBuffer->handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipe.handle());
+        vkCmdBindDescriptorSets(m_commandBuffer->handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout.handle(), 0, 1, set,
+                                0, nullptr);
+        m_commandBuffer->Draw(1, 0, 0, 0);
+        m_commandBuffer->EndRenderPass();
+        m_commandBuffer->end();
+    };
+
+    VkDescriptorSet reset_set;
+    m_errorMonitor->ExpectSuccess();
+    record_draw(&reset_set);
+    ASSERT_VK_SUCCESS(vkResetDescriptorPool(m_device->device(), pool, 0));
+    m_errorMonitor->VerifyNotFound();
+
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, " that is invalid because bound DescriptorSet ");
+    vkQueueSubmit(m_device->m_queue, 1, &submit_info, VK_NULL_HANDLE);
+    m_errorMonitor->VerifyFound();
+
+    // The reset returned the set's memory to the arena, and the handle is no longer a set
+    m_commandBuffer->begin();
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, VALIDATION_ERROR_17c13001);
+    vkCmdBindDescriptorSets(m_commandBuffer->handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout.handle(), 0, 1,
+                            &reset_set, 0, nullptr);
+    m_errorMonitor->VerifyFound();
+    m_commandBuffer->end();
+
+    // A set allocated from the rewound arena validates like any other, until the pool is destroyed under it
+    VkDescriptorSet destroyed_set;
+    m_errorMonitor->ExpectSuccess();
+    record_draw(&destroyed_set);
+    vkDestroyDescriptorPool(m_device->device(), pool, nullptr);
+    m_errorMonitor->VerifyNotFound();
+
+    const char *destroyed_msgs[] = {" that is invalid because bound DescriptorPool ",
+                                    " that is invalid because bound DescriptorSet "};
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, std::begin(destroyed_msgs), std::end(destroyed_msgs));
+    vkQueueSubmit(m_device->m_queue, 1, &submit_info, VK_NULL_HANDLE);
+    m_errorMonitor->VerifyFound();
+}
+
+TEST_F(VkLayerTest, DescriptorPoolArenaBeyondReserve) {
+    TEST_DESCRIPTION(
+        "Fill a pool without VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT with more sets than fit in the memory its arena "
+        "reserves up front, then reset and refill it. Sets past the reserve, and sets reusing the memory of reset ones, must "
+        "each keep their own descriptors and start out with none of them updated.");
+
+    ASSERT_NO_FATAL_FAILURE(Init(nullptr, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT));
+    ASSERT_NO_FATAL_FAILURE(InitViewport());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    // Thousands of sets take several times the 1 MiB an arena reserves before the pool's first reset
+    const uint32_t set_count = 8192;
+    const uint32_t descriptors_per_set = 4;
+
+    const VkDescriptorSetLayoutObj ds_layout(
+        m_device, {{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, descriptors_per_set, VK_SHADER_STAGE_ALL, nullptr}});
+    const VkPipelineLayoutObj pipeline_layout(m_device, {&ds_layout});
+    std::vector<VkDescriptorSetLayout> layouts(set_count, ds_layout.handle());
+
+    VkDescriptorPoolSize pool_size = {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, set_count * descriptors_per_set};
+    VkDescriptorPoolCreateInfo pool_ci = {VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO, nullptr, 0, set_count, 1, &pool_size};
+    VkDescriptorPool pool;
+    ASSERT_VK_SUCCESS(vkCreateDescriptorPool(m_device->device(), &pool_ci, nullptr, &pool));
+    VkDescriptorSetAllocateInfo alloc_info = {VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO, nullptr, pool, set_count,
+                                              layouts.data()};
+    std::vector<VkDescriptorSet> sets(set_count);
+
+    vk_testing::Buffer buffer;
+    buffer.init(*m_device, vk_testing::Buffer::create_info(256, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
+    const std::vector<VkDescriptorBufferInfo> buffer_infos(descriptors_per_set, {buffer.handle(), 0, VK_WHOLE_SIZE});
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstBinding = 0;
+    write.descriptorCount = descriptors_per_set;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.pBufferInfo = buffer_infos.data();
+
+    char const *fsSource =
+        "#version 450\n"
+        "\n"
+        "layout(set=0, binding=0) uniform foo { float x; } a[4];\n"
+        "layout(location=0) out vec4 color;\n"
+        "void main(){\n"
+        "   color = vec4(a[0].x + a[1].x + a[2].x + a[3].x);\n"
+        "}\n";
+    VkShaderObj vs(m_device, bindStateVertShaderText, VK_SHADER_STAGE_VERTEX_BIT, this);
+    VkShaderObj fs(m_device, fsSource, VK_SHADER_STAGE_FRAGMENT_BIT, this);
+    VkPipelineObj pipe(m_device);
+    pipe.AddShader(&vs);
+    pipe.AddShader(&fs);
+    pipe.AddDefaultColorAttachment();
+    pipe.CreateVKPipeline(pipeline_layout.handle(), renderPass());
+
+    VkViewport viewport = {0, 0, 16, 16, 0, 1};
+    VkRect2D scissor = {{0, 0}, {16, 16}};
+    auto draw_with = [&](VkDescriptorSet set) {
+        vkCmdBindDescriptorSets(m_commandBuffer->handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout.handle(), 0, 1, &set,
+                                0, nullptr);
+        m_commandBuffer->Draw(1, 0, 0, 0);
+    };
+    const char *not_updated_msg =
+        "Descriptor in binding #0 at global descriptor index 0 is being used in draw but has not been updated.";
+
+    for (uint32_t fill = 0; fill < 2; fill++) {
+        m_errorMonitor->ExpectSuccess();
+        ASSERT_VK_SUCCESS(vkAllocateDescriptorSets(m_device->device(), &alloc_info, sets.data()));
+        m_commandBuffer->begin();
+        m_commandBuffer->BeginRenderPass(m_renderPassBeginInfo);
+        vkCmdSetViewport(m_commandBuffer->handle(), 0, 1, &viewport);
+        vkCmdSetScissor(m_commandBuffer->handle(), 0, 1, &scissor);
+        vkCmdBindPipeline(m_commandBuffer->handle(), VK_PIPELINE_BIND_POINT_GRAPHICS, pipe.handle());
+        // Update every set but the middle one and the last one
+        std::vector<VkWriteDescriptorSet> writes;
+        for (uint32_t i = 0; i < set_count; i++) {
+            if (i == set_count / 2 || i == set_count - 1) continue;
+            write.dstSet = sets[i];
+            writes.push_back(write);
+        }
+        vkUpdateDescriptorSets(m_device->device(), static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+        draw_with(sets[0]);
+        draw_with(sets[set_count / 2 - 1]);
+        draw_with(sets[set_count - 2]);
+        m_errorMonitor->VerifyNotFound();
+
+        m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, not_updated_msg);
+        draw_with(sets[set_count / 2]);
+        m_errorMonitor->VerifyFound();
+        m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, not_updated_msg);
+        draw_with(sets[set_count - 1]);
+        m_errorMonitor->VerifyFound();
+
+        // After the first fill, the reset regrows the arena's reserve to cover everything the pool held
+        m_errorMonitor->ExpectSuccess();
+        m_commandBuffer->EndRenderPass();
+        m_commandBuffer->end();
+        ASSERT_VK_SUCCESS(vkResetDescriptorPool(m_device->device(), pool, 0));
+        m_errorMonitor->VerifyNotFound();
+    }
+
+    vkDestroyDescriptorPool(m_device->device(), pool, nullptr);
+}
+
+TEST_F(VkPositiveLayerTest, DescriptorPoolFreeSetsOutOfOrder) {
+    TEST_DESCRIPTION(
+        "Free sets individually from a pool that allows it, out of allocation order, and allocate the pool full again.");
+
+    ASSERT_NO_FATAL_FAILURE(Init());
+
+    const uint32_t set_count = 1024;
+
+    VkDescriptorSetLayoutBinding bindings[] = {
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2, VK_SHADER_STAGE_ALL, nullptr},
+        {1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_ALL, nullptr},
+    };
+    const VkDescriptorSetLayoutObj ds_layout(m_device, {bindings[0], bindings[1]});
+    std::vector<VkDescriptorSetLayout> layouts(set_count, ds_layout.handle());
+
+    VkDescriptorPoolSize pool_sizes[] = {{VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 * set_count},
+                                         {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, set_count}};
+    VkDescriptorPoolCreateInfo pool_ci = {};
+    pool_ci.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+    pool_ci.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+    pool_ci.maxSets = set_count;
+    pool_ci.poolSizeCount = 2;
+    pool_ci.pPoolSizes = pool_sizes;
+    VkDescriptorPool pool;
+    ASSERT_VK_SUCCESS(vkCreateDescriptorPool(m_device->device(), &pool_ci, nullptr, &pool));
+
+    VkDescriptorSetAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+    alloc_info.descriptorPool = pool;
+    alloc_info.descriptorSetCount = set_count;
+    alloc_info.pSetLayouts = layouts.data();
+    std::vector<VkDescriptorSet> sets(set_count);
+
+    vk_testing::Buffer buffer;
+    buffer.init(*m_device, vk_testing::Buffer::create_info(256, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
+    const VkDescriptorBufferInfo buffer_info[] = {{buffer.handle(), 0, VK_WHOLE_SIZE}, {buffer.handle(), 0, VK_WHOLE_SIZE}};
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstBinding = 0;
+    write.descriptorCount = 2;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.pBufferInfo = buffer_info;
+
+    // Free every other set, then the rest, and allocate the pool full again
+    m_errorMonitor->ExpectSuccess();
+    ASSERT_VK_SUCCESS(vkAllocateDescriptorSets(m_device->device(), &alloc_info, sets.data()));
+    std::vector<VkDescriptorSet> evens, odds;
+    for (uint32_t i = 0; i < set_count; i++) {
+        (i % 2 ? odds : evens).push_back(sets[i]);
+    }
+    vkFreeDescriptorSets(m_device->device(), pool, static_cast<uint32_t>(evens.size()), evens.data());
+    write.dstSet = odds.back();
+    vkUpdateDescriptorSets(m_device->device(), 1, &write, 0, nullptr);
+    vkFreeDescriptorSets(m_device->device(), pool, static_cast<uint32_t>(odds.size()), odds.data());
+    ASSERT_VK_SUCCESS(vkAllocateDescriptorSets(m_device->device(), &alloc_info, sets.data()));
+    m_errorMonitor->VerifyNotFound();
+    vkDestroyDescriptorPool(m_device->device(), pool, nullptr);
+}
+
+TEST_F(VkThreadedValidationTest, PipelineBatchMessageOrder) {
+    TEST_DESCRIPTION(
+        "Create a batch of graphics pipelines, several of them invalid, while core_validation validates batches on worker "
+        "threads, and check that the errors reach the callback on the calling thread, in pCreateInfos order, and still fail "
+        "the call.");
+
+    if (strtoul(getLayerOption("lunarg_core_validation.pipeline_validation_threads"), NULL, 10) < 2) {
+        printf("             lunarg_core_validation.pipeline_validation_threads is not above 1; skipped.\n");
+        return;
+    }
+
+    debug_message_log log;
+    ASSERT_NO_FATAL_FAILURE(InitFramework(recordDbgFunc, &log));
+    ASSERT_NO_FATAL_FAILURE(InitState());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    CreatePipelineHelper helper(*this);
+    helper.InitInfo();
+    helper.InitState();
+    helper.LateBindPipelineInfo();
+
+    // Each invalid pipeline gets a blend state with a different wrong attachmentCount, which its error message quotes
+    const uint32_t pipeline_count = 64;
+    const uint32_t invalid_indices[] = {3, 17, 18, 40, 63};
+    const size_t invalid_count = size(invalid_indices);
+    std::vector<VkPipelineColorBlendAttachmentState> attachments(invalid_count + 1, helper.cb_attachments_);
+    std::vector<VkPipelineColorBlendStateCreateInfo> blend_states(invalid_count, helper.cb_ci_);
+    std::vector<VkGraphicsPipelineCreateInfo> create_infos(pipeline_count, helper.gp_ci_);
+    for (size_t i = 0; i < invalid_count; i++) {
+        blend_states[i].attachmentCount = static_cast<uint32_t>(i + 2);  // The subpass has one color attachment
+        blend_states[i].pAttachments = attachments.data();
+        create_infos[invalid_indices[i]].pColorBlendState = &blend_states[i];
+    }
+
+    std::vector<VkPipeline> pipelines(pipeline_count, VK_NULL_HANDLE);
+    VkResult err = vkCreateGraphicsPipelines(m_device->device(), helper.pipeline_cache_, pipeline_count, create_infos.data(),
+                                             nullptr, pipelines.data());
+    EXPECT_EQ(VK_ERROR_VALIDATION_FAILED_EXT, err);
+
+    ASSERT_EQ(invalid_count, log.messages.size());
+    for (size_t i = 0; i < invalid_count; i++) {
+        const std::string expected = "pColorBlendState->attachmentCount of " + std::to_string(i + 2) + ".";
+        EXPECT_NE(std::string::npos, log.messages[i].find(expected)) << log.messages[i];
+        EXPECT_EQ(std::this_thread::get_id(), log.threads[i]) << log.messages[i];
+    }
+    for (auto pipeline : pipelines) {
+        EXPECT_EQ(VK_NULL_HANDLE, pipeline);
+    }
+}
+
+TEST_F(VkThreadedValidationTest, AsyncSubmitErrorsReportedByWait) {
+    TEST_DESCRIPTION(
+        "With async_submit_validation, submit a ONE_TIME_SUBMIT command buffer again and check that the error has reached "
+        "the callback by the time vkQueueWaitIdle or vkWaitForFences returns. Then fill the submission queue past its cap on "
+        "another device and check that destroying the device drains it.");
+
+    if (strcmp(getLayerOption("lunarg_core_validation.async_submit_validation"), "true")) {
+        printf("             lunarg_core_validation.async_submit_validation is not set; skipped.\n");
+        return;
+    }
+    ASSERT_NO_FATAL_FAILURE(Init());
+    ASSERT_NO_FATAL_FAILURE(InitViewport());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    // The framework begins command buffers with VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT
+    m_commandBuffer->begin();
+    m_commandBuffer->ClearAllBuffers(m_renderTargets, m_clear_color, nullptr, m_depth_clear_color, m_stencil_clear_color);
+    m_commandBuffer->end();
+
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &m_commandBuffer->handle();
+
+    m_errorMonitor->ExpectSuccess();
+    ASSERT_VK_SUCCESS(vkQueueSubmit(m_device->m_queue, 1, &submit_info, VK_NULL_HANDLE));
+    vkQueueWaitIdle(m_device->m_queue);
+    m_errorMonitor->VerifyNotFound();
+
+    // The submission reaches the driver before it is validated, so the error can only come from the wait
+    const char *one_shot_message = "VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT set, but has been submitted";
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, one_shot_message);
+    vkQueueSubmit(m_device->m_queue, 1, &submit_info, VK_NULL_HANDLE);
+    vkQueueWaitIdle(m_device->m_queue);
+    m_errorMonitor->VerifyFound();
+
+    VkFenceCreateInfo fence_ci = {VK_STRUCTURE_TYPE_FENCE_CREATE_INFO, nullptr, 0};
+    VkFence fence;
+    ASSERT_VK_SUCCESS(vkCreateFence(m_device->device(), &fence_ci, nullptr, &fence));
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, one_shot_message);
+    vkQueueSubmit(m_device->m_queue, 1, &submit_info, fence);
+    vkWaitForFences(m_device->device(), 1, &fence, VK_TRUE, UINT64_MAX);
+    m_errorMonitor->VerifyFound();
+    vkDestroyFence(m_device->device(), fence, nullptr);
+
+    // Submit faster than the worker is likely to validate, so that some submissions block on the cap of 64 queued ones and
+    // some are still queued when the device goes away
+    std::vector<const char *> device_extension_names;
+    std::unique_ptr<VkDeviceObj> test_device(new VkDeviceObj(0, gpu(), device_extension_names));
+    test_device->get_device_queue();
+    VkSubmitInfo empty_submit_info = {};
+    empty_submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    m_errorMonitor->ExpectSuccess();
+    for (uint32_t i = 0; i < 4 * 64; i++) {
+        ASSERT_VK_SUCCESS(vkQueueSubmit(test_device->m_queue, 1, &empty_submit_info, VK_NULL_HANDLE));
+    }
+    test_device.reset();
+    m_errorMonitor->VerifyNotFound();
+}
+
+#if GTEST_IS_THREADSAFE
+// The command buffer one RecordSharedBindings thread records, and the objects that every thread binds into its own
+struct shared_binding_thread_data {
+    VkCommandBuffer command_buffer;
+    const VkRenderPassBeginInfo *render_pass_begin_info;
+    VkPipeline pipeline;
+    VkPipelineLayout pipeline_layout;
+    VkDescriptorSet descriptor_set;
+    VkBuffer vertex_buffer;
+    uint32_t count;
+    bool draw_outside_render_pass;
+};
+
+extern "C" void *RecordSharedBindings(void *arg) {
+    auto data = reinterpret_cast<shared_binding_thread_data *>(arg);
+    const VkCommandBufferBeginInfo begin_info = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO, nullptr, 0, nullptr};
+    const VkViewport viewport = {0, 0, 16, 16, 0, 1};
+    const VkRect2D scissor = {{0, 0}, {16, 16}};
+    const VkDeviceSize offset = 0;
+    for (uint32_t i = 0; i < data->count; i++) {
+        // Beginning a recorded command buffer resets it, as its pool allows
+        vkBeginCommandBuffer(data->command_buffer, &begin_info);
+        vkCmdBeginRenderPass(data->command_buffer, data->render_pass_begin_info, VK_SUBPASS_CONTENTS_INLINE);
+        vkCmdSetViewport(data->command_buffer, 0, 1, &viewport);
+        vkCmdSetScissor(data->command_buffer, 0, 1, &scissor);
+        vkCmdBindPipeline(data->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, data->pipeline);
+        vkCmdBindDescriptorSets(data->command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, data->pipeline_layout, 0, 1,
+                                &data->descriptor_set, 0, nullptr);
+        vkCmdBindVertexBuffers(data->command_buffer, 0, 1, &data->vertex_buffer, &offset);
+        vkCmdDraw(data->command_buffer, 3, 1, 0, 0);
+        vkCmdEndRenderPass(data->command_buffer);
+        if (data->draw_outside_render_pass && i == data->count / 2) {
+            vkCmdDraw(data->command_buffer, 3, 1, 0, 0);
+        }
+        vkEndCommandBuffer(data->command_buffer);
+    }
+    return NULL;
+}
+
+TEST_F(VkThreadedValidationTest, ParallelRecordingSharedObjects) {
+    TEST_DESCRIPTION(
+        "With command_buffer_locking, record command buffers from several threads at once, each binding the same pipeline, "
+        "descriptor set and vertex buffer, and check that valid recording reports nothing while an invalid command recorded "
+        "on one of the threads is still reported.");
+
+    if (strcmp(getLayerOption("lunarg_core_validation.command_buffer_locking"), "true")) {
+        printf("             lunarg_core_validation.command_buffer_locking is not set; skipped.\n");
+        return;
+    }
+    ASSERT_NO_FATAL_FAILURE(Init());
+    ASSERT_NO_FATAL_FAILURE(InitViewport());
+    ASSERT_NO_FATAL_FAILURE(InitRenderTarget());
+
+    OneOffDescriptorSet ds(m_device, {{0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_ALL, nullptr}});
+    ASSERT_TRUE(ds.Initialized());
+    const VkPipelineLayoutObj pipeline_layout(m_device, {&ds.layout_});
+
+    vk_testing::Buffer uniform_buffer;
+    uniform_buffer.init(*m_device, vk_testing::Buffer::create_info(256, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT));
+    const VkDescriptorBufferInfo buffer_info = {uniform_buffer.handle(), 0, VK_WHOLE_SIZE};
+    VkWriteDescriptorSet write = {};
+    write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    write.dstSet = ds.set_;
+    write.dstBinding = 0;
+    write.descriptorCount = 1;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    write.pBufferInfo = &buffer_info;
+    vkUpdateDescriptorSets(m_device->device(), 1, &write, 0, nullptr);
+
+    vk_testing::Buffer vertex_buffer;
+    vertex_buffer.init(*m_device, vk_testing::Buffer::create_info(256, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT));
+
+    char const *fsSource =
+        "#version 450\n"
+        "\n"
+        "layout(set=0, binding=0) uniform foo { float x; } a;\n"
+        "layout(location=0) out vec4 color;\n"
+        "void main(){\n"
+        "   color = vec4(a.x);\n"
+        "}\n";
+    VkShaderObj vs(m_device, bindStateVertShaderText, VK_SHADER_STAGE_VERTEX_BIT, this);
+    VkShaderObj fs(m_device, fsSource, VK_SHADER_STAGE_FRAGMENT_BIT, this);
+    VkPipelineObj pipe(m_device);
+    pipe.AddShader(&vs);
+    pipe.AddShader(&fs);
+    pipe.AddDefaultColorAttachment();
+    pipe.CreateVKPipeline(pipeline_layout.handle(), renderPass());
+
+    // Each thread records into a command buffer from its own pool, so the threading layer sees no collision
+    const uint32_t thread_count = 4;
+    std::vector<std::unique_ptr<VkCommandPoolObj>> pools;
+    std::vector<std::unique_ptr<VkCommandBufferObj>> command_buffers;
+    std::vector<shared_binding_thread_data> data(thread_count);
+    std::vector<test_platform_thread> threads(thread_count);
+    for (uint32_t i = 0; i < thread_count; i++) {
+        pools.emplace_back(new VkCommandPoolObj(m_device, m_device->graphics_queue_node_index_,
+                                                VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT));
+        command_buffers.emplace_back(new VkCommandBufferObj(m_device, pools.back().get()));
+        data[i] = {command_buffers.back()->handle(), &m_renderPassBeginInfo, pipe.handle(), pipeline_layout.handle(),
+                   ds.set_, vertex_buffer.handle(), 1000, false};
+    }
+    auto record_from_threads = [&]() {
+        for (uint32_t i = 0; i < thread_count; i++) {
+            test_platform_thread_create(&threads[i], RecordSharedBindings, &data[i]);
+        }
+        for (uint32_t i = 0; i < thread_count; i++) {
+            test_platform_thread_join(threads[i], NULL);
+        }
+    };
+
+    m_errorMonitor->ExpectSuccess();
+    record_from_threads();
+    m_errorMonitor->VerifyNotFound();
+
+    // One thread draws outside its render pass once while the others keep recording
+    data[1].draw_outside_render_pass = true;
+    m_errorMonitor->SetDesiredFailureMsg(VK_DEBUG_REPORT_ERROR_BIT_EXT, VALIDATION_ERROR_1a200017);
+    record_from_threads();
+    m_errorMonitor->VerifyFound();
+}
+#endif  // GTEST_IS_THREADSAFE
+
+#if GTEST_IS_THREADSAFE
+struct invalid_sampler_thread_data {
+    VkDevice device;
+    uint32_t thread_index;
+    uint32_t count;
+};
+
+// A handle that no sampler has, which object_tracker quotes when a call uses it
+static VkSampler InvalidSampler(uint32_t thread_index, uint32_t index) {
+    return (VkSampler)((size_t)(0xbaad0000 | (thread_index << 12) | index));
+}
+
+extern "C" void *DestroyInvalidSamplers(void *arg) {
+    auto data = reinterpret_cast<invalid_sampler_thread_data *>(arg);
+    for (uint32_t i = 0; i < data->count; i++) {
+        vkDestroySampler(data->device, InvalidSampler(data->thread_index, i), NULL);
+    }
+    return NULL;
+}
+
+// Destroy count invalid samplers from each of thread_count threads at once, numbering the threads from first_thread
+static void DestroyInvalidSamplersFromThreads(VkDevice device, uint32_t first_thread, uint32_t thread_count, uint32_t count) {
+    std::vector<invalid_sampler_thread_data> data(thread_count);
+    std::vector<test_platform_thread> threads(thread_count);
+    for (uint32_t i = 0; i < thread_count; i++) {
+        data[i] = {device, first_thread + i, count};
+        test_platform_thread_create(&threads[i], DestroyInvalidSamplers, &data[i]);
+    }
+    for (uint32_t i = 0; i < thread_count; i++) {
+        test_platform_thread_join(threads[i], NULL);
+    }
+}
+
+// Check that the log holds exactly one invalid sampler error for each handle DestroyInvalidSamplersFromThreads used, each
+// delivered off the calling thread
+static void ExpectInvalidSamplerMessages(debug_message_log &log, uint32_t first_thread, uint32_t thread_count, uint32_t count) {
+    const std::string prefix = "Invalid Sampler Object 0x";
+    std::unordered_map<uint64_t, uint32_t> reports;
+    std::lock_guard<std::mutex> lock(log.lock);
+    for (size_t i = 0; i < log.messages.size(); i++) {
+        const size_t found = log.messages[i].find(prefix);
+        if (found == std::string::npos) continue;
+        reports[strtoull(log.messages[i].c_str() + found + prefix.size(), NULL, 16)]++;
+        EXPECT_NE(std::this_thread::get_id(), log.threads[i]) << log.messages[i];
+    }
+    for (uint32_t thread_index = first_thread; thread_index < first_thread + thread_count; thread_index++) {
+        for (uint32_t i = 0; i < count; i++) {
+            const uint64_t handle = (uint64_t)(size_t)InvalidSampler(thread_index, i);
+            EXPECT_EQ(1u, reports[handle]) << "sampler 0x" << std::hex << handle;
+        }
+    }
+}
+
+TEST_F(VkAsyncReportTest, MessagesFromThreadsDeliveredBeforeReturn) {
+    TEST_DESCRIPTION(
+        "With async_debug_report, log errors from several threads at once and check that each of them has reached the "
+        "callback, once and on the logger thread, by the time vkDestroyDebugReportCallbackEXT or vkDestroyDevice returns.");
+
+    if (strcmp(getLayerOption("lunarg_object_tracker.async_debug_report"), "true")) {
+        printf("             lunarg_object_tracker.async_debug_report is not set; skipped.\n");
+        return;
+    }
+    debug_message_log log;
+    ASSERT_NO_FATAL_FAILURE(InitFramework(recordDbgFunc, &log));
+    ASSERT_NO_FATAL_FAILURE(InitState());
+
+    // Each round stays below the default queue size of 4096, so nothing is dropped, and the second round wraps the ring
+    const uint32_t thread_count = 4;
+    const uint32_t count = 1000;
+
+    // Removing a callback first delivers everything logged while it was registered
+    auto create_callback =
+        (PFN_vkCreateDebugReportCallbackEXT)vkGetInstanceProcAddr(instance(), "vkCreateDebugReportCallbackEXT");
+    auto destroy_callback =
+        (PFN_vkDestroyDebugReportCallbackEXT)vkGetInstanceProcAddr(instance(), "vkDestroyDebugReportCallbackEXT");
+    ASSERT_TRUE(create_callback && destroy_callback);
+    debug_message_log callback_log;
+    VkDebugReportCallbackCreateInfoEXT callback_info = {VK_STRUCTURE_TYPE_DEBUG_REPORT_CALLBACK_CREATE_INFO_EXT, nullptr,
+                                                        VK_DEBUG_REPORT_ERROR_BIT_EXT, recordDbgFunc, &callback_log};
+    VkDebugReportCallbackEXT callback;
+    ASSERT_VK_SUCCESS(create_callback(instance(), &callback_info, nullptr, &callback));
+    DestroyInvalidSamplersFromThreads(m_device->device(), 0, thread_count, count);
+    destroy_callback(instance(), callback, nullptr);
+    ExpectInvalidSamplerMessages(callback_log, 0, thread_count, count);
+
+    // Destroying a device delivers everything logged about it
+    std::vector<const char *> device_extension_names;
+    std::unique_ptr<VkDeviceObj> test_device(new VkDeviceObj(0, gpu(), device_extension_names));
+    DestroyInvalidSamplersFromThreads(test_device->device(), thread_count, thread_count, count);
+    test_device.reset();
+    ExpectInvalidSamplerMessages(log, thread_count, thread_count, count);
+}
+#endif  // GTEST_IS_THREADSAFE
+
+// The tests below exercise containers that the layers share, directly rather than through the API
+
+#if GTEST_IS_THREADSAFE
+struct handle_table_thread_data {
+    vl_handle_table *table;
+    uint32_t thread_index;
+    uint32_t iterations;
+    std::atomic<uint64_t> *recently_erased;  // Ring of IDs writers have erased, for readers to look up again
+    size_t recently_erased_count;
+    std::atomic<bool> *writers_done;
+    std::atomic<uint32_t> *failures;
+};
+
+// Insert IDs, keep a window of them live, and erase the oldest; every live ID must map to its own value throughout
+extern "C" void *HandleTableWriter(void *arg) {
+    auto data = reinterpret_cast<handle_table_thread_data *>(arg);
+    const size_t window = 64;
+    std::vector<std::pair<uint64_t, uint64_t>> live;
+    for (uint32_t i = 0; i < data->iterations; i++) {
+        const uint64_t value = (uint64_t(data->thread_index + 1) << 32) | (i + 1);
+        live.emplace_back(data->table->insert(value), value);
+        if (live.size() < window) continue;
+        const auto oldest = live.front();
+        live.erase(live.begin());
+        if (data->table->find(oldest.first) != oldest.second) data->failures->fetch_add(1);
+        if (data->table->erase(oldest.first) != oldest.second) data->failures->fetch_add(1);
+        data->recently_erased[i % data->recently_erased_count].store(oldest.first);
+    }
+    for (auto &entry : live) {
+        if (data->table->erase(entry.first) != entry.second) data->failures->fetch_add(1);
+    }
+    return NULL;
+}
+
+// Look up and erase IDs that are already gone, which must find nothing and leave live IDs alone
+extern "C" void *HandleTableStaleReader(void *arg) {
+    auto data = reinterpret_cast<handle_table_thread_data *>(arg);
+    size_t next = 0;
+    while (!data->writers_done->load()) {
+        const uint64_t id = data->recently_erased[next++ % data->recently_erased_count].load();
+        if (!id) continue;
+        if (data->table->find(id) != 0) data->failures->fetch_add(1);
+        if (data->table->erase(id) != 0) data->failures->fetch_add(1);
+    }
+    return NULL;
+}
+
+TEST(VkLayerUtilsTest, HandleTableStaleIdsAcrossPages) {
+    TEST_DESCRIPTION(
+        "Insert and erase IDs from several threads while others keep looking up and erasing IDs that were already erased. "
+        "Pages fill, retire and get reused throughout, and a stale ID must never resolve to, or erase, another ID's entry.");
+
+    const uint32_t writer_count = 4;
+    const uint32_t reader_count = 4;
+    const uint64_t page_size = vl_handle_table::kPageSize;
+    // Start a few IDs short of a page boundary so the first page is partly used
+    vl_handle_table table(page_size - 3);
+
+    std::vector<std::atomic<uint64_t>> recently_erased(1024);
+    for (auto &id : recently_erased) id.store(0);
+    std::atomic<bool> writers_done(false);
+    std::atomic<uint32_t> failures(0);
+
+    std::vector<handle_table_thread_data> data(writer_count + reader_count);
+    for (uint32_t i = 0; i < data.size(); i++) {
+        data[i] = {&table, i, 50000, recently_erased.data(), recently_erased.size(), &writers_done, &failures};
+    }
+    std::vector<test_platform_thread> threads(data.size());
+    for (uint32_t i = 0; i < reader_count; i++) {
+        test_platform_thread_create(&threads[writer_count + i], HandleTableStaleReader, &data[writer_count + i]);
+    }
+    for (uint32_t i = 0; i < writer_count; i++) {
+        test_platform_thread_create(&threads[i], HandleTableWriter, &data[i]);
+    }
+    for (uint32_t i = 0; i < writer_count; i++) {
+        test_platform_thread_join(threads[i], NULL);
+    }
+    writers_done.store(true);
+    for (uint32_t i = 0; i < reader_count; i++) {
+        test_platform_thread_join(threads[writer_count + i], NULL);
+    }
+    EXPECT_EQ(0u, failures.load());
+
+    // Every ID handed out has been erased
+    const uint64_t last_id = table.insert(1);
+    for (uint64_t id = page_size - 3; id < last_id; id++) {
+        EXPECT_EQ(0u, table.find(id)) << "id " << id;
+    }
+    EXPECT_EQ(1u, table.erase(last_id));
+}
+#endif  // GTEST_IS_THREADSAFE
+
+TEST(VkLayerUtilsTest, HandleTableOverflow) {
+    TEST_DESCRIPTION("Hand out IDs across the end of the radix table into the locked overflow map and back out again.");
+
+    const uint64_t id_limit = vl_handle_table::kIdLimit;
+    vl_handle_table table(id_limit - 8);
+    std::vector<uint64_t> ids;
+    for (uint64_t i = 0; i < 16; i++) {
+        ids.push_back(table.insert(i + 100));
+    }
+    EXPECT_EQ(id_limit - 8, ids.front());
+    EXPECT_EQ(id_limit + 7, ids.back());
+    for (uint64_t i = 0; i < ids.size(); i++) {
+        EXPECT_EQ(i + 100, table.find(ids[i]));
+    }
+    for (uint64_t i = 0; i < ids.size(); i++) {
+        EXPECT_EQ(i + 100, table.erase(ids[i]));
+        EXPECT_EQ(0u, table.erase(ids[i]));
+        EXPECT_FALSE(table.contains(ids[i]));
+    }
+    EXPECT_EQ(0u, table.find(id_limit + 100));
+}
+
+// Messages that reach a callback behind a duplicate filter, and what the callback returns for them
+struct filtered_message_log {
+    VkBool32 bail;
+    std::vector<std::string> messages;
+};
+
+static VKAPI_ATTR VkBool32 VKAPI_CALL filteredDbgFunc(VkFlags msgFlags, VkDebugReportObjectTypeEXT objType, uint64_t srcObject,
+                                                      size_t location, int32_t msgCode, const char *pLayerPrefix,
+                                                      const char *pMsg, void *pUserData) {
+    auto log = static_cast<filtered_message_log *>(pUserData);
+    log->messages.push_back(pMsg);
+    return log->bail;
+}
+
+// Report data delivering errors to log
+class LoggedReportData {
+   public:
+    explicit LoggedReportData(filtered_message_log *log) : callback_(VK_NULL_HANDLE) {
+        data_ = debug_report_create_instance(nullptr, VK_NULL_HANDLE, 0, nullptr);
+        VkDebugReportCallbackCreateInfoEXT info = {VK_STRUCTURE_TYPE_DEBUG_REPORT_CALLBACK_CREATE_INFO_EXT, nullptr,
+                                                   VK_DEBUG_REPORT_ERROR_BIT_EXT, filteredDbgFunc, log};
+        layer_create_msg_callback(data_, false, &info, nullptr, &callback_);
+    }
+    ~LoggedReportData() {
+        layer_destroy_msg_callback(data_, callback_, nullptr);
+        layer_debug_report_destroy_instance(data_);
+    }
+
+    debug_report_data *get() { return data_; }
+
+    bool log(uint64_t object, const char *text) {
+        return log_msg(data_, VK_DEBUG_REPORT_ERROR_BIT_EXT, VK_DEBUG_REPORT_OBJECT_TYPE_UNKNOWN_EXT, object, 0, 1, "Test", "%s",
+                       text);
+    }
+
+   protected:
+    debug_report_data *data_;
+
+   private:
+    VkDebugReportCallbackEXT callback_;
+};
+
+// Report data with a duplicate filter, delivering errors to log
+class DuplicateFilterReportData : public LoggedReportData {
+   public:
+    DuplicateFilterReportData(filtered_message_log *log, uint32_t first_reports, uint32_t report_period,
+                              size_t max_messages = 4096)
+        : LoggedReportData(log) {
+        data_->duplicate_filter = new debug_report_duplicate_filter(first_reports, report_period, max_messages);
+    }
+};
+
+TEST(VkLayerUtilsTest, DuplicateFilterFirstAndPeriodicReports) {
+    TEST_DESCRIPTION(
+        "Log the same message repeatedly through a duplicate filter that reports the first 2 occurrences and every 3rd one "
+        "after that, and check which occurrences are reported and how many suppressed duplicates each one names.");
+
+    filtered_message_log log = {VK_FALSE, {}};
+    DuplicateFilterReportData report_data(&log, 2, 3);
+    for (uint32_t i = 0; i < 11; i++) {
+        report_data.log(1, "repeated");
+    }
+    // The same message about another object is counted apart
+    report_data.log(2, "repeated");
+
+    const std::string annotated = "repeated [2 duplicates of this message were suppressed]";
+    const std::vector<std::string> expected = {"repeated", "repeated", annotated, annotated, annotated, "repeated"};
+    EXPECT_EQ(expected, log.messages);
+}
+
+TEST(VkLayerUtilsTest, DuplicateFilterSuppressedReturnsLastBail) {
+    TEST_DESCRIPTION(
+        "Check that a suppressed duplicate returns what the callback returned for the last reported occurrence of its "
+        "message, without calling the callback.");
+
+    filtered_message_log log = {VK_TRUE, {}};
+    DuplicateFilterReportData report_data(&log, 1, 0);
+    EXPECT_TRUE(report_data.log(1, "skip"));
+    log.bail = VK_FALSE;
+    EXPECT_TRUE(report_data.log(1, "skip"));
+    EXPECT_FALSE(report_data.log(2, "continue"));
+    log.bail = VK_TRUE;
+    EXPECT_FALSE(report_data.log(2, "continue"));
+    EXPECT_EQ(2u, log.messages.size());
+}
+
+TEST(VkLayerUtilsTest, DuplicateFilterForgetsOldestMessages) {
+    TEST_DESCRIPTION(
+        "Fill a duplicate filter that counts only a few messages with messages about many objects, and check that a message "
+        "pushed out by them is reported again.");
+
+    filtered_message_log log = {VK_FALSE, {}};
+    DuplicateFilterReportData report_data(&log, 1, 0, 16);
+    report_data.log(1, "first object");
+    report_data.log(1, "first object");
+    EXPECT_EQ(1u, log.messages.size());
+    for (uint64_t object = 2; object < 1000; object++) {
+        report_data.log(object, "another object");
+    }
+    EXPECT_EQ(999u, log.messages.size());
+    report_data.log(1, "first object");
+    ASSERT_EQ(1000u, log.messages.size());
+    EXPECT_EQ("first object", log.messages.back());
+}
+
+TEST(VkLayerUtilsTest, CallSamplerChecksOneCallInPeriod) {
+    TEST_DESCRIPTION("Check that a call sampler with a call period of 4 picks exactly one call in every 4 made on a thread.");
+
+    call_sampler sampler;
+    EXPECT_FALSE(sampler.sampling());
+    EXPECT_TRUE(sampler.sample_call());
+
+    sampler.call_period = 4;
+    EXPECT_TRUE(sampler.sampling());
+    uint32_t checked = 0;
+    for (uint32_t i = 0; i < 400; i++) {
+        if (sampler.sample_call()) checked++;
+        if (i % 4 == 3) {
+            EXPECT_EQ(i / 4 + 1, checked) << "call " << i;
+        }
+    }
+    EXPECT_EQ(100u, checked);
+}
+
+#if GTEST_IS_THREADSAFE
+// A thread that starts writing a fence, holds the write until told to release it, then finishes it
+struct fence_writer_thread_data {
+    counter<VkFence> *fences;
+    debug_report_data *report_data;
+    VkFence fence;
+    uint32_t use_limit;
+    std::atomic<bool> held;
+    std::atomic<bool> release;
+};
+
+extern "C" void *HoldFenceWrite(void *arg) {
+    auto data = reinterpret_cast<fence_writer_thread_data *>(arg);
+    data->fences->startWrite(data->report_data, data->fence, data->use_limit);
+    data->held.store(true);
+    while (!data->release.load()) std::this_thread::yield();
+    data->fences->finishWrite(data->fence, data->use_limit);
+    return NULL;
+}
+
+TEST(VkLayerUtilsTest, CounterUseLimitRetiresIdleObjects) {
+    TEST_DESCRIPTION(
+        "Read fences while another thread writes them, through a counter that stops checking a fence after 2 uses, and check "
+        "that collisions are reported until the second checked use goes idle, and that no fence is retired while a use of it "
+        "is in flight. A fence with no limit goes on being reported.");
+
+    filtered_message_log log = {VK_FALSE, {}};
+    LoggedReportData report_data(&log);
+    counter<VkFence> fences("VkFence", VK_DEBUG_REPORT_OBJECT_TYPE_FENCE_EXT);
+    const VkFence limited = (VkFence)0x1000;
+    const VkFence unlimited = (VkFence)0x2000;
+    auto use_of = [&fences](VkFence fence) { return fences.uses.find((uint64_t)fence, false)->use.load(); };
+
+    // Read a fence while another thread holds a write to it, and return whether the fence was retired before the write
+    // finished
+    auto collide = [&](VkFence fence, uint32_t use_limit) {
+        fence_writer_thread_data data;
+        data.fences = &fences;
+        data.report_data = report_data.get();
+        data.fence = fence;
+        data.use_limit = use_limit;
+        data.held.store(false);
+        data.release.store(false);
+        test_platform_thread thread;
+        test_platform_thread_create(&thread, HoldFenceWrite, &data);
+        while (!data.held.load()) std::this_thread::yield();
+        fences.startRead(report_data.get(), fence, use_limit);
+        fences.finishRead(fence, use_limit);
+        const bool retired_in_flight = use_of(fence) == object_use_table::kRetired;
+        data.release.store(true);
+        test_platform_thread_join(thread, NULL);
+        return retired_in_flight;
+    };
+
+    // A first use alone leaves the fence tracked
+    fences.startWrite(report_data.get(), limited, 2);
+    fences.finishWrite(limited, 2);
+    EXPECT_EQ(0u, use_of(limited));
+    EXPECT_TRUE(log.messages.empty());
+
+    // The write is the second checked use, and the fence is retired once it finishes, after the read that collided with it
+    EXPECT_FALSE(collide(limited, 2));
+    EXPECT_EQ(1u, log.messages.size());
+    EXPECT_TRUE(use_of(limited) == object_use_table::kRetired);
+    // Retired, the fence is no longer checked
+    collide(limited, 2);
+    EXPECT_EQ(1u, log.messages.size());
+
+    EXPECT_FALSE(collide(unlimited, 0));
+    EXPECT_FALSE(collide(unlimited, 0));
+    EXPECT_FALSE(collide(unlimited, 0));
+    EXPECT_EQ(4u, log.messages.size());
+    EXPECT_EQ(0u, use_of(unlimited));
+    for (const auto &message : log.messages) {
+        EXPECT_NE(std::string::npos, message.find("THREADING ERROR : object of type VkFence is simultaneously used")) << message;
+    }
+}
+#endif  // GTEST_IS_THREADSAFE
+
 #if defined(ANDROID) && defined(VALIDATION_APK)
 const char *appTag = "VulkanLayerValidationTests";
 static bool initialized = false;
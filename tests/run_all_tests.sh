@@ -16,3 +16,12 @@ set -e
 # catch the errors that they are supposed to by intentionally doing things
 # that are wrong
 ./vk_layer_validation_tests
+
+# Run the tests of validation done on worker threads again with those threads turned on
+VK_LAYER_SETTINGS_PATH=./vk_layer_settings_threaded.txt ./vk_layer_validation_tests --gtest_filter=VkThreadedValidationTest.*
+
+# Run the tests of asynchronous debug report delivery again with it turned on
+VK_LAYER_SETTINGS_PATH=./vk_layer_settings_async_report.txt ./vk_layer_validation_tests --gtest_filter=VkAsyncReportTest.*
+
+# Run the tests of the layer's own validation cache file again with a file named
+VK_LAYER_SETTINGS_PATH=./vk_layer_settings_validation_cache.txt ./vk_layer_validation_tests --gtest_filter=VkValidationCacheFileTest.*